@@ -38,6 +38,7 @@ apis = [
     ["src/btstack_util.h", "Common Utils", "btUtil"],
     ["src/gap.h", "GAP", "gap"],
     ["src/hci.h", "HCI", "hci"],
+    ["src/hci_cmd_encoder.h","HCI Command Encoder","hciCmdEncoder"],
     ["src/hci_dump.h","HCI Logging","hciTrace"],
     ["src/hci_transport.h","HCI Transport","hciTransport"],
     ["src/l2cap.h", "L2CAP", "l2cap"],
@@ -146,6 +146,7 @@ static const char * adv_failed_warning = "\n"
 // att pdu pool implementation
 #ifndef HAVE_MALLOC
 static att_pdu_t att_pdu_storage[MAX_NUM_ATT_PDUS];
+static uint32_t att_pdu_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NUM_ATT_PDUS)];
 static btstack_memory_pool_t att_pdu_pool;
 static att_pdu_t * btstack_memory_att_pdu_get(void){
     void * buffer = btstack_memory_pool_get(&att_pdu_pool);
@@ -558,7 +559,7 @@ int btstack_main(int argc, const char * argv[]){
     sm_add_event_handler(&sm_event_callback_registration);
 
 #ifndef HAVE_MALLOC
-    btstack_memory_pool_create(&att_pdu_pool, att_pdu_storage, MAX_NUM_ATT_PDUS, sizeof(att_pdu_t));
+    btstack_memory_pool_create(&att_pdu_pool, att_pdu_storage, MAX_NUM_ATT_PDUS, sizeof(att_pdu_t), att_pdu_allocated);
 #endif
 
 #ifdef HAVE_BTSTACK_STDIN
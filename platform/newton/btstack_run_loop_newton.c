@@ -57,6 +57,7 @@
 
 #include "btstack_run_loop.h"
 #include "btstack_run_loop_newton.h"
+#include "btstack_run_loop_base.h"
 #include "btstack_linked_list.h"
 #include "btstack_util.h"
 
@@ -66,6 +67,7 @@
 #include <stddef.h> // NULL
 
 #include "hal_timer_newton.h"
+#include "hal_newton.h"
 
 /**
  * Add data_source to run_loop
@@ -87,25 +89,11 @@ static void btstack_run_loop_embedded_set_timer(btstack_state_t *btstack, btstac
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_embedded_add_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &btstack->run_loop->timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-
-    ts->item.next = it->next;
     ts->context = btstack;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(btstack, ts);
     hal_timer_newton_set_timer(btstack, ts->timeout);
     einstein_log(34, __func__, __LINE__, "%d", ts->timeout);
 }
@@ -114,28 +102,33 @@ static void btstack_run_loop_embedded_add_timer(btstack_state_t *btstack, btstac
  * Remove timer from run loop
  */
 static bool btstack_run_loop_embedded_remove_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
-    return btstack_linked_list_remove(&btstack->run_loop->timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(btstack, ts);
 }
 
 static void btstack_run_loop_embedded_dump_timer(btstack_state_t *btstack){
-#ifdef ENABLE_LOG_INFO
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) btstack->run_loop->timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, (unsigned int) ts->timeout);
-    }
-#endif
+    btstack_run_loop_base_dump_timer(btstack);
 }
 
-static void btstack_run_loop_embedded_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+static void btstack_run_loop_embedded_enable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t * ds, uint16_t callback_types){
+    UNUSED(btstack);
     ds->flags |= callback_types;
 }
 
-static void btstack_run_loop_embedded_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+static void btstack_run_loop_embedded_disable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t * ds, uint16_t callback_types){
+    UNUSED(btstack);
     ds->flags &= ~callback_types;
 }
 
+/**
+ * Execute callback on run loop thread, can be called from interrupt context
+ */
+static void btstack_run_loop_embedded_execute_on_main_thread(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration){
+    hal_cpu_disable_irqs();
+    btstack_run_loop_base_add_callback(btstack, callback_registration);
+    btstack->run_loop->trigger_event_received = 1;
+    hal_cpu_enable_irqs();
+}
+
 /**
  * Execute run_loop once
  */
@@ -151,17 +144,16 @@ void btstack_run_loop_embedded_execute_once(btstack_state_t *btstack) {
         }
     }
 
+    // process callbacks from other threads
+    hal_cpu_disable_irqs();
+    btstack_context_callback_registration_t * callbacks = btstack_run_loop_base_take_callbacks(btstack);
+    hal_cpu_enable_irqs();
+    btstack_run_loop_base_execute_callbacks(callbacks);
+
     uint32_t now = hal_time_ms();
 
     // process timers
-    while (btstack->run_loop->timers) {
-        btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack->run_loop->timers;
-        int32_t delta = btstack_time_delta(ts->timeout, now);
-        if (delta > 0) break;
-
-        btstack_run_loop_embedded_remove_timer(btstack, ts);
-        ts->process(btstack, ts);
-    }
+    btstack_run_loop_base_process_timers(btstack, now);
 }
 
 /**
@@ -186,8 +178,7 @@ void btstack_run_loop_embedded_trigger(btstack_state_t *btstack){
 }
 
 static void btstack_run_loop_embedded_init(btstack_state_t *btstack){
-    btstack->run_loop->data_sources = NULL;
-    btstack->run_loop->timers = NULL;
+    btstack_run_loop_base_init(btstack);
 }
 
 /**
@@ -206,6 +197,8 @@ const btstack_run_loop_t btstack_run_loop_embedded = {
     &btstack_run_loop_embedded_execute,
     &btstack_run_loop_embedded_dump_timer,
     &btstack_run_loop_embedded_get_time_ms,
+    &btstack_run_loop_embedded_execute_on_main_thread,
+    NULL,
 };
 
 const btstack_run_loop_t * btstack_run_loop_embedded_get_instance(void){
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+
+#define BTSTACK_FILE__ "btstack_run_loop_epoll.c"
+
+/*
+ *  btstack_run_loop_epoll.c
+ *
+ *  Linux run loop using epoll. File descriptors are registered with the kernel when a data
+ *  source is added or its callbacks change, so an iteration only visits the ready data sources.
+ *  Readiness is level-triggered, data sources don't need to drain their file descriptor.
+ */
+
+// enable POSIX functions (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809
+
+#include "btstack_run_loop_epoll.h"
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_util.h"
+#include "btstack_linked_list.h"
+#include "btstack_debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef HAVE_EPOLL
+#error "Please add HAVE_EPOLL to btstack_config.h to use the epoll run loop"
+#endif
+
+#ifndef HAVE_POSIX_TIME
+#error "Please add HAVE_POSIX_TIME to btstack_config.h to use the epoll run loop"
+#endif
+
+// max number of ready file descriptors processed per iteration
+#ifndef BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS
+#define BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS 16
+#endif
+
+static uint32_t btstack_run_loop_epoll_events_for_flags(uint16_t flags){
+    uint32_t events = 0;
+    if (flags & DATA_SOURCE_CALLBACK_READ){
+        events |= EPOLLIN;
+    }
+    if (flags & DATA_SOURCE_CALLBACK_WRITE){
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+static void btstack_run_loop_epoll_update(btstack_state_t *btstack, btstack_data_source_t *ds, int op){
+    if (ds->source.fd < 0) return;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = btstack_run_loop_epoll_events_for_flags(ds->flags);
+    event.data.ptr = ds;
+    int res = epoll_ctl(btstack->run_loop->epoll_fd, op, ds->source.fd, &event);
+    if (res < 0){
+        log_error("btstack_run_loop_epoll: epoll_ctl(%u) for fd %u failed, errno %u", op, ds->source.fd, errno);
+    }
+}
+
+/**
+ * Add data_source to run_loop
+ */
+static void btstack_run_loop_epoll_add_data_source(btstack_state_t *btstack, btstack_data_source_t *ds){
+    btstack->run_loop->data_sources_modified = 1;
+    log_info("btstack_run_loop_epoll_add_data_source %p with fd %u\n", ds, ds->source.fd);
+    btstack_run_loop_base_add_data_source(btstack, ds);
+    btstack_run_loop_epoll_update(btstack, ds, EPOLL_CTL_ADD);
+}
+
+/**
+ * Remove data_source from run loop
+ */
+static bool btstack_run_loop_epoll_remove_data_source(btstack_state_t *btstack, btstack_data_source_t *ds){
+    btstack->run_loop->data_sources_modified = 1;
+    log_debug("btstack_run_loop_epoll_remove_data_source %p\n", ds);
+    bool removed = btstack_run_loop_base_remove_data_source(btstack, ds);
+    if (removed){
+        btstack_run_loop_epoll_update(btstack, ds, EPOLL_CTL_DEL);
+    }
+    return removed;
+}
+
+static void btstack_run_loop_epoll_enable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t * ds, uint16_t callback_types){
+    btstack_run_loop_base_enable_data_source_callbacks(ds, callback_types);
+    btstack_run_loop_epoll_update(btstack, ds, EPOLL_CTL_MOD);
+}
+
+static void btstack_run_loop_epoll_disable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t * ds, uint16_t callback_types){
+    btstack_run_loop_base_disable_data_source_callbacks(ds, callback_types);
+    btstack_run_loop_epoll_update(btstack, ds, EPOLL_CTL_MOD);
+}
+
+static void btstack_run_loop_epoll_add_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
+    btstack_run_loop_base_add_timer(btstack, ts);
+    log_debug("Added timer %p at %u\n", ts, ts->timeout);
+}
+
+static bool btstack_run_loop_epoll_remove_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
+    return btstack_run_loop_base_remove_timer(btstack, ts);
+}
+
+static void btstack_run_loop_epoll_dump_timer(btstack_state_t *btstack){
+    btstack_run_loop_base_dump_timer(btstack);
+}
+
+static void btstack_run_loop_epoll_wakeup_process(btstack_state_t *btstack, btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(btstack);
+    UNUSED(callback_type);
+    // reset eventfd counter, callbacks are executed in every run loop iteration
+    uint64_t counter;
+    ssize_t res = read(ds->source.fd, &counter, sizeof(counter));
+    UNUSED(res);
+}
+
+/**
+ * Execute callback on run loop thread, can be called from any thread
+ */
+static void btstack_run_loop_epoll_execute_on_main_thread(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration){
+    btstack_run_loop_base_add_callback(btstack, callback_registration);
+    if (btstack->run_loop->wakeup_fd < 0) return;
+    const uint64_t increment = 1;
+    ssize_t res = write(btstack->run_loop->wakeup_fd, &increment, sizeof(increment));
+    UNUSED(res);
+}
+
+/**
+ * @brief Queries the current time in ms since start
+ */
+static uint32_t btstack_run_loop_epoll_get_time_ms(btstack_state_t *btstack){
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    uint64_t sec_val  = (uint64_t) (now_ts.tv_sec - btstack->run_loop->init_ts.tv_sec);
+    uint64_t nsec_val = (uint64_t) now_ts.tv_nsec;
+    return (uint32_t) ((sec_val * 1000) + (nsec_val / 1000000));
+}
+
+/**
+ * Execute run_loop
+ */
+static void btstack_run_loop_epoll_execute(btstack_state_t *btstack) {
+    struct epoll_event events[BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS];
+
+    log_info("epoll run loop with monotonic clock");
+
+    while (!btstack->run_loop->exit) {
+
+        // get next timeout, -1 = wait forever
+        uint32_t now_ms = btstack_run_loop_epoll_get_time_ms(btstack);
+        int32_t timeout_ms = btstack_run_loop_base_get_time_until_timeout(btstack, now_ms);
+        log_debug("btstack_run_loop_epoll_execute next timeout in %d ms", timeout_ms);
+
+        // wait for ready FDs
+        int num_events = epoll_wait(btstack->run_loop->epoll_fd, events, BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS, timeout_ms);
+        if (num_events < 0){
+            if (errno != EINTR){
+                log_error("btstack_run_loop_epoll_execute: epoll_wait failed, errno %u", errno);
+            }
+            num_events = 0;
+        }
+
+        // process ready data sources. stop if list changes, as pending events could refer to removed data sources
+        btstack->run_loop->data_sources_modified = 0;
+        int i;
+        for (i = 0; (i < num_events) && !btstack->run_loop->data_sources_modified; i++){
+            btstack_data_source_t *ds = (btstack_data_source_t *) events[i].data.ptr;
+            uint32_t ready = events[i].events;
+            if ((ready & (EPOLLIN | EPOLLHUP | EPOLLERR)) && (ds->flags & DATA_SOURCE_CALLBACK_READ)) {
+                log_debug("btstack_run_loop_epoll_execute: process read ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(btstack, ds, DATA_SOURCE_CALLBACK_READ);
+            }
+            if (btstack->run_loop->data_sources_modified) break;
+            if ((ready & EPOLLOUT) && (ds->flags & DATA_SOURCE_CALLBACK_WRITE)) {
+                log_debug("btstack_run_loop_epoll_execute: process write ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(btstack, ds, DATA_SOURCE_CALLBACK_WRITE);
+            }
+        }
+
+        // process callbacks from other threads
+        btstack_run_loop_base_execute_callbacks(btstack_run_loop_base_take_callbacks(btstack));
+
+        // process timers
+        now_ms = btstack_run_loop_epoll_get_time_ms(btstack);
+        btstack_run_loop_base_process_timers(btstack, now_ms);
+    }
+}
+
+// set timer
+static void btstack_run_loop_epoll_set_timer(btstack_state_t *btstack, btstack_timer_source_t *a, uint32_t timeout_in_ms){
+    uint32_t time_ms = btstack_run_loop_epoll_get_time_ms(btstack);
+    a->timeout = time_ms + timeout_in_ms;
+    log_debug("btstack_run_loop_epoll_set_timer to %u ms (now %u, timeout %u)", a->timeout, time_ms, timeout_in_ms);
+}
+
+static void btstack_run_loop_epoll_init(btstack_state_t *btstack){
+    btstack_run_loop_base_init(btstack);
+    btstack->run_loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (btstack->run_loop->epoll_fd < 0){
+        log_error("btstack_run_loop_epoll_init: epoll_create1 failed, errno %u", errno);
+    }
+
+    // eventfd to wake up epoll_wait from other threads
+    btstack->run_loop->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (btstack->run_loop->wakeup_fd >= 0){
+        btstack_run_loop_set_data_source_fd(&btstack->run_loop->wakeup_data_source, btstack->run_loop->wakeup_fd);
+        btstack_run_loop_set_data_source_handler(&btstack->run_loop->wakeup_data_source, &btstack_run_loop_epoll_wakeup_process);
+        btstack_run_loop_base_enable_data_source_callbacks(&btstack->run_loop->wakeup_data_source, DATA_SOURCE_CALLBACK_READ);
+        btstack_run_loop_epoll_add_data_source(btstack, &btstack->run_loop->wakeup_data_source);
+    } else {
+        log_error("btstack_run_loop_epoll_init: eventfd failed, errno %u", errno);
+        btstack->run_loop->wakeup_fd = -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &btstack->run_loop->init_ts);
+    btstack->run_loop->init_ts.tv_nsec = 0;
+}
+
+static void btstack_run_loop_epoll_deinit(btstack_state_t *btstack){
+    if (btstack->run_loop->wakeup_fd >= 0){
+        btstack_run_loop_epoll_remove_data_source(btstack, &btstack->run_loop->wakeup_data_source);
+        close(btstack->run_loop->wakeup_fd);
+        btstack->run_loop->wakeup_fd = -1;
+    }
+    if (btstack->run_loop->epoll_fd >= 0){
+        close(btstack->run_loop->epoll_fd);
+        btstack->run_loop->epoll_fd = -1;
+    }
+}
+
+static const btstack_run_loop_t btstack_run_loop_epoll = {
+    &btstack_run_loop_epoll_init,
+    &btstack_run_loop_epoll_add_data_source,
+    &btstack_run_loop_epoll_remove_data_source,
+    &btstack_run_loop_epoll_enable_data_source_callbacks,
+    &btstack_run_loop_epoll_disable_data_source_callbacks,
+    &btstack_run_loop_epoll_set_timer,
+    &btstack_run_loop_epoll_add_timer,
+    &btstack_run_loop_epoll_remove_timer,
+    &btstack_run_loop_epoll_execute,
+    &btstack_run_loop_epoll_dump_timer,
+    &btstack_run_loop_epoll_get_time_ms,
+    &btstack_run_loop_epoll_execute_on_main_thread,
+    &btstack_run_loop_epoll_deinit,
+};
+
+/**
+ * Provide btstack_run_loop_epoll instance
+ */
+const btstack_run_loop_t * btstack_run_loop_epoll_get_instance(void){
+    return &btstack_run_loop_epoll;
+}
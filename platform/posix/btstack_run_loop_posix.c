@@ -49,12 +49,14 @@
 #include "btstack_run_loop_posix.h"
 
 #include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
 #include "btstack_util.h"
 #include "btstack_linked_list.h"
 #include "btstack_debug.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <fcntl.h>
 #include <sys/select.h>
 #include <sys/time.h>
 #include <time.h>
@@ -81,49 +83,54 @@ static bool btstack_run_loop_posix_remove_data_source(btstack_state_t *btstack,
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_posix_add_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &btstack->run_loop->timers; it->next ; it = it->next){
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        btstack_assert(next != ts);
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(btstack, ts);
     log_debug("Added timer %p at %u\n", ts, ts->timeout);
-    // btstack_run_loop_posix_dump_timer();
 }
 
 /**
  * Remove timer from run loop
  */
 static bool btstack_run_loop_posix_remove_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
-    // log_info("Removed timer %x at %u\n", (int) ts, (unsigned int) ts->timeout.tv_sec);
-    // btstack_run_loop_posix_dump_timer();
-    return btstack_linked_list_remove(&btstack->run_loop->timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(btstack, ts);
 }
 
 static void btstack_run_loop_posix_dump_timer(btstack_state_t *btstack){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) btstack->run_loop->timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u (%p): timeout %u\n", i, ts, ts->timeout);
-    }
+    btstack_run_loop_base_dump_timer(btstack);
 }
 
-static void btstack_run_loop_posix_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+static void btstack_run_loop_posix_enable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t * ds, uint16_t callback_types){
+    UNUSED(btstack);
     ds->flags |= callback_types;
 }
 
-static void btstack_run_loop_posix_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+static void btstack_run_loop_posix_disable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t * ds, uint16_t callback_types){
+    UNUSED(btstack);
     ds->flags &= ~callback_types;
 }
 
+static void btstack_run_loop_posix_wakeup_process(btstack_state_t *btstack, btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(btstack);
+    UNUSED(callback_type);
+    // drain pipe, callbacks are executed in every run loop iteration
+    uint8_t buffer[16];
+    while (read(ds->source.fd, buffer, sizeof(buffer)) > 0);
+}
+
+/**
+ * Execute callback on run loop thread, can be called from any thread
+ */
+static void btstack_run_loop_posix_execute_on_main_thread(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration){
+    btstack_run_loop_base_add_callback(btstack, callback_registration);
+    if (btstack->run_loop->wakeup_fd < 0) return;
+    // wake up select. if pipe is full, a wakeup is pending anyway
+    const uint8_t wakeup = 0;
+    ssize_t res = write(btstack->run_loop->wakeup_fd, &wakeup, 1);
+    UNUSED(res);
+}
+
 #ifdef _POSIX_MONOTONIC_CLOCK
 /**
  * @brief Returns the timespec which represents the time(stop - start). It might be negative
@@ -184,7 +191,6 @@ static void btstack_run_loop_posix_execute(btstack_state_t *btstack) {
     fd_set descriptors_read;
     fd_set descriptors_write;
 
-    btstack_timer_source_t       *ts;
     btstack_linked_list_iterator_t it;
     struct timeval * timeout;
     struct timeval tv;
@@ -223,15 +229,10 @@ static void btstack_run_loop_posix_execute(btstack_state_t *btstack) {
 
         // get next timeout
         timeout = NULL;
-        if (btstack->run_loop->timers) {
-            ts = (btstack_timer_source_t *) btstack->run_loop->timers;
+        now_ms = btstack_run_loop_posix_get_time_ms(btstack);
+        int32_t delta = btstack_run_loop_base_get_time_until_timeout(btstack, now_ms);
+        if (delta >= 0) {
             timeout = &tv;
-            uint32_t list_timeout  = ts->timeout;
-            now_ms = btstack_run_loop_posix_get_time_ms(btstack);
-            int32_t delta = btstack_time_delta(list_timeout, now_ms);
-            if (delta < 0){
-                delta = 0;
-            }
             tv.tv_sec  = delta / 1000;
             tv.tv_usec = (int) (delta - (tv.tv_sec * 1000)) * 1000;
             log_debug("btstack_run_loop_execute next timeout in %u ms", delta);
@@ -258,18 +259,12 @@ static void btstack_run_loop_posix_execute(btstack_state_t *btstack) {
         }
         log_debug("btstack_run_loop_posix_execute: after ds check\n");
 
+        // process callbacks from other threads
+        btstack_run_loop_base_execute_callbacks(btstack_run_loop_base_take_callbacks(btstack));
+
         // process timers
         now_ms = btstack_run_loop_posix_get_time_ms(btstack);
-        while (btstack->run_loop->timers) {
-            ts = (btstack_timer_source_t *) btstack->run_loop->timers;
-            int32_t delta = btstack_time_delta(ts->timeout, now_ms);
-            if (delta > 0) break;
-            log_debug("btstack_run_loop_posix_execute: process timer %p\n", ts);
-
-            // remove timer before processing it to allow handler to re-register with run loop
-            btstack_run_loop_posix_remove_timer(btstack, ts);
-            ts->process(btstack, ts);
-        }
+        btstack_run_loop_base_process_timers(btstack, now_ms);
     }
 }
 
@@ -281,14 +276,36 @@ static void btstack_run_loop_posix_set_timer(btstack_state_t *btstack, btstack_t
 }
 
 static void btstack_run_loop_posix_init(btstack_state_t *btstack){
-    btstack->run_loop->data_sources = NULL;
-    btstack->run_loop->timers = NULL;
+    btstack_run_loop_base_init(btstack);
+
+    // pipe to wake up select from other threads
+    int fds[2];
+    if (pipe(fds) == 0){
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+        btstack->run_loop->wakeup_fd = fds[1];
+        btstack_run_loop_set_data_source_fd(&btstack->run_loop->wakeup_data_source, fds[0]);
+        btstack_run_loop_set_data_source_handler(&btstack->run_loop->wakeup_data_source, &btstack_run_loop_posix_wakeup_process);
+        btstack_run_loop_base_enable_data_source_callbacks(&btstack->run_loop->wakeup_data_source, DATA_SOURCE_CALLBACK_READ);
+        btstack_run_loop_posix_add_data_source(btstack, &btstack->run_loop->wakeup_data_source);
+    } else {
+        log_error("btstack_run_loop_posix_init: could not create wakeup pipe");
+        btstack->run_loop->wakeup_fd = -1;
+    }
 #ifdef _POSIX_MONOTONIC_CLOCK
     clock_gettime(CLOCK_MONOTONIC, &btstack->run_loop->init_ts);
     btstack->run_loop->init_ts.tv_nsec = 0;
 #endif
 }
 
+static void btstack_run_loop_posix_deinit(btstack_state_t *btstack){
+    if (btstack->run_loop->wakeup_fd < 0) return;
+    btstack_run_loop_posix_remove_data_source(btstack, &btstack->run_loop->wakeup_data_source);
+    close(btstack->run_loop->wakeup_data_source.source.fd);
+    close(btstack->run_loop->wakeup_fd);
+    btstack->run_loop->wakeup_fd = -1;
+}
+
 
 static const btstack_run_loop_t btstack_run_loop_posix = {
     &btstack_run_loop_posix_init,
@@ -302,6 +319,8 @@ static const btstack_run_loop_t btstack_run_loop_posix = {
     &btstack_run_loop_posix_execute,
     &btstack_run_loop_posix_dump_timer,
     &btstack_run_loop_posix_get_time_ms,
+    &btstack_run_loop_posix_execute_on_main_thread,
+    &btstack_run_loop_posix_deinit,
 };
 
 /**
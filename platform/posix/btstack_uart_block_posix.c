@@ -51,6 +51,7 @@
 #include <termios.h>  /* POSIX terminal control definitions */
 #include <fcntl.h>    /* File control definitions */
 #include <unistd.h>   /* UNIX standard function definitions */
+#include <sys/uio.h>  /* writev */
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -59,6 +60,9 @@
 #include <IOKit/serial/ioss.h>
 #endif
 
+// max blocks per writev call
+#define BTSTACK_UART_POSIX_IOV_MAX 16
+
 struct btstack_uart_state {
     // uart config
     const btstack_uart_config_t * uart_config;
@@ -70,18 +74,26 @@ struct btstack_uart_state {
     int             write_bytes_len;
     const uint8_t * write_bytes_data;
 
+    // scatter-gather write: remaining blocks, write_bytes_data/len track current block
+    const btstack_uart_block_iov_t * write_blocks;
+    uint16_t        write_blocks_num;
+
     // block read
     uint16_t  read_bytes_len;
     uint8_t * read_bytes_data;
 
+    // bulk read: deliver whatever a single read returned
+    int       read_bulk;
+
     // callbacks
     void (*block_sent)(btstack_state_t *btstack);
     void (*block_received)(btstack_state_t *btstack);
+    void (*data_received)(btstack_state_t *btstack, uint16_t len);
 };
 
 
 static int btstack_uart_posix_init(btstack_state_t *btstack, const btstack_uart_config_t * config){
-    btstack->uart = malloc(sizeof(struct btstack_uart_state));
+    btstack->uart = calloc(1, sizeof(struct btstack_uart_state));
     btstack->uart->uart_config = config;
     btstack->uart_block = btstack_uart_block_posix_instance();
     return 0;
@@ -93,8 +105,23 @@ static void btstack_uart_posix_process_write(btstack_state_t *btstack, btstack_d
 
     uint32_t start = btstack_run_loop_get_time_ms(btstack);
 
-    // write up to write_bytes_len to fd
-    int bytes_written = (int) write(ds->source.fd, btstack->uart->write_bytes_data, btstack->uart->write_bytes_len);
+    int bytes_written;
+    if (btstack->uart->write_blocks_num == 0){
+        // write up to write_bytes_len to fd
+        bytes_written = (int) write(ds->source.fd, btstack->uart->write_bytes_data, btstack->uart->write_bytes_len);
+    } else {
+        // write current and following blocks with a single call
+        struct iovec iov[BTSTACK_UART_POSIX_IOV_MAX];
+        int iovcnt = 1;
+        iov[0].iov_base = (void *) btstack->uart->write_bytes_data;
+        iov[0].iov_len  = btstack->uart->write_bytes_len;
+        while ((iovcnt < BTSTACK_UART_POSIX_IOV_MAX) && (iovcnt <= btstack->uart->write_blocks_num)){
+            iov[iovcnt].iov_base = (void *) btstack->uart->write_blocks[iovcnt - 1].data;
+            iov[iovcnt].iov_len  = btstack->uart->write_blocks[iovcnt - 1].len;
+            iovcnt++;
+        }
+        bytes_written = (int) writev(ds->source.fd, iov, iovcnt);
+    }
     uint32_t end = btstack_run_loop_get_time_ms(btstack);
     if (end - start > 10){
         log_info("write took %u ms", end - start);
@@ -109,6 +136,14 @@ static void btstack_uart_posix_process_write(btstack_state_t *btstack, btstack_d
         return;
     }
 
+    // advance over completely written blocks
+    while ((bytes_written >= btstack->uart->write_bytes_len) && (btstack->uart->write_blocks_num > 0)){
+        bytes_written -= btstack->uart->write_bytes_len;
+        btstack->uart->write_bytes_data = btstack->uart->write_blocks->data;
+        btstack->uart->write_bytes_len  = btstack->uart->write_blocks->len;
+        btstack->uart->write_blocks++;
+        btstack->uart->write_blocks_num--;
+    }
     btstack->uart->write_bytes_data += bytes_written;
     btstack->uart->write_bytes_len  -= bytes_written;
 
@@ -150,6 +185,16 @@ static void btstack_uart_posix_process_read(btstack_state_t *btstack, btstack_da
         return;
     }
 
+    if (btstack->uart->read_bulk){
+        btstack->uart->read_bulk = 0;
+        btstack->uart->read_bytes_len = 0;
+        btstack_run_loop_disable_data_source_callbacks(btstack, ds, DATA_SOURCE_CALLBACK_READ);
+        if (btstack->uart->data_received){
+            btstack->uart->data_received(btstack, (uint16_t) bytes_read);
+        }
+        return;
+    }
+
     btstack->uart->read_bytes_len   -= bytes_read;
     btstack->uart->read_bytes_data  += bytes_read;
     if (btstack->uart->read_bytes_len > 0) return;
@@ -402,6 +447,7 @@ static void btstack_uart_posix_send_block(btstack_state_t *btstack, const uint8_
     // setup async write
     btstack->uart->write_bytes_data = data;
     btstack->uart->write_bytes_len  = size;
+    btstack->uart->write_blocks_num = 0;
 
     // go
     // btstack_uart_posix_process_write(&transport_data_source);
@@ -411,12 +457,34 @@ static void btstack_uart_posix_send_block(btstack_state_t *btstack, const uint8_
 static void btstack_uart_posix_receive_block(btstack_state_t *btstack, uint8_t *buffer, uint16_t len){
     btstack->uart->read_bytes_data = buffer;
     btstack->uart->read_bytes_len = len;
+    btstack->uart->read_bulk = 0;
     btstack_run_loop_enable_data_source_callbacks(btstack, &btstack->uart->transport_data_source, DATA_SOURCE_CALLBACK_READ);
 
     // go
     // btstack_uart_posix_process_read(&transport_data_source);
 }
 
+static void btstack_uart_posix_send_blocks(btstack_state_t *btstack, const btstack_uart_block_iov_t * blocks, uint16_t num_blocks){
+    if (num_blocks == 0) return;
+    // setup async scatter-gather write
+    btstack->uart->write_bytes_data = blocks[0].data;
+    btstack->uart->write_bytes_len  = blocks[0].len;
+    btstack->uart->write_blocks     = &blocks[1];
+    btstack->uart->write_blocks_num = num_blocks - 1;
+    btstack_run_loop_enable_data_source_callbacks(btstack, &btstack->uart->transport_data_source, DATA_SOURCE_CALLBACK_WRITE);
+}
+
+static void btstack_uart_posix_set_data_received(btstack_state_t *btstack, void (*data_handler)(btstack_state_t *btstack, uint16_t len)){
+    btstack->uart->data_received = data_handler;
+}
+
+static void btstack_uart_posix_receive_data(btstack_state_t *btstack, uint8_t *buffer, uint16_t max_len){
+    btstack->uart->read_bytes_data = buffer;
+    btstack->uart->read_bytes_len = max_len;
+    btstack->uart->read_bulk = 1;
+    btstack_run_loop_enable_data_source_callbacks(btstack, &btstack->uart->transport_data_source, DATA_SOURCE_CALLBACK_READ);
+}
+
 // static void btstack_uart_posix_set_sleep(uint8_t sleep){
 // }
 // static void btstack_uart_posix_set_csr_irq_handler( void (*csr_irq_handler)(void)){
@@ -436,6 +504,9 @@ static const btstack_uart_block_t btstack_uart_posix = {
     /* int (*get_supported_sleep_modes); */                           NULL,
     /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    NULL,
     /* void (*set_wakeup_handler)(void (*handler)(void)); */          NULL,
+    /* void (*set_data_received)(void (*handler)(uint16_t len)); */   &btstack_uart_posix_set_data_received,
+    /* void (*receive_data)(uint8_t *buffer, uint16_t max_len); */    &btstack_uart_posix_receive_data,
+    /* void (*send_blocks)(const btstack_uart_block_iov_t *blocks, uint16_t num_blocks); */ &btstack_uart_posix_send_blocks,
 };
 
 const btstack_uart_block_t * btstack_uart_block_posix_instance(void){
@@ -21,16 +21,24 @@ unsigned int __aeabi_uidiv(unsigned int a, unsigned int b)
     return __rt_udiv(b, a);
 }
 
+// NewtonOS kernel calls, mask IRQs and can be nested
+extern void PublicEnterAtomic(void);
+extern void PublicExitAtomic(void);
+
 void hal_cpu_disable_irqs()
 {
+    PublicEnterAtomic();
 }
 
 void hal_cpu_enable_irqs()
 {
+    PublicExitAtomic();
 }
 
+// BluntServer task blocks in its message loop, no need to sleep here
 void hal_cpu_enable_irqs_and_sleep()
 {
+    PublicExitAtomic();
 }
 
 void* calloc (size_t num, size_t size)
@@ -21,6 +21,10 @@ typedef struct btstack_hal_state {
 
 void btstack_hal_init(btstack_state_t *btstack);
 
+void hal_cpu_disable_irqs(void);
+void hal_cpu_enable_irqs(void);
+void hal_cpu_enable_irqs_and_sleep(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -56,6 +56,7 @@
 #include "ble/sm.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
+#include "btstack_instrumentation.h"
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
 #include "gap.h"
@@ -114,10 +115,10 @@ static att_server_t * att_server_for_handle(hci_con_handle_t con_handle){
 
 #ifdef ENABLE_GATT_OVER_CLASSIC
 static att_server_t * att_server_for_l2cap_cid(uint16_t l2cap_cid){
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
     hci_connections_get_iterator(&it);
-    while(btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    while(btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         att_server_t * att_server = &connection->att_server;
         if (att_server->l2cap_cid == l2cap_cid) return att_server;
     }
@@ -127,10 +128,10 @@ static att_server_t * att_server_for_l2cap_cid(uint16_t l2cap_cid){
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static att_server_t * att_server_for_state(att_server_state_t state){
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
     hci_connections_get_iterator(&it);
-    while(btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    while(btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         att_server_t * att_server = &connection->att_server;
         if (att_server->state == state) return att_server;
     }
@@ -474,7 +475,9 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
             att_server = att_server_for_l2cap_cid(channel);
             if (!att_server) break;
 
+            BTSTACK_INSTRUMENTATION_START(classic_pdu_start_us);
             att_server_handle_att_pdu(att_server, packet, size);
+            BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_ATT, att_server->connection.con_handle, size, classic_pdu_start_us);
             break;
 #endif
 
@@ -676,11 +679,13 @@ static void att_server_trigger_send_for_phase(att_server_t * att_server,  att_se
         case ATT_SERVER_RUN_PHASE_2_INDICATIONS:
             client = (btstack_context_callback_registration_t*) att_server->indication_requests;
             btstack_linked_list_remove(&att_server->indication_requests, (btstack_linked_item_t *) client);
+            BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_EMITTED(BTSTACK_INSTRUMENTATION_LAYER_ATT, att_server->connection.con_handle);
             client->callback(client->context);
             break;
        case ATT_SERVER_RUN_PHASE_3_NOTIFICATIONS:
             client = (btstack_context_callback_registration_t*) att_server->notification_requests;
             btstack_linked_list_remove(&att_server->notification_requests, (btstack_linked_item_t *) client);
+            BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_EMITTED(BTSTACK_INSTRUMENTATION_LAYER_ATT, att_server->connection.con_handle);
             client->callback(client->context);
             break;
     }
@@ -697,10 +702,10 @@ static void att_server_handle_can_send_now(void){
         att_server_run_phase_t phase = (att_server_run_phase_t) phase_index;
         hci_con_handle_t skip_connections_until = att_server_last_can_send_now;
         while (true){
-            btstack_linked_list_iterator_t it;
+            btstack_dlist_iterator_t it;
             hci_connections_get_iterator(&it);
-            while(btstack_linked_list_iterator_has_next(&it)){
-                hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+            while(btstack_dlist_iterator_has_next(&it)){
+                hci_connection_t * connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
                 att_server_t * att_server = &connection->att_server;
 
                 int data_ready = att_server_data_ready_for_phase(att_server, phase);
@@ -832,7 +837,9 @@ static void att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *pa
             att_server = att_server_for_handle(handle);
             if (!att_server) break;
 
+            BTSTACK_INSTRUMENTATION_START(pdu_start_us);
             att_server_handle_att_pdu(att_server, packet, size);
+            BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_ATT, handle, size, pdu_start_us);
             break;
     }
 }
@@ -1146,6 +1153,7 @@ int att_server_request_to_send_notification(btstack_context_callback_registratio
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
     bool added = btstack_linked_list_add_tail(&att_server->notification_requests, (btstack_linked_item_t*) callback_registration);
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(BTSTACK_INSTRUMENTATION_LAYER_ATT, con_handle);
     att_server_request_can_send_now(att_server);
     if (added){
         return ERROR_CODE_SUCCESS;
@@ -1158,6 +1166,7 @@ int att_server_request_to_send_indication(btstack_context_callback_registration_
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
     bool added = btstack_linked_list_add_tail(&att_server->indication_requests, (btstack_linked_item_t*) callback_registration);
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(BTSTACK_INSTRUMENTATION_LAYER_ATT, con_handle);
     att_server_request_can_send_now(att_server);
     if (added){
         return ERROR_CODE_SUCCESS;
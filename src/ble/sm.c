@@ -1899,13 +1899,13 @@ static bool sm_run_rau(void){
 
 // CSRK Lookup
 static bool sm_run_csrk(void){
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
 
     // -- if csrk lookup ready, find connection that require csrk lookup
     if (sm_address_resolution_idle()){
         hci_connections_get_iterator(&it);
-        while(btstack_linked_list_iterator_has_next(&it)){
-            hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        while(btstack_dlist_iterator_has_next(&it)){
+            hci_connection_t * hci_connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
             sm_connection_t  * sm_connection  = &hci_connection->sm_connection;
             if (sm_connection->sm_irk_lookup_state == IRK_LOOKUP_W4_READY){
                 // and start lookup
@@ -1993,10 +1993,10 @@ static bool sm_run_oob(void){
 
 // handle basic actions that don't requires the full context
 static bool sm_run_basic(void){
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
     hci_connections_get_iterator(&it);
-    while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * hci_connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         sm_connection_t  * sm_connection = &hci_connection->sm_connection;
         switch(sm_connection->sm_engine_state){
             // responder side
@@ -2027,10 +2027,10 @@ static bool sm_run_basic(void){
 
 static void sm_run_activate_connection(void){
     // Find connections that requires setup context and make active if no other is locked
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
     hci_connections_get_iterator(&it);
-    while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * hci_connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         sm_connection_t  * sm_connection = &hci_connection->sm_connection;
         // - if no connection locked and we're ready/waiting for setup context, fetch it and start
         int done = 1;
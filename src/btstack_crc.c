@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_crc.c"
+
+/*
+ *  btstack_crc.c
+ *
+ *  CRC-16 and CRC-8 calculation for H5, L2CAP ERTM and RFCOMM
+ *
+ *  All CRCs are reflected (LSB first). By default, one table lookup per byte is used with the tables in flash.
+ *  With ENABLE_CRC_SLICING_BY_4 or ENABLE_CRC_SLICING_BY_8, 4 or 8 tables per CRC are generated in RAM by
+ *  btstack_crc_init and 4 or 8 bytes are processed per step.
+ *  With ENABLE_CRC_PCLMUL on x86_64, blocks of 16 bytes are folded with carry-less multiplication if the CPU
+ *  supports it, and only the final 16 bytes and the tail are processed via tables.
+ */
+
+#include "btstack_config.h"
+#include "btstack_crc.h"
+
+#include <stdint.h>
+
+#if defined(ENABLE_CRC_SLICING_BY_8)
+#define BTSTACK_CRC_SLICES 8
+#elif defined(ENABLE_CRC_SLICING_BY_4)
+#define BTSTACK_CRC_SLICES 4
+#endif
+
+#if defined(ENABLE_CRC_PCLMUL) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BTSTACK_CRC_PCLMUL
+#include <wmmintrin.h>
+#endif
+
+// reflected generator polynoms
+#define CRC16_POLYNOM_REFLECTED         0xa001      // D^16 + D^15 + D^2 + 1
+#define CRC16_CCITT_POLYNOM_REFLECTED   0x8408      // D^16 + D^12 + D^5 + 1
+#define CRC8_POLYNOM_REFLECTED          0xe0        // D^8 + D^2 + D + 1
+
+#ifdef BTSTACK_CRC_SLICES
+
+typedef struct {
+    uint16_t polynom;
+    uint8_t  ready;
+    uint16_t table[BTSTACK_CRC_SLICES][256];
+} btstack_crc_slicing_t;
+
+static btstack_crc_slicing_t btstack_crc16_slicing       = { CRC16_POLYNOM_REFLECTED, 0, { { 0 } } };
+static btstack_crc_slicing_t btstack_crc16_ccitt_slicing = { CRC16_CCITT_POLYNOM_REFLECTED, 0, { { 0 } } };
+static btstack_crc_slicing_t btstack_crc8_slicing        = { CRC8_POLYNOM_REFLECTED, 0, { { 0 } } };
+
+static void btstack_crc_slicing_init(btstack_crc_slicing_t * slicing){
+    int i;
+    int bit;
+    int slice;
+    for (i = 0; i < 256; i++){
+        uint16_t crc = (uint16_t) i;
+        for (bit = 0; bit < 8; bit++){
+            crc = (crc & 1) ? ((crc >> 1) ^ slicing->polynom) : (crc >> 1);
+        }
+        slicing->table[0][i] = crc;
+    }
+    // table[n][i] = crc of byte i followed by n zero bytes
+    for (slice = 1; slice < BTSTACK_CRC_SLICES; slice++){
+        for (i = 0; i < 256; i++){
+            uint16_t crc = slicing->table[slice - 1][i];
+            slicing->table[slice][i] = (crc >> 8) ^ slicing->table[0][crc & 0xff];
+        }
+    }
+    slicing->ready = 1;
+}
+
+static inline uint32_t btstack_crc_read_32(const uint8_t * data){
+    return ((uint32_t) data[0]) | (((uint32_t) data[1]) << 8) | (((uint32_t) data[2]) << 16) | (((uint32_t) data[3]) << 24);
+}
+
+static uint16_t btstack_crc_slicing_update(btstack_crc_slicing_t * slicing, uint16_t crc, const uint8_t * data, uint16_t len){
+    if (!slicing->ready){
+        btstack_crc_slicing_init(slicing);
+    }
+    const uint16_t (*table)[256] = (const uint16_t (*)[256]) slicing->table;
+    while (len >= BTSTACK_CRC_SLICES){
+        uint32_t word = crc ^ btstack_crc_read_32(data);
+#if BTSTACK_CRC_SLICES == 8
+        uint32_t word2 = btstack_crc_read_32(&data[4]);
+        crc = table[7][word & 0xff]  ^ table[6][(word >> 8) & 0xff]  ^ table[5][(word >> 16) & 0xff]  ^ table[4][word >> 24]
+            ^ table[3][word2 & 0xff] ^ table[2][(word2 >> 8) & 0xff] ^ table[1][(word2 >> 16) & 0xff] ^ table[0][word2 >> 24];
+#else
+        crc = table[3][word & 0xff]  ^ table[2][(word >> 8) & 0xff]  ^ table[1][(word >> 16) & 0xff]  ^ table[0][word >> 24];
+#endif
+        data += BTSTACK_CRC_SLICES;
+        len  -= BTSTACK_CRC_SLICES;
+    }
+    while (len--){
+        crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xff];
+    }
+    return crc;
+}
+
+#else
+
+/*
+ * CRC lookup table for generator polynom D^16 + D^15 + D^2 + 1
+ */
+static const uint16_t crc16_table[256] = {
+    0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241, 0xc601, 0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1, 0xc481, 0x0440,
+    0xcc01, 0x0cc0, 0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40, 0x0a00, 0xcac1, 0xcb81, 0x0b40, 0xc901, 0x09c0, 0x0880, 0xc841,
+    0xd801, 0x18c0, 0x1980, 0xd941, 0x1b00, 0xdbc1, 0xda81, 0x1a40, 0x1e00, 0xdec1, 0xdf81, 0x1f40, 0xdd01, 0x1dc0, 0x1c80, 0xdc41,
+    0x1400, 0xd4c1, 0xd581, 0x1540, 0xd701, 0x17c0, 0x1680, 0xd641, 0xd201, 0x12c0, 0x1380, 0xd341, 0x1100, 0xd1c1, 0xd081, 0x1040,
+    0xf001, 0x30c0, 0x3180, 0xf141, 0x3300, 0xf3c1, 0xf281, 0x3240, 0x3600, 0xf6c1, 0xf781, 0x3740, 0xf501, 0x35c0, 0x3480, 0xf441,
+    0x3c00, 0xfcc1, 0xfd81, 0x3d40, 0xff01, 0x3fc0, 0x3e80, 0xfe41, 0xfa01, 0x3ac0, 0x3b80, 0xfb41, 0x3900, 0xf9c1, 0xf881, 0x3840,
+    0x2800, 0xe8c1, 0xe981, 0x2940, 0xeb01, 0x2bc0, 0x2a80, 0xea41, 0xee01, 0x2ec0, 0x2f80, 0xef41, 0x2d00, 0xedc1, 0xec81, 0x2c40,
+    0xe401, 0x24c0, 0x2580, 0xe541, 0x2700, 0xe7c1, 0xe681, 0x2640, 0x2200, 0xe2c1, 0xe381, 0x2340, 0xe101, 0x21c0, 0x2080, 0xe041,
+    0xa001, 0x60c0, 0x6180, 0xa141, 0x6300, 0xa3c1, 0xa281, 0x6240, 0x6600, 0xa6c1, 0xa781, 0x6740, 0xa501, 0x65c0, 0x6480, 0xa441,
+    0x6c00, 0xacc1, 0xad81, 0x6d40, 0xaf01, 0x6fc0, 0x6e80, 0xae41, 0xaa01, 0x6ac0, 0x6b80, 0xab41, 0x6900, 0xa9c1, 0xa881, 0x6840,
+    0x7800, 0xb8c1, 0xb981, 0x7940, 0xbb01, 0x7bc0, 0x7a80, 0xba41, 0xbe01, 0x7ec0, 0x7f80, 0xbf41, 0x7d00, 0xbdc1, 0xbc81, 0x7c40,
+    0xb401, 0x74c0, 0x7580, 0xb541, 0x7700, 0xb7c1, 0xb681, 0x7640, 0x7200, 0xb2c1, 0xb381, 0x7340, 0xb101, 0x71c0, 0x7080, 0xb041,
+    0x5000, 0x90c1, 0x9181, 0x5140, 0x9301, 0x53c0, 0x5280, 0x9241, 0x9601, 0x56c0, 0x5780, 0x9741, 0x5500, 0x95c1, 0x9481, 0x5440,
+    0x9c01, 0x5cc0, 0x5d80, 0x9d41, 0x5f00, 0x9fc1, 0x9e81, 0x5e40, 0x5a00, 0x9ac1, 0x9b81, 0x5b40, 0x9901, 0x59c0, 0x5880, 0x9841,
+    0x8801, 0x48c0, 0x4980, 0x8941, 0x4b00, 0x8bc1, 0x8a81, 0x4a40, 0x4e00, 0x8ec1, 0x8f81, 0x4f40, 0x8d01, 0x4dc0, 0x4c80, 0x8c41,
+    0x4400, 0x84c1, 0x8581, 0x4540, 0x8701, 0x47c0, 0x4680, 0x8641, 0x8201, 0x42c0, 0x4380, 0x8341, 0x4100, 0x81c1, 0x8081, 0x4040, 
+};
+
+/*
+ * CRC16-CCITT - compromise: use 32 byte table - 512 byte table would be faster, but that's too large
+ */
+static const uint16_t crc16_ccitt_table[16] = {
+    0x0000, 0x1081, 0x2102, 0x3183,
+    0x4204, 0x5285, 0x6306, 0x7387,
+    0x8408, 0x9489, 0xa50a, 0xb58b,
+    0xc60c, 0xd68d, 0xe70e, 0xf78f
+};
+
+/*
+ * CRC (reversed crc) lookup table as calculated by the table generator in ETSI TS 101 369 V6.3.0.
+ */
+static const uint8_t crc8_table[256] = {    /* reversed, 8-bit, poly=0x07 */
+    0x00, 0x91, 0xE3, 0x72, 0x07, 0x96, 0xE4, 0x75, 0x0E, 0x9F, 0xED, 0x7C, 0x09, 0x98, 0xEA, 0x7B,
+    0x1C, 0x8D, 0xFF, 0x6E, 0x1B, 0x8A, 0xF8, 0x69, 0x12, 0x83, 0xF1, 0x60, 0x15, 0x84, 0xF6, 0x67,
+    0x38, 0xA9, 0xDB, 0x4A, 0x3F, 0xAE, 0xDC, 0x4D, 0x36, 0xA7, 0xD5, 0x44, 0x31, 0xA0, 0xD2, 0x43,
+    0x24, 0xB5, 0xC7, 0x56, 0x23, 0xB2, 0xC0, 0x51, 0x2A, 0xBB, 0xC9, 0x58, 0x2D, 0xBC, 0xCE, 0x5F,
+    0x70, 0xE1, 0x93, 0x02, 0x77, 0xE6, 0x94, 0x05, 0x7E, 0xEF, 0x9D, 0x0C, 0x79, 0xE8, 0x9A, 0x0B,
+    0x6C, 0xFD, 0x8F, 0x1E, 0x6B, 0xFA, 0x88, 0x19, 0x62, 0xF3, 0x81, 0x10, 0x65, 0xF4, 0x86, 0x17,
+    0x48, 0xD9, 0xAB, 0x3A, 0x4F, 0xDE, 0xAC, 0x3D, 0x46, 0xD7, 0xA5, 0x34, 0x41, 0xD0, 0xA2, 0x33,
+    0x54, 0xC5, 0xB7, 0x26, 0x53, 0xC2, 0xB0, 0x21, 0x5A, 0xCB, 0xB9, 0x28, 0x5D, 0xCC, 0xBE, 0x2F,
+    0xE0, 0x71, 0x03, 0x92, 0xE7, 0x76, 0x04, 0x95, 0xEE, 0x7F, 0x0D, 0x9C, 0xE9, 0x78, 0x0A, 0x9B,
+    0xFC, 0x6D, 0x1F, 0x8E, 0xFB, 0x6A, 0x18, 0x89, 0xF2, 0x63, 0x11, 0x80, 0xF5, 0x64, 0x16, 0x87,
+    0xD8, 0x49, 0x3B, 0xAA, 0xDF, 0x4E, 0x3C, 0xAD, 0xD6, 0x47, 0x35, 0xA4, 0xD1, 0x40, 0x32, 0xA3,
+    0xC4, 0x55, 0x27, 0xB6, 0xC3, 0x52, 0x20, 0xB1, 0xCA, 0x5B, 0x29, 0xB8, 0xCD, 0x5C, 0x2E, 0xBF,
+    0x90, 0x01, 0x73, 0xE2, 0x97, 0x06, 0x74, 0xE5, 0x9E, 0x0F, 0x7D, 0xEC, 0x99, 0x08, 0x7A, 0xEB,
+    0x8C, 0x1D, 0x6F, 0xFE, 0x8B, 0x1A, 0x68, 0xF9, 0x82, 0x13, 0x61, 0xF0, 0x85, 0x14, 0x66, 0xF7,
+    0xA8, 0x39, 0x4B, 0xDA, 0xAF, 0x3E, 0x4C, 0xDD, 0xA6, 0x37, 0x45, 0xD4, 0xA1, 0x30, 0x42, 0xD3,
+    0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1, 0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF
+};
+
+#endif
+
+static uint16_t btstack_crc16_update_bytes(uint16_t crc, const uint8_t * data, uint16_t len){
+#ifdef BTSTACK_CRC_SLICES
+    return btstack_crc_slicing_update(&btstack_crc16_slicing, crc, data, len);
+#else
+    while (len--){
+        crc = (crc >> 8) ^ crc16_table[(crc ^ *data++) & 0xff];
+    }
+    return crc;
+#endif
+}
+
+static uint16_t btstack_crc16_ccitt_update_bytes(uint16_t crc, const uint8_t * data, uint16_t len){
+#ifdef BTSTACK_CRC_SLICES
+    return btstack_crc_slicing_update(&btstack_crc16_ccitt_slicing, crc, data, len);
+#else
+    while (len--){
+        uint8_t ch = *data++;
+        crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ ch) & 0x000f];
+        crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ (ch >> 4)) & 0x000f];
+    }
+    return crc;
+#endif
+}
+
+static uint8_t btstack_crc8_update_bytes(uint8_t crc, const uint8_t * data, uint16_t len){
+#ifdef BTSTACK_CRC_SLICES
+    return (uint8_t) btstack_crc_slicing_update(&btstack_crc8_slicing, crc, data, len);
+#else
+    while (len--){
+        crc = crc8_table[crc ^ *data++];
+    }
+    return crc;
+#endif
+}
+
+#ifdef BTSTACK_CRC_PCLMUL
+
+// minimal length for folding: first block and at least one more
+#define BTSTACK_CRC_PCLMUL_MIN_LEN 32
+
+/*
+ * Folding in the reflected domain: bit i of the 128-bit accumulator is the coefficient of x^(127-i).
+ * With accumulator A = lo * x^64 + hi, A * x^128 + next = lo * x^192 + hi * x^128 + next (mod P).
+ * The carry-less product of two reflected 64-bit values is shifted by one, so the constants
+ * are x^191 mod P and x^127 mod P. The folded accumulator has the same CRC as the consumed data.
+ */
+typedef struct {
+    uint16_t polynom;   // normal form without leading term
+    uint8_t  width;
+    uint8_t  ready;
+    uint64_t k_lo;      // x^191 mod P
+    uint64_t k_hi;      // x^127 mod P
+} btstack_crc_fold_t;
+
+static btstack_crc_fold_t btstack_crc16_fold       = { 0x8005, 16, 0, 0, 0 };
+static btstack_crc_fold_t btstack_crc16_ccitt_fold = { 0x1021, 16, 0, 0, 0 };
+static btstack_crc_fold_t btstack_crc8_fold        = { 0x07,    8, 0, 0, 0 };
+
+static int btstack_crc_pclmul_supported = -1;
+
+static uint64_t btstack_crc_fold_constant(const btstack_crc_fold_t * fold, int exponent){
+    uint32_t top = 1u << fold->width;
+    uint32_t remainder = 1;
+    int i;
+    for (i = 0; i < exponent; i++){
+        remainder <<= 1;
+        if (remainder & top){
+            remainder ^= top | fold->polynom;
+        }
+    }
+    uint64_t constant = 0;
+    for (i = 0; i < fold->width; i++){
+        if (remainder & (1u << i)){
+            constant |= 1ull << (63 - i);
+        }
+    }
+    return constant;
+}
+
+static void btstack_crc_fold_init(btstack_crc_fold_t * fold){
+    fold->k_lo = btstack_crc_fold_constant(fold, 191);
+    fold->k_hi = btstack_crc_fold_constant(fold, 127);
+    fold->ready = 1;
+}
+
+static int btstack_crc_pclmul_available(void){
+    if (btstack_crc_pclmul_supported < 0){
+        __builtin_cpu_init();
+        btstack_crc_pclmul_supported = __builtin_cpu_supports("pclmul") ? 1 : 0;
+    }
+    return btstack_crc_pclmul_supported;
+}
+
+// fold len (multiple of 16, >= 32) bytes into 16 bytes, crc is applied to the first bytes
+__attribute__((target("pclmul,sse2")))
+static void btstack_crc_pclmul_fold(btstack_crc_fold_t * fold, uint16_t crc, const uint8_t * data, uint16_t len, uint8_t * result){
+    if (!fold->ready){
+        btstack_crc_fold_init(fold);
+    }
+    const __m128i constants = _mm_set_epi64x((long long) fold->k_hi, (long long) fold->k_lo);
+    __m128i accumulator = _mm_xor_si128(_mm_loadu_si128((const __m128i *) data), _mm_cvtsi32_si128(crc));
+    data += 16;
+    len  -= 16;
+    while (len){
+        __m128i lo = _mm_clmulepi64_si128(accumulator, constants, 0x00);
+        __m128i hi = _mm_clmulepi64_si128(accumulator, constants, 0x11);
+        accumulator = _mm_xor_si128(_mm_xor_si128(lo, hi), _mm_loadu_si128((const __m128i *) data));
+        data += 16;
+        len  -= 16;
+    }
+    _mm_storeu_si128((__m128i *) result, accumulator);
+}
+
+#endif
+
+// tables are only generated once, so further calls, e.g. by hci_init of other instances, don't modify them
+void btstack_crc_init(void){
+#ifdef BTSTACK_CRC_SLICES
+    if (!btstack_crc8_slicing.ready){
+        btstack_crc_slicing_init(&btstack_crc16_slicing);
+        btstack_crc_slicing_init(&btstack_crc16_ccitt_slicing);
+        btstack_crc_slicing_init(&btstack_crc8_slicing);
+    }
+#endif
+#ifdef BTSTACK_CRC_PCLMUL
+    if (!btstack_crc8_fold.ready){
+        btstack_crc_fold_init(&btstack_crc16_fold);
+        btstack_crc_fold_init(&btstack_crc16_ccitt_fold);
+        btstack_crc_fold_init(&btstack_crc8_fold);
+    }
+    (void) btstack_crc_pclmul_available();
+#endif
+}
+
+uint16_t btstack_crc16_update(uint16_t crc, const uint8_t * data, uint16_t len){
+#ifdef BTSTACK_CRC_PCLMUL
+    if (len >= BTSTACK_CRC_PCLMUL_MIN_LEN && btstack_crc_pclmul_available()){
+        uint8_t folded[16];
+        uint16_t fold_len = len & ~0x0f;
+        btstack_crc_pclmul_fold(&btstack_crc16_fold, crc, data, fold_len, folded);
+        crc  = btstack_crc16_update_bytes(0, folded, sizeof(folded));
+        data += fold_len;
+        len  -= fold_len;
+    }
+#endif
+    return btstack_crc16_update_bytes(crc, data, len);
+}
+
+uint16_t btstack_crc16_ccitt_update(uint16_t crc, const uint8_t * data, uint16_t len){
+#ifdef BTSTACK_CRC_PCLMUL
+    if (len >= BTSTACK_CRC_PCLMUL_MIN_LEN && btstack_crc_pclmul_available()){
+        uint8_t folded[16];
+        uint16_t fold_len = len & ~0x0f;
+        btstack_crc_pclmul_fold(&btstack_crc16_ccitt_fold, crc, data, fold_len, folded);
+        crc  = btstack_crc16_ccitt_update_bytes(0, folded, sizeof(folded));
+        data += fold_len;
+        len  -= fold_len;
+    }
+#endif
+    return btstack_crc16_ccitt_update_bytes(crc, data, len);
+}
+
+uint8_t btstack_crc8_update(uint8_t crc, const uint8_t * data, uint16_t len){
+#ifdef BTSTACK_CRC_PCLMUL
+    if (len >= BTSTACK_CRC_PCLMUL_MIN_LEN && btstack_crc_pclmul_available()){
+        uint8_t folded[16];
+        uint16_t fold_len = len & ~0x0f;
+        btstack_crc_pclmul_fold(&btstack_crc8_fold, crc, data, fold_len, folded);
+        crc  = btstack_crc8_update_bytes(0, folded, sizeof(folded));
+        data += fold_len;
+        len  -= fold_len;
+    }
+#endif
+    return btstack_crc8_update_bytes(crc, data, len);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_crc.h
+ *
+ *  CRC-16 and CRC-8 calculation for H5, L2CAP ERTM and RFCOMM
+ */
+
+#ifndef BTSTACK_CRC_H
+#define BTSTACK_CRC_H
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/* API_START */
+
+/**
+ * @brief Generate CRC tables in RAM and detect CPU support for ENABLE_CRC_SLICING_BY_4/8 and ENABLE_CRC_PCLMUL
+ * @note Called by hci_init. Without it, tables are generated on first use, which is not thread-safe
+ */
+void btstack_crc_init(void);
+
+/**
+ * @brief Update CRC-16 with generator polynom D^16 + D^15 + D^2 + 1 (reflected), used for L2CAP ERTM FCS with initial value 0
+ * @param crc current value
+ * @param data
+ * @param len
+ * @return updated crc
+ */
+uint16_t btstack_crc16_update(uint16_t crc, const uint8_t * data, uint16_t len);
+
+/**
+ * @brief Update CRC-16-CCITT with generator polynom D^16 + D^12 + D^5 + 1 (reflected), used for H5 Data Integrity Check with initial value 0xffff
+ * @param crc current value
+ * @param data
+ * @param len
+ * @return updated crc
+ */
+uint16_t btstack_crc16_ccitt_update(uint16_t crc, const uint8_t * data, uint16_t len);
+
+/**
+ * @brief Update CRC-8 with generator polynom D^8 + D^2 + D + 1 (reflected) from ETSI TS 101 369, used for RFCOMM FCS with initial value 0xff
+ * @param crc current value
+ * @param data
+ * @param len
+ * @return updated crc
+ */
+uint8_t btstack_crc8_update(uint8_t crc, const uint8_t * data, uint16_t len);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_CRC_H
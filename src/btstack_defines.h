@@ -59,10 +59,18 @@
 // packet handler
 typedef void (*btstack_packet_handler_t) (btstack_state_t *btstack, uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 
+// event subscription: one bit per event code, and one bit per subevent code of HCI_EVENT_LE_META
+typedef struct {
+    uint8_t events[32];
+    uint8_t le_meta_subevents[32];
+} btstack_event_mask_t;
+
 // packet callback supporting multiple registrations
 typedef struct {
     btstack_linked_item_t    item;
     btstack_packet_handler_t callback;
+    // optional event subscription, NULL for all events
+    const btstack_event_mask_t * event_mask;
 } btstack_packet_callback_registration_t;
 
 // context callback supporting multiple registrations
@@ -655,6 +663,24 @@ typedef uint8_t sm_key_t[16];
  */
 #define BTSTACK_EVENT_DISCOVERABLE_ENABLED                 0x66
 
+/**
+ * @brief Periodic per-layer statistics with ENABLE_BTSTACK_INSTRUMENTATION, see btstack_instrumentation.h, times in us
+ * @format 12444444444
+ * @param layer
+ * @param id
+ * @param num_packets
+ * @param num_bytes
+ * @param handler_time_total
+ * @param handler_time_max
+ * @param num_queued
+ * @param queueing_delay_total
+ * @param queueing_delay_max
+ * @param num_can_send_now
+ * @param can_send_now_wait_total
+ * @param can_send_now_wait_max
+ */
+#define BTSTACK_EVENT_INSTRUMENTATION_STATISTICS           0x6A
+
 // Daemon Events
 
 /**
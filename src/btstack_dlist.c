@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_dlist.c"
+
+/*
+ *  btstack_dlist.c
+ *
+ *  Items not in a list have prev and next set to NULL. As only the first item of a list has no predecessor,
+ *  this allows to check if an item is in the list in O(1).
+ */
+
+#include "btstack_dlist.h"
+#include "btstack_debug.h"
+
+#include <stddef.h>
+
+static bool btstack_dlist_contains(const btstack_dlist_t * list, const btstack_dlist_item_t * item){
+    return (item->prev != NULL) || (list->first == item);
+}
+
+bool btstack_dlist_empty(const btstack_dlist_t * list){
+    return list->first == NULL;
+}
+
+bool btstack_dlist_insert_after(btstack_dlist_t * list, btstack_dlist_item_t * position, btstack_dlist_item_t * item){
+    if (btstack_dlist_contains(list, item)) return false;
+    item->prev = position;
+    if (position == NULL){
+        item->next  = list->first;
+        list->first = item;
+    } else {
+        item->next = position->next;
+        position->next = item;
+    }
+    if (item->next == NULL){
+        list->last = item;
+    } else {
+        item->next->prev = item;
+    }
+    return true;
+}
+
+bool btstack_dlist_add(btstack_dlist_t * list, btstack_dlist_item_t * item){
+    return btstack_dlist_insert_after(list, NULL, item);
+}
+
+bool btstack_dlist_add_tail(btstack_dlist_t * list, btstack_dlist_item_t * item){
+    return btstack_dlist_insert_after(list, list->last, item);
+}
+
+bool btstack_dlist_remove(btstack_dlist_t * list, btstack_dlist_item_t * item){
+    if (item == NULL) return false;
+    if (!btstack_dlist_contains(list, item)) return false;
+    if (item->prev == NULL){
+        list->first = item->next;
+    } else {
+        item->prev->next = item->next;
+    }
+    if (item->next == NULL){
+        list->last = item->prev;
+    } else {
+        item->next->prev = item->prev;
+    }
+    item->next = NULL;
+    item->prev = NULL;
+    return true;
+}
+
+btstack_dlist_item_t * btstack_dlist_pop(btstack_dlist_t * list){
+    btstack_dlist_item_t * item = list->first;
+    if (item == NULL) return NULL;
+    (void) btstack_dlist_remove(list, item);
+    return item;
+}
+
+btstack_dlist_item_t * btstack_dlist_get_first_item(const btstack_dlist_t * list){
+    return list->first;
+}
+
+btstack_dlist_item_t * btstack_dlist_get_last_item(const btstack_dlist_t * list){
+    return list->last;
+}
+
+int btstack_dlist_count(const btstack_dlist_t * list){
+    int counter = 0;
+    const btstack_dlist_item_t * it;
+    for (it = list->first; it != NULL; it = it->next){
+        counter++;
+    }
+    return counter;
+}
+
+
+//
+// Doubly Linked List Iterator implementation
+//
+
+// get item following current one, if current item was removed, continue after its former predecessor
+static btstack_dlist_item_t * btstack_dlist_iterator_get_following(btstack_dlist_iterator_t * it){
+    if (!it->advance_on_next){
+        return it->list->first;
+    }
+    if (btstack_dlist_contains(it->list, it->curr)){
+        return it->curr->next;
+    }
+    return (it->prev != NULL) ? it->prev->next : it->list->first;
+}
+
+void btstack_dlist_iterator_init(btstack_dlist_iterator_t * it, btstack_dlist_t * list){
+    it->list = list;
+    it->prev = NULL;
+    it->curr = NULL;
+    it->advance_on_next = false;
+}
+
+bool btstack_dlist_iterator_has_next(btstack_dlist_iterator_t * it){
+    return btstack_dlist_iterator_get_following(it) != NULL;
+}
+
+btstack_dlist_item_t * btstack_dlist_iterator_next(btstack_dlist_iterator_t * it){
+    btstack_dlist_item_t * item = btstack_dlist_iterator_get_following(it);
+    it->curr = item;
+    it->prev = (item != NULL) ? item->prev : NULL;
+    it->advance_on_next = true;
+    return item;
+}
+
+void btstack_dlist_iterator_remove(btstack_dlist_iterator_t * it){
+    if (!btstack_dlist_contains(it->list, it->curr)){
+        log_error("current item %p not in list", it->curr);
+        return;
+    }
+    it->prev = it->curr->prev;
+    (void) btstack_dlist_remove(it->list, it->curr);
+}
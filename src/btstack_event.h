@@ -1079,6 +1079,115 @@ static inline uint8_t btstack_event_discoverable_enabled_get_discoverable(const
     return event[2];
 }
 
+/**
+ * @brief Get field layer from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return layer
+ * @note: btstack_type 1
+ */
+static inline uint8_t btstack_event_instrumentation_statistics_get_layer(const uint8_t * event){
+    return event[2];
+}
+/**
+ * @brief Get field id from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return id
+ * @note: btstack_type 2
+ */
+static inline uint16_t btstack_event_instrumentation_statistics_get_id(const uint8_t * event){
+    return little_endian_read_16(event, 3);
+}
+/**
+ * @brief Get field num_packets from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return num_packets
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_num_packets(const uint8_t * event){
+    return little_endian_read_32(event, 5);
+}
+/**
+ * @brief Get field num_bytes from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return num_bytes
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_num_bytes(const uint8_t * event){
+    return little_endian_read_32(event, 9);
+}
+/**
+ * @brief Get field handler_time_total from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return handler_time_total
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_handler_time_total(const uint8_t * event){
+    return little_endian_read_32(event, 13);
+}
+/**
+ * @brief Get field handler_time_max from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return handler_time_max
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_handler_time_max(const uint8_t * event){
+    return little_endian_read_32(event, 17);
+}
+/**
+ * @brief Get field num_queued from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return num_queued
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_num_queued(const uint8_t * event){
+    return little_endian_read_32(event, 21);
+}
+/**
+ * @brief Get field queueing_delay_total from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return queueing_delay_total
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_queueing_delay_total(const uint8_t * event){
+    return little_endian_read_32(event, 25);
+}
+/**
+ * @brief Get field queueing_delay_max from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return queueing_delay_max
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_queueing_delay_max(const uint8_t * event){
+    return little_endian_read_32(event, 29);
+}
+/**
+ * @brief Get field num_can_send_now from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return num_can_send_now
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_num_can_send_now(const uint8_t * event){
+    return little_endian_read_32(event, 33);
+}
+/**
+ * @brief Get field can_send_now_wait_total from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return can_send_now_wait_total
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_can_send_now_wait_total(const uint8_t * event){
+    return little_endian_read_32(event, 37);
+}
+/**
+ * @brief Get field can_send_now_wait_max from event BTSTACK_EVENT_INSTRUMENTATION_STATISTICS
+ * @param event packet
+ * @return can_send_now_wait_max
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_instrumentation_statistics_get_can_send_now_wait_max(const uint8_t * event){
+    return little_endian_read_32(event, 41);
+}
+
 /**
  * @brief Get field active from event HCI_EVENT_TRANSPORT_SLEEP_MODE
  * @param event packet
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_instrumentation.c"
+
+/*
+ *  btstack_instrumentation.c
+ *
+ *  Per-layer latency and throughput counters, see btstack_instrumentation.h
+ *
+ *  Counters are process-wide like hci_dump. Channels are kept in a small table with linear search,
+ *  the first BTSTACK_INSTRUMENTATION_NUM_CHANNELS (layer, id) pairs seen are tracked.
+ */
+
+// enable POSIX functions (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809
+
+#include "btstack_config.h"
+
+#include "btstack_instrumentation.h"
+
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+
+#include <string.h>
+
+#ifdef HAVE_POSIX_TIME
+#include <time.h>
+#endif
+
+typedef struct {
+    uint8_t  in_use;
+    uint8_t  layer;
+    uint16_t id;
+    // can send now requested but not emitted yet
+    uint8_t  can_send_now_pending;
+    uint32_t can_send_now_requested_us;
+    btstack_instrumentation_counters_t counters;
+} btstack_instrumentation_channel_t;
+
+static uint32_t (*instrumentation_get_time_us)(void);
+
+static btstack_instrumentation_counters_t instrumentation_layers[BTSTACK_INSTRUMENTATION_NUM_LAYERS];
+static btstack_instrumentation_channel_t  instrumentation_channels[BTSTACK_INSTRUMENTATION_NUM_CHANNELS];
+
+static btstack_timer_source_t instrumentation_timer;
+static uint32_t               instrumentation_period_ms;
+
+#ifdef HAVE_POSIX_TIME
+static uint32_t btstack_instrumentation_posix_time_us(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((uint64_t) now.tv_sec * 1000000u + (uint64_t) now.tv_nsec / 1000u);
+}
+#endif
+
+void btstack_instrumentation_init(uint32_t (*get_time_us)(void)){
+    instrumentation_get_time_us = get_time_us;
+#ifdef HAVE_POSIX_TIME
+    if (instrumentation_get_time_us == NULL){
+        instrumentation_get_time_us = &btstack_instrumentation_posix_time_us;
+    }
+#endif
+    btstack_instrumentation_reset();
+}
+
+void btstack_instrumentation_reset(void){
+    memset(instrumentation_layers,   0, sizeof(instrumentation_layers));
+    memset(instrumentation_channels, 0, sizeof(instrumentation_channels));
+}
+
+uint32_t btstack_instrumentation_get_time_us(void){
+    if (instrumentation_get_time_us == NULL) return 0;
+    return (*instrumentation_get_time_us)();
+}
+
+static btstack_instrumentation_channel_t * btstack_instrumentation_channel_for_id(btstack_instrumentation_layer_t layer, uint16_t id, bool create){
+    btstack_instrumentation_channel_t * free_channel = NULL;
+    int i;
+    for (i = 0; i < BTSTACK_INSTRUMENTATION_NUM_CHANNELS; i++){
+        btstack_instrumentation_channel_t * channel = &instrumentation_channels[i];
+        if (!channel->in_use){
+            if (free_channel == NULL){
+                free_channel = channel;
+            }
+            continue;
+        }
+        if ((channel->layer == (uint8_t) layer) && (channel->id == id)) return channel;
+    }
+    if (!create || (free_channel == NULL)) return NULL;
+    free_channel->in_use = 1;
+    free_channel->layer  = (uint8_t) layer;
+    free_channel->id     = id;
+    return free_channel;
+}
+
+static void btstack_instrumentation_add_time(uint32_t * total_us, uint32_t * max_us, uint32_t time_us){
+    *total_us += time_us;
+    *max_us = btstack_max(*max_us, time_us);
+}
+
+static void btstack_instrumentation_count_handled(btstack_instrumentation_counters_t * counters, uint16_t size, uint32_t handler_time_us){
+    counters->num_packets++;
+    counters->num_bytes += size;
+    btstack_instrumentation_add_time(&counters->handler_time_total_us, &counters->handler_time_max_us, handler_time_us);
+}
+
+static void btstack_instrumentation_count_queued(btstack_instrumentation_counters_t * counters, uint32_t delay_us){
+    counters->num_queued++;
+    btstack_instrumentation_add_time(&counters->queueing_delay_total_us, &counters->queueing_delay_max_us, delay_us);
+}
+
+static void btstack_instrumentation_count_can_send_now(btstack_instrumentation_counters_t * counters, uint32_t wait_us){
+    counters->num_can_send_now++;
+    btstack_instrumentation_add_time(&counters->can_send_now_wait_total_us, &counters->can_send_now_wait_max_us, wait_us);
+}
+
+void btstack_instrumentation_packet_handled(btstack_instrumentation_layer_t layer, uint16_t id, uint16_t size, uint32_t start_us){
+    if (layer >= BTSTACK_INSTRUMENTATION_NUM_LAYERS) return;
+    uint32_t handler_time_us = btstack_instrumentation_get_time_us() - start_us;
+    btstack_instrumentation_count_handled(&instrumentation_layers[layer], size, handler_time_us);
+    btstack_instrumentation_channel_t * channel = btstack_instrumentation_channel_for_id(layer, id, true);
+    if (channel == NULL) return;
+    btstack_instrumentation_count_handled(&channel->counters, size, handler_time_us);
+}
+
+void btstack_instrumentation_packet_queued(btstack_instrumentation_layer_t layer, uint16_t id, uint32_t delay_us){
+    if (layer >= BTSTACK_INSTRUMENTATION_NUM_LAYERS) return;
+    btstack_instrumentation_count_queued(&instrumentation_layers[layer], delay_us);
+    btstack_instrumentation_channel_t * channel = btstack_instrumentation_channel_for_id(layer, id, true);
+    if (channel == NULL) return;
+    btstack_instrumentation_count_queued(&channel->counters, delay_us);
+}
+
+void btstack_instrumentation_can_send_now_requested(btstack_instrumentation_layer_t layer, uint16_t id){
+    if (layer >= BTSTACK_INSTRUMENTATION_NUM_LAYERS) return;
+    btstack_instrumentation_channel_t * channel = btstack_instrumentation_channel_for_id(layer, id, true);
+    if (channel == NULL) return;
+    // keep time of first request
+    if (channel->can_send_now_pending) return;
+    channel->can_send_now_pending = 1;
+    channel->can_send_now_requested_us = btstack_instrumentation_get_time_us();
+}
+
+void btstack_instrumentation_can_send_now_emitted(btstack_instrumentation_layer_t layer, uint16_t id){
+    if (layer >= BTSTACK_INSTRUMENTATION_NUM_LAYERS) return;
+    btstack_instrumentation_channel_t * channel = btstack_instrumentation_channel_for_id(layer, id, false);
+    if ((channel == NULL) || !channel->can_send_now_pending) return;
+    channel->can_send_now_pending = 0;
+    uint32_t wait_us = btstack_instrumentation_get_time_us() - channel->can_send_now_requested_us;
+    btstack_instrumentation_count_can_send_now(&instrumentation_layers[layer], wait_us);
+    btstack_instrumentation_count_can_send_now(&channel->counters, wait_us);
+}
+
+const btstack_instrumentation_counters_t * btstack_instrumentation_get_layer(btstack_instrumentation_layer_t layer){
+    if (layer >= BTSTACK_INSTRUMENTATION_NUM_LAYERS) return NULL;
+    return &instrumentation_layers[layer];
+}
+
+const btstack_instrumentation_counters_t * btstack_instrumentation_get_channel(btstack_instrumentation_layer_t layer, uint16_t id){
+    btstack_instrumentation_channel_t * channel = btstack_instrumentation_channel_for_id(layer, id, false);
+    if (channel == NULL) return NULL;
+    return &channel->counters;
+}
+
+static void btstack_instrumentation_emit_statistics(btstack_state_t *btstack, uint8_t layer, uint16_t id, const btstack_instrumentation_counters_t * counters){
+    uint8_t event[45];
+    event[0] = BTSTACK_EVENT_INSTRUMENTATION_STATISTICS;
+    event[1] = sizeof(event) - 2;
+    event[2] = layer;
+    little_endian_store_16(event,  3, id);
+    little_endian_store_32(event,  5, counters->num_packets);
+    little_endian_store_32(event,  9, counters->num_bytes);
+    little_endian_store_32(event, 13, counters->handler_time_total_us);
+    little_endian_store_32(event, 17, counters->handler_time_max_us);
+    little_endian_store_32(event, 21, counters->num_queued);
+    little_endian_store_32(event, 25, counters->queueing_delay_total_us);
+    little_endian_store_32(event, 29, counters->queueing_delay_max_us);
+    little_endian_store_32(event, 33, counters->num_can_send_now);
+    little_endian_store_32(event, 37, counters->can_send_now_wait_total_us);
+    little_endian_store_32(event, 41, counters->can_send_now_wait_max_us);
+    hci_emit_btstack_event(btstack, event, sizeof(event), 1);
+}
+
+static bool btstack_instrumentation_counters_active(const btstack_instrumentation_counters_t * counters){
+    return (counters->num_packets + counters->num_queued + counters->num_can_send_now) > 0;
+}
+
+static void btstack_instrumentation_timer_handler(btstack_state_t *btstack, btstack_timer_source_t * ts){
+    uint8_t layer;
+    for (layer = 0; layer < BTSTACK_INSTRUMENTATION_NUM_LAYERS; layer++){
+        if (!btstack_instrumentation_counters_active(&instrumentation_layers[layer])) continue;
+        btstack_instrumentation_emit_statistics(btstack, layer, BTSTACK_INSTRUMENTATION_ID_ALL, &instrumentation_layers[layer]);
+    }
+    int i;
+    for (i = 0; i < BTSTACK_INSTRUMENTATION_NUM_CHANNELS; i++){
+        btstack_instrumentation_channel_t * channel = &instrumentation_channels[i];
+        if (!channel->in_use) continue;
+        if (!btstack_instrumentation_counters_active(&channel->counters)) continue;
+        btstack_instrumentation_emit_statistics(btstack, channel->layer, channel->id, &channel->counters);
+    }
+    // event handler might have disabled periodic event
+    if (instrumentation_period_ms == 0) return;
+    btstack_run_loop_set_timer(btstack, ts, instrumentation_period_ms);
+    btstack_run_loop_add_timer(btstack, ts);
+}
+
+void btstack_instrumentation_enable_periodic_event(btstack_state_t *btstack, uint32_t period_ms){
+    btstack_run_loop_remove_timer(btstack, &instrumentation_timer);
+    instrumentation_period_ms = period_ms;
+    if (period_ms == 0) return;
+    btstack_run_loop_set_timer_handler(&instrumentation_timer, &btstack_instrumentation_timer_handler);
+    btstack_run_loop_set_timer(btstack, &instrumentation_timer, period_ms);
+    btstack_run_loop_add_timer(btstack, &instrumentation_timer);
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_instrumentation.h
+ *
+ *  Optional per-layer latency and throughput counters, enabled with ENABLE_BTSTACK_INSTRUMENTATION
+ *
+ *  H4 Transport, HCI, L2CAP, ATT Server, RFCOMM and the run loop report packets, bytes, handler time,
+ *  queueing delay and time from can send now request to can send now event per layer and per
+ *  connection handle / channel. Handler time includes the time spent in higher layers.
+ *
+ *  Without ENABLE_BTSTACK_INSTRUMENTATION, all BTSTACK_INSTRUMENTATION_* hooks compile to nothing.
+ */
+
+#ifndef BTSTACK_INSTRUMENTATION_H
+#define BTSTACK_INSTRUMENTATION_H
+
+#include <stdint.h>
+
+#include "btstack_config.h"
+#include "btstack_state.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// number of (layer, id) pairs tracked individually, further ones only count towards the layer
+#ifndef BTSTACK_INSTRUMENTATION_NUM_CHANNELS
+#define BTSTACK_INSTRUMENTATION_NUM_CHANNELS 16
+#endif
+
+// id used in BTSTACK_EVENT_INSTRUMENTATION_STATISTICS for layer totals
+#define BTSTACK_INSTRUMENTATION_ID_ALL 0xffff
+
+// ids used by the run loop layer
+#define BTSTACK_INSTRUMENTATION_ID_RUN_LOOP_TIMER    0
+#define BTSTACK_INSTRUMENTATION_ID_RUN_LOOP_CALLBACK 1
+
+/* API_START */
+
+/**
+ * Layers and their ids:
+ * - HCI_TRANSPORT: packet type, queueing delay is time in transmit queue
+ * - HCI:           connection handle of incoming ACL packets
+ * - L2CAP:         channel id of incoming packets, local cid / fixed channel id for can send now
+ * - ATT:           connection handle
+ * - RFCOMM:        rfcomm cid
+ * - RUN_LOOP:      timers and callbacks, queueing delay is time from timeout until timer is processed
+ */
+typedef enum {
+    BTSTACK_INSTRUMENTATION_LAYER_HCI_TRANSPORT = 0,
+    BTSTACK_INSTRUMENTATION_LAYER_HCI,
+    BTSTACK_INSTRUMENTATION_LAYER_L2CAP,
+    BTSTACK_INSTRUMENTATION_LAYER_ATT,
+    BTSTACK_INSTRUMENTATION_LAYER_RFCOMM,
+    BTSTACK_INSTRUMENTATION_LAYER_RUN_LOOP,
+    BTSTACK_INSTRUMENTATION_NUM_LAYERS
+} btstack_instrumentation_layer_t;
+
+// times in microseconds, average = total / count
+typedef struct {
+    uint32_t num_packets;
+    uint32_t num_bytes;
+    uint32_t handler_time_total_us;
+    uint32_t handler_time_max_us;
+    uint32_t num_queued;
+    uint32_t queueing_delay_total_us;
+    uint32_t queueing_delay_max_us;
+    uint32_t num_can_send_now;
+    uint32_t can_send_now_wait_total_us;
+    uint32_t can_send_now_wait_max_us;
+} btstack_instrumentation_counters_t;
+
+/**
+ * @brief Init instrumentation and reset all counters
+ * @param get_time_us returns monotonic time in microseconds, NULL uses CLOCK_MONOTONIC with HAVE_POSIX_TIME,
+ *        without time source only packets, bytes and number of events are counted
+ */
+void btstack_instrumentation_init(uint32_t (*get_time_us)(void));
+
+/**
+ * @brief Reset all counters and forget tracked channels
+ */
+void btstack_instrumentation_reset(void);
+
+/**
+ * @brief Get counters for a layer
+ * @param layer
+ * @return counters or NULL for invalid layer
+ */
+const btstack_instrumentation_counters_t * btstack_instrumentation_get_layer(btstack_instrumentation_layer_t layer);
+
+/**
+ * @brief Get counters for connection handle or channel in a layer
+ * @param layer
+ * @param id
+ * @return counters or NULL if not tracked
+ */
+const btstack_instrumentation_counters_t * btstack_instrumentation_get_channel(btstack_instrumentation_layer_t layer, uint16_t id);
+
+/**
+ * @brief Emit BTSTACK_EVENT_INSTRUMENTATION_STATISTICS for each active layer and tracked channel periodically
+ * @param btstack instance used for timer and event handlers
+ * @param period_ms, 0 to disable
+ */
+void btstack_instrumentation_enable_periodic_event(btstack_state_t *btstack, uint32_t period_ms);
+
+/* API_END */
+
+// hooks used by the stack
+
+uint32_t btstack_instrumentation_get_time_us(void);
+
+void btstack_instrumentation_packet_handled(btstack_instrumentation_layer_t layer, uint16_t id, uint16_t size, uint32_t start_us);
+
+void btstack_instrumentation_packet_queued(btstack_instrumentation_layer_t layer, uint16_t id, uint32_t delay_us);
+
+void btstack_instrumentation_can_send_now_requested(btstack_instrumentation_layer_t layer, uint16_t id);
+
+void btstack_instrumentation_can_send_now_emitted(btstack_instrumentation_layer_t layer, uint16_t id);
+
+#ifdef ENABLE_BTSTACK_INSTRUMENTATION
+#define BTSTACK_INSTRUMENTATION_START(start_us)                   uint32_t start_us = btstack_instrumentation_get_time_us()
+#define BTSTACK_INSTRUMENTATION_HANDLED(layer, id, size, start_us) btstack_instrumentation_packet_handled(layer, id, size, start_us)
+#define BTSTACK_INSTRUMENTATION_QUEUED(layer, id, delay_us)        btstack_instrumentation_packet_queued(layer, id, delay_us)
+#define BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(layer, id)  btstack_instrumentation_can_send_now_requested(layer, id)
+#define BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_EMITTED(layer, id)    btstack_instrumentation_can_send_now_emitted(layer, id)
+#else
+#define BTSTACK_INSTRUMENTATION_START(start_us)
+#define BTSTACK_INSTRUMENTATION_HANDLED(layer, id, size, start_us)
+#define BTSTACK_INSTRUMENTATION_QUEUED(layer, id, delay_us)
+#define BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(layer, id)
+#define BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_EMITTED(layer, id)
+#endif
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_INSTRUMENTATION_H
@@ -50,419 +50,1524 @@
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 
 
 
 // MARK: hci_connection_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_HCI_CONNECTIONS)
+    #if defined(MAX_NO_HCI_CONNECTIONS)
+        #error "Deprecated MAX_NO_HCI_CONNECTIONS defined instead of MAX_NR_HCI_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_HCI_CONNECTIONS."
+    #else
+        #define MAX_NR_HCI_CONNECTIONS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_HCI_CONNECTIONS) && (MAX_NR_HCI_CONNECTIONS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static hci_connection_t hci_connection_storage[MAX_NR_HCI_CONNECTIONS];
+static uint32_t hci_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_HCI_CONNECTIONS)];
+#endif
+static btstack_memory_pool_t hci_connection_pool;
+hci_connection_t * btstack_memory_hci_connection_get(void){
+    void * buffer = btstack_memory_pool_get(&hci_connection_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(hci_connection_t));
+    }
+    return (hci_connection_t *) buffer;
+}
+void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    btstack_memory_pool_free(&hci_connection_pool, hci_connection);
+}
+#elif defined(MAX_NR_HCI_CONNECTIONS)
+hci_connection_t * btstack_memory_hci_connection_get(void){
+    return NULL;
+}
+void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    // silence compiler warning about unused parameter in a portable way
+    (void) hci_connection;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t hci_connection_statistics;
 hci_connection_t * btstack_memory_hci_connection_get(void){
     void * buffer = malloc(sizeof(hci_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(hci_connection_t));
     }
+    btstack_memory_pool_statistics_allocated(&hci_connection_statistics, buffer);
     return (hci_connection_t *) buffer;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    btstack_memory_pool_statistics_freed(&hci_connection_statistics, hci_connection);
     free(hci_connection);
 }
+#endif
 
 
 
 // MARK: l2cap_service_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_L2CAP_SERVICES)
+    #if defined(MAX_NO_L2CAP_SERVICES)
+        #error "Deprecated MAX_NO_L2CAP_SERVICES defined instead of MAX_NR_L2CAP_SERVICES. Please update your btstack_config.h to use MAX_NR_L2CAP_SERVICES."
+    #else
+        #define MAX_NR_L2CAP_SERVICES 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_L2CAP_SERVICES) && (MAX_NR_L2CAP_SERVICES > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static l2cap_service_t l2cap_service_storage[MAX_NR_L2CAP_SERVICES];
+static uint32_t l2cap_service_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_L2CAP_SERVICES)];
+#endif
+static btstack_memory_pool_t l2cap_service_pool;
+l2cap_service_t * btstack_memory_l2cap_service_get(void){
+    void * buffer = btstack_memory_pool_get(&l2cap_service_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(l2cap_service_t));
+    }
+    return (l2cap_service_t *) buffer;
+}
+void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    btstack_memory_pool_free(&l2cap_service_pool, l2cap_service);
+}
+#elif defined(MAX_NR_L2CAP_SERVICES)
+l2cap_service_t * btstack_memory_l2cap_service_get(void){
+    return NULL;
+}
+void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    // silence compiler warning about unused parameter in a portable way
+    (void) l2cap_service;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t l2cap_service_statistics;
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
     void * buffer = malloc(sizeof(l2cap_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_service_t));
     }
+    btstack_memory_pool_statistics_allocated(&l2cap_service_statistics, buffer);
     return (l2cap_service_t *) buffer;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    btstack_memory_pool_statistics_freed(&l2cap_service_statistics, l2cap_service);
     free(l2cap_service);
 }
+#endif
 
 
 // MARK: l2cap_channel_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_L2CAP_CHANNELS)
+    #if defined(MAX_NO_L2CAP_CHANNELS)
+        #error "Deprecated MAX_NO_L2CAP_CHANNELS defined instead of MAX_NR_L2CAP_CHANNELS. Please update your btstack_config.h to use MAX_NR_L2CAP_CHANNELS."
+    #else
+        #define MAX_NR_L2CAP_CHANNELS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_L2CAP_CHANNELS) && (MAX_NR_L2CAP_CHANNELS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static l2cap_channel_t l2cap_channel_storage[MAX_NR_L2CAP_CHANNELS];
+static uint32_t l2cap_channel_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_L2CAP_CHANNELS)];
+#endif
+static btstack_memory_pool_t l2cap_channel_pool;
+l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
+    void * buffer = btstack_memory_pool_get(&l2cap_channel_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(l2cap_channel_t));
+    }
+    return (l2cap_channel_t *) buffer;
+}
+void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    btstack_memory_pool_free(&l2cap_channel_pool, l2cap_channel);
+}
+#elif defined(MAX_NR_L2CAP_CHANNELS)
+l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
+    return NULL;
+}
+void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    // silence compiler warning about unused parameter in a portable way
+    (void) l2cap_channel;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t l2cap_channel_statistics;
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
     void * buffer = malloc(sizeof(l2cap_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_channel_t));
     }
+    btstack_memory_pool_statistics_allocated(&l2cap_channel_statistics, buffer);
     return (l2cap_channel_t *) buffer;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    btstack_memory_pool_statistics_freed(&l2cap_channel_statistics, l2cap_channel);
     free(l2cap_channel);
 }
+#endif
 
 
 #ifdef ENABLE_CLASSIC
 
 // MARK: rfcomm_multiplexer_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_RFCOMM_MULTIPLEXERS)
+    #if defined(MAX_NO_RFCOMM_MULTIPLEXERS)
+        #error "Deprecated MAX_NO_RFCOMM_MULTIPLEXERS defined instead of MAX_NR_RFCOMM_MULTIPLEXERS. Please update your btstack_config.h to use MAX_NR_RFCOMM_MULTIPLEXERS."
+    #else
+        #define MAX_NR_RFCOMM_MULTIPLEXERS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_RFCOMM_MULTIPLEXERS) && (MAX_NR_RFCOMM_MULTIPLEXERS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static rfcomm_multiplexer_t rfcomm_multiplexer_storage[MAX_NR_RFCOMM_MULTIPLEXERS];
+static uint32_t rfcomm_multiplexer_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_RFCOMM_MULTIPLEXERS)];
+#endif
+static btstack_memory_pool_t rfcomm_multiplexer_pool;
+rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
+    void * buffer = btstack_memory_pool_get(&rfcomm_multiplexer_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(rfcomm_multiplexer_t));
+    }
+    return (rfcomm_multiplexer_t *) buffer;
+}
+void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    btstack_memory_pool_free(&rfcomm_multiplexer_pool, rfcomm_multiplexer);
+}
+#elif defined(MAX_NR_RFCOMM_MULTIPLEXERS)
+rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
+    return NULL;
+}
+void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    // silence compiler warning about unused parameter in a portable way
+    (void) rfcomm_multiplexer;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t rfcomm_multiplexer_statistics;
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
     void * buffer = malloc(sizeof(rfcomm_multiplexer_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_multiplexer_t));
     }
+    btstack_memory_pool_statistics_allocated(&rfcomm_multiplexer_statistics, buffer);
     return (rfcomm_multiplexer_t *) buffer;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    btstack_memory_pool_statistics_freed(&rfcomm_multiplexer_statistics, rfcomm_multiplexer);
     free(rfcomm_multiplexer);
 }
+#endif
 
 
 // MARK: rfcomm_service_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_RFCOMM_SERVICES)
+    #if defined(MAX_NO_RFCOMM_SERVICES)
+        #error "Deprecated MAX_NO_RFCOMM_SERVICES defined instead of MAX_NR_RFCOMM_SERVICES. Please update your btstack_config.h to use MAX_NR_RFCOMM_SERVICES."
+    #else
+        #define MAX_NR_RFCOMM_SERVICES 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_RFCOMM_SERVICES) && (MAX_NR_RFCOMM_SERVICES > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static rfcomm_service_t rfcomm_service_storage[MAX_NR_RFCOMM_SERVICES];
+static uint32_t rfcomm_service_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_RFCOMM_SERVICES)];
+#endif
+static btstack_memory_pool_t rfcomm_service_pool;
+rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
+    void * buffer = btstack_memory_pool_get(&rfcomm_service_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(rfcomm_service_t));
+    }
+    return (rfcomm_service_t *) buffer;
+}
+void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    btstack_memory_pool_free(&rfcomm_service_pool, rfcomm_service);
+}
+#elif defined(MAX_NR_RFCOMM_SERVICES)
+rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
+    return NULL;
+}
+void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    // silence compiler warning about unused parameter in a portable way
+    (void) rfcomm_service;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t rfcomm_service_statistics;
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
     void * buffer = malloc(sizeof(rfcomm_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_service_t));
     }
+    btstack_memory_pool_statistics_allocated(&rfcomm_service_statistics, buffer);
     return (rfcomm_service_t *) buffer;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    btstack_memory_pool_statistics_freed(&rfcomm_service_statistics, rfcomm_service);
     free(rfcomm_service);
 }
+#endif
 
 
 // MARK: rfcomm_channel_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_RFCOMM_CHANNELS)
+    #if defined(MAX_NO_RFCOMM_CHANNELS)
+        #error "Deprecated MAX_NO_RFCOMM_CHANNELS defined instead of MAX_NR_RFCOMM_CHANNELS. Please update your btstack_config.h to use MAX_NR_RFCOMM_CHANNELS."
+    #else
+        #define MAX_NR_RFCOMM_CHANNELS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_RFCOMM_CHANNELS) && (MAX_NR_RFCOMM_CHANNELS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static rfcomm_channel_t rfcomm_channel_storage[MAX_NR_RFCOMM_CHANNELS];
+static uint32_t rfcomm_channel_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_RFCOMM_CHANNELS)];
+#endif
+static btstack_memory_pool_t rfcomm_channel_pool;
+rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
+    void * buffer = btstack_memory_pool_get(&rfcomm_channel_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(rfcomm_channel_t));
+    }
+    return (rfcomm_channel_t *) buffer;
+}
+void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    btstack_memory_pool_free(&rfcomm_channel_pool, rfcomm_channel);
+}
+#elif defined(MAX_NR_RFCOMM_CHANNELS)
+rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
+    return NULL;
+}
+void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    // silence compiler warning about unused parameter in a portable way
+    (void) rfcomm_channel;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t rfcomm_channel_statistics;
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
     void * buffer = malloc(sizeof(rfcomm_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_channel_t));
     }
+    btstack_memory_pool_statistics_allocated(&rfcomm_channel_statistics, buffer);
     return (rfcomm_channel_t *) buffer;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    btstack_memory_pool_statistics_freed(&rfcomm_channel_statistics, rfcomm_channel);
     free(rfcomm_channel);
 }
+#endif
 
 
 
 // MARK: btstack_link_key_db_memory_entry_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)
+    #if defined(MAX_NO_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)
+        #error "Deprecated MAX_NO_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES defined instead of MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES. Please update your btstack_config.h to use MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES."
+    #else
+        #define MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES) && (MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static btstack_link_key_db_memory_entry_t btstack_link_key_db_memory_entry_storage[MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES];
+static uint32_t btstack_link_key_db_memory_entry_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)];
+#endif
+static btstack_memory_pool_t btstack_link_key_db_memory_entry_pool;
+btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
+    void * buffer = btstack_memory_pool_get(&btstack_link_key_db_memory_entry_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(btstack_link_key_db_memory_entry_t));
+    }
+    return (btstack_link_key_db_memory_entry_t *) buffer;
+}
+void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    btstack_memory_pool_free(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry);
+}
+#elif defined(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)
+btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
+    return NULL;
+}
+void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    // silence compiler warning about unused parameter in a portable way
+    (void) btstack_link_key_db_memory_entry;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t btstack_link_key_db_memory_entry_statistics;
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
     void * buffer = malloc(sizeof(btstack_link_key_db_memory_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(btstack_link_key_db_memory_entry_t));
     }
+    btstack_memory_pool_statistics_allocated(&btstack_link_key_db_memory_entry_statistics, buffer);
     return (btstack_link_key_db_memory_entry_t *) buffer;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    btstack_memory_pool_statistics_freed(&btstack_link_key_db_memory_entry_statistics, btstack_link_key_db_memory_entry);
     free(btstack_link_key_db_memory_entry);
 }
+#endif
 
 
 
 // MARK: bnep_service_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_BNEP_SERVICES)
+    #if defined(MAX_NO_BNEP_SERVICES)
+        #error "Deprecated MAX_NO_BNEP_SERVICES defined instead of MAX_NR_BNEP_SERVICES. Please update your btstack_config.h to use MAX_NR_BNEP_SERVICES."
+    #else
+        #define MAX_NR_BNEP_SERVICES 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_BNEP_SERVICES) && (MAX_NR_BNEP_SERVICES > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static bnep_service_t bnep_service_storage[MAX_NR_BNEP_SERVICES];
+static uint32_t bnep_service_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_BNEP_SERVICES)];
+#endif
+static btstack_memory_pool_t bnep_service_pool;
+bnep_service_t * btstack_memory_bnep_service_get(void){
+    void * buffer = btstack_memory_pool_get(&bnep_service_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(bnep_service_t));
+    }
+    return (bnep_service_t *) buffer;
+}
+void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    btstack_memory_pool_free(&bnep_service_pool, bnep_service);
+}
+#elif defined(MAX_NR_BNEP_SERVICES)
+bnep_service_t * btstack_memory_bnep_service_get(void){
+    return NULL;
+}
+void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    // silence compiler warning about unused parameter in a portable way
+    (void) bnep_service;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t bnep_service_statistics;
 bnep_service_t * btstack_memory_bnep_service_get(void){
     void * buffer = malloc(sizeof(bnep_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(bnep_service_t));
     }
+    btstack_memory_pool_statistics_allocated(&bnep_service_statistics, buffer);
     return (bnep_service_t *) buffer;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    btstack_memory_pool_statistics_freed(&bnep_service_statistics, bnep_service);
     free(bnep_service);
 }
+#endif
 
 
 // MARK: bnep_channel_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_BNEP_CHANNELS)
+    #if defined(MAX_NO_BNEP_CHANNELS)
+        #error "Deprecated MAX_NO_BNEP_CHANNELS defined instead of MAX_NR_BNEP_CHANNELS. Please update your btstack_config.h to use MAX_NR_BNEP_CHANNELS."
+    #else
+        #define MAX_NR_BNEP_CHANNELS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_BNEP_CHANNELS) && (MAX_NR_BNEP_CHANNELS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static bnep_channel_t bnep_channel_storage[MAX_NR_BNEP_CHANNELS];
+static uint32_t bnep_channel_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_BNEP_CHANNELS)];
+#endif
+static btstack_memory_pool_t bnep_channel_pool;
+bnep_channel_t * btstack_memory_bnep_channel_get(void){
+    void * buffer = btstack_memory_pool_get(&bnep_channel_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(bnep_channel_t));
+    }
+    return (bnep_channel_t *) buffer;
+}
+void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    btstack_memory_pool_free(&bnep_channel_pool, bnep_channel);
+}
+#elif defined(MAX_NR_BNEP_CHANNELS)
+bnep_channel_t * btstack_memory_bnep_channel_get(void){
+    return NULL;
+}
+void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    // silence compiler warning about unused parameter in a portable way
+    (void) bnep_channel;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t bnep_channel_statistics;
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
     void * buffer = malloc(sizeof(bnep_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(bnep_channel_t));
     }
+    btstack_memory_pool_statistics_allocated(&bnep_channel_statistics, buffer);
     return (bnep_channel_t *) buffer;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    btstack_memory_pool_statistics_freed(&bnep_channel_statistics, bnep_channel);
     free(bnep_channel);
 }
+#endif
 
 
 
 // MARK: hfp_connection_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_HFP_CONNECTIONS)
+    #if defined(MAX_NO_HFP_CONNECTIONS)
+        #error "Deprecated MAX_NO_HFP_CONNECTIONS defined instead of MAX_NR_HFP_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_HFP_CONNECTIONS."
+    #else
+        #define MAX_NR_HFP_CONNECTIONS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_HFP_CONNECTIONS) && (MAX_NR_HFP_CONNECTIONS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static hfp_connection_t hfp_connection_storage[MAX_NR_HFP_CONNECTIONS];
+static uint32_t hfp_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_HFP_CONNECTIONS)];
+#endif
+static btstack_memory_pool_t hfp_connection_pool;
+hfp_connection_t * btstack_memory_hfp_connection_get(void){
+    void * buffer = btstack_memory_pool_get(&hfp_connection_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(hfp_connection_t));
+    }
+    return (hfp_connection_t *) buffer;
+}
+void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    btstack_memory_pool_free(&hfp_connection_pool, hfp_connection);
+}
+#elif defined(MAX_NR_HFP_CONNECTIONS)
+hfp_connection_t * btstack_memory_hfp_connection_get(void){
+    return NULL;
+}
+void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    // silence compiler warning about unused parameter in a portable way
+    (void) hfp_connection;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t hfp_connection_statistics;
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
     void * buffer = malloc(sizeof(hfp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(hfp_connection_t));
     }
+    btstack_memory_pool_statistics_allocated(&hfp_connection_statistics, buffer);
     return (hfp_connection_t *) buffer;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    btstack_memory_pool_statistics_freed(&hfp_connection_statistics, hfp_connection);
     free(hfp_connection);
 }
+#endif
 
 
 
 // MARK: service_record_item_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_SERVICE_RECORD_ITEMS)
+    #if defined(MAX_NO_SERVICE_RECORD_ITEMS)
+        #error "Deprecated MAX_NO_SERVICE_RECORD_ITEMS defined instead of MAX_NR_SERVICE_RECORD_ITEMS. Please update your btstack_config.h to use MAX_NR_SERVICE_RECORD_ITEMS."
+    #else
+        #define MAX_NR_SERVICE_RECORD_ITEMS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_SERVICE_RECORD_ITEMS) && (MAX_NR_SERVICE_RECORD_ITEMS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static service_record_item_t service_record_item_storage[MAX_NR_SERVICE_RECORD_ITEMS];
+static uint32_t service_record_item_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_SERVICE_RECORD_ITEMS)];
+#endif
+static btstack_memory_pool_t service_record_item_pool;
+service_record_item_t * btstack_memory_service_record_item_get(void){
+    void * buffer = btstack_memory_pool_get(&service_record_item_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(service_record_item_t));
+    }
+    return (service_record_item_t *) buffer;
+}
+void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    btstack_memory_pool_free(&service_record_item_pool, service_record_item);
+}
+#elif defined(MAX_NR_SERVICE_RECORD_ITEMS)
+service_record_item_t * btstack_memory_service_record_item_get(void){
+    return NULL;
+}
+void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    // silence compiler warning about unused parameter in a portable way
+    (void) service_record_item;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t service_record_item_statistics;
 service_record_item_t * btstack_memory_service_record_item_get(void){
     void * buffer = malloc(sizeof(service_record_item_t));
     if (buffer){
         memset(buffer, 0, sizeof(service_record_item_t));
     }
+    btstack_memory_pool_statistics_allocated(&service_record_item_statistics, buffer);
     return (service_record_item_t *) buffer;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    btstack_memory_pool_statistics_freed(&service_record_item_statistics, service_record_item);
     free(service_record_item);
 }
+#endif
 
 
 
 // MARK: avdtp_stream_endpoint_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVDTP_STREAM_ENDPOINTS)
+    #if defined(MAX_NO_AVDTP_STREAM_ENDPOINTS)
+        #error "Deprecated MAX_NO_AVDTP_STREAM_ENDPOINTS defined instead of MAX_NR_AVDTP_STREAM_ENDPOINTS. Please update your btstack_config.h to use MAX_NR_AVDTP_STREAM_ENDPOINTS."
+    #else
+        #define MAX_NR_AVDTP_STREAM_ENDPOINTS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVDTP_STREAM_ENDPOINTS) && (MAX_NR_AVDTP_STREAM_ENDPOINTS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static avdtp_stream_endpoint_t avdtp_stream_endpoint_storage[MAX_NR_AVDTP_STREAM_ENDPOINTS];
+static uint32_t avdtp_stream_endpoint_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVDTP_STREAM_ENDPOINTS)];
+#endif
+static btstack_memory_pool_t avdtp_stream_endpoint_pool;
+avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
+    void * buffer = btstack_memory_pool_get(&avdtp_stream_endpoint_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(avdtp_stream_endpoint_t));
+    }
+    return (avdtp_stream_endpoint_t *) buffer;
+}
+void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    btstack_memory_pool_free(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint);
+}
+#elif defined(MAX_NR_AVDTP_STREAM_ENDPOINTS)
+avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
+    return NULL;
+}
+void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    // silence compiler warning about unused parameter in a portable way
+    (void) avdtp_stream_endpoint;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t avdtp_stream_endpoint_statistics;
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
     void * buffer = malloc(sizeof(avdtp_stream_endpoint_t));
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_stream_endpoint_t));
     }
+    btstack_memory_pool_statistics_allocated(&avdtp_stream_endpoint_statistics, buffer);
     return (avdtp_stream_endpoint_t *) buffer;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    btstack_memory_pool_statistics_freed(&avdtp_stream_endpoint_statistics, avdtp_stream_endpoint);
     free(avdtp_stream_endpoint);
 }
+#endif
 
 
 
 // MARK: avdtp_connection_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVDTP_CONNECTIONS)
+    #if defined(MAX_NO_AVDTP_CONNECTIONS)
+        #error "Deprecated MAX_NO_AVDTP_CONNECTIONS defined instead of MAX_NR_AVDTP_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_AVDTP_CONNECTIONS."
+    #else
+        #define MAX_NR_AVDTP_CONNECTIONS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVDTP_CONNECTIONS) && (MAX_NR_AVDTP_CONNECTIONS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static avdtp_connection_t avdtp_connection_storage[MAX_NR_AVDTP_CONNECTIONS];
+static uint32_t avdtp_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVDTP_CONNECTIONS)];
+#endif
+static btstack_memory_pool_t avdtp_connection_pool;
+avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
+    void * buffer = btstack_memory_pool_get(&avdtp_connection_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(avdtp_connection_t));
+    }
+    return (avdtp_connection_t *) buffer;
+}
+void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    btstack_memory_pool_free(&avdtp_connection_pool, avdtp_connection);
+}
+#elif defined(MAX_NR_AVDTP_CONNECTIONS)
+avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
+    return NULL;
+}
+void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    // silence compiler warning about unused parameter in a portable way
+    (void) avdtp_connection;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t avdtp_connection_statistics;
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
     void * buffer = malloc(sizeof(avdtp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_connection_t));
     }
+    btstack_memory_pool_statistics_allocated(&avdtp_connection_statistics, buffer);
     return (avdtp_connection_t *) buffer;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    btstack_memory_pool_statistics_freed(&avdtp_connection_statistics, avdtp_connection);
     free(avdtp_connection);
 }
+#endif
 
 
 
 // MARK: avrcp_connection_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVRCP_CONNECTIONS)
+    #if defined(MAX_NO_AVRCP_CONNECTIONS)
+        #error "Deprecated MAX_NO_AVRCP_CONNECTIONS defined instead of MAX_NR_AVRCP_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_AVRCP_CONNECTIONS."
+    #else
+        #define MAX_NR_AVRCP_CONNECTIONS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVRCP_CONNECTIONS) && (MAX_NR_AVRCP_CONNECTIONS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static avrcp_connection_t avrcp_connection_storage[MAX_NR_AVRCP_CONNECTIONS];
+static uint32_t avrcp_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVRCP_CONNECTIONS)];
+#endif
+static btstack_memory_pool_t avrcp_connection_pool;
+avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
+    void * buffer = btstack_memory_pool_get(&avrcp_connection_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(avrcp_connection_t));
+    }
+    return (avrcp_connection_t *) buffer;
+}
+void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    btstack_memory_pool_free(&avrcp_connection_pool, avrcp_connection);
+}
+#elif defined(MAX_NR_AVRCP_CONNECTIONS)
+avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
+    return NULL;
+}
+void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    // silence compiler warning about unused parameter in a portable way
+    (void) avrcp_connection;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t avrcp_connection_statistics;
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_connection_t));
     }
+    btstack_memory_pool_statistics_allocated(&avrcp_connection_statistics, buffer);
     return (avrcp_connection_t *) buffer;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    btstack_memory_pool_statistics_freed(&avrcp_connection_statistics, avrcp_connection);
     free(avrcp_connection);
 }
+#endif
 
 
 
 // MARK: avrcp_browsing_connection_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVRCP_BROWSING_CONNECTIONS)
+    #if defined(MAX_NO_AVRCP_BROWSING_CONNECTIONS)
+        #error "Deprecated MAX_NO_AVRCP_BROWSING_CONNECTIONS defined instead of MAX_NR_AVRCP_BROWSING_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_AVRCP_BROWSING_CONNECTIONS."
+    #else
+        #define MAX_NR_AVRCP_BROWSING_CONNECTIONS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVRCP_BROWSING_CONNECTIONS) && (MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static avrcp_browsing_connection_t avrcp_browsing_connection_storage[MAX_NR_AVRCP_BROWSING_CONNECTIONS];
+static uint32_t avrcp_browsing_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVRCP_BROWSING_CONNECTIONS)];
+#endif
+static btstack_memory_pool_t avrcp_browsing_connection_pool;
+avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
+    void * buffer = btstack_memory_pool_get(&avrcp_browsing_connection_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(avrcp_browsing_connection_t));
+    }
+    return (avrcp_browsing_connection_t *) buffer;
+}
+void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    btstack_memory_pool_free(&avrcp_browsing_connection_pool, avrcp_browsing_connection);
+}
+#elif defined(MAX_NR_AVRCP_BROWSING_CONNECTIONS)
+avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
+    return NULL;
+}
+void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    // silence compiler warning about unused parameter in a portable way
+    (void) avrcp_browsing_connection;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t avrcp_browsing_connection_statistics;
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_browsing_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_browsing_connection_t));
     }
+    btstack_memory_pool_statistics_allocated(&avrcp_browsing_connection_statistics, buffer);
     return (avrcp_browsing_connection_t *) buffer;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    btstack_memory_pool_statistics_freed(&avrcp_browsing_connection_statistics, avrcp_browsing_connection);
     free(avrcp_browsing_connection);
 }
+#endif
 
 
 #endif
 #ifdef ENABLE_BLE
 
 // MARK: gatt_client_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_GATT_CLIENTS)
+    #if defined(MAX_NO_GATT_CLIENTS)
+        #error "Deprecated MAX_NO_GATT_CLIENTS defined instead of MAX_NR_GATT_CLIENTS. Please update your btstack_config.h to use MAX_NR_GATT_CLIENTS."
+    #else
+        #define MAX_NR_GATT_CLIENTS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_GATT_CLIENTS) && (MAX_NR_GATT_CLIENTS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static gatt_client_t gatt_client_storage[MAX_NR_GATT_CLIENTS];
+static uint32_t gatt_client_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_GATT_CLIENTS)];
+#endif
+static btstack_memory_pool_t gatt_client_pool;
+gatt_client_t * btstack_memory_gatt_client_get(void){
+    void * buffer = btstack_memory_pool_get(&gatt_client_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(gatt_client_t));
+    }
+    return (gatt_client_t *) buffer;
+}
+void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    btstack_memory_pool_free(&gatt_client_pool, gatt_client);
+}
+#elif defined(MAX_NR_GATT_CLIENTS)
+gatt_client_t * btstack_memory_gatt_client_get(void){
+    return NULL;
+}
+void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    // silence compiler warning about unused parameter in a portable way
+    (void) gatt_client;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t gatt_client_statistics;
 gatt_client_t * btstack_memory_gatt_client_get(void){
     void * buffer = malloc(sizeof(gatt_client_t));
     if (buffer){
         memset(buffer, 0, sizeof(gatt_client_t));
     }
+    btstack_memory_pool_statistics_allocated(&gatt_client_statistics, buffer);
     return (gatt_client_t *) buffer;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    btstack_memory_pool_statistics_freed(&gatt_client_statistics, gatt_client);
     free(gatt_client);
 }
+#endif
 
 
 // MARK: whitelist_entry_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_WHITELIST_ENTRIES)
+    #if defined(MAX_NO_WHITELIST_ENTRIES)
+        #error "Deprecated MAX_NO_WHITELIST_ENTRIES defined instead of MAX_NR_WHITELIST_ENTRIES. Please update your btstack_config.h to use MAX_NR_WHITELIST_ENTRIES."
+    #else
+        #define MAX_NR_WHITELIST_ENTRIES 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_WHITELIST_ENTRIES) && (MAX_NR_WHITELIST_ENTRIES > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static whitelist_entry_t whitelist_entry_storage[MAX_NR_WHITELIST_ENTRIES];
+static uint32_t whitelist_entry_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_WHITELIST_ENTRIES)];
+#endif
+static btstack_memory_pool_t whitelist_entry_pool;
+whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
+    void * buffer = btstack_memory_pool_get(&whitelist_entry_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(whitelist_entry_t));
+    }
+    return (whitelist_entry_t *) buffer;
+}
+void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    btstack_memory_pool_free(&whitelist_entry_pool, whitelist_entry);
+}
+#elif defined(MAX_NR_WHITELIST_ENTRIES)
+whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
+    return NULL;
+}
+void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    // silence compiler warning about unused parameter in a portable way
+    (void) whitelist_entry;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t whitelist_entry_statistics;
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
     void * buffer = malloc(sizeof(whitelist_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(whitelist_entry_t));
     }
+    btstack_memory_pool_statistics_allocated(&whitelist_entry_statistics, buffer);
     return (whitelist_entry_t *) buffer;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    btstack_memory_pool_statistics_freed(&whitelist_entry_statistics, whitelist_entry);
     free(whitelist_entry);
 }
+#endif
 
 
 // MARK: sm_lookup_entry_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_SM_LOOKUP_ENTRIES)
+    #if defined(MAX_NO_SM_LOOKUP_ENTRIES)
+        #error "Deprecated MAX_NO_SM_LOOKUP_ENTRIES defined instead of MAX_NR_SM_LOOKUP_ENTRIES. Please update your btstack_config.h to use MAX_NR_SM_LOOKUP_ENTRIES."
+    #else
+        #define MAX_NR_SM_LOOKUP_ENTRIES 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_SM_LOOKUP_ENTRIES) && (MAX_NR_SM_LOOKUP_ENTRIES > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static sm_lookup_entry_t sm_lookup_entry_storage[MAX_NR_SM_LOOKUP_ENTRIES];
+static uint32_t sm_lookup_entry_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_SM_LOOKUP_ENTRIES)];
+#endif
+static btstack_memory_pool_t sm_lookup_entry_pool;
+sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
+    void * buffer = btstack_memory_pool_get(&sm_lookup_entry_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(sm_lookup_entry_t));
+    }
+    return (sm_lookup_entry_t *) buffer;
+}
+void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    btstack_memory_pool_free(&sm_lookup_entry_pool, sm_lookup_entry);
+}
+#elif defined(MAX_NR_SM_LOOKUP_ENTRIES)
+sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
+    return NULL;
+}
+void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    // silence compiler warning about unused parameter in a portable way
+    (void) sm_lookup_entry;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t sm_lookup_entry_statistics;
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
     void * buffer = malloc(sizeof(sm_lookup_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(sm_lookup_entry_t));
     }
+    btstack_memory_pool_statistics_allocated(&sm_lookup_entry_statistics, buffer);
     return (sm_lookup_entry_t *) buffer;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    btstack_memory_pool_statistics_freed(&sm_lookup_entry_statistics, sm_lookup_entry);
     free(sm_lookup_entry);
 }
+#endif
 
 
 #endif
 #ifdef ENABLE_MESH
 
 // MARK: mesh_network_pdu_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_NETWORK_PDUS)
+    #if defined(MAX_NO_MESH_NETWORK_PDUS)
+        #error "Deprecated MAX_NO_MESH_NETWORK_PDUS defined instead of MAX_NR_MESH_NETWORK_PDUS. Please update your btstack_config.h to use MAX_NR_MESH_NETWORK_PDUS."
+    #else
+        #define MAX_NR_MESH_NETWORK_PDUS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_NETWORK_PDUS) && (MAX_NR_MESH_NETWORK_PDUS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static mesh_network_pdu_t mesh_network_pdu_storage[MAX_NR_MESH_NETWORK_PDUS];
+static uint32_t mesh_network_pdu_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_NETWORK_PDUS)];
+#endif
+static btstack_memory_pool_t mesh_network_pdu_pool;
+mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
+    void * buffer = btstack_memory_pool_get(&mesh_network_pdu_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(mesh_network_pdu_t));
+    }
+    return (mesh_network_pdu_t *) buffer;
+}
+void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    btstack_memory_pool_free(&mesh_network_pdu_pool, mesh_network_pdu);
+}
+#elif defined(MAX_NR_MESH_NETWORK_PDUS)
+mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
+    return NULL;
+}
+void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    // silence compiler warning about unused parameter in a portable way
+    (void) mesh_network_pdu;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t mesh_network_pdu_statistics;
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_network_pdu_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_pdu_t));
     }
+    btstack_memory_pool_statistics_allocated(&mesh_network_pdu_statistics, buffer);
     return (mesh_network_pdu_t *) buffer;
 }
 void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    btstack_memory_pool_statistics_freed(&mesh_network_pdu_statistics, mesh_network_pdu);
     free(mesh_network_pdu);
 }
+#endif
 
 
 // MARK: mesh_transport_pdu_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_TRANSPORT_PDUS)
+    #if defined(MAX_NO_MESH_TRANSPORT_PDUS)
+        #error "Deprecated MAX_NO_MESH_TRANSPORT_PDUS defined instead of MAX_NR_MESH_TRANSPORT_PDUS. Please update your btstack_config.h to use MAX_NR_MESH_TRANSPORT_PDUS."
+    #else
+        #define MAX_NR_MESH_TRANSPORT_PDUS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_TRANSPORT_PDUS) && (MAX_NR_MESH_TRANSPORT_PDUS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static mesh_transport_pdu_t mesh_transport_pdu_storage[MAX_NR_MESH_TRANSPORT_PDUS];
+static uint32_t mesh_transport_pdu_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_TRANSPORT_PDUS)];
+#endif
+static btstack_memory_pool_t mesh_transport_pdu_pool;
+mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
+    void * buffer = btstack_memory_pool_get(&mesh_transport_pdu_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(mesh_transport_pdu_t));
+    }
+    return (mesh_transport_pdu_t *) buffer;
+}
+void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
+    btstack_memory_pool_free(&mesh_transport_pdu_pool, mesh_transport_pdu);
+}
+#elif defined(MAX_NR_MESH_TRANSPORT_PDUS)
+mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
+    return NULL;
+}
+void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
+    // silence compiler warning about unused parameter in a portable way
+    (void) mesh_transport_pdu;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t mesh_transport_pdu_statistics;
 mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_transport_pdu_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_pdu_t));
     }
+    btstack_memory_pool_statistics_allocated(&mesh_transport_pdu_statistics, buffer);
     return (mesh_transport_pdu_t *) buffer;
 }
 void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
+    btstack_memory_pool_statistics_freed(&mesh_transport_pdu_statistics, mesh_transport_pdu);
     free(mesh_transport_pdu);
 }
+#endif
 
 
 // MARK: mesh_network_key_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_NETWORK_KEYS)
+    #if defined(MAX_NO_MESH_NETWORK_KEYS)
+        #error "Deprecated MAX_NO_MESH_NETWORK_KEYS defined instead of MAX_NR_MESH_NETWORK_KEYS. Please update your btstack_config.h to use MAX_NR_MESH_NETWORK_KEYS."
+    #else
+        #define MAX_NR_MESH_NETWORK_KEYS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_NETWORK_KEYS) && (MAX_NR_MESH_NETWORK_KEYS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static mesh_network_key_t mesh_network_key_storage[MAX_NR_MESH_NETWORK_KEYS];
+static uint32_t mesh_network_key_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_NETWORK_KEYS)];
+#endif
+static btstack_memory_pool_t mesh_network_key_pool;
+mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
+    void * buffer = btstack_memory_pool_get(&mesh_network_key_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(mesh_network_key_t));
+    }
+    return (mesh_network_key_t *) buffer;
+}
+void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    btstack_memory_pool_free(&mesh_network_key_pool, mesh_network_key);
+}
+#elif defined(MAX_NR_MESH_NETWORK_KEYS)
+mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
+    return NULL;
+}
+void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    // silence compiler warning about unused parameter in a portable way
+    (void) mesh_network_key;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t mesh_network_key_statistics;
 mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
     void * buffer = malloc(sizeof(mesh_network_key_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_key_t));
     }
+    btstack_memory_pool_statistics_allocated(&mesh_network_key_statistics, buffer);
     return (mesh_network_key_t *) buffer;
 }
 void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    btstack_memory_pool_statistics_freed(&mesh_network_key_statistics, mesh_network_key);
     free(mesh_network_key);
 }
+#endif
 
 
 // MARK: mesh_transport_key_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_TRANSPORT_KEYS)
+    #if defined(MAX_NO_MESH_TRANSPORT_KEYS)
+        #error "Deprecated MAX_NO_MESH_TRANSPORT_KEYS defined instead of MAX_NR_MESH_TRANSPORT_KEYS. Please update your btstack_config.h to use MAX_NR_MESH_TRANSPORT_KEYS."
+    #else
+        #define MAX_NR_MESH_TRANSPORT_KEYS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_TRANSPORT_KEYS) && (MAX_NR_MESH_TRANSPORT_KEYS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static mesh_transport_key_t mesh_transport_key_storage[MAX_NR_MESH_TRANSPORT_KEYS];
+static uint32_t mesh_transport_key_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_TRANSPORT_KEYS)];
+#endif
+static btstack_memory_pool_t mesh_transport_key_pool;
+mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
+    void * buffer = btstack_memory_pool_get(&mesh_transport_key_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(mesh_transport_key_t));
+    }
+    return (mesh_transport_key_t *) buffer;
+}
+void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    btstack_memory_pool_free(&mesh_transport_key_pool, mesh_transport_key);
+}
+#elif defined(MAX_NR_MESH_TRANSPORT_KEYS)
+mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
+    return NULL;
+}
+void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    // silence compiler warning about unused parameter in a portable way
+    (void) mesh_transport_key;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t mesh_transport_key_statistics;
 mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
     void * buffer = malloc(sizeof(mesh_transport_key_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_key_t));
     }
+    btstack_memory_pool_statistics_allocated(&mesh_transport_key_statistics, buffer);
     return (mesh_transport_key_t *) buffer;
 }
 void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    btstack_memory_pool_statistics_freed(&mesh_transport_key_statistics, mesh_transport_key);
     free(mesh_transport_key);
 }
+#endif
 
 
 // MARK: mesh_virtual_address_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_VIRTUAL_ADDRESSS)
+    #if defined(MAX_NO_MESH_VIRTUAL_ADDRESSS)
+        #error "Deprecated MAX_NO_MESH_VIRTUAL_ADDRESSS defined instead of MAX_NR_MESH_VIRTUAL_ADDRESSS. Please update your btstack_config.h to use MAX_NR_MESH_VIRTUAL_ADDRESSS."
+    #else
+        #define MAX_NR_MESH_VIRTUAL_ADDRESSS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_VIRTUAL_ADDRESSS) && (MAX_NR_MESH_VIRTUAL_ADDRESSS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static mesh_virtual_address_t mesh_virtual_address_storage[MAX_NR_MESH_VIRTUAL_ADDRESSS];
+static uint32_t mesh_virtual_address_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_VIRTUAL_ADDRESSS)];
+#endif
+static btstack_memory_pool_t mesh_virtual_address_pool;
+mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
+    void * buffer = btstack_memory_pool_get(&mesh_virtual_address_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(mesh_virtual_address_t));
+    }
+    return (mesh_virtual_address_t *) buffer;
+}
+void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    btstack_memory_pool_free(&mesh_virtual_address_pool, mesh_virtual_address);
+}
+#elif defined(MAX_NR_MESH_VIRTUAL_ADDRESSS)
+mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
+    return NULL;
+}
+void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    // silence compiler warning about unused parameter in a portable way
+    (void) mesh_virtual_address;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t mesh_virtual_address_statistics;
 mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
     void * buffer = malloc(sizeof(mesh_virtual_address_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_virtual_address_t));
     }
+    btstack_memory_pool_statistics_allocated(&mesh_virtual_address_statistics, buffer);
     return (mesh_virtual_address_t *) buffer;
 }
 void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    btstack_memory_pool_statistics_freed(&mesh_virtual_address_statistics, mesh_virtual_address);
     free(mesh_virtual_address);
 }
+#endif
 
 
 // MARK: mesh_subnet_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_SUBNETS)
+    #if defined(MAX_NO_MESH_SUBNETS)
+        #error "Deprecated MAX_NO_MESH_SUBNETS defined instead of MAX_NR_MESH_SUBNETS. Please update your btstack_config.h to use MAX_NR_MESH_SUBNETS."
+    #else
+        #define MAX_NR_MESH_SUBNETS 0
+    #endif
+#endif
+
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_SUBNETS) && (MAX_NR_MESH_SUBNETS > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
+static mesh_subnet_t mesh_subnet_storage[MAX_NR_MESH_SUBNETS];
+static uint32_t mesh_subnet_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_SUBNETS)];
+#endif
+static btstack_memory_pool_t mesh_subnet_pool;
+mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
+    void * buffer = btstack_memory_pool_get(&mesh_subnet_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(mesh_subnet_t));
+    }
+    return (mesh_subnet_t *) buffer;
+}
+void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    btstack_memory_pool_free(&mesh_subnet_pool, mesh_subnet);
+}
+#elif defined(MAX_NR_MESH_SUBNETS)
+mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
+    return NULL;
+}
+void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    // silence compiler warning about unused parameter in a portable way
+    (void) mesh_subnet;
+};
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t mesh_subnet_statistics;
 mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
     void * buffer = malloc(sizeof(mesh_subnet_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_subnet_t));
     }
+    btstack_memory_pool_statistics_allocated(&mesh_subnet_statistics, buffer);
     return (mesh_subnet_t *) buffer;
 }
 void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    btstack_memory_pool_statistics_freed(&mesh_subnet_statistics, mesh_subnet);
     free(mesh_subnet);
 }
+#endif
 
 
 #endif
 // init
 void btstack_memory_init(void){
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
 #if MAX_NR_HCI_CONNECTIONS > 0
-    btstack_memory_pool_create(&hci_connection_pool, hci_connection_storage, MAX_NR_HCI_CONNECTIONS, sizeof(hci_connection_t));
+    btstack_memory_pool_create(&hci_connection_pool, hci_connection_storage, MAX_NR_HCI_CONNECTIONS, sizeof(hci_connection_t), hci_connection_allocated);
 #endif
 #if MAX_NR_L2CAP_SERVICES > 0
-    btstack_memory_pool_create(&l2cap_service_pool, l2cap_service_storage, MAX_NR_L2CAP_SERVICES, sizeof(l2cap_service_t));
+    btstack_memory_pool_create(&l2cap_service_pool, l2cap_service_storage, MAX_NR_L2CAP_SERVICES, sizeof(l2cap_service_t), l2cap_service_allocated);
 #endif
 #if MAX_NR_L2CAP_CHANNELS > 0
-    btstack_memory_pool_create(&l2cap_channel_pool, l2cap_channel_storage, MAX_NR_L2CAP_CHANNELS, sizeof(l2cap_channel_t));
+    btstack_memory_pool_create(&l2cap_channel_pool, l2cap_channel_storage, MAX_NR_L2CAP_CHANNELS, sizeof(l2cap_channel_t), l2cap_channel_allocated);
 #endif
 #ifdef ENABLE_CLASSIC
 #if MAX_NR_RFCOMM_MULTIPLEXERS > 0
-    btstack_memory_pool_create(&rfcomm_multiplexer_pool, rfcomm_multiplexer_storage, MAX_NR_RFCOMM_MULTIPLEXERS, sizeof(rfcomm_multiplexer_t));
+    btstack_memory_pool_create(&rfcomm_multiplexer_pool, rfcomm_multiplexer_storage, MAX_NR_RFCOMM_MULTIPLEXERS, sizeof(rfcomm_multiplexer_t), rfcomm_multiplexer_allocated);
 #endif
 #if MAX_NR_RFCOMM_SERVICES > 0
-    btstack_memory_pool_create(&rfcomm_service_pool, rfcomm_service_storage, MAX_NR_RFCOMM_SERVICES, sizeof(rfcomm_service_t));
+    btstack_memory_pool_create(&rfcomm_service_pool, rfcomm_service_storage, MAX_NR_RFCOMM_SERVICES, sizeof(rfcomm_service_t), rfcomm_service_allocated);
 #endif
 #if MAX_NR_RFCOMM_CHANNELS > 0
-    btstack_memory_pool_create(&rfcomm_channel_pool, rfcomm_channel_storage, MAX_NR_RFCOMM_CHANNELS, sizeof(rfcomm_channel_t));
+    btstack_memory_pool_create(&rfcomm_channel_pool, rfcomm_channel_storage, MAX_NR_RFCOMM_CHANNELS, sizeof(rfcomm_channel_t), rfcomm_channel_allocated);
 #endif
 #if MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0
-    btstack_memory_pool_create(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry_storage, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES, sizeof(btstack_link_key_db_memory_entry_t));
+    btstack_memory_pool_create(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry_storage, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES, sizeof(btstack_link_key_db_memory_entry_t), btstack_link_key_db_memory_entry_allocated);
 #endif
 #if MAX_NR_BNEP_SERVICES > 0
-    btstack_memory_pool_create(&bnep_service_pool, bnep_service_storage, MAX_NR_BNEP_SERVICES, sizeof(bnep_service_t));
+    btstack_memory_pool_create(&bnep_service_pool, bnep_service_storage, MAX_NR_BNEP_SERVICES, sizeof(bnep_service_t), bnep_service_allocated);
 #endif
 #if MAX_NR_BNEP_CHANNELS > 0
-    btstack_memory_pool_create(&bnep_channel_pool, bnep_channel_storage, MAX_NR_BNEP_CHANNELS, sizeof(bnep_channel_t));
+    btstack_memory_pool_create(&bnep_channel_pool, bnep_channel_storage, MAX_NR_BNEP_CHANNELS, sizeof(bnep_channel_t), bnep_channel_allocated);
 #endif
 #if MAX_NR_HFP_CONNECTIONS > 0
-    btstack_memory_pool_create(&hfp_connection_pool, hfp_connection_storage, MAX_NR_HFP_CONNECTIONS, sizeof(hfp_connection_t));
+    btstack_memory_pool_create(&hfp_connection_pool, hfp_connection_storage, MAX_NR_HFP_CONNECTIONS, sizeof(hfp_connection_t), hfp_connection_allocated);
 #endif
 #if MAX_NR_SERVICE_RECORD_ITEMS > 0
-    btstack_memory_pool_create(&service_record_item_pool, service_record_item_storage, MAX_NR_SERVICE_RECORD_ITEMS, sizeof(service_record_item_t));
+    btstack_memory_pool_create(&service_record_item_pool, service_record_item_storage, MAX_NR_SERVICE_RECORD_ITEMS, sizeof(service_record_item_t), service_record_item_allocated);
 #endif
 #if MAX_NR_AVDTP_STREAM_ENDPOINTS > 0
-    btstack_memory_pool_create(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint_storage, MAX_NR_AVDTP_STREAM_ENDPOINTS, sizeof(avdtp_stream_endpoint_t));
+    btstack_memory_pool_create(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint_storage, MAX_NR_AVDTP_STREAM_ENDPOINTS, sizeof(avdtp_stream_endpoint_t), avdtp_stream_endpoint_allocated);
 #endif
 #if MAX_NR_AVDTP_CONNECTIONS > 0
-    btstack_memory_pool_create(&avdtp_connection_pool, avdtp_connection_storage, MAX_NR_AVDTP_CONNECTIONS, sizeof(avdtp_connection_t));
+    btstack_memory_pool_create(&avdtp_connection_pool, avdtp_connection_storage, MAX_NR_AVDTP_CONNECTIONS, sizeof(avdtp_connection_t), avdtp_connection_allocated);
 #endif
 #if MAX_NR_AVRCP_CONNECTIONS > 0
-    btstack_memory_pool_create(&avrcp_connection_pool, avrcp_connection_storage, MAX_NR_AVRCP_CONNECTIONS, sizeof(avrcp_connection_t));
+    btstack_memory_pool_create(&avrcp_connection_pool, avrcp_connection_storage, MAX_NR_AVRCP_CONNECTIONS, sizeof(avrcp_connection_t), avrcp_connection_allocated);
 #endif
 #if MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0
-    btstack_memory_pool_create(&avrcp_browsing_connection_pool, avrcp_browsing_connection_storage, MAX_NR_AVRCP_BROWSING_CONNECTIONS, sizeof(avrcp_browsing_connection_t));
+    btstack_memory_pool_create(&avrcp_browsing_connection_pool, avrcp_browsing_connection_storage, MAX_NR_AVRCP_BROWSING_CONNECTIONS, sizeof(avrcp_browsing_connection_t), avrcp_browsing_connection_allocated);
 #endif
 #endif
 #ifdef ENABLE_BLE
 #if MAX_NR_GATT_CLIENTS > 0
-    btstack_memory_pool_create(&gatt_client_pool, gatt_client_storage, MAX_NR_GATT_CLIENTS, sizeof(gatt_client_t));
+    btstack_memory_pool_create(&gatt_client_pool, gatt_client_storage, MAX_NR_GATT_CLIENTS, sizeof(gatt_client_t), gatt_client_allocated);
 #endif
 #if MAX_NR_WHITELIST_ENTRIES > 0
-    btstack_memory_pool_create(&whitelist_entry_pool, whitelist_entry_storage, MAX_NR_WHITELIST_ENTRIES, sizeof(whitelist_entry_t));
+    btstack_memory_pool_create(&whitelist_entry_pool, whitelist_entry_storage, MAX_NR_WHITELIST_ENTRIES, sizeof(whitelist_entry_t), whitelist_entry_allocated);
 #endif
 #if MAX_NR_SM_LOOKUP_ENTRIES > 0
-    btstack_memory_pool_create(&sm_lookup_entry_pool, sm_lookup_entry_storage, MAX_NR_SM_LOOKUP_ENTRIES, sizeof(sm_lookup_entry_t));
+    btstack_memory_pool_create(&sm_lookup_entry_pool, sm_lookup_entry_storage, MAX_NR_SM_LOOKUP_ENTRIES, sizeof(sm_lookup_entry_t), sm_lookup_entry_allocated);
 #endif
 #endif
 #ifdef ENABLE_MESH
 #if MAX_NR_MESH_NETWORK_PDUS > 0
-    btstack_memory_pool_create(&mesh_network_pdu_pool, mesh_network_pdu_storage, MAX_NR_MESH_NETWORK_PDUS, sizeof(mesh_network_pdu_t));
+    btstack_memory_pool_create(&mesh_network_pdu_pool, mesh_network_pdu_storage, MAX_NR_MESH_NETWORK_PDUS, sizeof(mesh_network_pdu_t), mesh_network_pdu_allocated);
 #endif
 #if MAX_NR_MESH_TRANSPORT_PDUS > 0
-    btstack_memory_pool_create(&mesh_transport_pdu_pool, mesh_transport_pdu_storage, MAX_NR_MESH_TRANSPORT_PDUS, sizeof(mesh_transport_pdu_t));
+    btstack_memory_pool_create(&mesh_transport_pdu_pool, mesh_transport_pdu_storage, MAX_NR_MESH_TRANSPORT_PDUS, sizeof(mesh_transport_pdu_t), mesh_transport_pdu_allocated);
 #endif
 #if MAX_NR_MESH_NETWORK_KEYS > 0
-    btstack_memory_pool_create(&mesh_network_key_pool, mesh_network_key_storage, MAX_NR_MESH_NETWORK_KEYS, sizeof(mesh_network_key_t));
+    btstack_memory_pool_create(&mesh_network_key_pool, mesh_network_key_storage, MAX_NR_MESH_NETWORK_KEYS, sizeof(mesh_network_key_t), mesh_network_key_allocated);
 #endif
 #if MAX_NR_MESH_TRANSPORT_KEYS > 0
-    btstack_memory_pool_create(&mesh_transport_key_pool, mesh_transport_key_storage, MAX_NR_MESH_TRANSPORT_KEYS, sizeof(mesh_transport_key_t));
+    btstack_memory_pool_create(&mesh_transport_key_pool, mesh_transport_key_storage, MAX_NR_MESH_TRANSPORT_KEYS, sizeof(mesh_transport_key_t), mesh_transport_key_allocated);
 #endif
 #if MAX_NR_MESH_VIRTUAL_ADDRESSS > 0
-    btstack_memory_pool_create(&mesh_virtual_address_pool, mesh_virtual_address_storage, MAX_NR_MESH_VIRTUAL_ADDRESSS, sizeof(mesh_virtual_address_t));
+    btstack_memory_pool_create(&mesh_virtual_address_pool, mesh_virtual_address_storage, MAX_NR_MESH_VIRTUAL_ADDRESSS, sizeof(mesh_virtual_address_t), mesh_virtual_address_allocated);
 #endif
 #if MAX_NR_MESH_SUBNETS > 0
-    btstack_memory_pool_create(&mesh_subnet_pool, mesh_subnet_storage, MAX_NR_MESH_SUBNETS, sizeof(mesh_subnet_t));
+    btstack_memory_pool_create(&mesh_subnet_pool, mesh_subnet_storage, MAX_NR_MESH_SUBNETS, sizeof(mesh_subnet_t), mesh_subnet_allocated);
+#endif
+#endif
+#endif
+}
+
+// arena
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+uint32_t btstack_memory_arena_get_size(const btstack_memory_arena_config_t * config){
+    uint32_t size = 0;
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_hci_connections, sizeof(hci_connection_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_l2cap_services, sizeof(l2cap_service_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_l2cap_channels, sizeof(l2cap_channel_t));
+#ifdef ENABLE_CLASSIC
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_rfcomm_multiplexers, sizeof(rfcomm_multiplexer_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_rfcomm_services, sizeof(rfcomm_service_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_rfcomm_channels, sizeof(rfcomm_channel_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_btstack_link_key_db_memory_entries, sizeof(btstack_link_key_db_memory_entry_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_bnep_services, sizeof(bnep_service_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_bnep_channels, sizeof(bnep_channel_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_hfp_connections, sizeof(hfp_connection_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_service_record_items, sizeof(service_record_item_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_avdtp_stream_endpoints, sizeof(avdtp_stream_endpoint_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_avdtp_connections, sizeof(avdtp_connection_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_avrcp_connections, sizeof(avrcp_connection_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_avrcp_browsing_connections, sizeof(avrcp_browsing_connection_t));
+#endif
+#ifdef ENABLE_BLE
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_gatt_clients, sizeof(gatt_client_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_whitelist_entries, sizeof(whitelist_entry_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_sm_lookup_entries, sizeof(sm_lookup_entry_t));
+#endif
+#ifdef ENABLE_MESH
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_mesh_network_pdus, sizeof(mesh_network_pdu_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_mesh_transport_pdus, sizeof(mesh_transport_pdu_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_mesh_network_keys, sizeof(mesh_network_key_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_mesh_transport_keys, sizeof(mesh_transport_key_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_mesh_virtual_addresss, sizeof(mesh_virtual_address_t));
+    size += btstack_memory_pool_get_buffer_size(config->max_nr_mesh_subnets, sizeof(mesh_subnet_t));
+#endif
+    return size;
+}
+
+uint8_t btstack_memory_init_arena(void * arena, uint32_t arena_size, const btstack_memory_arena_config_t * config){
+    // align start of arena
+    uint32_t misalignment = (uint32_t) (((uintptr_t) arena) & (BTSTACK_MEMORY_POOL_ALIGNMENT - 1));
+    uint32_t offset = (misalignment == 0) ? 0 : (BTSTACK_MEMORY_POOL_ALIGNMENT - misalignment);
+    if ((offset + btstack_memory_arena_get_size(config)) > arena_size){
+        log_error("btstack_memory_init_arena: arena with %u bytes too small", (unsigned int) arena_size);
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+    // carve pools from arena one after the other
+    uint8_t * buffer = ((uint8_t *) arena) + offset;
+    buffer += btstack_memory_pool_create_in_buffer(&hci_connection_pool, buffer, config->max_nr_hci_connections, sizeof(hci_connection_t));
+    buffer += btstack_memory_pool_create_in_buffer(&l2cap_service_pool, buffer, config->max_nr_l2cap_services, sizeof(l2cap_service_t));
+    buffer += btstack_memory_pool_create_in_buffer(&l2cap_channel_pool, buffer, config->max_nr_l2cap_channels, sizeof(l2cap_channel_t));
+#ifdef ENABLE_CLASSIC
+    buffer += btstack_memory_pool_create_in_buffer(&rfcomm_multiplexer_pool, buffer, config->max_nr_rfcomm_multiplexers, sizeof(rfcomm_multiplexer_t));
+    buffer += btstack_memory_pool_create_in_buffer(&rfcomm_service_pool, buffer, config->max_nr_rfcomm_services, sizeof(rfcomm_service_t));
+    buffer += btstack_memory_pool_create_in_buffer(&rfcomm_channel_pool, buffer, config->max_nr_rfcomm_channels, sizeof(rfcomm_channel_t));
+    buffer += btstack_memory_pool_create_in_buffer(&btstack_link_key_db_memory_entry_pool, buffer, config->max_nr_btstack_link_key_db_memory_entries, sizeof(btstack_link_key_db_memory_entry_t));
+    buffer += btstack_memory_pool_create_in_buffer(&bnep_service_pool, buffer, config->max_nr_bnep_services, sizeof(bnep_service_t));
+    buffer += btstack_memory_pool_create_in_buffer(&bnep_channel_pool, buffer, config->max_nr_bnep_channels, sizeof(bnep_channel_t));
+    buffer += btstack_memory_pool_create_in_buffer(&hfp_connection_pool, buffer, config->max_nr_hfp_connections, sizeof(hfp_connection_t));
+    buffer += btstack_memory_pool_create_in_buffer(&service_record_item_pool, buffer, config->max_nr_service_record_items, sizeof(service_record_item_t));
+    buffer += btstack_memory_pool_create_in_buffer(&avdtp_stream_endpoint_pool, buffer, config->max_nr_avdtp_stream_endpoints, sizeof(avdtp_stream_endpoint_t));
+    buffer += btstack_memory_pool_create_in_buffer(&avdtp_connection_pool, buffer, config->max_nr_avdtp_connections, sizeof(avdtp_connection_t));
+    buffer += btstack_memory_pool_create_in_buffer(&avrcp_connection_pool, buffer, config->max_nr_avrcp_connections, sizeof(avrcp_connection_t));
+    buffer += btstack_memory_pool_create_in_buffer(&avrcp_browsing_connection_pool, buffer, config->max_nr_avrcp_browsing_connections, sizeof(avrcp_browsing_connection_t));
+#endif
+#ifdef ENABLE_BLE
+    buffer += btstack_memory_pool_create_in_buffer(&gatt_client_pool, buffer, config->max_nr_gatt_clients, sizeof(gatt_client_t));
+    buffer += btstack_memory_pool_create_in_buffer(&whitelist_entry_pool, buffer, config->max_nr_whitelist_entries, sizeof(whitelist_entry_t));
+    buffer += btstack_memory_pool_create_in_buffer(&sm_lookup_entry_pool, buffer, config->max_nr_sm_lookup_entries, sizeof(sm_lookup_entry_t));
+#endif
+#ifdef ENABLE_MESH
+    buffer += btstack_memory_pool_create_in_buffer(&mesh_network_pdu_pool, buffer, config->max_nr_mesh_network_pdus, sizeof(mesh_network_pdu_t));
+    buffer += btstack_memory_pool_create_in_buffer(&mesh_transport_pdu_pool, buffer, config->max_nr_mesh_transport_pdus, sizeof(mesh_transport_pdu_t));
+    buffer += btstack_memory_pool_create_in_buffer(&mesh_network_key_pool, buffer, config->max_nr_mesh_network_keys, sizeof(mesh_network_key_t));
+    buffer += btstack_memory_pool_create_in_buffer(&mesh_transport_key_pool, buffer, config->max_nr_mesh_transport_keys, sizeof(mesh_transport_key_t));
+    buffer += btstack_memory_pool_create_in_buffer(&mesh_virtual_address_pool, buffer, config->max_nr_mesh_virtual_addresss, sizeof(mesh_virtual_address_t));
+    buffer += btstack_memory_pool_create_in_buffer(&mesh_subnet_pool, buffer, config->max_nr_mesh_subnets, sizeof(mesh_subnet_t));
+#endif
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
+// statistics
+void btstack_memory_get_statistics(void (*callback)(const char * name, const btstack_memory_pool_statistics_t * statistics)){
+    // silence compiler warning about unused parameter if no pools are configured
+    (void) callback;
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_HCI_CONNECTIONS) && (MAX_NR_HCI_CONNECTIONS > 0))
+    (*callback)("hci_connection", btstack_memory_pool_get_statistics(&hci_connection_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("hci_connection", &hci_connection_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_L2CAP_SERVICES) && (MAX_NR_L2CAP_SERVICES > 0))
+    (*callback)("l2cap_service", btstack_memory_pool_get_statistics(&l2cap_service_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("l2cap_service", &l2cap_service_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_L2CAP_CHANNELS) && (MAX_NR_L2CAP_CHANNELS > 0))
+    (*callback)("l2cap_channel", btstack_memory_pool_get_statistics(&l2cap_channel_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("l2cap_channel", &l2cap_channel_statistics);
+#endif
+#ifdef ENABLE_CLASSIC
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_RFCOMM_MULTIPLEXERS) && (MAX_NR_RFCOMM_MULTIPLEXERS > 0))
+    (*callback)("rfcomm_multiplexer", btstack_memory_pool_get_statistics(&rfcomm_multiplexer_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("rfcomm_multiplexer", &rfcomm_multiplexer_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_RFCOMM_SERVICES) && (MAX_NR_RFCOMM_SERVICES > 0))
+    (*callback)("rfcomm_service", btstack_memory_pool_get_statistics(&rfcomm_service_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("rfcomm_service", &rfcomm_service_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_RFCOMM_CHANNELS) && (MAX_NR_RFCOMM_CHANNELS > 0))
+    (*callback)("rfcomm_channel", btstack_memory_pool_get_statistics(&rfcomm_channel_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("rfcomm_channel", &rfcomm_channel_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES) && (MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0))
+    (*callback)("btstack_link_key_db_memory_entry", btstack_memory_pool_get_statistics(&btstack_link_key_db_memory_entry_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("btstack_link_key_db_memory_entry", &btstack_link_key_db_memory_entry_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_BNEP_SERVICES) && (MAX_NR_BNEP_SERVICES > 0))
+    (*callback)("bnep_service", btstack_memory_pool_get_statistics(&bnep_service_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("bnep_service", &bnep_service_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_BNEP_CHANNELS) && (MAX_NR_BNEP_CHANNELS > 0))
+    (*callback)("bnep_channel", btstack_memory_pool_get_statistics(&bnep_channel_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("bnep_channel", &bnep_channel_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_HFP_CONNECTIONS) && (MAX_NR_HFP_CONNECTIONS > 0))
+    (*callback)("hfp_connection", btstack_memory_pool_get_statistics(&hfp_connection_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("hfp_connection", &hfp_connection_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_SERVICE_RECORD_ITEMS) && (MAX_NR_SERVICE_RECORD_ITEMS > 0))
+    (*callback)("service_record_item", btstack_memory_pool_get_statistics(&service_record_item_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("service_record_item", &service_record_item_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVDTP_STREAM_ENDPOINTS) && (MAX_NR_AVDTP_STREAM_ENDPOINTS > 0))
+    (*callback)("avdtp_stream_endpoint", btstack_memory_pool_get_statistics(&avdtp_stream_endpoint_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("avdtp_stream_endpoint", &avdtp_stream_endpoint_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVDTP_CONNECTIONS) && (MAX_NR_AVDTP_CONNECTIONS > 0))
+    (*callback)("avdtp_connection", btstack_memory_pool_get_statistics(&avdtp_connection_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("avdtp_connection", &avdtp_connection_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVRCP_CONNECTIONS) && (MAX_NR_AVRCP_CONNECTIONS > 0))
+    (*callback)("avrcp_connection", btstack_memory_pool_get_statistics(&avrcp_connection_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("avrcp_connection", &avrcp_connection_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_AVRCP_BROWSING_CONNECTIONS) && (MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0))
+    (*callback)("avrcp_browsing_connection", btstack_memory_pool_get_statistics(&avrcp_browsing_connection_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("avrcp_browsing_connection", &avrcp_browsing_connection_statistics);
+#endif
+#endif
+#ifdef ENABLE_BLE
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_GATT_CLIENTS) && (MAX_NR_GATT_CLIENTS > 0))
+    (*callback)("gatt_client", btstack_memory_pool_get_statistics(&gatt_client_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("gatt_client", &gatt_client_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_WHITELIST_ENTRIES) && (MAX_NR_WHITELIST_ENTRIES > 0))
+    (*callback)("whitelist_entry", btstack_memory_pool_get_statistics(&whitelist_entry_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("whitelist_entry", &whitelist_entry_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_SM_LOOKUP_ENTRIES) && (MAX_NR_SM_LOOKUP_ENTRIES > 0))
+    (*callback)("sm_lookup_entry", btstack_memory_pool_get_statistics(&sm_lookup_entry_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("sm_lookup_entry", &sm_lookup_entry_statistics);
+#endif
+#endif
+#ifdef ENABLE_MESH
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_NETWORK_PDUS) && (MAX_NR_MESH_NETWORK_PDUS > 0))
+    (*callback)("mesh_network_pdu", btstack_memory_pool_get_statistics(&mesh_network_pdu_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("mesh_network_pdu", &mesh_network_pdu_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_TRANSPORT_PDUS) && (MAX_NR_MESH_TRANSPORT_PDUS > 0))
+    (*callback)("mesh_transport_pdu", btstack_memory_pool_get_statistics(&mesh_transport_pdu_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("mesh_transport_pdu", &mesh_transport_pdu_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_NETWORK_KEYS) && (MAX_NR_MESH_NETWORK_KEYS > 0))
+    (*callback)("mesh_network_key", btstack_memory_pool_get_statistics(&mesh_network_key_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("mesh_network_key", &mesh_network_key_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_TRANSPORT_KEYS) && (MAX_NR_MESH_TRANSPORT_KEYS > 0))
+    (*callback)("mesh_transport_key", btstack_memory_pool_get_statistics(&mesh_transport_key_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("mesh_transport_key", &mesh_transport_key_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_VIRTUAL_ADDRESSS) && (MAX_NR_MESH_VIRTUAL_ADDRESSS > 0))
+    (*callback)("mesh_virtual_address", btstack_memory_pool_get_statistics(&mesh_virtual_address_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("mesh_virtual_address", &mesh_virtual_address_statistics);
+#endif
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(MAX_NR_MESH_SUBNETS) && (MAX_NR_MESH_SUBNETS > 0))
+    (*callback)("mesh_subnet", btstack_memory_pool_get_statistics(&mesh_subnet_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("mesh_subnet", &mesh_subnet_statistics);
 #endif
 #endif
 }
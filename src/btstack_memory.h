@@ -53,6 +53,8 @@ extern "C" {
 
 #include "btstack_config.h"
 
+#include "btstack_memory_pool.h"
+
 // Core
 #include "hci.h"
 #include "l2cap.h"
@@ -82,11 +84,64 @@ extern "C" {
 
 /* API_START */
 
+// number of elements per type for btstack_memory_init_arena, fields named after MAX_NR_* defines
+typedef struct {
+    uint16_t max_nr_hci_connections;
+    uint16_t max_nr_l2cap_services;
+    uint16_t max_nr_l2cap_channels;
+    uint16_t max_nr_rfcomm_multiplexers;
+    uint16_t max_nr_rfcomm_services;
+    uint16_t max_nr_rfcomm_channels;
+    uint16_t max_nr_btstack_link_key_db_memory_entries;
+    uint16_t max_nr_bnep_services;
+    uint16_t max_nr_bnep_channels;
+    uint16_t max_nr_hfp_connections;
+    uint16_t max_nr_service_record_items;
+    uint16_t max_nr_avdtp_stream_endpoints;
+    uint16_t max_nr_avdtp_connections;
+    uint16_t max_nr_avrcp_connections;
+    uint16_t max_nr_avrcp_browsing_connections;
+    uint16_t max_nr_gatt_clients;
+    uint16_t max_nr_whitelist_entries;
+    uint16_t max_nr_sm_lookup_entries;
+    uint16_t max_nr_mesh_network_pdus;
+    uint16_t max_nr_mesh_transport_pdus;
+    uint16_t max_nr_mesh_network_keys;
+    uint16_t max_nr_mesh_transport_keys;
+    uint16_t max_nr_mesh_virtual_addresss;
+    uint16_t max_nr_mesh_subnets;
+} btstack_memory_arena_config_t;
+
 /**
  * @brief Initializes BTstack memory pools.
  */
 void btstack_memory_init(void);
 
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+/**
+ * @brief Get size of arena needed for given number of elements per type
+ * @param config
+ * @return size in bytes for an arena aligned to BTSTACK_MEMORY_POOL_ALIGNMENT
+ */
+uint32_t btstack_memory_arena_get_size(const btstack_memory_arena_config_t * config);
+
+/**
+ * @brief Initializes BTstack memory pools from single arena instead of btstack_memory_init with ENABLE_BTSTACK_MEMORY_ARENA
+ * @note  pools are placed contiguously in the order of btstack_memory_arena_config_t, MAX_NR_* defines are ignored
+ * @param arena
+ * @param arena_size
+ * @param config with number of elements per type, fields for types of disabled features are ignored
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if arena is too small
+ */
+uint8_t btstack_memory_init_arena(void * arena, uint32_t arena_size, const btstack_memory_arena_config_t * config);
+#endif
+
+/**
+ * @brief Report usage of all memory pools, or of allocations via malloc with HAVE_MALLOC, for capacity planning
+ * @param callback called with type name, e.g. "l2cap_channel", and statistics for each pool
+ */
+void btstack_memory_get_statistics(void (*callback)(const char * name, const btstack_memory_pool_statistics_t * statistics));
+
 /* API_END */
 
 // hci_connection
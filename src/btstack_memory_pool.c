@@ -42,58 +42,113 @@
  *
  *  Fixed-size block allocation
  *
- *  Free blocks are kept in singly linked list
+ *  Free blocks are kept in singly linked list. A bitmap with one bit per block marks the allocated ones,
+ *  which allows to detect double free and blocks from other pools without walking the free list.
  *
  */
 
 #include "btstack_memory_pool.h"
 
 #include <stddef.h>
+#include <string.h>
 #include "btstack_debug.h"
 
 typedef struct node {
     struct node * next;
 } node_t;
 
-void btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size){
-    node_t *free_blocks = (node_t*) pool;
-    char   *mem_ptr = (char *) storage;
-    int i;
-    
+static void btstack_memory_pool_push(btstack_memory_pool_t *pool, node_t * node){
+    node->next = (node_t *) pool->free_blocks;
+    pool->free_blocks = node;
+}
+
+void btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size, uint32_t * allocated){
+    pool->storage     = (uint8_t *) storage;
+    pool->allocated   = allocated;
+    pool->block_size  = (uint32_t) block_size;
+    pool->free_blocks = NULL;
+    memset(&pool->statistics, 0, sizeof(btstack_memory_pool_statistics_t));
+    pool->statistics.num_blocks = (uint32_t) count;
+    memset(allocated, 0, BTSTACK_MEMORY_POOL_BITMAP_SIZE(count) * sizeof(uint32_t));
+
     // create singly linked list of all available blocks
-    free_blocks->next = NULL;
+    int i;
     for (i = 0 ; i < count ; i++){
-        btstack_memory_pool_free(pool, mem_ptr);
-        mem_ptr += block_size;
+        btstack_memory_pool_push(pool, (node_t *) &pool->storage[i * block_size]);
     }
 }
 
+static uint32_t btstack_memory_pool_align(uint32_t size){
+    return (size + BTSTACK_MEMORY_POOL_ALIGNMENT - 1) & ~((uint32_t) BTSTACK_MEMORY_POOL_ALIGNMENT - 1);
+}
+
+uint32_t btstack_memory_pool_get_buffer_size(int count, int block_size){
+    uint32_t storage_size = btstack_memory_pool_align((uint32_t) count * (uint32_t) block_size);
+    uint32_t bitmap_size  = btstack_memory_pool_align(BTSTACK_MEMORY_POOL_BITMAP_SIZE((uint32_t) count) * sizeof(uint32_t));
+    return storage_size + bitmap_size;
+}
+
+uint32_t btstack_memory_pool_create_in_buffer(btstack_memory_pool_t *pool, uint8_t * buffer, int count, int block_size){
+    // blocks first, followed by allocated bitmap
+    uint32_t storage_size = btstack_memory_pool_align((uint32_t) count * (uint32_t) block_size);
+    btstack_memory_pool_create(pool, buffer, count, block_size, (uint32_t *) (void *) &buffer[storage_size]);
+    return btstack_memory_pool_get_buffer_size(count, block_size);
+}
+
 void * btstack_memory_pool_get(btstack_memory_pool_t *pool){
-    node_t *free_blocks = (node_t*) pool;
-    
-    if (!free_blocks->next) return NULL;
-    
+    node_t * node = (node_t *) pool->free_blocks;
+    if (node == NULL) {
+        pool->statistics.num_failed++;
+        return NULL;
+    }
+
     // remove first
-    node_t *node      = free_blocks->next;
-    free_blocks->next = node->next;
-    
+    pool->free_blocks = node->next;
+
+    uint32_t index = (uint32_t) ((uint8_t *) node - pool->storage) / pool->block_size;
+    pool->allocated[index >> 5] |= 1u << (index & 31);
+    btstack_memory_pool_statistics_allocated(&pool->statistics, node);
     return (void*) node;
 }
 
 void btstack_memory_pool_free(btstack_memory_pool_t *pool, void * block){
-    node_t *free_blocks = (node_t*) pool;
-    node_t *node        = (node_t*) block;
-
-    // raise error and abort if node already in list
-    node_t * it;
-    for (it = free_blocks->next; it != NULL; it = it->next){
-        if (it == node) {
-            log_error("btstack_memory_pool_free: block %p freed twice for pool %p", block, pool);
-            return;
-        }
+    // raise error and abort if block is not from this pool or not allocated
+    uint8_t * block_ptr = (uint8_t *) block;
+    uint32_t  pool_size = pool->statistics.num_blocks * pool->block_size;
+    if ((block_ptr < pool->storage) || (block_ptr >= &pool->storage[pool_size])
+    || ((((uint32_t) (block_ptr - pool->storage)) % pool->block_size) != 0)){
+        log_error("btstack_memory_pool_free: block %p not from pool %p", block, pool);
+        return;
+    }
+    uint32_t index = (uint32_t) (block_ptr - pool->storage) / pool->block_size;
+    uint32_t mask  = 1u << (index & 31);
+    if ((pool->allocated[index >> 5] & mask) == 0){
+        log_error("btstack_memory_pool_free: block %p freed twice for pool %p", block, pool);
+        return;
     }
+    pool->allocated[index >> 5] &= ~mask;
 
     // add block as node to list
-    node->next          = free_blocks->next;
-    free_blocks->next   = node;
+    btstack_memory_pool_push(pool, (node_t *) block);
+    btstack_memory_pool_statistics_freed(&pool->statistics, block);
+}
+
+const btstack_memory_pool_statistics_t * btstack_memory_pool_get_statistics(const btstack_memory_pool_t *pool){
+    return &pool->statistics;
+}
+
+void btstack_memory_pool_statistics_allocated(btstack_memory_pool_statistics_t * statistics, const void * block){
+    if (block == NULL){
+        statistics->num_failed++;
+        return;
+    }
+    statistics->num_used++;
+    if (statistics->num_used > statistics->max_used){
+        statistics->max_used = statistics->num_used;
+    }
+}
+
+void btstack_memory_pool_statistics_freed(btstack_memory_pool_statistics_t * statistics, const void * block){
+    if (block == NULL) return;
+    statistics->num_used--;
 }
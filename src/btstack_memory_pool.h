@@ -42,21 +42,53 @@
  *
  *  @Assumption block_size >= sizeof(void *)
  *  @Assumption size of storage >= count * block_size
+ *  @Assumption size of allocated bitmap >= BTSTACK_MEMORY_POOL_BITMAP_SIZE(count) words
  *
- *  @Note minimal implementation, no error checking/handling
+ *  @Note double free and blocks not from this pool are detected in O(1) via the allocated bitmap and ignored
  */
 
 #ifndef btstack_memory_pool_H
 #define btstack_memory_pool_H
 
+#include <stdint.h>
+
 #if defined __cplusplus
 extern "C" {
 #endif
 
-typedef void * btstack_memory_pool_t;
+// number of uint32_t words needed for allocated bitmap of a pool with count blocks
+#define BTSTACK_MEMORY_POOL_BITMAP_SIZE(count) (((count) + 31) / 32)
+
+// alignment of storage and allocated bitmap for pools created in a buffer, must be a power of two
+#ifndef BTSTACK_MEMORY_POOL_ALIGNMENT
+#define BTSTACK_MEMORY_POOL_ALIGNMENT 8
+#endif
+
+// usage statistics, also used by btstack_memory for allocations via malloc
+typedef struct {
+    uint32_t num_blocks;    // 0 for malloc
+    uint32_t num_used;
+    uint32_t max_used;      // high-water mark
+    uint32_t num_failed;    // failed allocations
+} btstack_memory_pool_statistics_t;
+
+typedef struct btstack_memory_pool {
+    // singly linked list of free blocks
+    void     * free_blocks;
+    uint8_t  * storage;
+    uint32_t * allocated;
+    uint32_t   block_size;
+    btstack_memory_pool_statistics_t statistics;
+} btstack_memory_pool_t;
 
-// initialize memory pool with with given storage, block size and count
-void   btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size);
+// initialize memory pool with with given storage, block size and count, allocated bitmap is cleared
+void   btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size, uint32_t * allocated);
+
+// get size of buffer needed for storage and allocated bitmap of a pool with count blocks, multiple of BTSTACK_MEMORY_POOL_ALIGNMENT
+uint32_t btstack_memory_pool_get_buffer_size(int count, int block_size);
+
+// initialize memory pool with storage and allocated bitmap placed in buffer aligned to BTSTACK_MEMORY_POOL_ALIGNMENT, @returns bytes used
+uint32_t btstack_memory_pool_create_in_buffer(btstack_memory_pool_t *pool, uint8_t * buffer, int count, int block_size);
 
 // get free block from pool, @returns NULL or pointer to block
 void * btstack_memory_pool_get(btstack_memory_pool_t *pool);
@@ -64,6 +96,15 @@ void * btstack_memory_pool_get(btstack_memory_pool_t *pool);
 // return previously reserved block to memory pool
 void   btstack_memory_pool_free(btstack_memory_pool_t *pool, void * block);
 
+// get usage statistics of pool
+const btstack_memory_pool_statistics_t * btstack_memory_pool_get_statistics(const btstack_memory_pool_t *pool);
+
+// update usage statistics after allocation attempt, used for malloc
+void   btstack_memory_pool_statistics_allocated(btstack_memory_pool_statistics_t * statistics, const void * block);
+
+// update usage statistics after free, used for malloc
+void   btstack_memory_pool_statistics_freed(btstack_memory_pool_statistics_t * statistics, const void * block);
+
 #if defined __cplusplus
 }
 #endif
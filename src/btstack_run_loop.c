@@ -44,6 +44,7 @@
  */
 
 #include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -81,7 +82,7 @@ void * btstack_run_loop_get_data_source_handle(btstack_data_source_t *ds){
 
 void btstack_run_loop_enable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t *ds, uint16_t callbacks){
     if (btstack->run_loop->run_loop->enable_data_source_callbacks){
-        btstack->run_loop->run_loop->enable_data_source_callbacks(ds, callbacks);
+        btstack->run_loop->run_loop->enable_data_source_callbacks(btstack, ds, callbacks);
     } else {
         log_error("btstack_run_loop_remove_data_source not implemented");
     }
@@ -89,7 +90,7 @@ void btstack_run_loop_enable_data_source_callbacks(btstack_state_t *btstack, bts
 
 void btstack_run_loop_disable_data_source_callbacks(btstack_state_t *btstack, btstack_data_source_t *ds, uint16_t callbacks){
     if (btstack->run_loop->run_loop->disable_data_source_callbacks){
-        btstack->run_loop->run_loop->disable_data_source_callbacks(ds, callbacks);
+        btstack->run_loop->run_loop->disable_data_source_callbacks(btstack, ds, callbacks);
     } else {
         log_error("btstack_run_loop_disable_data_source_callbacks not implemented");
     }
@@ -158,6 +159,14 @@ uint32_t btstack_run_loop_get_time_ms(btstack_state_t *btstack){
 }
 
 
+void btstack_run_loop_execute_on_main_thread(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration){
+    if (btstack->run_loop->run_loop->execute_on_main_thread){
+        btstack->run_loop->run_loop->execute_on_main_thread(btstack, callback_registration);
+    } else {
+        log_error("btstack_run_loop_execute_on_main_thread not implemented");
+    }
+}
+
 void btstack_run_loop_timer_dump(btstack_state_t *btstack){
     btstack->run_loop->run_loop->dump_timer(btstack);
 }
@@ -178,3 +187,13 @@ void btstack_run_loop_init(btstack_state_t * btstack, const btstack_run_loop_t *
     btstack->run_loop->run_loop->init(btstack);
 }
 
+void btstack_run_loop_deinit(btstack_state_t * btstack){
+    if (btstack->run_loop == NULL) return;
+    if (btstack->run_loop->run_loop->deinit != NULL){
+        btstack->run_loop->run_loop->deinit(btstack);
+    }
+    btstack_run_loop_base_deinit(btstack);
+    free(btstack->run_loop);
+    btstack->run_loop = NULL;
+}
+
@@ -48,6 +48,7 @@
 #include "btstack_state.h"
 
 #include "btstack_bool.h"
+#include "btstack_defines.h"
 #include "btstack_linked_list.h"
 
 #include <stdint.h>
@@ -98,33 +99,57 @@ typedef struct btstack_timer_source {
     // will be called when timer fired
     void  (*process)(btstack_state_t *btstack, struct btstack_timer_source *ts);
     void * context;
+    // position in run loop timer heap, only valid while timer is active
+    uint32_t heap_index;
 } btstack_timer_source_t;
 
 typedef struct btstack_run_loop {
 	void (*init)(btstack_state_t * state);
 	void (*add_data_source)(btstack_state_t *btstack, btstack_data_source_t * data_source);
 	bool (*remove_data_source)(btstack_state_t *btstack, btstack_data_source_t * data_source);
-	void (*enable_data_source_callbacks)(btstack_data_source_t * data_source, uint16_t callbacks);
-	void (*disable_data_source_callbacks)(btstack_data_source_t * data_source, uint16_t callbacks);
+	void (*enable_data_source_callbacks)(btstack_state_t *btstack, btstack_data_source_t * data_source, uint16_t callbacks);
+	void (*disable_data_source_callbacks)(btstack_state_t *btstack, btstack_data_source_t * data_source, uint16_t callbacks);
 	void (*set_timer)(btstack_state_t *btstack, btstack_timer_source_t * timer, uint32_t timeout_in_ms);
 	void (*add_timer)(btstack_state_t *btstack, btstack_timer_source_t *timer);
 	bool  (*remove_timer)(btstack_state_t *btstack, btstack_timer_source_t *timer);
 	void (*execute)(btstack_state_t *btstack);
 	void (*dump_timer)(btstack_state_t *btstack);
 	uint32_t (*get_time_ms)(btstack_state_t *btstack);
+	void (*execute_on_main_thread)(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration);
+	void (*deinit)(btstack_state_t *btstack);
 } btstack_run_loop_t;
 
+// max number of active timers per run loop if timer heap cannot grow with realloc
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_BTSTACK_TIMERS)
+#define MAX_NR_BTSTACK_TIMERS 32
+#endif
+
 struct btstack_run_loop_state {
     btstack_linked_list_t data_sources;
-    btstack_linked_list_t timers;
+    // binary min-heap of active timers ordered by timeout, see btstack_run_loop_base.c
+    btstack_timer_source_t ** timers;
+    uint32_t num_timers;
+    uint32_t max_timers;
+#ifdef MAX_NR_BTSTACK_TIMERS
+    btstack_timer_source_t * timers_storage[MAX_NR_BTSTACK_TIMERS];
+#endif
     const btstack_run_loop_t * run_loop;
     int trigger_event_received;
     int data_sources_modified;
 	int exit;
+    // callbacks added by btstack_run_loop_execute_on_main_thread, most recent first
+    btstack_context_callback_registration_t * callbacks;
+    // used by POSIX run loops to wake up from select/epoll_wait when a callback was added
+    btstack_data_source_t wakeup_data_source;
+    int wakeup_fd;
 #ifdef HAVE_POSIX_TIME
     // start time. tv_usec/tv_nsec = 0
     struct timespec init_ts;
 #endif
+#ifdef HAVE_EPOLL
+    // epoll instance with all registered data sources
+    int epoll_fd;
+#endif
 };
 
 void btstack_run_loop_timer_dump(btstack_state_t *btstack);
@@ -138,6 +163,11 @@ void btstack_run_loop_timer_dump(btstack_state_t *btstack);
  */
 void btstack_run_loop_init(btstack_state_t * state, const btstack_run_loop_t * run_loop);
 
+/**
+ * @brief Deinit run loop and release its resources, e.g. file descriptors. Data sources and timers have to be removed before
+ */
+void btstack_run_loop_deinit(btstack_state_t * state);
+
 /**
  * @brief Set timer based on current time in milliseconds.
  */
@@ -234,6 +264,13 @@ void btstack_run_loop_add_data_source(btstack_state_t *btstack, btstack_data_sou
  */
 int btstack_run_loop_remove_data_source(btstack_state_t *btstack, btstack_data_source_t * data_source);
 
+/**
+ * @brief Execute callback on the run loop thread during the next run loop iteration
+ * @note Can be called from any thread or interrupt context, callback registration must stay valid until callback was executed
+ * @param callback_registration with callback and context
+ */
+void btstack_run_loop_execute_on_main_thread(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration);
+
 /**
  * @brief Execute configured run loop once.
  */
@@ -38,28 +38,65 @@
 #define BTSTACK_FILE__ "btstack_run_loop_base.c"
 
 /*
- *  btstack_run_loop_base.h
+ *  btstack_run_loop_base.c
  *
  *  Portable implementation of timer and data source managment as base for platform specific implementations
+ *
+ *  Timers are kept in a binary min-heap ordered by timeout, each timer stores its position in the heap.
+ *  Adding and removing a timer is O(log n), getting the next timer is O(1). The heap grows with realloc,
+ *  or has a fixed capacity of MAX_NR_BTSTACK_TIMERS if defined or without HAVE_MALLOC.
+ *
+ *  Callbacks from other threads are pushed onto a singly linked list, the run loop takes the complete list at once.
+ *  On hosted systems, this is done lock-free with atomic compare-and-swap / exchange, which makes it a
+ *  multi-producer / single-consumer queue. Embedded run loops disable interrupts instead.
  */
 
 #include "btstack_debug.h"
 #include "btstack_config.h"
+#include "btstack_instrumentation.h"
 #include "btstack_util.h"
 
 #include "btstack_run_loop_base.h"
 
-void btstack_run_loop_base_init(void){
-    btstack_run_loop_base_timers = NULL;
-    btstack_run_loop_base_data_sources = NULL;
+#include <stdlib.h>
+
+#if !defined(HAVE_EMBEDDED_TICK) && !defined(HAVE_EMBEDDED_TIME_MS)
+#define RUN_LOOP_BASE_LOCK_FREE_CALLBACKS
+#endif
+
+#ifndef MAX_NR_BTSTACK_TIMERS
+// initial size of timer heap, doubled when full
+#define BTSTACK_RUN_LOOP_BASE_TIMERS_INITIAL 16
+#endif
+
+void btstack_run_loop_base_init(btstack_state_t *btstack){
+    btstack->run_loop->data_sources = NULL;
+#ifdef MAX_NR_BTSTACK_TIMERS
+    btstack->run_loop->timers = btstack->run_loop->timers_storage;
+    btstack->run_loop->max_timers = MAX_NR_BTSTACK_TIMERS;
+#else
+    btstack->run_loop->timers = NULL;
+    btstack->run_loop->max_timers = 0;
+#endif
+    btstack->run_loop->num_timers = 0;
+    btstack->run_loop->callbacks = NULL;
 }
 
-void btstack_run_loop_base_add_data_source(btstack_data_source_t *ds){
-    btstack_linked_list_add(&btstack_run_loop_base_data_sources, (btstack_linked_item_t *) ds);
+void btstack_run_loop_base_deinit(btstack_state_t *btstack){
+#ifndef MAX_NR_BTSTACK_TIMERS
+    free(btstack->run_loop->timers);
+    btstack->run_loop->timers = NULL;
+    btstack->run_loop->max_timers = 0;
+#endif
+    btstack->run_loop->num_timers = 0;
 }
 
-bool btstack_run_loop_base_remove_data_source(btstack_data_source_t *ds){
-    return btstack_linked_list_remove(&btstack_run_loop_base_data_sources, (btstack_linked_item_t *) ds);
+void btstack_run_loop_base_add_data_source(btstack_state_t *btstack, btstack_data_source_t *ds){
+    btstack_linked_list_add(&btstack->run_loop->data_sources, (btstack_linked_item_t *) ds);
+}
+
+bool btstack_run_loop_base_remove_data_source(btstack_state_t *btstack, btstack_data_source_t *ds){
+    return btstack_linked_list_remove(&btstack->run_loop->data_sources, (btstack_linked_item_t *) ds);
 }
 
 void btstack_run_loop_base_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
@@ -70,36 +107,109 @@ void btstack_run_loop_base_disable_data_source_callbacks(btstack_data_source_t *
     ds->flags &= ~callback_types;
 }
 
+static bool btstack_run_loop_base_timer_before(const btstack_timer_source_t * a, const btstack_timer_source_t * b){
+    return btstack_time_delta(a->timeout, b->timeout) < 0;
+}
+
+static void btstack_run_loop_base_heap_set(btstack_state_t *btstack, uint32_t index, btstack_timer_source_t * ts){
+    btstack->run_loop->timers[index] = ts;
+    ts->heap_index = index;
+}
+
+static void btstack_run_loop_base_heap_sift_up(btstack_state_t *btstack, uint32_t index){
+    btstack_timer_source_t ** heap = btstack->run_loop->timers;
+    btstack_timer_source_t * ts = heap[index];
+    while (index > 0){
+        uint32_t parent = (index - 1) / 2;
+        if (!btstack_run_loop_base_timer_before(ts, heap[parent])) break;
+        btstack_run_loop_base_heap_set(btstack, index, heap[parent]);
+        index = parent;
+    }
+    btstack_run_loop_base_heap_set(btstack, index, ts);
+}
+
+static void btstack_run_loop_base_heap_sift_down(btstack_state_t *btstack, uint32_t index){
+    btstack_timer_source_t ** heap = btstack->run_loop->timers;
+    uint32_t num_timers = btstack->run_loop->num_timers;
+    btstack_timer_source_t * ts = heap[index];
+    while (true){
+        uint32_t child = (2 * index) + 1;
+        if (child >= num_timers) break;
+        if (((child + 1) < num_timers) && btstack_run_loop_base_timer_before(heap[child + 1], heap[child])){
+            child++;
+        }
+        if (!btstack_run_loop_base_timer_before(heap[child], ts)) break;
+        btstack_run_loop_base_heap_set(btstack, index, heap[child]);
+        index = child;
+    }
+    btstack_run_loop_base_heap_set(btstack, index, ts);
+}
+
+static bool btstack_run_loop_base_timer_active(btstack_state_t *btstack, btstack_timer_source_t *ts){
+    uint32_t index = ts->heap_index;
+    if (index >= btstack->run_loop->num_timers) return false;
+    return btstack->run_loop->timers[index] == ts;
+}
 
-bool btstack_run_loop_base_remove_timer(btstack_timer_source_t *ts){
-    return btstack_linked_list_remove(&btstack_run_loop_base_timers, (btstack_linked_item_t *) ts);
+bool btstack_run_loop_base_remove_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
+    if (!btstack_run_loop_base_timer_active(btstack, ts)) return false;
+    uint32_t index = ts->heap_index;
+    btstack->run_loop->num_timers--;
+    uint32_t last = btstack->run_loop->num_timers;
+    if (index != last){
+        // move last timer into the gap and restore heap order
+        btstack_timer_source_t * moved = btstack->run_loop->timers[last];
+        btstack_run_loop_base_heap_set(btstack, index, moved);
+        btstack_run_loop_base_heap_sift_up(btstack, index);
+        btstack_run_loop_base_heap_sift_down(btstack, moved->heap_index);
+    }
+    return true;
 }
 
-void btstack_run_loop_base_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &btstack_run_loop_base_timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        if ((btstack_timer_source_t *) it->next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+void btstack_run_loop_base_add_timer(btstack_state_t *btstack, btstack_timer_source_t *ts){
+    // don't add timer that's already in there
+    if (btstack_run_loop_base_timer_active(btstack, ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+        return;
+    }
+    if (btstack->run_loop->num_timers == btstack->run_loop->max_timers){
+#ifdef MAX_NR_BTSTACK_TIMERS
+        log_error( "btstack_run_loop_timer_add error: more than MAX_NR_BTSTACK_TIMERS timers");
+        return;
+#else
+        // grow heap
+        uint32_t max_timers = btstack->run_loop->max_timers ? (2 * btstack->run_loop->max_timers) : BTSTACK_RUN_LOOP_BASE_TIMERS_INITIAL;
+        btstack_timer_source_t ** timers = (btstack_timer_source_t **) realloc(btstack->run_loop->timers, max_timers * sizeof(btstack_timer_source_t *));
+        if (timers == NULL){
+            log_error( "btstack_run_loop_timer_add error: out of memory");
             return;
         }
-        // exit if list timeout is after new timeout
-        uint32_t list_timeout = ((btstack_timer_source_t *) it->next)->timeout;
-        int32_t delta = btstack_time_delta(ts->timeout, list_timeout);
-        if (delta < 0) break;
+        btstack->run_loop->timers = timers;
+        btstack->run_loop->max_timers = max_timers;
+#endif
     }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    uint32_t index = btstack->run_loop->num_timers++;
+    btstack_run_loop_base_heap_set(btstack, index, ts);
+    btstack_run_loop_base_heap_sift_up(btstack, index);
 }
 
-void  btstack_run_loop_base_process_timers(uint32_t now){
+btstack_timer_source_t * btstack_run_loop_base_get_next_timer(btstack_state_t *btstack){
+    if (btstack->run_loop->num_timers == 0) return NULL;
+    return btstack->run_loop->timers[0];
+}
+
+void  btstack_run_loop_base_process_timers(btstack_state_t *btstack, uint32_t now){
     // process timers, exit when timeout is in the future
-    while (btstack_run_loop_base_timers) {
-        btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
+    while (btstack->run_loop->num_timers) {
+        btstack_timer_source_t * ts = btstack->run_loop->timers[0];
         int32_t delta = btstack_time_delta(ts->timeout, now);
         if (delta > 0) break;
-        btstack_run_loop_base_remove_timer(ts);
-        ts->process(ts);
+        // remove timer before processing it to allow handler to re-register with run loop
+        btstack_run_loop_base_remove_timer(btstack, ts);
+        BTSTACK_INSTRUMENTATION_QUEUED(BTSTACK_INSTRUMENTATION_LAYER_RUN_LOOP, BTSTACK_INSTRUMENTATION_ID_RUN_LOOP_TIMER, (uint32_t) (-delta) * 1000u);
+        BTSTACK_INSTRUMENTATION_START(timer_start_us);
+        ts->process(btstack, ts);
+        BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_RUN_LOOP, BTSTACK_INSTRUMENTATION_ID_RUN_LOOP_TIMER, 0, timer_start_us);
     }
 }
 
@@ -107,13 +217,68 @@ void  btstack_run_loop_base_process_timers(uint32_t now){
  * @brief Get time until first timer fires
  * @returns -1 if no timers, time until next timeout otherwise
  */
-int32_t btstack_run_loop_base_get_time_until_timeout(uint32_t now){
-    if (btstack_run_loop_base_timers == NULL) return -1;
-    btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
-    uint32_t list_timeout  = ts->timeout;
+int32_t btstack_run_loop_base_get_time_until_timeout(btstack_state_t *btstack, uint32_t now){
+    if (btstack->run_loop->num_timers == 0) return -1;
+    uint32_t list_timeout = btstack->run_loop->timers[0]->timeout;
     int32_t delta = btstack_time_delta(list_timeout, now);
     if (delta < 0){
         delta = 0;
     }
     return delta;
 }
+
+void btstack_run_loop_base_dump_timer(btstack_state_t *btstack){
+#ifdef ENABLE_LOG_INFO
+    uint32_t i;
+    for (i = 0; i < btstack->run_loop->num_timers; i++){
+        btstack_timer_source_t *ts = btstack->run_loop->timers[i];
+        log_info("timer %u (%p): timeout %u\n", (unsigned int) i, ts, (unsigned int) ts->timeout);
+    }
+#else
+    UNUSED(btstack);
+#endif
+}
+
+void btstack_run_loop_base_add_callback(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration){
+#ifdef RUN_LOOP_BASE_LOCK_FREE_CALLBACKS
+    btstack_context_callback_registration_t * head = __atomic_load_n(&btstack->run_loop->callbacks, __ATOMIC_RELAXED);
+    do {
+        callback_registration->item = (btstack_linked_item_t *) head;
+    } while (!__atomic_compare_exchange_n(&btstack->run_loop->callbacks, &head, callback_registration, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+#else
+    callback_registration->item = (btstack_linked_item_t *) btstack->run_loop->callbacks;
+    btstack->run_loop->callbacks = callback_registration;
+#endif
+}
+
+btstack_context_callback_registration_t * btstack_run_loop_base_take_callbacks(btstack_state_t *btstack){
+#ifdef RUN_LOOP_BASE_LOCK_FREE_CALLBACKS
+    // cheap check first to avoid atomic write if nothing is pending
+    if (__atomic_load_n(&btstack->run_loop->callbacks, __ATOMIC_RELAXED) == NULL) return NULL;
+    return __atomic_exchange_n(&btstack->run_loop->callbacks, NULL, __ATOMIC_ACQUIRE);
+#else
+    btstack_context_callback_registration_t * callbacks = btstack->run_loop->callbacks;
+    btstack->run_loop->callbacks = NULL;
+    return callbacks;
+#endif
+}
+
+void btstack_run_loop_base_execute_callbacks(btstack_context_callback_registration_t * callbacks){
+    // reverse list to execute callbacks in order they were added
+    btstack_context_callback_registration_t * ordered = NULL;
+    while (callbacks != NULL){
+        btstack_context_callback_registration_t * next = (btstack_context_callback_registration_t *) callbacks->item;
+        callbacks->item = (btstack_linked_item_t *) ordered;
+        ordered = callbacks;
+        callbacks = next;
+    }
+    // get next before calling callback, as callback might register itself again
+    while (ordered != NULL){
+        btstack_context_callback_registration_t * next = (btstack_context_callback_registration_t *) ordered->item;
+        ordered->item = NULL;
+        BTSTACK_INSTRUMENTATION_START(callback_start_us);
+        (*ordered->callback)(ordered->context);
+        BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_RUN_LOOP, BTSTACK_INSTRUMENTATION_ID_RUN_LOOP_CALLBACK, 0, callback_start_us);
+        ordered = next;
+    }
+}
@@ -54,52 +54,84 @@
 extern "C" {
 #endif
 
-// private data (access only by run loop implementations)
-extern btstack_linked_list_t btstack_run_loop_base_timers;
-extern btstack_linked_list_t btstack_run_loop_base_data_sources;
-	
 /**
  * @brief Init
  */
-void btstack_run_loop_base_init(void);
+void btstack_run_loop_base_init(btstack_state_t *btstack);
+
+/**
+ * @brief Deinit, free timer heap
+ */
+void btstack_run_loop_base_deinit(btstack_state_t *btstack);
 
 /**
  * @brief Add timer source.
  * @param timer to add
  */
-void btstack_run_loop_base_add_timer(btstack_timer_source_t * timer); 
+void btstack_run_loop_base_add_timer(btstack_state_t *btstack, btstack_timer_source_t * timer);
 
 /**
  * @brief Remove timer source.
  * @param timer to remove
  * @returns true if timer was removed
  */
-bool  btstack_run_loop_base_remove_timer(btstack_timer_source_t * timer);
+bool  btstack_run_loop_base_remove_timer(btstack_state_t *btstack, btstack_timer_source_t * timer);
+
+/**
+ * @brief Get timer that expires first
+ * @returns timer or NULL if no timers
+ */
+btstack_timer_source_t * btstack_run_loop_base_get_next_timer(btstack_state_t *btstack);
 
 /**
  * @brief Process timers: remove expired timers from list and call their process function
  * @param now
  */
-void  btstack_run_loop_base_process_timers(uint32_t now);
+void  btstack_run_loop_base_process_timers(btstack_state_t *btstack, uint32_t now);
 
 /**
  * @brief Get time until first timer fires
  * @returns -1 if no timers, time until next timeout otherwise
  */
-int32_t btstack_run_loop_base_get_time_until_timeout(uint32_t now);
+int32_t btstack_run_loop_base_get_time_until_timeout(btstack_state_t *btstack, uint32_t now);
+
+/**
+ * @brief Log all active timers
+ */
+void btstack_run_loop_base_dump_timer(btstack_state_t *btstack);
+
+/**
+ * @brief Add callback to list of callbacks to execute on the run loop thread
+ * @note Lock-free and thread-safe on hosted systems, embedded run loops (HAVE_EMBEDDED_TICK / HAVE_EMBEDDED_TIME_MS)
+ *       have to call it with interrupts disabled
+ * @param callback_registration
+ */
+void btstack_run_loop_base_add_callback(btstack_state_t *btstack, btstack_context_callback_registration_t * callback_registration);
+
+/**
+ * @brief Remove all pending callbacks from run loop. Same locking rules as btstack_run_loop_base_add_callback
+ * @returns pending callbacks, most recent first
+ */
+btstack_context_callback_registration_t * btstack_run_loop_base_take_callbacks(btstack_state_t *btstack);
+
+/**
+ * @brief Execute callbacks returned by btstack_run_loop_base_take_callbacks in the order they were added
+ * @param callbacks
+ */
+void btstack_run_loop_base_execute_callbacks(btstack_context_callback_registration_t * callbacks);
 
 /**
  * @brief Add data source to run loop
  * @param data_source to add
  */
-void btstack_run_loop_base_add_data_source(btstack_data_source_t * data_source);
+void btstack_run_loop_base_add_data_source(btstack_state_t *btstack, btstack_data_source_t * data_source);
 
 /**
  * @brief Remove data source from run loop
  * @param data_source to remove
  * @returns true if data srouce was removed
  */
-bool btstack_run_loop_base_remove_data_source(btstack_data_source_t * data_source);
+bool btstack_run_loop_base_remove_data_source(btstack_state_t *btstack, btstack_data_source_t * data_source);
 
 /**
  * @brief Enable callbacks for a data source
@@ -42,191 +42,289 @@
  *  SLIP encoder/decoder
  */
 
+#include <string.h>
+
 #include "btstack_slip.h"
 #include "btstack_debug.h"
+#include "btstack_util.h"
 
-typedef enum {
-	SLIP_ENCODER_DEFAULT,
-	SLIP_ENCODER_SEND_DC,
-	SLIP_ENCODER_SEND_DD
-} btstack_slip_encoder_state_t;
-
-// h5 slip state machine
-typedef enum {
-    SLIP_DECODER_UNKNOWN = 1,
-    SLIP_DECODER_ACTIVE,
-    SLIP_DECODER_X_C0,
-    SLIP_DECODER_X_DB,
-    SLIP_DECODER_COMPLETE
-} btstack_slip_decoder_state_t;
-
-
-// encoder
-static btstack_slip_encoder_state_t encoder_state;
-static const uint8_t * encoder_data;
-static uint16_t  encoder_len;
-
-// decoder 
-static btstack_slip_decoder_state_t decoder_state;
-static uint8_t * decoder_buffer;
-static uint16_t  decoder_max_size;
-static uint16_t  decoder_pos;
+// bitmaps of bytes that need to be escaped: SOF, 0xdb and optionally XON/XOFF
+static const uint8_t btstack_slip_escape_bitmap[32] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00,
+};
+static const uint8_t btstack_slip_escape_bitmap_xon_xoff[32] = {
+	0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00,
+};
 
+static inline int btstack_slip_needs_escape(const uint8_t * bitmap, uint8_t value){
+	return (bitmap[value >> 3] >> (value & 7)) & 1;
+}
 
 // ENCODER
 
 /**
  * @brief Initialise SLIP encoder with data
+ * @param encoder
  * @param data
  * @param len
  */
-void btstack_slip_encoder_start(const uint8_t * data, uint16_t len){
-	encoder_state = SLIP_ENCODER_DEFAULT;
-	encoder_data  = data;
-	encoder_len   = len;
+void btstack_slip_encoder_start(btstack_slip_encoder_t * encoder, const uint8_t * data, uint16_t len){
+	encoder->state = SLIP_ENCODER_DEFAULT;
+	encoder->data  = data;
+	encoder->len   = len;
+}
+
+/**
+ * @brief Escape XON and XOFF bytes, required for out-of-frame software flow control
+ * @param encoder
+ * @param enabled
+ */
+void btstack_slip_encoder_set_escape_xon_xoff(btstack_slip_encoder_t * encoder, int enabled){
+	encoder->escape_xon_xoff = enabled ? 1 : 0;
 }
 
 /**
  * @brief Check if encoder has data ready
+ * @param encoder
  * @return True if data ready
  */
-int  btstack_slip_encoder_has_data(void){
-	if (encoder_state != SLIP_ENCODER_DEFAULT) return 1;
-	return encoder_len > 0;
+int  btstack_slip_encoder_has_data(btstack_slip_encoder_t * encoder){
+	if (encoder->state != SLIP_ENCODER_DEFAULT) return 1;
+	return encoder->len > 0;
 }
 
 /** 
  * @brief Get next byte from encoder 
+ * @param encoder
  * @return Next bytes from encoder
  */
-uint8_t btstack_slip_encoder_get_byte(void){
+uint8_t btstack_slip_encoder_get_byte(btstack_slip_encoder_t * encoder){
 	uint8_t next_byte;
-	switch (encoder_state){
+	switch (encoder->state){
 		case SLIP_ENCODER_DEFAULT:
-			next_byte = *encoder_data++;
-			encoder_len--;
+			next_byte = *encoder->data++;
+			encoder->len--;
 			switch (next_byte){
 				case BTSTACK_SLIP_SOF:
-					encoder_state = SLIP_ENCODER_SEND_DC;
+					encoder->state = SLIP_ENCODER_SEND_DC;
 					return 0xdb;
 				case 0xdb:
-					encoder_state = SLIP_ENCODER_SEND_DD;
+					encoder->state = SLIP_ENCODER_SEND_DD;
+					return 0xdb;
+				case BTSTACK_SLIP_XON:
+					if (!encoder->escape_xon_xoff) break;
+					encoder->state = SLIP_ENCODER_SEND_DE;
+					return 0xdb;
+				case BTSTACK_SLIP_XOFF:
+					if (!encoder->escape_xon_xoff) break;
+					encoder->state = SLIP_ENCODER_SEND_DF;
 					return 0xdb;
 				default:
                     break;
 			}
 			return next_byte;
 		case SLIP_ENCODER_SEND_DC:
-			encoder_state = SLIP_ENCODER_DEFAULT;
+			encoder->state = SLIP_ENCODER_DEFAULT;
 			return 0x0dc;
 		case SLIP_ENCODER_SEND_DD:
-			encoder_state = SLIP_ENCODER_DEFAULT;
+			encoder->state = SLIP_ENCODER_DEFAULT;
 			return 0x0dd;
+		case SLIP_ENCODER_SEND_DE:
+			encoder->state = SLIP_ENCODER_DEFAULT;
+			return 0x0de;
+		case SLIP_ENCODER_SEND_DF:
+			encoder->state = SLIP_ENCODER_DEFAULT;
+			return 0x0df;
         default:
-            log_error("btstack_slip_encoder_get_byte invalid state %x", encoder_state);
+            log_error("btstack_slip_encoder_get_byte invalid state %x", encoder->state);
             return 0x00;
 	}
 }
 
+/**
+ * @brief Encode as much data as fits into buffer
+ * @param encoder
+ * @param buffer to store encoded data
+ * @param size of buffer
+ * @return Number of bytes stored in buffer
+ */
+uint16_t btstack_slip_encoder_encode(btstack_slip_encoder_t * encoder, uint8_t * buffer, uint16_t size){
+	const uint8_t * escape_bitmap = encoder->escape_xon_xoff ? btstack_slip_escape_bitmap_xon_xoff : btstack_slip_escape_bitmap;
+	uint16_t pos = 0;
+
+	// finish pending escape sequence
+	if ((encoder->state != SLIP_ENCODER_DEFAULT) && (size > 0)){
+		buffer[pos++] = btstack_slip_encoder_get_byte(encoder);
+	}
+
+	while ((encoder->len > 0) && (pos < size)){
+		// copy run of bytes that don't need to be escaped
+		uint16_t max_run = btstack_min(encoder->len, size - pos);
+		uint16_t run = 0;
+		while ((run < max_run) && !btstack_slip_needs_escape(escape_bitmap, encoder->data[run])){
+			run++;
+		}
+		(void) memcpy(&buffer[pos], encoder->data, run);
+		pos          += run;
+		encoder->data += run;
+		encoder->len  -= run;
+		if (run == max_run) continue;
+
+		// escape byte, second byte is stored on next call if buffer is full
+		buffer[pos++] = btstack_slip_encoder_get_byte(encoder);
+		if (pos < size){
+			buffer[pos++] = btstack_slip_encoder_get_byte(encoder);
+		}
+	}
+	return pos;
+}
+
 // Decoder
 
-static void btstack_slip_decoder_reset(void){
-	decoder_state = SLIP_DECODER_UNKNOWN;
-	decoder_pos = 0;
+static void btstack_slip_decoder_reset(btstack_slip_decoder_t * decoder){
+	decoder->state = SLIP_DECODER_UNKNOWN;
+	decoder->pos = 0;
 }
 
-static void btstack_slip_decoder_store_byte(uint8_t input){
-	if (decoder_pos >= decoder_max_size){
+static void btstack_slip_decoder_store_byte(btstack_slip_decoder_t * decoder, uint8_t input){
+	if (decoder->pos >= decoder->max_size){
 	    log_error("btstack_slip_decoder_store_byte: packet to long");
-	    btstack_slip_decoder_reset();
+	    btstack_slip_decoder_reset(decoder);
 	}
-	decoder_buffer[decoder_pos++] = input;
+	decoder->buffer[decoder->pos++] = input;
 }
 
 /**
  * @brief Initialise SLIP decoder with buffer
+ * @param decoder
  * @param buffer to store received data
  * @param max_size of buffer
  */
-void btstack_slip_decoder_init(uint8_t * buffer, uint16_t max_size){
-	decoder_buffer = buffer;
-	decoder_max_size = max_size;
-	btstack_slip_decoder_reset();
+void btstack_slip_decoder_init(btstack_slip_decoder_t * decoder, uint8_t * buffer, uint16_t max_size){
+	decoder->buffer = buffer;
+	decoder->max_size = max_size;
+	btstack_slip_decoder_reset(decoder);
 }
 
 /**
  * @brief Process received byte
+ * @param decoder
  * @param data
  */
 
-void btstack_slip_decoder_process(uint8_t input){
-	switch(decoder_state){
+void btstack_slip_decoder_process(btstack_slip_decoder_t * decoder, uint8_t input){
+	switch(decoder->state){
         case SLIP_DECODER_UNKNOWN:
             if (input != BTSTACK_SLIP_SOF) break;
-            btstack_slip_decoder_reset();
-            decoder_state = SLIP_DECODER_X_C0;
+            btstack_slip_decoder_reset(decoder);
+            decoder->state = SLIP_DECODER_X_C0;
             break;
         case SLIP_DECODER_COMPLETE:
         	log_error("btstack_slip_decoder_process called in state COMPLETE");
-            btstack_slip_decoder_reset();
+            btstack_slip_decoder_reset(decoder);
         	break;
         case SLIP_DECODER_X_C0:
             switch(input){
                 case BTSTACK_SLIP_SOF:
                     break;
                 case 0xdb:
-                    decoder_state = SLIP_DECODER_X_DB;
+                    decoder->state = SLIP_DECODER_X_DB;
                     break;
                 default:
-                    btstack_slip_decoder_store_byte(input);
-                    decoder_state = SLIP_DECODER_ACTIVE;
+                    btstack_slip_decoder_store_byte(decoder, input);
+                    decoder->state = SLIP_DECODER_ACTIVE;
                     break; 
             }                   
             break;
         case SLIP_DECODER_X_DB:
             switch(input){
                 case 0xdc:
-                    btstack_slip_decoder_store_byte(BTSTACK_SLIP_SOF);
-                    decoder_state = SLIP_DECODER_ACTIVE;
+                    btstack_slip_decoder_store_byte(decoder, BTSTACK_SLIP_SOF);
+                    decoder->state = SLIP_DECODER_ACTIVE;
                     break;
                 case 0xdd:
-                    btstack_slip_decoder_store_byte(0xdb);
-                    decoder_state = SLIP_DECODER_ACTIVE;
+                    btstack_slip_decoder_store_byte(decoder, 0xdb);
+                    decoder->state = SLIP_DECODER_ACTIVE;
+                    break;
+                case 0xde:
+                    btstack_slip_decoder_store_byte(decoder, BTSTACK_SLIP_XON);
+                    decoder->state = SLIP_DECODER_ACTIVE;
+                    break;
+                case 0xdf:
+                    btstack_slip_decoder_store_byte(decoder, BTSTACK_SLIP_XOFF);
+                    decoder->state = SLIP_DECODER_ACTIVE;
                     break;
                 default:
-                    btstack_slip_decoder_reset();
+                    btstack_slip_decoder_reset(decoder);
                     break;
             }
             break;
         case SLIP_DECODER_ACTIVE:
             switch(input){
                 case BTSTACK_SLIP_SOF:
-                    if (decoder_pos){
-                    	decoder_state = SLIP_DECODER_COMPLETE;
+                    if (decoder->pos){
+                    	decoder->state = SLIP_DECODER_COMPLETE;
                     } else {
-	                    btstack_slip_decoder_reset();
+	                    btstack_slip_decoder_reset(decoder);
                     }
                     break;
                 case 0xdb:
-                    decoder_state = SLIP_DECODER_X_DB;
+                    decoder->state = SLIP_DECODER_X_DB;
                     break;
                 default:
-                    btstack_slip_decoder_store_byte(input);
+                    btstack_slip_decoder_store_byte(decoder, input);
                     break;
             }
             break;
     }
 }
 
+/**
+ * @brief Process received data until frame is complete
+ * @param decoder
+ * @param data
+ * @param len
+ * @return Number of bytes processed. If frame is complete, remaining data needs to be processed after decoder init
+ */
+uint16_t btstack_slip_decoder_process_data(btstack_slip_decoder_t * decoder, const uint8_t * data, uint16_t len){
+	uint16_t pos = 0;
+	while (pos < len){
+		if (decoder->state == SLIP_DECODER_ACTIVE){
+			// copy run of regular bytes
+			uint16_t run = 0;
+			while (((pos + run) < len) && (data[pos + run] != BTSTACK_SLIP_SOF) && (data[pos + run] != 0xdb)){
+				run++;
+			}
+			if (run > 0){
+				if ((decoder->pos + run) > decoder->max_size){
+					log_error("btstack_slip_decoder_process_data: packet to long");
+					btstack_slip_decoder_reset(decoder);
+				} else {
+					(void) memcpy(&decoder->buffer[decoder->pos], &data[pos], run);
+					decoder->pos += run;
+				}
+				pos += run;
+				continue;
+			}
+		}
+		btstack_slip_decoder_process(decoder, data[pos++]);
+		if (decoder->state == SLIP_DECODER_COMPLETE) break;
+	}
+	return pos;
+}
+
 /**
  * @brief Get size of decoded frame
+ * @param decoder
  * @return size of frame. Size = 0 => frame not complete
  */
 
-uint16_t btstack_slip_decoder_frame_size(void){
-	switch (decoder_state){
+uint16_t btstack_slip_decoder_frame_size(btstack_slip_decoder_t * decoder){
+	switch (decoder->state){
 		case SLIP_DECODER_COMPLETE:
-			return decoder_pos;
+			return decoder->pos;
 		default:
 			return 0;
 	}
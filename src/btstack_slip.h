@@ -51,49 +51,115 @@ extern "C" {
 
 #define BTSTACK_SLIP_SOF 0xc0
 
+// out-of-frame software flow control
+#define BTSTACK_SLIP_XON  0x11
+#define BTSTACK_SLIP_XOFF 0x13
+
+typedef enum {
+	SLIP_ENCODER_DEFAULT,
+	SLIP_ENCODER_SEND_DC,
+	SLIP_ENCODER_SEND_DD,
+	SLIP_ENCODER_SEND_DE,
+	SLIP_ENCODER_SEND_DF
+} btstack_slip_encoder_state_t;
+
+typedef enum {
+    SLIP_DECODER_UNKNOWN = 1,
+    SLIP_DECODER_ACTIVE,
+    SLIP_DECODER_X_C0,
+    SLIP_DECODER_X_DB,
+    SLIP_DECODER_COMPLETE
+} btstack_slip_decoder_state_t;
+
+typedef struct {
+	btstack_slip_encoder_state_t state;
+	const uint8_t * data;
+	uint16_t len;
+	// escape XON/XOFF if out-of-frame flow control is used
+	uint8_t  escape_xon_xoff;
+} btstack_slip_encoder_t;
+
+typedef struct {
+	btstack_slip_decoder_state_t state;
+	uint8_t * buffer;
+	uint16_t  max_size;
+	uint16_t  pos;
+} btstack_slip_decoder_t;
+
 // ENCODER
 
 /**
  * @brief Initialise SLIP encoder with data
+ * @param encoder
  * @param data
  * @param len
  */
-void btstack_slip_encoder_start(const uint8_t * data, uint16_t len);
+void btstack_slip_encoder_start(btstack_slip_encoder_t * encoder, const uint8_t * data, uint16_t len);
+
+/**
+ * @brief Escape XON and XOFF bytes, required for out-of-frame software flow control
+ * @param encoder
+ * @param enabled
+ */
+void btstack_slip_encoder_set_escape_xon_xoff(btstack_slip_encoder_t * encoder, int enabled);
 
 /**
  * @brief Check if encoder has data ready
+ * @param encoder
  * @return True if data ready
  */
-int  btstack_slip_encoder_has_data(void);
+int  btstack_slip_encoder_has_data(btstack_slip_encoder_t * encoder);
 
 /** 
  * @brief Get next byte from encoder 
+ * @param encoder
  * @return Next bytes from encoder
  */
-uint8_t btstack_slip_encoder_get_byte(void);
+uint8_t btstack_slip_encoder_get_byte(btstack_slip_encoder_t * encoder);
+
+/**
+ * @brief Encode as much data as fits into buffer
+ * @param encoder
+ * @param buffer to store encoded data
+ * @param size of buffer
+ * @return Number of bytes stored in buffer
+ */
+uint16_t btstack_slip_encoder_encode(btstack_slip_encoder_t * encoder, uint8_t * buffer, uint16_t size);
 
 // DECODER
 
 /**
  * @brief Initialise SLIP decoder with buffer
+ * @param decoder
  * @param buffer to store received data
  * @param max_size of buffer
  */
-void btstack_slip_decoder_init(uint8_t * buffer, uint16_t max_size);
+void btstack_slip_decoder_init(btstack_slip_decoder_t * decoder, uint8_t * buffer, uint16_t max_size);
 
 /**
  * @brief Process received byte
+ * @param decoder
  * @param input
  */
 
-void btstack_slip_decoder_process(uint8_t input);
+void btstack_slip_decoder_process(btstack_slip_decoder_t * decoder, uint8_t input);
+
+/**
+ * @brief Process received data until frame is complete
+ * @param decoder
+ * @param data
+ * @param len
+ * @return Number of bytes processed. If frame is complete, remaining data needs to be processed after decoder init
+ */
+uint16_t btstack_slip_decoder_process_data(btstack_slip_decoder_t * decoder, const uint8_t * data, uint16_t len);
 
 /**
  * @brief Get size of decoded frame
+ * @param decoder
  * @return size of frame. Size = 0 => frame not complete
  */
 
-uint16_t btstack_slip_decoder_frame_size(void);
+uint16_t btstack_slip_decoder_frame_size(btstack_slip_decoder_t * decoder);
 
 #if defined __cplusplus
 }
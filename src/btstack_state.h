@@ -47,6 +47,9 @@
 typedef struct btstack_run_loop_state * btstack_run_loop_state_ptr;
 typedef struct hci_stack * hci_stack_ptr;
 typedef struct btstack_hci_h4_state * btstack_hci_h4_state_ptr;
+typedef struct btstack_hci_h5_state * btstack_hci_h5_state_ptr;
+typedef struct btstack_hci_virtual_state * btstack_hci_virtual_state_ptr;
+typedef struct btstack_hci_replay_state * btstack_hci_replay_state_ptr;
 typedef struct btstack_l2cap_state * btstack_l2cap_state_ptr;
 typedef struct btstack_sdp_state * btstack_sdp_state_ptr;
 typedef struct btstack_uart_state * btstack_uart_state_ptr;
@@ -56,6 +59,9 @@ typedef struct {
     btstack_run_loop_state_ptr run_loop;
     hci_stack_ptr hci;
     btstack_hci_h4_state_ptr hci_h4;
+    btstack_hci_h5_state_ptr hci_h5;
+    btstack_hci_virtual_state_ptr hci_virtual;
+    btstack_hci_replay_state_ptr hci_replay;
     btstack_l2cap_state_ptr l2cpi;
     btstack_sdp_state_ptr sdp;
     btstack_uart_state_ptr uart;
@@ -69,6 +69,12 @@ typedef enum {
     BTSTACK_UART_SLEEP_MASK_RTS_LOW_WAKE_ON_RX_EDGE     = 1 << BTSTACK_UART_SLEEP_RTS_LOW_WAKE_ON_RX_EDGE
 } btstack_uart_sleep_mode_mask_t;
 
+// block for btstack_uart_block_t.send_blocks
+typedef struct {
+    const uint8_t * data;
+    uint16_t        len;
+} btstack_uart_block_iov_t;
+
 typedef struct btstack_uart_block {
     /**
      * init transport
@@ -144,6 +150,24 @@ typedef struct btstack_uart_block {
      */
     void (*set_wakeup_handler)(btstack_state_t *btstack, void (*wakeup_handler)(btstack_state_t *btstack));
 
+    // optional support for bulk reads, NULL if not supported
+
+    /**
+     * set callback for data received via receive_data. NULL disables callback
+     */
+    void (*set_data_received)(btstack_state_t *btstack, void (*data_handler)(btstack_state_t *btstack, uint16_t len));
+
+    /**
+     * receive as many bytes as available, at least one and at most max_len
+     */
+    void (*receive_data)(btstack_state_t *btstack, uint8_t *buffer, uint16_t max_len);
+
+    /**
+     * send multiple blocks with a single write, callback set by set_block_sent is called once when all blocks are sent
+     * blocks array and data need to stay valid until then
+     */
+    void (*send_blocks)(btstack_state_t *btstack, const btstack_uart_block_iov_t * blocks, uint16_t num_blocks);
+
 } btstack_uart_block_t;
 
 // common implementations
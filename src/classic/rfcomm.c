@@ -49,6 +49,7 @@
 #include "bluetooth_sdp.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
+#include "btstack_instrumentation.h"
 #include "btstack_memory.h"
 #include "btstack_util.h"
 #include "classic/core.h"
@@ -325,6 +326,7 @@ static void rfcomm_emit_can_send_now(rfcomm_channel_t *channel) {
     event[1] = sizeof(event) - 2;
     little_endian_store_16(event, 2, channel->rfcomm_cid);
     hci_dump_packet( HCI_EVENT_PACKET, 0, event, sizeof(event));
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_EMITTED(BTSTACK_INSTRUMENTATION_LAYER_RFCOMM, channel->rfcomm_cid);
     (channel->packet_handler)(HCI_EVENT_PACKET, channel->rfcomm_cid, event, sizeof(event));
 }
 
@@ -1456,8 +1458,10 @@ static void rfcomm_channel_packet_handler_uih(rfcomm_multiplexer_t *multiplexer,
         }
         
         // deliver payload
+        BTSTACK_INSTRUMENTATION_START(handler_start_us);
         (channel->packet_handler)(RFCOMM_DATA_PACKET, channel->rfcomm_cid,
                               &packet[payload_offset], size-payload_offset-1);
+        BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_RFCOMM, channel->rfcomm_cid, size-payload_offset-1, handler_start_us);
     }
     
     // automatically provide new credits to remote device, if no incoming flow control
@@ -2209,6 +2213,7 @@ void rfcomm_request_can_send_now_event(uint16_t rfcomm_cid){
         return;
     }
     channel->waiting_for_can_send_now = 1;
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(BTSTACK_INSTRUMENTATION_LAYER_RFCOMM, rfcomm_cid);
     l2cap_request_can_send_now_event(channel->multiplexer->l2cap_cid);
 }
 
@@ -66,8 +66,10 @@
 #include <stdio.h>
 #include <inttypes.h>
 
+#include "btstack_crc.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
+#include "btstack_instrumentation.h"
 #include "btstack_linked_list.h"
 #include "btstack_memory.h"
 #include "bluetooth_company_id.h"
@@ -75,6 +77,7 @@
 #include "gap.h"
 #include "hci.h"
 #include "hci_cmd.h"
+#include "hci_cmd_encoder.h"
 #include "hci_dump.h"
 #include "ad_parser.h"
 #include "log.h"
@@ -148,12 +151,21 @@ static int  hci_power_control_on(btstack_state_t *btstack);
 static void hci_power_control_off(btstack_state_t *btstack);
 static void hci_state_reset(btstack_state_t *btstack);
 static void hci_emit_transport_packet_sent(btstack_state_t *btstack);
+static void hci_acl_iov_packets_drop(btstack_state_t *btstack, hci_con_handle_t con_handle);
+static bool hci_acl_iov_packet_in_progress(btstack_state_t *btstack);
 static void hci_emit_disconnection_complete(btstack_state_t *btstack, hci_con_handle_t con_handle, uint8_t reason);
 static void hci_emit_nr_connections_changed(btstack_state_t *btstack);
 static void hci_emit_hci_open_failed(btstack_state_t *btstack);
 static void hci_emit_dedicated_bonding_result(btstack_state_t *btstack, bd_addr_t address, uint8_t status);
 static void hci_emit_event(btstack_state_t *btstack, uint8_t * event, uint16_t size, int dump);
 static void hci_emit_acl_packet(btstack_state_t *btstack, uint8_t * packet, uint16_t size);
+static hci_command_request_t * hci_command_in_flight_complete(btstack_state_t *btstack, uint16_t opcode);
+static void hci_command_in_flight_add(btstack_state_t *btstack, uint16_t opcode);
+static hci_command_in_flight_t * hci_command_in_flight_free(btstack_state_t *btstack);
+static void hci_command_in_flight_abandon_oldest(btstack_state_t *btstack);
+static void hci_command_request_fail(btstack_state_t *btstack, hci_command_request_t * request, uint8_t status);
+static void hci_command_requests_fail(btstack_state_t *btstack, bool include_queued, uint8_t status);
+static int  hci_send_reserved_cmd_packet(btstack_state_t *btstack, uint16_t size);
 static void hci_run(btstack_state_t *btstack);
 static int  hci_is_le_connection(hci_connection_t * connection);
 static int  hci_number_free_acl_slots_for_connection_type(btstack_state_t *btstack, bd_addr_type_t address_type);
@@ -176,6 +188,86 @@ static hci_connection_t * gap_get_outgoing_connection(btstack_state_t *btstack);
 static const char * default_classic_name = "BTstack 00:00:00:00:00:00";
 #endif
 
+#if (HCI_CONNECTION_INDEX_SIZE & (HCI_CONNECTION_INDEX_SIZE - 1)) != 0
+#error "HCI_CONNECTION_INDEX_SIZE must be a power of two"
+#endif
+
+/**
+ * connection lookup tables
+ *
+ * Each table slot caches the last connection that mapped to it. Lookups verify the slot and fall back
+ * to a walk of the connection list on a miss, so the tables never need to be complete, only consistent:
+ * a connection must be removed from its slots before it is freed.
+ */
+static inline unsigned int hci_connection_index_for_handle(hci_con_handle_t con_handle){
+    return con_handle & (HCI_CONNECTION_INDEX_SIZE - 1);
+}
+
+static unsigned int hci_connection_index_for_address(const bd_addr_t addr, bd_addr_type_t addr_type){
+    unsigned int hash = (unsigned int) addr_type;
+    int i;
+    for (i=0;i<6;i++){
+        hash = (hash * 31) ^ addr[i];
+    }
+    return hash & (HCI_CONNECTION_INDEX_SIZE - 1);
+}
+
+static void hci_connection_index_add(btstack_state_t *btstack, hci_connection_t * conn){
+    if (conn->con_handle != HCI_CON_HANDLE_INVALID){
+        btstack->hci->connection_for_handle_index[hci_connection_index_for_handle(conn->con_handle)] = conn;
+    }
+    btstack->hci->connection_for_address_index[hci_connection_index_for_address(conn->address, conn->address_type)] = conn;
+}
+
+static void hci_connection_index_remove(btstack_state_t *btstack, hci_connection_t * conn){
+    unsigned int index = hci_connection_index_for_handle(conn->con_handle);
+    if (btstack->hci->connection_for_handle_index[index] == conn){
+        btstack->hci->connection_for_handle_index[index] = NULL;
+    }
+    index = hci_connection_index_for_address(conn->address, conn->address_type);
+    if (btstack->hci->connection_for_address_index[index] == conn){
+        btstack->hci->connection_for_address_index[index] = NULL;
+    }
+}
+
+static void hci_connection_set_handle(btstack_state_t *btstack, hci_connection_t * conn, hci_con_handle_t con_handle){
+    hci_connection_index_remove(btstack, conn);
+    conn->con_handle = con_handle;
+    hci_connection_index_add(btstack, conn);
+}
+
+// track ACL packets in flight per connection and per connection type
+static uint16_t * hci_acl_packets_sent_counter(btstack_state_t *btstack, hci_connection_t * conn){
+    if (conn->address_type == BD_ADDR_TYPE_ACL) return &btstack->hci->acl_packets_sent_classic;
+    if (hci_is_le_connection(conn)) return &btstack->hci->acl_packets_sent_le;
+    return NULL;
+}
+
+static void hci_connection_packets_sent(btstack_state_t *btstack, hci_connection_t * conn, uint8_t num_packets){
+    conn->num_packets_sent += num_packets;
+    uint16_t * counter = hci_acl_packets_sent_counter(btstack, conn);
+    if (counter){
+        *counter += num_packets;
+    }
+}
+
+static void hci_connection_packets_completed(btstack_state_t *btstack, hci_connection_t * conn, uint8_t num_packets){
+    conn->num_packets_sent -= num_packets;
+    uint16_t * counter = hci_acl_packets_sent_counter(btstack, conn);
+    if (counter){
+        *counter -= num_packets;
+    }
+}
+
+// remove connection from list and lookup tables and free it
+static void hci_connection_free(btstack_state_t *btstack, hci_connection_t * conn){
+    // packets not completed by the controller are flushed on disconnect
+    hci_connection_packets_completed(btstack, conn, conn->num_packets_sent);
+    hci_connection_index_remove(btstack, conn);
+    btstack_dlist_remove(&btstack->hci->connections, (btstack_dlist_item_t *) conn);
+    btstack_memory_hci_connection_free( conn );
+}
+
 /**
  * create connection for given address
  *
@@ -207,7 +299,8 @@ static hci_connection_t * create_connection_for_bd_addr_and_type(btstack_state_t
 #ifdef ENABLE_LE_LIMIT_ACL_FRAGMENT_BY_MAX_OCTETS
     conn->le_max_tx_octets = 27;
 #endif
-    btstack_linked_list_add(&btstack->hci->connections, (btstack_linked_item_t *) conn);
+    btstack_dlist_add(&btstack->hci->connections, (btstack_dlist_item_t *) conn);
+    hci_connection_index_add(btstack, conn);
     return conn;
 }
 
@@ -268,8 +361,8 @@ void gap_set_max_number_peripheral_connections(btstack_state_t *btstack, int max
  * @return hci connections iterator
  */
 
-void hci_connections_get_iterator(btstack_state_t *btstack, btstack_linked_list_iterator_t *it){
-    btstack_linked_list_iterator_init(it, &btstack->hci->connections);
+void hci_connections_get_iterator(btstack_state_t *btstack, btstack_dlist_iterator_t *it){
+    btstack_dlist_iterator_init(it, &btstack->hci->connections);
 }
 
 /**
@@ -278,11 +371,18 @@ void hci_connections_get_iterator(btstack_state_t *btstack, btstack_linked_list_
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_handle(btstack_state_t *btstack, hci_con_handle_t con_handle){
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &btstack->hci->connections);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * item = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    unsigned int index = hci_connection_index_for_handle(con_handle);
+    hci_connection_t * conn = btstack->hci->connection_for_handle_index[index];
+    if ((conn != NULL) && (conn->con_handle == con_handle)) {
+        return conn;
+    }
+    // slot miss, e.g. after collision
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &btstack->hci->connections);
+    while (btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * item = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         if ( item->con_handle == con_handle ) {
+            btstack->hci->connection_for_handle_index[index] = item;
             return item;
         }
     }
@@ -295,12 +395,19 @@ hci_connection_t * hci_connection_for_handle(btstack_state_t *btstack, hci_con_h
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_bd_addr_and_type(btstack_state_t *btstack, bd_addr_t  addr, bd_addr_type_t addr_type){
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &btstack->hci->connections);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    unsigned int index = hci_connection_index_for_address(addr, addr_type);
+    hci_connection_t * conn = btstack->hci->connection_for_address_index[index];
+    if ((conn != NULL) && (conn->address_type == addr_type) && (memcmp(addr, conn->address, 6) == 0)) {
+        return conn;
+    }
+    // slot miss, e.g. after collision
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &btstack->hci->connections);
+    while (btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         if (connection->address_type != addr_type)  continue;
         if (memcmp(addr, connection->address, 6) != 0) continue;
+        btstack->hci->connection_for_address_index[index] = connection;
         return connection;
     }
     return NULL;
@@ -319,10 +426,10 @@ inline static void connectionSetAuthenticationFlags(hci_connection_t * conn, hci
 #ifdef ENABLE_SCO_OVER_HCI
 static int hci_number_sco_connections(btstack_state_t *btstack){
     int connections = 0;
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, btstack->hci->connections);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &btstack->hci->connections);
+    while (btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         if (connection->address_type != BD_ADDR_TYPE_SCO) continue;
         connections++;
     }
@@ -436,8 +543,8 @@ static int hci_is_le_connection(hci_connection_t * connection){
  */
 static int nr_hci_connections(btstack_state_t *btstack){
     int count = 0;
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) btstack->hci->connections; it != NULL ; it = it->next){
+    btstack_dlist_item_t *it;
+    for (it = btstack->hci->connections.first; it != NULL ; it = it->next){
         count++;
     }
     return count;
@@ -445,19 +552,9 @@ static int nr_hci_connections(btstack_state_t *btstack){
 
 static int hci_number_free_acl_slots_for_connection_type(btstack_state_t *btstack, bd_addr_type_t address_type){
 
-    unsigned int num_packets_sent_classic = 0;
-    unsigned int num_packets_sent_le = 0;
+    unsigned int num_packets_sent_classic = btstack->hci->acl_packets_sent_classic;
+    unsigned int num_packets_sent_le = btstack->hci->acl_packets_sent_le;
 
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) btstack->hci->connections; it != NULL; it = it->next){
-        hci_connection_t * connection = (hci_connection_t *) it;
-        if (hci_is_le_connection(connection)){
-            num_packets_sent_le += connection->num_packets_sent;
-        }
-        if (connection->address_type == BD_ADDR_TYPE_ACL){
-            num_packets_sent_classic += connection->num_packets_sent;
-        }
-    }
     log_debug("ACL classic buffers: %u used of %u", num_packets_sent_classic, btstack->hci->acl_packets_total_num);
     int free_slots_classic = btstack->hci->acl_packets_total_num - num_packets_sent_classic;
     int free_slots_le = 0;
@@ -512,10 +609,10 @@ int hci_number_free_acl_slots_for_handle(btstack_state_t *btstack, hci_con_handl
 #ifdef ENABLE_CLASSIC
 static int hci_number_free_sco_slots(btstack_state_t *btstack){
     unsigned int num_sco_packets_sent  = 0;
-    btstack_linked_item_t *it;
+    btstack_dlist_item_t *it;
     if (btstack->hci->synchronous_flow_control_enabled){
         // explicit flow control
-        for (it = (btstack_linked_item_t *) btstack->hci->connections; it ; it = it->next){
+        for (it = btstack->hci->connections.first; it ; it = it->next){
             hci_connection_t * connection = (hci_connection_t *) it;
             if (connection->address_type != BD_ADDR_TYPE_SCO) continue;
             num_sco_packets_sent += connection->num_packets_sent;
@@ -528,7 +625,7 @@ static int hci_number_free_sco_slots(btstack_state_t *btstack){
     } else {
         // implicit flow control -- TODO
         int num_ready = 0;
-        for (it = (btstack_linked_item_t *) btstack->hci->connections; it ; it = it->next){
+        for (it = btstack->hci->connections.first; it ; it = it->next){
             hci_connection_t * connection = (hci_connection_t *) it;
             if (connection->address_type != BD_ADDR_TYPE_SCO) continue;
             if (connection->sco_tx_ready == 0) continue;
@@ -539,59 +636,133 @@ static int hci_number_free_sco_slots(btstack_state_t *btstack){
 }
 #endif
 
-// only used to send HCI Host Number Completed Packets
-static int hci_can_send_comand_packet_transport(btstack_state_t *btstack){
-    if (btstack->hci->hci_packet_buffer_reserved) return 0;
+// outgoing packet buffer pool
 
-    // check for async hci transport implementations
-    if (btstack->hci->hci_transport->can_send_packet_now){
-        if (!btstack->hci->hci_transport->can_send_packet_now(btstack, HCI_COMMAND_DATA_PACKET)){
-            return 0;
-        }
+static hci_packet_buffer_t * hci_packet_buffer_for_packet(btstack_state_t *btstack, const uint8_t * packet){
+    int i;
+    for (i = 0; i < HCI_OUTGOING_PACKET_BUFFER_NUM; i++){
+        hci_packet_buffer_t * buffer = &btstack->hci->packet_buffers[i];
+        if ((packet >= buffer->packet) && (packet < &buffer->packet[HCI_OUTGOING_PACKET_BUFFER_SIZE])) return buffer;
     }
-    return 1;
+    return NULL;
 }
 
-// new functions replacing hci_can_send_packet_now[_using_packet_buffer]
-int hci_can_send_command_packet_now(btstack_state_t *btstack){
-    if (hci_can_send_comand_packet_transport(btstack) == 0) return 0;
-    return btstack->hci->num_cmd_packets > 0;
+// select free buffer for next packet if current one has been handed over
+static void hci_packet_buffer_select_current(btstack_state_t *btstack){
+    hci_packet_buffer_t * current = btstack->hci->packet_buffer_current;
+    if ((current->state == HCI_PACKET_BUFFER_FREE) || (current->state == HCI_PACKET_BUFFER_RESERVED)) return;
+    int i;
+    for (i = 0; i < HCI_OUTGOING_PACKET_BUFFER_NUM; i++){
+        hci_packet_buffer_t * buffer = &btstack->hci->packet_buffers[i];
+        if (buffer->state != HCI_PACKET_BUFFER_FREE) continue;
+        btstack->hci->packet_buffer_current = buffer;
+        btstack->hci->hci_packet_buffer = buffer->packet;
+        return;
+    }
+}
+
+static void hci_packet_buffer_free(btstack_state_t *btstack, hci_packet_buffer_t * buffer){
+    buffer->state = HCI_PACKET_BUFFER_FREE;
+    buffer->num_in_transport = 0;
+    buffer->iov_packet = NULL;
+    hci_packet_buffer_select_current(btstack);
+}
+
+static int hci_packet_buffer_available(btstack_state_t *btstack){
+    return btstack->hci->packet_buffer_current->state == HCI_PACKET_BUFFER_FREE;
+}
+
+static void hci_packet_buffer_reset(btstack_state_t *btstack){
+    int i;
+    for (i = 0; i < HCI_OUTGOING_PACKET_BUFFER_NUM; i++){
+        btstack->hci->packet_buffers[i].state = HCI_PACKET_BUFFER_FREE;
+        btstack->hci->packet_buffers[i].num_in_transport = 0;
+        btstack->hci->packet_buffers[i].iov_packet = NULL;
+    }
+    btstack->hci->packet_buffer_current = &btstack->hci->packet_buffers[0];
+    btstack->hci->hci_packet_buffer = btstack->hci->packet_buffers[0].packet;
+    btstack->hci->packet_buffer_queue = NULL;
+    btstack->hci->packets_in_transport_head = 0;
+    btstack->hci->packets_in_transport_num = 0;
+    btstack->hci->acl_fragmentation_buffer = NULL;
+    btstack->hci->acl_fragmentation_pos = 0;
+    btstack->hci->acl_fragmentation_total_size = 0;
+    // HCI Transport doesn't report outstanding fragments anymore
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &btstack->hci->acl_iov_packets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_acl_iov_packet_t * packet = (hci_acl_iov_packet_t *) btstack_linked_list_iterator_next(&it);
+        packet->num_in_transport = 0;
+    }
+    hci_acl_iov_packets_drop(btstack, HCI_CON_HANDLE_INVALID);
+}
+
+// assumption: synchronous implementations don't provide can_send_packet_now as they don't keep the buffer after the call
+static int hci_transport_synchronous(btstack_state_t *btstack){
+    return btstack->hci->hci_transport->can_send_packet_now == NULL;
 }
 
 static int hci_transport_can_send_prepared_packet_now(btstack_state_t *btstack, uint8_t packet_type){
     // check for async hci transport implementations
-    if (!btstack->hci->hci_transport->can_send_packet_now) return 1;
+    if (hci_transport_synchronous(btstack)) return 1;
+    if (btstack->hci->packets_in_transport_num >= HCI_TRANSPORT_TX_QUEUE_SIZE) return 0;
     return btstack->hci->hci_transport->can_send_packet_now(btstack, packet_type);
 }
 
-static int hci_can_send_prepared_acl_packet_for_address_type(btstack_state_t *btstack, bd_addr_type_t address_type){
+// only used to send HCI Host Number Completed Packets
+static int hci_can_send_comand_packet_transport(btstack_state_t *btstack){
+    if (!hci_packet_buffer_available(btstack)) return 0;
+    return hci_transport_can_send_prepared_packet_now(btstack, HCI_COMMAND_DATA_PACKET);
+}
+
+// new functions replacing hci_can_send_packet_now[_using_packet_buffer]
+int hci_can_send_command_packet_now(btstack_state_t *btstack){
+    if (hci_can_send_comand_packet_transport(btstack) == 0) return 0;
+    // Num_HCI_Command_Packets can be refreshed while commands are in flight
+    if (hci_command_in_flight_free(btstack) == NULL) return 0;
+    return btstack->hci->num_cmd_packets > 0;
+}
+
+static int hci_transport_can_send_acl_fragment_now(btstack_state_t *btstack, hci_con_handle_t con_handle){
     if (!hci_transport_can_send_prepared_packet_now(btstack, HCI_ACL_DATA_PACKET)) return 0;
-    return hci_number_free_acl_slots_for_connection_type(btstack, address_type) > 0;
+    return hci_number_free_acl_slots_for_handle(btstack, con_handle) > 0;
+}
+
+// fragments share the packet buffer and the next ACL header overwrites the end of the previous fragment,
+// so only one fragment of the buffer can be in the HCI Transport at a time
+static int hci_transport_can_send_next_acl_fragment_now(btstack_state_t *btstack, hci_con_handle_t con_handle){
+    if (btstack->hci->acl_fragmentation_buffer->num_in_transport > 0) return 0;
+    return hci_transport_can_send_acl_fragment_now(btstack, con_handle);
+}
+
+// ACL packets prepared in the packet buffer would block the remaining fragments of a packet gathered from caller memory
+static int hci_packet_buffer_available_for_acl(btstack_state_t *btstack){
+    if (!hci_packet_buffer_available(btstack)) return 0;
+    return hci_acl_iov_packet_in_progress(btstack) ? 0 : 1;
 }
 
+// prepared packets get queued while the HCI Transport is busy, so only controller buffers are checked
 int hci_can_send_acl_le_packet_now(btstack_state_t *btstack){
-    if (btstack->hci->hci_packet_buffer_reserved) return 0;
-    return hci_can_send_prepared_acl_packet_for_address_type(btstack, BD_ADDR_TYPE_LE_PUBLIC);
+    if (!hci_packet_buffer_available_for_acl(btstack)) return 0;
+    return hci_number_free_acl_slots_for_connection_type(btstack, BD_ADDR_TYPE_LE_PUBLIC) > 0;
 }
 
 int hci_can_send_prepared_acl_packet_now(btstack_state_t *btstack, hci_con_handle_t con_handle) {
-    if (!hci_transport_can_send_prepared_packet_now(btstack, HCI_ACL_DATA_PACKET)) return 0;
     return hci_number_free_acl_slots_for_handle(btstack, con_handle) > 0;
 }
 
 int hci_can_send_acl_packet_now(btstack_state_t *btstack, hci_con_handle_t con_handle){
-    if (btstack->hci->hci_packet_buffer_reserved) return 0;
+    if (!hci_packet_buffer_available_for_acl(btstack)) return 0;
     return hci_can_send_prepared_acl_packet_now(btstack, con_handle);
 }
 
 #ifdef ENABLE_CLASSIC
 int hci_can_send_acl_classic_packet_now(btstack_state_t *btstack){
-    if (btstack->hci->hci_packet_buffer_reserved) return 0;
-    return hci_can_send_prepared_acl_packet_for_address_type(btstack, BD_ADDR_TYPE_ACL);
+    if (!hci_packet_buffer_available_for_acl(btstack)) return 0;
+    return hci_number_free_acl_slots_for_connection_type(btstack, BD_ADDR_TYPE_ACL) > 0;
 }
 
 int hci_can_send_prepared_sco_packet_now(btstack_state_t *btstack){
-    if (!hci_transport_can_send_prepared_packet_now(btstack, HCI_SCO_DATA_PACKET)) return 0;
     if (hci_have_usb_transport(btstack)){
         return btstack->hci->sco_can_send_now;
     } else {
@@ -600,7 +771,7 @@ int hci_can_send_prepared_sco_packet_now(btstack_state_t *btstack){
 }
 
 int hci_can_send_sco_packet_now(btstack_state_t *btstack){
-    if (btstack->hci->hci_packet_buffer_reserved) return 0;
+    if (!hci_packet_buffer_available(btstack)) return 0;
     return hci_can_send_prepared_sco_packet_now(btstack);
 }
 
@@ -612,33 +783,58 @@ void hci_request_sco_can_send_now_event(btstack_state_t *btstack){
 
 // used for internal checks in l2cap.c
 int hci_is_packet_buffer_reserved(btstack_state_t *btstack){
-    return btstack->hci->hci_packet_buffer_reserved;
+    return !hci_packet_buffer_available(btstack);
 }
 
 // reserves outgoing packet buffer. @returns 1 if successful
 int hci_reserve_packet_buffer(btstack_state_t *btstack){
-    if (btstack->hci->hci_packet_buffer_reserved) {
+    if (!hci_packet_buffer_available(btstack)) {
         log_error("hci_reserve_packet_buffer called but buffer already reserved");
         return 0;
     }
-    btstack->hci->hci_packet_buffer_reserved = 1;
+    btstack->hci->packet_buffer_current->state = HCI_PACKET_BUFFER_RESERVED;
     return 1;
 }
 
 void hci_release_packet_buffer(btstack_state_t *btstack){
-    btstack->hci->hci_packet_buffer_reserved = 0;
+    if (btstack->hci->packet_buffer_current->state != HCI_PACKET_BUFFER_RESERVED) return;
+    hci_packet_buffer_free(btstack, btstack->hci->packet_buffer_current);
+}
+
+// asynchronous transports own the packet buffer until HCI_EVENT_TRANSPORT_PACKET_SENT, which is reported once per packet in send order
+static int hci_transport_send_packet(btstack_state_t *btstack, uint8_t packet_type, uint8_t * packet, int size){
+    if (!hci_transport_synchronous(btstack)){
+        hci_packet_buffer_t * buffer = hci_packet_buffer_for_packet(btstack, packet);
+        if (btstack->hci->packets_in_transport_num < HCI_TRANSPORT_TX_QUEUE_SIZE){
+            uint8_t index = (btstack->hci->packets_in_transport_head + btstack->hci->packets_in_transport_num) % HCI_TRANSPORT_TX_QUEUE_SIZE;
+            btstack->hci->packets_in_transport[index] = buffer;
+            btstack->hci->packets_in_transport_num++;
+        } else {
+            log_error("hci_transport_send_packet: more than HCI_TRANSPORT_TX_QUEUE_SIZE packets in transport");
+        }
+        if (buffer){
+            buffer->state = HCI_PACKET_BUFFER_IN_TRANSPORT;
+            buffer->num_in_transport++;
+            hci_packet_buffer_select_current(btstack);
+        }
+    }
+    return btstack->hci->hci_transport->send_packet(btstack, packet_type, packet, size);
 }
 
-// assumption: synchronous implementations don't provide can_send_packet_now as they don't keep the buffer after the call
-static int hci_transport_synchronous(btstack_state_t *btstack){
-    return btstack->hci->hci_transport->can_send_packet_now == NULL;
+// @returns buffer of oldest packet in transport or NULL
+static hci_packet_buffer_t * hci_transport_packet_sent(btstack_state_t *btstack){
+    if (btstack->hci->packets_in_transport_num == 0) return NULL;
+    hci_packet_buffer_t * buffer = btstack->hci->packets_in_transport[btstack->hci->packets_in_transport_head];
+    btstack->hci->packets_in_transport_head = (btstack->hci->packets_in_transport_head + 1) % HCI_TRANSPORT_TX_QUEUE_SIZE;
+    btstack->hci->packets_in_transport_num--;
+    if (buffer != NULL){
+        buffer->num_in_transport--;
+    }
+    return buffer;
 }
 
-static int hci_send_acl_packet_fragments(btstack_state_t *btstack, hci_connection_t *connection){
-
-    // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", btstack->hci->acl_fragmentation_pos, btstack->hci->acl_fragmentation_total_size, connection->con_handle);
-
-    // max ACL data packet length depends on connection type (LE vs. Classic) and available buffers
+// max ACL data packet length depends on connection type (LE vs. Classic) and available buffers
+static uint16_t hci_max_acl_fragment_length(btstack_state_t *btstack, hci_connection_t *connection){
     uint16_t max_acl_data_packet_length = btstack->hci->acl_data_packet_length;
     if (hci_is_le_connection(connection) && (btstack->hci->le_data_packets_length > 0)){
         max_acl_data_packet_length = btstack->hci->le_data_packets_length;
@@ -649,9 +845,18 @@ static int hci_send_acl_packet_fragments(btstack_state_t *btstack, hci_connectio
         max_acl_data_packet_length = connection->le_max_tx_octets;
     }
 #endif
+    return max_acl_data_packet_length;
+}
+
+static int hci_send_acl_packet_fragments(btstack_state_t *btstack, hci_connection_t *connection){
+
+    // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", btstack->hci->acl_fragmentation_pos, btstack->hci->acl_fragmentation_total_size, connection->con_handle);
+
+    uint16_t max_acl_data_packet_length = hci_max_acl_fragment_length(btstack, connection);
 
     log_debug("hci_send_acl_packet_fragments entered");
 
+    uint8_t * acl_buffer = btstack->hci->acl_fragmentation_buffer->packet;
     int err;
     // multiple packets could be send on a synchronous HCI transport
     while (true){
@@ -671,16 +876,17 @@ static int hci_send_acl_packet_fragments(btstack_state_t *btstack, hci_connectio
 
         // copy handle_and_flags if not first fragment and update packet boundary flags to be 01 (continuing fragmnent)
         if (acl_header_pos > 0){
-            uint16_t handle_and_flags = little_endian_read_16(btstack->hci->hci_packet_buffer, 0);
+            uint16_t handle_and_flags = little_endian_read_16(acl_buffer, 0);
             handle_and_flags = (handle_and_flags & 0xcfff) | (1 << 12);
-            little_endian_store_16(btstack->hci->hci_packet_buffer, acl_header_pos, handle_and_flags);
+            little_endian_store_16(acl_buffer, acl_header_pos, handle_and_flags);
+
+            // count packet, first fragment has been counted in hci_send_acl_packet_buffer
+            hci_connection_packets_sent(btstack, connection, 1);
         }
 
         // update header len
-        little_endian_store_16(btstack->hci->hci_packet_buffer, acl_header_pos + 2, current_acl_data_packet_length);
+        little_endian_store_16(acl_buffer, acl_header_pos + 2, current_acl_data_packet_length);
 
-        // count packet
-        connection->num_packets_sent++;
         log_debug("hci_send_acl_packet_fragments loop before send (more fragments %d)", more_fragments);
 
         // update state for next fragment (if any) as "transport done" might be sent during send_packet already
@@ -694,11 +900,10 @@ static int hci_send_acl_packet_fragments(btstack_state_t *btstack, hci_connectio
         }
 
         // send packet
-        uint8_t * packet = &btstack->hci->hci_packet_buffer[acl_header_pos];
+        uint8_t * packet = &acl_buffer[acl_header_pos];
         const int size = current_acl_data_packet_length + 4;
         hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, size);
-        btstack->hci->acl_fragmentation_tx_active = 1;
-        err = btstack->hci->hci_transport->send_packet(btstack, HCI_ACL_DATA_PACKET, packet, size);
+        err = hci_transport_send_packet(btstack, HCI_ACL_DATA_PACKET, packet, size);
 
         log_debug("hci_send_acl_packet_fragments loop after send (more fragments %d)", more_fragments);
 
@@ -706,27 +911,262 @@ static int hci_send_acl_packet_fragments(btstack_state_t *btstack, hci_connectio
         if (!more_fragments) break;
 
         // can send more?
-        if (!hci_can_send_prepared_acl_packet_now(btstack, connection->con_handle)) return err;
+        if (!hci_transport_can_send_next_acl_fragment_now(btstack, connection->con_handle)) return err;
     }
 
     log_debug("hci_send_acl_packet_fragments loop over");
 
     // release buffer now for synchronous transport
     if (hci_transport_synchronous(btstack)){
-        btstack->hci->acl_fragmentation_tx_active = 0;
-        hci_release_packet_buffer(btstack);
+        hci_packet_buffer_t * buffer = btstack->hci->acl_fragmentation_buffer;
+        btstack->hci->acl_fragmentation_buffer = NULL;
+        hci_packet_buffer_free(btstack, buffer);
         hci_emit_transport_packet_sent(btstack);
     }
 
     return err;
 }
 
+// hand next queued ACL/SCO packet to HCI Transport. @returns true if packet was sent
+static bool hci_send_next_queued_packet(btstack_state_t *btstack, int * err){
+    *err = 0;
+
+    // wait for all fragments of previous packet, HCI Transport limits number of packets in flight
+    if (btstack->hci->acl_fragmentation_buffer != NULL) return false;
+    if (hci_acl_iov_packet_in_progress(btstack)) return false;
+
+    hci_packet_buffer_t * buffer = (hci_packet_buffer_t *) btstack->hci->packet_buffer_queue;
+    if (buffer == NULL) return false;
+    if (!hci_transport_can_send_prepared_packet_now(btstack, buffer->packet_type)) return false;
+    btstack_linked_list_pop(&btstack->hci->packet_buffer_queue);
+
+    hci_connection_t * connection;
+    switch (buffer->packet_type){
+        case HCI_ACL_DATA_PACKET:
+            connection = hci_connection_for_handle(btstack, READ_ACL_CONNECTION_HANDLE(buffer->packet));
+            if (!connection){
+                log_info("hci_send_next_queued_packet: no connection for ACL packet -> discard");
+                hci_packet_buffer_free(btstack, buffer);
+                hci_emit_transport_packet_sent(btstack);
+                return false;
+            }
+            // setup data
+            btstack->hci->acl_fragmentation_buffer = buffer;
+            btstack->hci->acl_fragmentation_total_size = buffer->size;
+            btstack->hci->acl_fragmentation_pos = 4;   // start of L2CAP packet
+            *err = hci_send_acl_packet_fragments(btstack, connection);
+            return true;
+#ifdef ENABLE_CLASSIC
+        case HCI_SCO_DATA_PACKET:
+            hci_dump_packet(HCI_SCO_DATA_PACKET, 0, buffer->packet, buffer->size);
+            *err = hci_transport_send_packet(btstack, HCI_SCO_DATA_PACKET, buffer->packet, buffer->size);
+            if (hci_transport_synchronous(btstack)){
+                hci_packet_buffer_free(btstack, buffer);
+                hci_emit_transport_packet_sent(btstack);
+            }
+            return true;
+#endif
+        default:
+            hci_packet_buffer_free(btstack, buffer);
+            return false;
+    }
+}
+
+// queue prepared packet behind packets from other buffers and try to send it
+static int hci_queue_packet_buffer(btstack_state_t *btstack, uint8_t packet_type, int size){
+    hci_packet_buffer_t * buffer = btstack->hci->packet_buffer_current;
+    buffer->state = HCI_PACKET_BUFFER_QUEUED;
+    buffer->packet_type = packet_type;
+    buffer->size = (uint16_t) size;
+    btstack_linked_list_add_tail(&btstack->hci->packet_buffer_queue, (btstack_linked_item_t *) buffer);
+    hci_packet_buffer_select_current(btstack);
+
+    int err;
+    (void) hci_send_next_queued_packet(btstack, &err);
+    return err;
+}
+
+// drop queued packets for closed connection
+static void hci_packet_buffer_queue_drop_for_handle(btstack_state_t *btstack, hci_con_handle_t con_handle){
+    bool dropped = false;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &btstack->hci->packet_buffer_queue);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_packet_buffer_t * buffer = (hci_packet_buffer_t *) btstack_linked_list_iterator_next(&it);
+        if (READ_ACL_CONNECTION_HANDLE(buffer->packet) != con_handle) continue;   // same for ACL and SCO
+        log_info("drop queued packet for closed connection 0x%04x", con_handle);
+        btstack_linked_list_iterator_remove(&it);
+        hci_packet_buffer_free(btstack, buffer);
+        dropped = true;
+    }
+    if (!dropped) return;
+
+    // buffers are available again, wake up senders waiting on other connections
+    hci_emit_transport_packet_sent(btstack);
+#ifdef ENABLE_CLASSIC
+    hci_notify_if_sco_can_send_now(btstack);
+#endif
+}
+
+// ACL packets gathered from caller memory
+
+static uint16_t hci_acl_iov_packet_len(const hci_acl_iov_packet_t * packet){
+    return packet->header_len + packet->payload_len;
+}
+
+// first packet that still has fragments to send
+static hci_acl_iov_packet_t * hci_acl_iov_packet_next(btstack_state_t *btstack){
+    btstack_linked_item_t * it;
+    for (it = btstack->hci->acl_iov_packets; it != NULL; it = it->next){
+        hci_acl_iov_packet_t * packet = (hci_acl_iov_packet_t *) it;
+        if (packet->pos < hci_acl_iov_packet_len(packet)) return packet;
+    }
+    return NULL;
+}
+
+// first fragment has been sent, other ACL packets have to wait for the remaining ones
+static bool hci_acl_iov_packet_in_progress(btstack_state_t *btstack){
+    hci_acl_iov_packet_t * packet = hci_acl_iov_packet_next(btstack);
+    return (packet != NULL) && (packet->pos > 0);
+}
+
+// copy len bytes starting at pos of header + payload into buffer
+static void hci_acl_iov_packet_gather(const hci_acl_iov_packet_t * packet, uint8_t * buffer, uint16_t pos, uint16_t len){
+    while ((len > 0) && (pos < packet->header_len)){
+        *buffer++ = packet->header[pos++];
+        len--;
+    }
+    uint32_t offset = (uint32_t) packet->payload_offset + pos - packet->header_len;
+    int i;
+    for (i = 0; (i < packet->iov_count) && (len > 0); i++){
+        const hci_iov_t * iov = &packet->iov[i];
+        if (offset >= iov->len){
+            offset -= iov->len;
+            continue;
+        }
+        uint16_t chunk = btstack_min(iov->len - offset, len);
+        (void)memcpy(buffer, &iov->data[offset], chunk);
+        buffer += chunk;
+        len    -= chunk;
+        offset  = 0;
+    }
+}
+
+// emit callback when all fragments have been sent and are not in HCI Transport anymore
+static void hci_acl_iov_packet_check_complete(btstack_state_t *btstack, hci_acl_iov_packet_t * packet){
+    if (packet->pos < hci_acl_iov_packet_len(packet)) return;
+    if (packet->num_in_transport > 0) return;
+    btstack_linked_list_remove(&btstack->hci->acl_iov_packets, (btstack_linked_item_t *) packet);
+    (*packet->callback)(btstack, packet, packet->status);
+}
+
+// drop packets for closed connection or all for HCI_CON_HANDLE_INVALID
+static void hci_acl_iov_packets_drop(btstack_state_t *btstack, hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &btstack->hci->acl_iov_packets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_acl_iov_packet_t * packet = (hci_acl_iov_packet_t *) btstack_linked_list_iterator_next(&it);
+        if ((con_handle != HCI_CON_HANDLE_INVALID) && (packet->con_handle != con_handle)) continue;
+        if (packet->pos < hci_acl_iov_packet_len(packet)){
+            log_info("drop ACL iov packet for closed connection 0x%04x", packet->con_handle);
+            packet->status = ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+            packet->pos = hci_acl_iov_packet_len(packet);
+        }
+        // keep packet until fragments have left HCI Transport
+        if (packet->num_in_transport > 0) continue;
+        btstack_linked_list_iterator_remove(&it);
+        (*packet->callback)(btstack, packet, packet->status);
+    }
+}
+
+// assemble next fragment in free packet buffer and send it. @returns true if fragment was sent
+static bool hci_acl_iov_packet_send_fragment(btstack_state_t *btstack, int * err){
+    *err = 0;
+
+    hci_acl_iov_packet_t * packet = hci_acl_iov_packet_next(btstack);
+    if (packet == NULL) return false;
+
+    // prepared packets first, they have been counted already
+    if (packet->pos == 0){
+        if (btstack->hci->acl_fragmentation_buffer != NULL) return false;
+        if (btstack->hci->packet_buffer_queue != NULL) return false;
+    }
+
+    hci_connection_t * connection = hci_connection_for_handle(btstack, packet->con_handle);
+    if (!connection){
+        hci_acl_iov_packets_drop(btstack, packet->con_handle);
+        return false;
+    }
+
+    if (!hci_packet_buffer_available(btstack)) return false;
+    if (!hci_transport_can_send_acl_fragment_now(btstack, packet->con_handle)) return false;
+
+    uint16_t total_len = hci_acl_iov_packet_len(packet);
+    uint16_t len = btstack_min(total_len - packet->pos, hci_max_acl_fragment_length(btstack, connection));
+    len = btstack_min(len, HCI_ACL_PAYLOAD_SIZE);
+
+    uint16_t packet_boundary_flag = 0x01;   // continuing fragment
+    if (packet->pos == 0){
+        packet_boundary_flag = packet->packet_boundary_flag;
+#ifdef ENABLE_CLASSIC
+        hci_connection_timestamp(btstack, connection);
+#endif
+    }
+
+    hci_packet_buffer_t * buffer = btstack->hci->packet_buffer_current;
+    uint8_t * acl_buffer = buffer->packet;
+    little_endian_store_16(acl_buffer, 0, packet->con_handle | (packet_boundary_flag << 12));
+    little_endian_store_16(acl_buffer, 2, len);
+    hci_acl_iov_packet_gather(packet, &acl_buffer[4], packet->pos, len);
+    packet->pos += len;
+
+    hci_connection_packets_sent(btstack, connection, 1);
+
+    if (hci_transport_synchronous(btstack)){
+        hci_dump_packet(HCI_ACL_DATA_PACKET, 0, acl_buffer, len + 4);
+        *err = btstack->hci->hci_transport->send_packet(btstack, HCI_ACL_DATA_PACKET, acl_buffer, len + 4);
+        if (packet->pos == total_len){
+            hci_acl_iov_packet_check_complete(btstack, packet);
+            hci_emit_transport_packet_sent(btstack);
+        }
+    } else {
+        buffer->iov_packet = packet;
+        packet->num_in_transport++;
+        hci_dump_packet(HCI_ACL_DATA_PACKET, 0, acl_buffer, len + 4);
+        *err = hci_transport_send_packet(btstack, HCI_ACL_DATA_PACKET, acl_buffer, len + 4);
+    }
+    return true;
+}
+
+uint8_t hci_send_acl_iov_packet(btstack_state_t *btstack, hci_acl_iov_packet_t * packet){
+    if (hci_connection_for_handle(btstack, packet->con_handle) == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (packet->header_len > HCI_ACL_IOV_HEADER_MAX_SIZE) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (hci_acl_iov_packet_len(packet) == 0) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    uint32_t iov_len = 0;
+    int i;
+    for (i = 0; i < packet->iov_count; i++){
+        iov_len += packet->iov[i].len;
+    }
+    if (((uint32_t) packet->payload_offset + packet->payload_len) > iov_len) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+
+    packet->pos = 0;
+    packet->num_in_transport = 0;
+    packet->status = ERROR_CODE_SUCCESS;
+    btstack_linked_list_add_tail(&btstack->hci->acl_iov_packets, (btstack_linked_item_t *) packet);
+
+    // send as many fragments as possible
+    int err;
+    while (hci_acl_iov_packet_send_fragment(btstack, &err)){
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
 // pre: caller has reserved the packet buffer
 int hci_send_acl_packet_buffer(btstack_state_t *btstack, int size){
 
     // log_info("hci_send_acl_packet_buffer size %u", size);
 
-    if (!btstack->hci->hci_packet_buffer_reserved) {
+    if (btstack->hci->packet_buffer_current->state != HCI_PACKET_BUFFER_RESERVED) {
         log_error("hci_send_acl_packet_buffer called without reserving packet buffer");
         return 0;
     }
@@ -734,7 +1174,7 @@ int hci_send_acl_packet_buffer(btstack_state_t *btstack, int size){
     uint8_t * packet = btstack->hci->hci_packet_buffer;
     hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(packet);
 
-    // check for free places on Bluetooth module
+    // check for free places on Bluetooth module, queued packets are already accounted for
     if (!hci_can_send_prepared_acl_packet_now(btstack, con_handle)) {
         log_error("hci_send_acl_packet_buffer called but no free ACL buffers on controller");
         hci_release_packet_buffer(btstack);
@@ -756,11 +1196,10 @@ int hci_send_acl_packet_buffer(btstack_state_t *btstack, int size){
 
     // hci_dump_packet( HCI_ACL_DATA_PACKET, 0, packet, size);
 
-    // setup data
-    btstack->hci->acl_fragmentation_total_size = size;
-    btstack->hci->acl_fragmentation_pos = 4;   // start of L2CAP packet
+    // count packet (first fragment)
+    hci_connection_packets_sent(btstack, connection, 1);
 
-    return hci_send_acl_packet_fragments(btstack, connection);
+    return hci_queue_packet_buffer(btstack, HCI_ACL_DATA_PACKET, size);
 }
 
 #ifdef ENABLE_CLASSIC
@@ -769,7 +1208,7 @@ int hci_send_sco_packet_buffer(btstack_state_t *btstack, int size){
 
     // log_info("hci_send_acl_packet_buffer size %u", size);
 
-    if (!btstack->hci->hci_packet_buffer_reserved) {
+    if (btstack->hci->packet_buffer_current->state != HCI_PACKET_BUFFER_RESERVED) {
         log_error("hci_send_acl_packet_buffer called without reserving packet buffer");
         return 0;
     }
@@ -809,15 +1248,7 @@ int hci_send_sco_packet_buffer(btstack_state_t *btstack, int size){
         }
     }
 
-    hci_dump_packet( HCI_SCO_DATA_PACKET, 0, packet, size);
-    int err = btstack->hci->hci_transport->send_packet(btstack, HCI_SCO_DATA_PACKET, packet, size);
-
-    if (hci_transport_synchronous(btstack)){
-        hci_release_packet_buffer(btstack);
-        hci_emit_transport_packet_sent(btstack);
-    }
-
-    return err;
+    return hci_queue_packet_buffer(btstack, HCI_SCO_DATA_PACKET, size);
 }
 #endif
 
@@ -942,8 +1373,7 @@ static void hci_shutdown_connection(btstack_state_t *btstack, hci_connection_t *
 
     btstack_run_loop_remove_timer(btstack, &conn->timeout);
 
-    btstack_linked_list_remove(&btstack->hci->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free(btstack, conn);
 
     // now it's gone
     hci_emit_nr_connections_changed(btstack);
@@ -1110,10 +1540,10 @@ static void hci_reenable_advertisements_if_needed(void){
     if (!btstack->hci->le_advertisements_active && btstack->hci->le_advertisements_enabled){
         // get number of active le slave connections
         int num_slave_connections = 0;
-        btstack_linked_list_iterator_t it;
-        btstack_linked_list_iterator_init(&it, btstack->hci->connections);
-        while (btstack_linked_list_iterator_has_next(&it)){
-            hci_connection_t * con = (hci_connection_t*) btstack_linked_list_iterator_next(&it);
+        btstack_dlist_iterator_t it;
+        btstack_dlist_iterator_init(&it, &btstack->hci->connections);
+        while (btstack_dlist_iterator_has_next(&it)){
+            hci_connection_t * con = (hci_connection_t*) btstack_dlist_iterator_next(&it);
             log_info("state %u, role %u, le_con %u", con->state, con->role, hci_is_le_connection(con));
             if (con->state != OPEN) continue;
             if (con->role  != HCI_ROLE_SLAVE) continue;
@@ -1149,12 +1579,13 @@ static void hci_initialization_timeout_handler(btstack_state_t *btstack, btstack
             log_info("Resend HCI Reset");
             btstack->hci->substate = HCI_INIT_SEND_RESET;
             btstack->hci->num_cmd_packets = 1;
+            hci_command_requests_fail(btstack, false, ERROR_CODE_COMMAND_DISALLOWED);
             hci_run(btstack);
             break;
         case HCI_INIT_W4_CUSTOM_INIT_CSR_WARM_BOOT_LINK_RESET:
             log_info("Resend HCI Reset - CSR Warm Boot with Link Reset");
             if (btstack->hci->hci_transport->reset_link){
-                btstack->hci->hci_transport->reset_link();
+                btstack->hci->hci_transport->reset_link(btstack);
             }
 
             /* fall through */
@@ -1163,6 +1594,7 @@ static void hci_initialization_timeout_handler(btstack_state_t *btstack, btstack
             log_info("Resend HCI Reset - CSR Warm Boot");
             btstack->hci->substate = HCI_INIT_SEND_RESET_CSR_WARM_BOOT;
             btstack->hci->num_cmd_packets = 1;
+            hci_command_requests_fail(btstack, false, ERROR_CODE_COMMAND_DISALLOWED);
             hci_run(btstack);
             break;
         case HCI_INIT_W4_SEND_BAUD_CHANGE:
@@ -1175,7 +1607,7 @@ static void hci_initialization_timeout_handler(btstack_state_t *btstack, btstack
             if (btstack->hci->manufacturer == BLUETOOTH_COMPANY_ID_CAMBRIDGE_SILICON_RADIO){
                 if (btstack->hci->hci_transport->reset_link){
                     log_info("Link Reset");
-                    btstack->hci->hci_transport->reset_link();
+                    btstack->hci->hci_transport->reset_link(btstack);
                 }
                 btstack->hci->substate = HCI_INIT_SEND_RESET_CSR_WARM_BOOT;
                 hci_run(btstack);
@@ -1297,7 +1729,7 @@ static void hci_initializing_run(btstack_state_t *btstack){
                     int size = 3 + btstack->hci->hci_packet_buffer[2];
                     btstack->hci->last_cmd_opcode = little_endian_read_16(btstack->hci->hci_packet_buffer, 0);
                     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, btstack->hci->hci_packet_buffer, size);
-                    btstack->hci->hci_transport->send_packet(btstack, HCI_COMMAND_DATA_PACKET, btstack->hci->hci_packet_buffer, size);
+                    hci_transport_send_packet(btstack, HCI_COMMAND_DATA_PACKET, btstack->hci->hci_packet_buffer, size);
                     break;
                 }
                 log_info("Init script done");
@@ -1417,7 +1849,7 @@ static void hci_initializing_run(btstack_state_t *btstack){
             (void)memcpy(&packet[3], btstack->hci->local_name, bytes_to_copy);
             // expand '00:00:00:00:00:00' in name with bd_addr
             btstack_replace_bd_addr_placeholder(&packet[3], bytes_to_copy, btstack->hci->local_bd_addr);
-            hci_send_cmd_packet(btstack, packet, HCI_CMD_HEADER_SIZE + DEVICE_NAME_LEN);
+            hci_send_reserved_cmd_packet(btstack, HCI_CMD_HEADER_SIZE + DEVICE_NAME_LEN);
             break;
         }
         case HCI_INIT_WRITE_EIR_DATA: {
@@ -1459,7 +1891,7 @@ static void hci_initializing_run(btstack_state_t *btstack){
                 // expand '00:00:00:00:00:00' in name with bd_addr
                 btstack_replace_bd_addr_placeholder(&packet[offset], bytes_to_copy, btstack->hci->local_bd_addr);
             }
-            hci_send_cmd_packet(btstack, packet, HCI_CMD_HEADER_SIZE + 1 + EXTENDED_INQUIRY_RESPONSE_DATA_LEN);
+            hci_send_reserved_cmd_packet(btstack, HCI_CMD_HEADER_SIZE + 1 + EXTENDED_INQUIRY_RESPONSE_DATA_LEN);
             break;
         }
         case HCI_INIT_WRITE_INQUIRY_MODE:
@@ -1576,6 +2008,7 @@ static bool hci_initializing_event_handler_command_completed(btstack_state_t *bt
     if ((btstack->hci->substate == HCI_INIT_W4_CUSTOM_INIT) && (hci_event_packet_get_type(packet) == HCI_EVENT_VENDOR_SPECIFIC)){
         // TODO: track actual command
         command_completed = true;
+        hci_command_in_flight_abandon_oldest(btstack);
     }
 
     // Vendor == Toshiba
@@ -1584,6 +2017,7 @@ static bool hci_initializing_event_handler_command_completed(btstack_state_t *bt
         command_completed = true;
         // Fix: no HCI Command Complete received, so num_cmd_packets not reset
         btstack->hci->num_cmd_packets = 1;
+        hci_command_in_flight_abandon_oldest(btstack);
     }
 #endif
 
@@ -1884,8 +2318,7 @@ static void hci_handle_connection_failed(btstack_state_t *btstack, hci_connectio
 #endif
 
     // connection failed, remove entry
-    btstack_linked_list_remove(&btstack->hci->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free(btstack, conn);
 
 #ifdef ENABLE_CLASSIC
     // notify client if dedicated bonding
@@ -1930,8 +2363,11 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
     bd_addr_type_t addr_type;
     hci_con_handle_t handle;
     hci_connection_t * conn;
+    hci_packet_buffer_t * buffer;
     int i;
     int create_connection_cmd;
+    // requester of completed command, notified after stack and upper layers have seen the event
+    hci_command_request_t * command_request = NULL;
 
 #ifdef ENABLE_CLASSIC
     uint8_t link_type;
@@ -1942,8 +2378,10 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
     switch (hci_event_packet_get_type(packet)) {
 
         case HCI_EVENT_COMMAND_COMPLETE:
-            // get num cmd packets - limit to 1 to reduce complexity
-            btstack->hci->num_cmd_packets = packet[2] ? 1 : 0;
+            // get num cmd packets - limit to HCI_NUM_CMD_PACKETS_MAX to reduce complexity
+            btstack->hci->num_cmd_packets = btstack_min(packet[2], HCI_NUM_CMD_PACKETS_MAX);
+            // free slot now, so handlers of this event can send the next command
+            command_request = hci_command_in_flight_complete(btstack, hci_event_command_complete_get_command_opcode(packet));
             einstein_log(90, __func__, __LINE__, "%d", btstack->hci->num_cmd_packets);
 
             if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_read_local_name)){
@@ -2115,8 +2553,9 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
             break;
 
         case HCI_EVENT_COMMAND_STATUS:
-            // get num cmd packets - limit to 1 to reduce complexity
-            btstack->hci->num_cmd_packets = packet[3] ? 1 : 0;
+            // get num cmd packets - limit to HCI_NUM_CMD_PACKETS_MAX to reduce complexity
+            btstack->hci->num_cmd_packets = btstack_min(packet[3], HCI_NUM_CMD_PACKETS_MAX);
+            command_request = hci_command_in_flight_complete(btstack, hci_event_command_status_get_command_opcode(packet));
 
             // check command status to detected failed outgoing connections
             create_connection_cmd = 0;
@@ -2165,10 +2604,10 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
                 }
 
                 if (conn->num_packets_sent >= num_packets){
-                    conn->num_packets_sent -= num_packets;
+                    hci_connection_packets_completed(btstack, conn, num_packets);
                 } else {
                     log_error("hci_number_completed_packets, more packet slots freed then sent.");
-                    conn->num_packets_sent = 0;
+                    hci_connection_packets_completed(btstack, conn, conn->num_packets_sent);
                 }
                 // log_info("hci_number_completed_packet %u processed for handle %u, outstanding %u", num_packets, handle, conn->num_packets_sent);
 
@@ -2235,7 +2674,7 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
             if (conn) {
                 if (!packet[2]){
                     conn->state = OPEN;
-                    conn->con_handle = little_endian_read_16(packet, 3);
+                    hci_connection_set_handle(btstack, conn, little_endian_read_16(packet, 3));
 
                     // queue get remote feature
                     conn->bonding_flags |= BONDING_REQUEST_REMOTE_FEATURES;
@@ -2274,7 +2713,7 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
                 break;
             }
             conn->state = OPEN;
-            conn->con_handle = little_endian_read_16(packet, 3);
+            hci_connection_set_handle(btstack, conn, little_endian_read_16(packet, 3));
 
 #ifdef ENABLE_SCO_OVER_HCI
             // update SCO
@@ -2444,21 +2883,28 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
             handle = little_endian_read_16(packet, 3);
             // drop outgoing ACL fragments if it is for closed connection and release buffer if tx not active
             if (btstack->hci->acl_fragmentation_total_size > 0) {
-                if (handle == READ_ACL_CONNECTION_HANDLE(btstack->hci->hci_packet_buffer)){
-                    int release_buffer = btstack->hci->acl_fragmentation_tx_active == 0;
+                buffer = btstack->hci->acl_fragmentation_buffer;
+                if (handle == READ_ACL_CONNECTION_HANDLE(buffer->packet)){
+                    int release_buffer = buffer->num_in_transport == 0;
                     log_info("drop fragmented ACL data for closed connection, release buffer %u", release_buffer);
                     btstack->hci->acl_fragmentation_total_size = 0;
                     btstack->hci->acl_fragmentation_pos = 0;
                     if (release_buffer){
-                        hci_release_packet_buffer(btstack);
+                        btstack->hci->acl_fragmentation_buffer = NULL;
+                        hci_packet_buffer_free(btstack, buffer);
                     }
                 }
             }
+            // drop packets queued for closed connection
+            hci_packet_buffer_queue_drop_for_handle(btstack, handle);
+            hci_acl_iov_packets_drop(btstack, handle);
 
             conn = hci_connection_for_handle(btstack, handle);
             if (!conn) break;
             // mark connection for shutdown
             conn->state = RECEIVED_DISCONNECTION_COMPLETE;
+            // controller discards packets of closed connection without Number Of Completed Packets
+            hci_connection_packets_completed(btstack, conn, conn->num_packets_sent);
 
             // emit dedicatd bonding event
             if (conn->bonding_flags & BONDING_EMIT_COMPLETE_ON_DISCONNECT){
@@ -2503,9 +2949,22 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
                 log_error("Synchronous HCI Transport shouldn't send HCI_EVENT_TRANSPORT_PACKET_SENT");
                 return; // instead of break: to avoid re-entering hci_run(btstack)
             }
-            btstack->hci->acl_fragmentation_tx_active = 0;
-            if (btstack->hci->acl_fragmentation_total_size) break;
-            hci_release_packet_buffer(btstack);
+            buffer = hci_transport_packet_sent(btstack);
+            // keep buffer while other fragments are in transport or still need to be sent
+            if ((buffer != NULL) && (buffer->num_in_transport == 0)){
+                hci_acl_iov_packet_t * iov_packet = buffer->iov_packet;
+                if (buffer != btstack->hci->acl_fragmentation_buffer){
+                    hci_packet_buffer_free(btstack, buffer);
+                } else if (btstack->hci->acl_fragmentation_total_size == 0){
+                    btstack->hci->acl_fragmentation_buffer = NULL;
+                    hci_packet_buffer_free(btstack, buffer);
+                }
+                // fragment gathered from caller memory accepted
+                if (iov_packet != NULL){
+                    iov_packet->num_in_transport--;
+                    hci_acl_iov_packet_check_complete(btstack, iov_packet);
+                }
+            }
 
             // L2CAP receives this event via the hci_emit_event below
 
@@ -2567,8 +3026,7 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
                         btstack->hci->le_connecting_state = LE_CONNECTING_IDLE;
                         // remove entry
                         if (conn){
-                            btstack_linked_list_remove(&btstack->hci->connections, (btstack_linked_item_t *) conn);
-                            btstack_memory_hci_connection_free( conn );
+                            hci_connection_free(btstack, conn);
                         }
                         break;
                     }
@@ -2596,7 +3054,7 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
 
                     conn->state = OPEN;
                     conn->role  = packet[6];
-                    conn->con_handle             = hci_subevent_le_connection_complete_get_connection_handle(packet);
+                    hci_connection_set_handle(btstack, conn, hci_subevent_le_connection_complete_get_connection_handle(packet));
                     conn->le_connection_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
 
 #ifdef ENABLE_LE_PERIPHERAL
@@ -2670,6 +3128,9 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
             switch (btstack->hci->manufacturer){
                 case BLUETOOTH_COMPANY_ID_CAMBRIDGE_SILICON_RADIO:
                     btstack->hci->num_cmd_packets = 1;
+                    if (hci_command_in_flight_free(btstack) == NULL){
+                        hci_command_in_flight_abandon_oldest(btstack);
+                    }
                     break;
                 default:
                     break;
@@ -2685,6 +3146,11 @@ void event_handler(btstack_state_t *btstack, uint8_t *packet, int size){
     // notify upper stack
 	hci_emit_event(btstack, packet, size, 0);   // don't dump, already happened in packet handler
 
+    // notify requester of queued command
+    if ((command_request != NULL) && (command_request->callback != NULL)){
+        (*command_request->callback)(btstack, HCI_EVENT_PACKET, 0, packet, size);
+    }
+
     // moved here to give upper stack a chance to close down everything with hci_connection_t intact
     if (hci_event_packet_get_type(packet) == HCI_EVENT_DISCONNECTION_COMPLETE){
         if (!packet[2]){
@@ -2806,9 +3272,12 @@ static void packet_handler(btstack_state_t *btstack, uint8_t packet_type, uint8_
         case HCI_EVENT_PACKET:
             event_handler(btstack, packet, size);
             break;
-        case HCI_ACL_DATA_PACKET:
+        case HCI_ACL_DATA_PACKET: {
+            BTSTACK_INSTRUMENTATION_START(acl_start_us);
             acl_handler(btstack, packet, size);
+            BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_HCI, READ_ACL_CONNECTION_HANDLE(packet), size, acl_start_us);
             break;
+        }
 #ifdef ENABLE_CLASSIC
         case HCI_SCO_DATA_PACKET:
             sco_handler(btstack, packet, size);
@@ -2823,9 +3292,31 @@ static void packet_handler(btstack_state_t *btstack, uint8_t packet_type, uint8_
  * @brief Add event packet handler.
  */
 void hci_add_event_handler(btstack_state_t *btstack, btstack_packet_callback_registration_t * callback_handler){
+    callback_handler->event_mask = NULL;
     btstack_linked_list_add_tail(&btstack->hci->event_handlers, (btstack_linked_item_t*) callback_handler);
 }
 
+void hci_add_event_handler_with_mask(btstack_state_t *btstack, btstack_packet_callback_registration_t * callback_handler, const btstack_event_mask_t * event_mask){
+    callback_handler->event_mask = event_mask;
+    btstack_linked_list_add_tail(&btstack->hci->event_handlers, (btstack_linked_item_t*) callback_handler);
+}
+
+void hci_event_mask_add_event(btstack_event_mask_t * event_mask, uint8_t event_code){
+    if (event_code == HCI_EVENT_LE_META){
+        memset(event_mask->le_meta_subevents, 0xff, sizeof(event_mask->le_meta_subevents));
+    }
+    event_mask->events[event_code >> 3] |= 1 << (event_code & 7);
+}
+
+void hci_event_mask_add_le_meta_subevent(btstack_event_mask_t * event_mask, uint8_t subevent_code){
+    event_mask->le_meta_subevents[subevent_code >> 3] |= 1 << (subevent_code & 7);
+}
+
+void hci_get_event_dispatch_statistics(btstack_state_t *btstack, uint32_t * num_dispatched, uint32_t * num_skipped){
+    *num_dispatched = btstack->hci->event_handler_dispatched;
+    *num_skipped    = btstack->hci->event_handler_skipped;
+}
+
 
 /** Register HCI packet handlers */
 void hci_register_acl_packet_handler(btstack_state_t *btstack, btstack_packet_handler_t handler){
@@ -2843,7 +3334,16 @@ void hci_register_sco_packet_handler(btstack_state_t *btstack, btstack_packet_ha
 
 static void hci_state_reset(btstack_state_t *btstack){
     // no connections yet
-    btstack->hci->connections = NULL;
+    memset(&btstack->hci->connections, 0, sizeof(btstack_dlist_t));
+    memset(btstack->hci->connection_for_handle_index, 0, sizeof(btstack->hci->connection_for_handle_index));
+    memset(btstack->hci->connection_for_address_index, 0, sizeof(btstack->hci->connection_for_address_index));
+
+    // commands sent before HCI Reset won't complete, queued ones are sent when working
+    hci_command_requests_fail(btstack, false, ERROR_CODE_COMMAND_DISALLOWED);
+
+    // no ACL packets in flight
+    btstack->hci->acl_packets_sent_classic = 0;
+    btstack->hci->acl_packets_sent_le = 0;
 
     // keep discoverable/connectable as this has been requested by the client(s)
     // btstack->hci->discoverable = 0;
@@ -2851,8 +3351,8 @@ static void hci_state_reset(btstack_state_t *btstack){
     // btstack->hci->bondable = 1;
     // btstack->hci->own_addr_type = 0;
 
-    // buffer is free
-    btstack->hci->hci_packet_buffer_reserved = 0;
+    // buffers are free
+    hci_packet_buffer_reset(btstack);
 
     // no pending cmds
     btstack->hci->decline_reason = 0;
@@ -2888,7 +3388,7 @@ void hci_set_link_key_db(btstack_state_t *btstack, btstack_link_key_db_t const *
 void hci_init(btstack_state_t * btstack, const hci_transport_t *transport, const void *config){
 
     btstack->hci = (hci_stack_t*) calloc(1, sizeof(hci_stack_t));
-    btstack->hci->hci_packet_buffer_data = calloc(1, HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE);
+    btstack->hci->hci_packet_buffer_data = calloc(HCI_OUTGOING_PACKET_BUFFER_NUM, HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE);
 
     // reference to use transport layer implementation
     btstack->hci->hci_transport = transport;
@@ -2896,12 +3396,23 @@ void hci_init(btstack_state_t * btstack, const hci_transport_t *transport, const
     // reference to used config
     btstack->hci->config = config;
 
-    // setup pointer for outgoing packet buffer
-    btstack->hci->hci_packet_buffer = &btstack->hci->hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+    // setup pointers for outgoing packet buffers, each with pre-buffer
+    int i;
+    for (i = 0; i < HCI_OUTGOING_PACKET_BUFFER_NUM; i++){
+        uint8_t * data = &btstack->hci->hci_packet_buffer_data[i * (HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE)];
+        btstack->hci->packet_buffers[i].packet = &data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+    }
+    hci_packet_buffer_reset(btstack);
 
     // max acl payload size defined in config.h
     btstack->hci->acl_data_packet_length = HCI_ACL_PAYLOAD_SIZE;
 
+    // generate CRC tables before HCI Transport and upper layers use them
+    btstack_crc_init();
+
+    // timestamps in hci dump without file system use run loop time
+    hci_dump_set_btstack(btstack);
+
     // register packet handlers with transport
     transport->register_packet_handler(btstack, &packet_handler);
 
@@ -3001,11 +3512,11 @@ void hci_close(btstack_state_t *btstack){
         btstack->hci->link_key_db->close();
     }
 
-    btstack_linked_list_iterator_t lit;
-    btstack_linked_list_iterator_init(&lit, &btstack->hci->connections);
-    while (btstack_linked_list_iterator_has_next(&lit)){
+    btstack_dlist_iterator_t lit;
+    btstack_dlist_iterator_init(&lit, &btstack->hci->connections);
+    while (btstack_dlist_iterator_has_next(&lit)){
         // cancel all l2cap connections by emitting dicsconnection complete before shutdown (free) connection
-        hci_connection_t * connection = (hci_connection_t*) btstack_linked_list_iterator_next(&lit);
+        hci_connection_t * connection = (hci_connection_t*) btstack_dlist_iterator_next(&lit);
         hci_emit_disconnection_complete(btstack, connection->con_handle, 0x16); // terminated by local host
         hci_shutdown_connection(btstack, connection);
     }
@@ -3128,6 +3639,9 @@ static void hci_power_control_off(btstack_state_t *btstack){
     log_info("hci_power_control_off - control closed");
 
     btstack->hci->state = HCI_STATE_OFF;
+
+    // drop queued commands
+    hci_command_requests_fail(btstack, true, ERROR_CODE_COMMAND_DISALLOWED);
 }
 
 static void hci_power_control_sleep(btstack_state_t *btstack){
@@ -3177,7 +3691,7 @@ static int hci_power_control_wake(btstack_state_t *btstack){
 static void hci_power_transition_to_initializing(btstack_state_t *btstack){
     // set up state machine
     btstack->hci->num_cmd_packets = 1; // assume that one cmd can be sent
-    btstack->hci->hci_packet_buffer_reserved = 0;
+    hci_packet_buffer_reset(btstack);
     btstack->hci->state = HCI_STATE_INITIALIZING;
     btstack->hci->substate = HCI_INIT_SEND_RESET;
 }
@@ -3371,8 +3885,8 @@ static void hci_host_num_completed_packets(void){
     size++;  // skip num handles
 
     // add { handle, packets } entries
-    btstack_linked_item_t * it;
-    for (it = (btstack_linked_item_t *) btstack->hci->connections; it ; it = it->next){
+    btstack_dlist_item_t * it;
+    for (it = btstack->hci->connections.first; it ; it = it->next){
         hci_connection_t * connection = (hci_connection_t *) it;
         if (connection->num_packets_completed){
             little_endian_store_16(packet, size, connection->con_handle);
@@ -3409,12 +3923,19 @@ static void hci_halting_timeout_handler(btstack_state_t *btstack, btstack_timer_
     hci_run(btstack);
 }
 
+// reserve packet buffer for command created with hci_cmd_encode_*, pre: hci_can_send_command_packet_now
+static uint8_t * hci_reserve_cmd_packet_buffer(btstack_state_t *btstack){
+    hci_reserve_packet_buffer(btstack);
+    return btstack->hci->hci_packet_buffer;
+}
+
 static bool hci_run_acl_fragments(btstack_state_t *btstack){
     if (btstack->hci->acl_fragmentation_total_size > 0) {
-        hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(btstack->hci->hci_packet_buffer);
+        hci_packet_buffer_t * buffer = btstack->hci->acl_fragmentation_buffer;
+        hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(buffer->packet);
         hci_connection_t *connection = hci_connection_for_handle(btstack, con_handle);
         if (connection) {
-            if (hci_can_send_prepared_acl_packet_now(btstack, con_handle)){
+            if (hci_transport_can_send_next_acl_fragment_now(btstack, con_handle)){
                 hci_send_acl_packet_fragments(btstack, connection);
                 return true;
             }
@@ -3423,11 +3944,47 @@ static bool hci_run_acl_fragments(btstack_state_t *btstack){
             log_info("hci_run: fragmented ACL packet no connection -> discard fragment");
             btstack->hci->acl_fragmentation_total_size = 0;
             btstack->hci->acl_fragmentation_pos = 0;
+            if (buffer->num_in_transport == 0){
+                btstack->hci->acl_fragmentation_buffer = NULL;
+                hci_packet_buffer_free(btstack, buffer);
+            }
         }
     }
     return false;
 }
 
+static bool hci_run_command_queue(btstack_state_t *btstack){
+    if (btstack->hci->state != HCI_STATE_WORKING) return false;
+    hci_command_request_t * request = (hci_command_request_t *) btstack_linked_list_pop(&btstack->hci->command_queue);
+    if (request == NULL) return false;
+    hci_reserve_packet_buffer(btstack);
+    btstack->hci->last_cmd_opcode = little_endian_read_16(request->packet, 0);
+    (void)memcpy(btstack->hci->hci_packet_buffer, request->packet, request->size);
+    btstack->hci->command_request_sending = request;
+    hci_send_reserved_cmd_packet(btstack, request->size);
+    // not sent, e.g. create connection for open connection
+    if (btstack->hci->command_request_sending != NULL){
+        btstack->hci->command_request_sending = NULL;
+        hci_command_request_fail(btstack, request, ERROR_CODE_COMMAND_DISALLOWED);
+    }
+    return true;
+}
+
+static bool hci_run_packet_buffer_queue(btstack_state_t *btstack){
+    int err;
+    return hci_send_next_queued_packet(btstack, &err);
+}
+
+// send as many fragments as HCI Transport and controller buffers allow
+static bool hci_run_acl_iov_packets(btstack_state_t *btstack){
+    int err;
+    bool sent = false;
+    while (hci_acl_iov_packet_send_fragment(btstack, &err)){
+        sent = true;
+    }
+    return sent;
+}
+
 #ifdef ENABLE_CLASSIC
 static bool hci_run_general_gap_classic(btstack_state_t *btstack){
 
@@ -3646,8 +4203,9 @@ static bool hci_run_general_gap_le(btstack_state_t *btstack){
 #endif
 
 static bool hci_run_general_pending_commmands(btstack_state_t *btstack){
-    btstack_linked_item_t * it;
-    for (it = (btstack_linked_item_t *) btstack->hci->connections; it != NULL; it = it->next){
+    uint8_t * packet;
+    btstack_dlist_item_t * it;
+    for (it = btstack->hci->connections.first; it != NULL; it = it->next){
         hci_connection_t * connection = (hci_connection_t *) it;
 
         switch(connection->state){
@@ -3709,7 +4267,8 @@ static bool hci_run_general_pending_commmands(btstack_state_t *btstack){
 #endif
             case SEND_DISCONNECT:
                 connection->state = SENT_DISCONNECT;
-                hci_send_cmd(btstack, &hci_disconnect, connection->con_handle, 0x13); // remote closed connection
+                packet = hci_reserve_cmd_packet_buffer(btstack);
+                hci_send_cmd_packet_buffer(btstack, hci_cmd_encode_disconnect(packet, connection->con_handle, 0x13)); // remote closed connection
                 return true;
 
             default:
@@ -3721,7 +4280,8 @@ static bool hci_run_general_pending_commmands(btstack_state_t *btstack){
 
         if (connection->authentication_flags & READ_RSSI){
             connectionClearAuthenticationFlags(connection, READ_RSSI);
-            hci_send_cmd(btstack, &hci_read_rssi, connection->con_handle);
+            packet = hci_reserve_cmd_packet_buffer(btstack);
+            hci_send_cmd_packet_buffer(btstack, hci_cmd_encode_read_rssi(packet, connection->con_handle));
             return true;
         }
 
@@ -3796,7 +4356,8 @@ static bool hci_run_general_pending_commmands(btstack_state_t *btstack){
         if (connection->bonding_flags & BONDING_DISCONNECT_DEDICATED_DONE){
             connection->bonding_flags &= ~BONDING_DISCONNECT_DEDICATED_DONE;
             connection->bonding_flags |= BONDING_EMIT_COMPLETE_ON_DISCONNECT;
-            hci_send_cmd(btstack, &hci_disconnect, connection->con_handle, 0x13);  // authentication done
+            packet = hci_reserve_cmd_packet_buffer(btstack);
+            hci_send_cmd_packet_buffer(btstack, hci_cmd_encode_disconnect(packet, connection->con_handle, 0x13));  // authentication done
             return true;
         }
 
@@ -3808,7 +4369,8 @@ static bool hci_run_general_pending_commmands(btstack_state_t *btstack){
 
         if (connection->bonding_flags & BONDING_SEND_ENCRYPTION_REQUEST){
             connection->bonding_flags &= ~BONDING_SEND_ENCRYPTION_REQUEST;
-            hci_send_cmd(btstack, &hci_set_connection_encryption, connection->con_handle, 1);
+            packet = hci_reserve_cmd_packet_buffer(btstack);
+            hci_send_cmd_packet_buffer(btstack, hci_cmd_encode_set_connection_encryption(packet, connection->con_handle, 1));
             return true;
         }
         if (connection->bonding_flags & BONDING_SEND_READ_ENCRYPTION_KEY_SIZE){
@@ -3820,7 +4382,8 @@ static bool hci_run_general_pending_commmands(btstack_state_t *btstack){
 
         if (connection->bonding_flags & BONDING_DISCONNECT_SECURITY_BLOCK){
             connection->bonding_flags &= ~BONDING_DISCONNECT_SECURITY_BLOCK;
-            hci_send_cmd(btstack, &hci_disconnect, connection->con_handle, 0x0005);  // authentication failure
+            packet = hci_reserve_cmd_packet_buffer(btstack);
+            hci_send_cmd_packet_buffer(btstack, hci_cmd_encode_disconnect(packet, connection->con_handle, 0x0005));  // authentication failure
             return true;
         }
 
@@ -3846,15 +4409,17 @@ static bool hci_run_general_pending_commmands(btstack_state_t *btstack){
             // response to L2CAP CON PARAMETER UPDATE REQUEST
             case CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
-                hci_send_cmd(btstack, &hci_le_connection_update, connection->con_handle, connection->le_conn_interval_min,
+                packet = hci_reserve_cmd_packet_buffer(btstack);
+                hci_send_cmd_packet_buffer(btstack, hci_cmd_encode_le_connection_update(packet, connection->con_handle, connection->le_conn_interval_min,
                              connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout,
-                             0x0000, 0xffff);
+                             0x0000, 0xffff));
                 return true;
             case CON_PARAMETER_UPDATE_REPLY:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
-                hci_send_cmd(btstack, &hci_le_remote_connection_parameter_request_reply, connection->con_handle, connection->le_conn_interval_min,
+                packet = hci_reserve_cmd_packet_buffer(btstack);
+                hci_send_cmd_packet_buffer(btstack, hci_cmd_encode_le_remote_connection_parameter_request_reply(packet, connection->con_handle, connection->le_conn_interval_min,
                              connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout,
-                             0x0000, 0xffff);
+                             0x0000, 0xffff));
                 return true;
             case CON_PARAMETER_UPDATE_NEGATIVE_REPLY:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
@@ -3882,6 +4447,14 @@ static void hci_run(btstack_state_t *btstack){
     done = hci_run_acl_fragments(btstack);
     if (done) return;
 
+    // then packets prepared while the HCI Transport was busy
+    done = hci_run_packet_buffer_queue(btstack);
+    if (done) return;
+
+    // and packets gathered from caller memory
+    done = hci_run_acl_iov_packets(btstack);
+    if (done) return;
+
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
     // send host num completed packets next as they don't require num_cmd_packets > 0
     if (!hci_can_send_comand_packet_transport()) return;
@@ -3893,6 +4466,10 @@ static void hci_run(btstack_state_t *btstack){
 
     if (!hci_can_send_command_packet_now(btstack)) return;
 
+    // commands queued with hci_queue_cmd
+    done = hci_run_command_queue(btstack);
+    if (done) return;
+
     // global/non-connection oriented commands
 
 
@@ -3941,7 +4518,7 @@ static void hci_run(btstack_state_t *btstack){
 #endif
 #endif
                     // close all open connections
-                    connection =  (hci_connection_t *) btstack->hci->connections;
+                    connection =  (hci_connection_t *) btstack_dlist_get_first_item(&btstack->hci->connections);
                     if (connection){
                         hci_con_handle_t con_handle = (uint16_t) connection->con_handle;
                         if (!hci_can_send_command_packet_now(btstack)) return;
@@ -4001,7 +4578,7 @@ static void hci_run(btstack_state_t *btstack){
                 case HCI_FALLING_ASLEEP_DISCONNECT:
                     log_info("HCI_STATE_FALLING_ASLEEP");
                     // close all open connections
-                    connection =  (hci_connection_t *) btstack->hci->connections;
+                    connection =  (hci_connection_t *) btstack_dlist_get_first_item(&btstack->hci->connections);
 
 #ifdef HAVE_PLATFORM_IPHONE_OS
                     // don't close connections, if H4 supports power management
@@ -4195,8 +4772,171 @@ int hci_send_cmd_packet(btstack_state_t *btstack, uint8_t *packet, int size){
 
     btstack->hci->num_cmd_packets--;
 
+    hci_command_in_flight_add(btstack, little_endian_read_16(packet, 0));
+
     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, packet, size);
-    return btstack->hci->hci_transport->send_packet(btstack, HCI_COMMAND_DATA_PACKET, packet, size);
+    return hci_transport_send_packet(btstack, HCI_COMMAND_DATA_PACKET, packet, size);
+}
+
+#ifdef ENABLE_HCI_COMMAND_STATISTICS
+static void hci_command_statistics_update(btstack_state_t *btstack, uint16_t opcode, uint32_t send_time_ms){
+    uint32_t latency_ms = btstack_run_loop_get_time_ms(btstack) - send_time_ms;
+
+    // find or add opcode
+    hci_command_statistics_t * statistics = NULL;
+    int i;
+    for (i = 0; i < HCI_COMMAND_STATISTICS_NUM; i++){
+        uint16_t entry_opcode = btstack->hci->command_statistics[i].opcode;
+        if ((entry_opcode != opcode) && (entry_opcode != 0)) continue;
+        statistics = &btstack->hci->command_statistics[i];
+        break;
+    }
+    if (statistics == NULL) return;
+    statistics->opcode = opcode;
+    statistics->num_completed++;
+    statistics->latency_total_ms += latency_ms;
+    statistics->latency_max_ms = btstack_max(statistics->latency_max_ms, latency_ms);
+}
+
+const hci_command_statistics_t * hci_get_command_statistics(btstack_state_t *btstack, uint16_t opcode){
+    int i;
+    for (i = 0; i < HCI_COMMAND_STATISTICS_NUM; i++){
+        if (btstack->hci->command_statistics[i].opcode == opcode) return &btstack->hci->command_statistics[i];
+    }
+    return NULL;
+}
+#endif
+
+// report failure to requester with Command Status event
+static void hci_command_request_fail(btstack_state_t *btstack, hci_command_request_t * request, uint8_t status){
+    if (request->callback == NULL) return;
+    uint8_t event[6];
+    event[0] = HCI_EVENT_COMMAND_STATUS;
+    event[1] = sizeof(event) - 2;
+    event[2] = status;
+    event[3] = 0;   // no command credits
+    little_endian_store_16(event, 4, little_endian_read_16(request->packet, 0));
+    (*request->callback)(btstack, HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+// oldest command in flight with given opcode, or oldest one if opcode is 0
+static hci_command_in_flight_t * hci_command_in_flight_oldest(btstack_state_t *btstack, uint16_t opcode){
+    hci_command_in_flight_t * oldest = NULL;
+    int i;
+    for (i = 0; i < HCI_NUM_CMD_PACKETS_MAX; i++){
+        hci_command_in_flight_t * command = &btstack->hci->commands_in_flight[i];
+        if (command->opcode == 0) continue;
+        if ((opcode != 0) && (command->opcode != opcode)) continue;
+        if ((oldest != NULL) && ((int16_t)(command->sequence - oldest->sequence) > 0)) continue;
+        oldest = command;
+    }
+    return oldest;
+}
+
+// unused slot, NULL if HCI_NUM_CMD_PACKETS_MAX commands are in flight
+static hci_command_in_flight_t * hci_command_in_flight_free(btstack_state_t *btstack){
+    int i;
+    for (i = 0; i < HCI_NUM_CMD_PACKETS_MAX; i++){
+        if (btstack->hci->commands_in_flight[i].opcode == 0) return &btstack->hci->commands_in_flight[i];
+    }
+    return NULL;
+}
+
+// command passed to HCI Transport, remember requester
+static void hci_command_in_flight_add(btstack_state_t *btstack, uint16_t opcode){
+    hci_command_request_t * request = btstack->hci->command_request_sending;
+    btstack->hci->command_request_sending = NULL;
+    hci_command_in_flight_t * command = hci_command_in_flight_free(btstack);
+    if (command == NULL){
+        // sent without hci_can_send_command_packet_now, Command Complete/Status cannot be matched
+        log_error("no slot for command 0x%04x in flight", opcode);
+        if (request != NULL){
+            hci_command_request_fail(btstack, request, ERROR_CODE_UNSPECIFIED_ERROR);
+        }
+        return;
+    }
+    command->opcode   = opcode;
+    command->sequence = btstack->hci->command_sequence++;
+    command->request  = request;
+#ifdef ENABLE_HCI_COMMAND_STATISTICS
+    command->send_time_ms = btstack_run_loop_get_time_ms(btstack);
+#endif
+}
+
+// controller won't send Command Complete/Status for oldest command, e.g. vendor command answered by vendor event
+static void hci_command_in_flight_abandon_oldest(btstack_state_t *btstack){
+    hci_command_in_flight_t * command = hci_command_in_flight_oldest(btstack, 0);
+    if (command == NULL) return;
+    log_info("no Command Complete/Status expected for opcode 0x%04x", command->opcode);
+    hci_command_request_t * request = command->request;
+    command->opcode = 0;
+    command->request = NULL;
+    if (request != NULL){
+        hci_command_request_fail(btstack, request, ERROR_CODE_UNSPECIFIED_ERROR);
+    }
+}
+
+// Command Complete or Command Status received, @returns requester or NULL for commands sent by the stack itself
+static hci_command_request_t * hci_command_in_flight_complete(btstack_state_t *btstack, uint16_t opcode){
+    // Command Complete for NOP only provides command credits
+    if (opcode == 0) return NULL;
+
+    hci_command_in_flight_t * command = hci_command_in_flight_oldest(btstack, opcode);
+    if (command == NULL) return NULL;
+    hci_command_request_t * request = command->request;
+    command->opcode = 0;
+    command->request = NULL;
+
+#ifdef ENABLE_HCI_COMMAND_STATISTICS
+    hci_command_statistics_update(btstack, opcode, command->send_time_ms);
+#endif
+    return request;
+}
+
+// fail commands in flight, and queued commands if requested
+static void hci_command_requests_fail(btstack_state_t *btstack, bool include_queued, uint8_t status){
+    btstack_linked_list_t failed = NULL;
+    int i;
+    for (i = 0; i < HCI_NUM_CMD_PACKETS_MAX; i++){
+        hci_command_in_flight_t * command = &btstack->hci->commands_in_flight[i];
+        if (command->request != NULL){
+            btstack_linked_list_add_tail(&failed, (btstack_linked_item_t *) command->request);
+        }
+        command->opcode = 0;
+        command->request = NULL;
+    }
+    if (include_queued){
+        while (btstack->hci->command_queue != NULL){
+            btstack_linked_list_add_tail(&failed, btstack_linked_list_pop(&btstack->hci->command_queue));
+        }
+    }
+    // requesters might queue new commands from their callbacks
+    while (failed != NULL){
+        hci_command_request_t * request = (hci_command_request_t *) btstack_linked_list_pop(&failed);
+        hci_command_request_fail(btstack, request, status);
+    }
+}
+
+uint8_t hci_queue_cmd(btstack_state_t *btstack, hci_command_request_t * request, btstack_packet_handler_t callback, const hci_cmd_t * cmd, ...){
+    // request->packet might be smaller than the largest HCI Command, e.g. in LE-only builds
+    uint8_t packet[HCI_CMD_HEADER_SIZE + HCI_CMD_PAYLOAD_SIZE];
+    va_list argptr;
+    va_start(argptr, cmd);
+    uint16_t size = hci_cmd_create_from_template(packet, cmd, argptr);
+    va_end(argptr);
+    if (size > sizeof(request->packet)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    (void)memcpy(request->packet, packet, size);
+    request->size = size;
+    return hci_queue_cmd_packet(btstack, request, callback);
+}
+
+uint8_t hci_queue_cmd_packet(btstack_state_t *btstack, hci_command_request_t * request, btstack_packet_handler_t callback){
+    if ((request->size < HCI_CMD_HEADER_SIZE) || (request->size > sizeof(request->packet))) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (request->size != (HCI_CMD_HEADER_SIZE + request->packet[2])) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    request->callback = callback;
+    btstack_linked_list_add_tail(&btstack->hci->command_queue, (btstack_linked_item_t *) request);
+    hci_run(btstack);
+    return ERROR_CODE_SUCCESS;
 }
 
 // disconnect because of security block
@@ -4239,6 +4979,25 @@ void gap_secure_connections_enable(btstack_state_t *btstack, bool enable){
 
 #endif
 
+// pre: command has been created in reserved packet buffer
+static int hci_send_reserved_cmd_packet(btstack_state_t *btstack, uint16_t size){
+    int err = hci_send_cmd_packet(btstack, btstack->hci->hci_packet_buffer, size);
+
+    // release packet buffer on error or for synchronous transport implementations
+    if ((err < 0) || hci_transport_synchronous(btstack)){
+        hci_release_packet_buffer(btstack);
+        hci_emit_transport_packet_sent(btstack);
+    }
+
+    return err;
+}
+
+// pre: command has been created in reserved packet buffer, e.g. with hci_cmd_encode_*
+int hci_send_cmd_packet_buffer(btstack_state_t *btstack, int size){
+    btstack->hci->last_cmd_opcode = little_endian_read_16(btstack->hci->hci_packet_buffer, 0);
+    return hci_send_reserved_cmd_packet(btstack, size);
+}
+
 // va_list part of hci_send_cmd
 int hci_send_cmd_va_arg(btstack_state_t *btstack, const hci_cmd_t *cmd, va_list argptr){
     if (!hci_can_send_command_packet_now(btstack)){
@@ -4251,15 +5010,7 @@ int hci_send_cmd_va_arg(btstack_state_t *btstack, const hci_cmd_t *cmd, va_list
     uint8_t * packet = btstack->hci->hci_packet_buffer;
     uint16_t size = hci_cmd_create_from_template(packet, cmd, argptr);
     einstein_log(32, __func__, __LINE__, "%04x %d", cmd->opcode, size);
-    int err = hci_send_cmd_packet(btstack, packet, size);
-
-    // release packet buffer on error or for synchronous transport implementations
-    if ((err < 0) || hci_transport_synchronous(btstack)){
-        hci_release_packet_buffer(btstack);
-        hci_emit_transport_packet_sent(btstack);
-    }
-
-    return err;
+    return hci_send_reserved_cmd_packet(btstack, size);
 }
 
 /**
@@ -4276,17 +5027,31 @@ int hci_send_cmd(btstack_state_t *btstack, const hci_cmd_t *cmd, ...){
 // Create various non-HCI events.
 // TODO: generalize, use table similar to hci_create_command
 
+static bool hci_event_mask_matches(const btstack_event_mask_t * event_mask, uint8_t event_code, const uint8_t * event, uint16_t size){
+    if ((event_code == HCI_EVENT_LE_META) && (size >= 3)){
+        uint8_t subevent_code = event[2];
+        return (event_mask->le_meta_subevents[subevent_code >> 3] & (1 << (subevent_code & 7))) != 0;
+    }
+    return (event_mask->events[event_code >> 3] & (1 << (event_code & 7))) != 0;
+}
+
 static void hci_emit_event(btstack_state_t *btstack, uint8_t * event, uint16_t size, int dump){
     // dump packet
     if (dump) {
         hci_dump_packet( HCI_EVENT_PACKET, 0, event, size);
     }
 
-    // dispatch to all event handlers
+    // dispatch to all event handlers subscribed to this event
+    uint8_t event_code = hci_event_packet_get_type(event);
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &btstack->hci->event_handlers);
     while (btstack_linked_list_iterator_has_next(&it)){
         btstack_packet_callback_registration_t * entry = (btstack_packet_callback_registration_t*) btstack_linked_list_iterator_next(&it);
+        if (entry->event_mask && !hci_event_mask_matches(entry->event_mask, event_code, event, size)){
+            btstack->hci->event_handler_skipped++;
+            continue;
+        }
+        btstack->hci->event_handler_dispatched++;
         entry->callback(btstack, HCI_EVENT_PACKET, 0, event, size);
     }
 }
@@ -4410,6 +5175,10 @@ void hci_emit_state(btstack_state_t *btstack){
     hci_emit_event(btstack, event, sizeof(event), 1);
 }
 
+void hci_emit_btstack_event(btstack_state_t *btstack, uint8_t * event, uint16_t size, int dump){
+    hci_emit_event(btstack, event, size, dump);
+}
+
 #ifdef ENABLE_CLASSIC
 static void hci_emit_connection_complete(btstack_state_t *btstack, bd_addr_t address, hci_con_handle_t con_handle, uint8_t status){
     uint8_t event[13];
@@ -4782,8 +5551,8 @@ uint8_t gap_connect(btstack_state_t *btstack, bd_addr_t addr, bd_addr_type_t add
 
 // @assumption: only a single outgoing LE Connection exists
 static hci_connection_t * gap_get_outgoing_connection(btstack_state_t *btstack){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) btstack->hci->connections; it != NULL; it = it->next){
+    btstack_dlist_item_t *it;
+    for (it = btstack->hci->connections.first; it != NULL; it = it->next){
         hci_connection_t * conn = (hci_connection_t *) it;
         if (!hci_is_le_connection(conn)) continue;
         switch (conn->state){
@@ -4805,8 +5574,7 @@ uint8_t gap_connect_cancel(btstack_state_t *btstack){
         case SEND_CREATE_CONNECTION:
             // skip sending create connection and emit event instead
             hci_emit_le_connection_complete(btstack, conn->address_type, conn->address, 0, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
-            btstack_linked_list_remove(&btstack->hci->connections, (btstack_linked_item_t *) conn);
-            btstack_memory_hci_connection_free( conn );
+            hci_connection_free(btstack, conn);
             break;
         case SENT_CREATE_CONNECTION:
             // request to send cancel connection
@@ -5355,10 +6123,10 @@ void hci_set_hardware_error_callback(btstack_state_t *btstack, void (*fn)(uint8_
 }
 
 void hci_disconnect_all(btstack_state_t *btstack){
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &btstack->hci->connections);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * con = (hci_connection_t*) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &btstack->hci->connections);
+    while (btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * con = (hci_connection_t*) btstack_dlist_iterator_next(&it);
         if (con->state == SENT_DISCONNECT) continue;
         con->state = SEND_DISCONNECT;
     }
@@ -5537,11 +6305,11 @@ void hci_setup_test_connections_fuzz(void){
 }
 
 void hci_free_connections_fuzz(void){
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, btstack->hci->connections);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * con = (hci_connection_t*) btstack_linked_list_iterator_next(&it);
-        btstack_linked_list_iterator_remove(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &btstack->hci->connections);
+    while (btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * con = (hci_connection_t*) btstack_dlist_iterator_next(&it);
+        btstack_dlist_iterator_remove(&it);
         btstack_memory_hci_connection_free(con);
     }
 }
@@ -50,6 +50,7 @@
 
 #include "btstack_chipset.h"
 #include "btstack_control.h"
+#include "btstack_dlist.h"
 #include "btstack_linked_list.h"
 #include "btstack_util.h"
 #include "classic/btstack_link_key_db.h"
@@ -471,8 +472,8 @@ typedef struct {
 
 //
 typedef struct {
-    // linked list - assert: first field
-    btstack_linked_item_t    item;
+    // doubly linked list - assert: first field
+    btstack_dlist_item_t     item;
 
     // remote side
     bd_addr_t address;
@@ -721,6 +722,145 @@ typedef struct {
     uint8_t        state;
 } whitelist_entry_t;
 
+// number of slots in the connection lookup tables, must be a power of two
+#ifndef HCI_CONNECTION_INDEX_SIZE
+#define HCI_CONNECTION_INDEX_SIZE 16
+#endif
+
+// number of outgoing packet buffers, more than one allows to prepare packets while the HCI Transport is busy
+#ifndef HCI_OUTGOING_PACKET_BUFFER_NUM
+#define HCI_OUTGOING_PACKET_BUFFER_NUM 1
+#endif
+
+// max number of packets an asynchronous HCI Transport accepts before HCI_EVENT_TRANSPORT_PACKET_SENT, allows to coalesce writes
+#ifndef HCI_TRANSPORT_TX_QUEUE_SIZE
+#define HCI_TRANSPORT_TX_QUEUE_SIZE 1
+#endif
+
+// max number of HCI commands in flight, Num_HCI_Command_Packets reported by the controller is limited to this
+#ifndef HCI_NUM_CMD_PACKETS_MAX
+#define HCI_NUM_CMD_PACKETS_MAX 1
+#endif
+
+// number of opcodes with latency statistics, see ENABLE_HCI_COMMAND_STATISTICS
+#ifndef HCI_COMMAND_STATISTICS_NUM
+#define HCI_COMMAND_STATISTICS_NUM 16
+#endif
+
+/**
+ * HCI command queued with hci_queue_cmd
+ */
+typedef struct {
+    // linked list - assert: first field
+    btstack_linked_item_t item;
+
+    // receives Command Complete or Command Status event for this command
+    btstack_packet_handler_t callback;
+
+    uint16_t size;
+    uint8_t  packet[HCI_CMD_BUFFER_SIZE];
+} hci_command_request_t;
+
+// HCI command sent to the controller and waiting for Command Complete/Status
+typedef struct {
+    // 0 if unused
+    uint16_t opcode;
+    // send order, oldest command with matching opcode is completed first
+    uint16_t sequence;
+    // NULL for commands sent by the stack itself
+    hci_command_request_t * request;
+#ifdef ENABLE_HCI_COMMAND_STATISTICS
+    uint32_t send_time_ms;
+#endif
+} hci_command_in_flight_t;
+
+#ifdef ENABLE_HCI_COMMAND_STATISTICS
+typedef struct {
+    uint16_t opcode;
+    uint16_t num_completed;
+    uint32_t latency_total_ms;
+    uint32_t latency_max_ms;
+} hci_command_statistics_t;
+
+#endif
+
+// max size of headers sent in front of the payload of an hci_acl_iov_packet_t, e.g. L2CAP header + SDU length
+#ifndef HCI_ACL_IOV_HEADER_MAX_SIZE
+#define HCI_ACL_IOV_HEADER_MAX_SIZE 6
+#endif
+
+/**
+ * Part of an ACL payload in caller memory
+ */
+typedef struct {
+    const uint8_t * data;
+    uint16_t len;
+} hci_iov_t;
+
+struct hci_acl_iov_packet;
+
+/**
+ * @brief Called when all fragments of an hci_acl_iov_packet_t have been accepted by the HCI Transport or if the packet was dropped
+ * @param packet
+ * @param status ERROR_CODE_SUCCESS or ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER if connection was closed
+ */
+typedef void (*hci_acl_iov_packet_callback_t)(btstack_state_t *btstack, struct hci_acl_iov_packet * packet, uint8_t status);
+
+/**
+ * ACL packet gathered from header and payload in caller memory, see hci_send_acl_iov_packet
+ */
+typedef struct hci_acl_iov_packet {
+    // linked list - assert: first field
+    btstack_linked_item_t item;
+
+    hci_con_handle_t con_handle;
+    // packet boundary flag of first fragment, 0x00 = non-flushable, 0x02 = flushable
+    uint8_t  packet_boundary_flag;
+
+    // header, e.g. L2CAP header, followed by payload_len bytes starting at payload_offset of the iov
+    uint8_t  header[HCI_ACL_IOV_HEADER_MAX_SIZE];
+    uint8_t  header_len;
+    const hci_iov_t * iov;
+    uint8_t  iov_count;
+    uint16_t payload_offset;
+    uint16_t payload_len;
+
+    hci_acl_iov_packet_callback_t callback;
+    void * context;
+
+    // internal: bytes handed to HCI Transport, fragments in asynchronous HCI Transport, status
+    uint16_t pos;
+    uint8_t  num_in_transport;
+    uint8_t  status;
+} hci_acl_iov_packet_t;
+
+typedef enum {
+    HCI_PACKET_BUFFER_FREE = 0,
+    HCI_PACKET_BUFFER_RESERVED,         // owned by caller of hci_reserve_packet_buffer
+    HCI_PACKET_BUFFER_QUEUED,           // ACL/SCO packet waiting for HCI Transport or controller buffers
+    HCI_PACKET_BUFFER_IN_TRANSPORT,     // owned by asynchronous HCI Transport until HCI_EVENT_TRANSPORT_PACKET_SENT
+} hci_packet_buffer_state_t;
+
+typedef struct {
+    // linked list - assert: first field
+    btstack_linked_item_t item;
+
+    // packet without pre-buffer
+    uint8_t * packet;
+
+    hci_packet_buffer_state_t state;
+
+    // number of packets from this buffer in asynchronous HCI Transport, > 1 for ACL fragments
+    uint8_t  num_in_transport;
+
+    // queued packet
+    uint8_t  packet_type;
+    uint16_t size;
+
+    // fragment of ACL packet gathered from caller memory
+    hci_acl_iov_packet_t * iov_packet;
+} hci_packet_buffer_t;
+
 /**
  * main data structure
  */
@@ -739,7 +879,11 @@ typedef struct hci_stack {
     const btstack_link_key_db_t * link_key_db;
 
     // list of existing baseband connections
-    btstack_linked_list_t     connections;
+    btstack_dlist_t           connections;
+
+    // direct-mapped lookup tables for connections by handle and by address/type
+    hci_connection_t * connection_for_handle_index[HCI_CONNECTION_INDEX_SIZE];
+    hci_connection_t * connection_for_address_index[HCI_CONNECTION_INDEX_SIZE];
 
     /* callback to L2CAP layer */
     btstack_packet_handler_t acl_packet_handler;
@@ -778,13 +922,24 @@ typedef struct hci_stack {
     gap_security_level_t gap_security_level;
 #endif
 
-    // single buffer for HCI packet assembly + additional prebuffer for H4 drivers
-    uint8_t   * hci_packet_buffer;
+    // pool of buffers for HCI packet assembly + additional prebuffer for H4 drivers
+    hci_packet_buffer_t packet_buffers[HCI_OUTGOING_PACKET_BUFFER_NUM];
     uint8_t   * hci_packet_buffer_data;
-    uint8_t   hci_packet_buffer_reserved;
+    // buffer returned by hci_get_outgoing_packet_buffer, free or reserved if any buffer is not in use
+    hci_packet_buffer_t * packet_buffer_current;
+    uint8_t   * hci_packet_buffer;
+    // prepared ACL/SCO packets in send order
+    btstack_linked_list_t packet_buffer_queue;
+    // buffers of packets passed to asynchronous HCI Transport in send order, NULL for packets not from pool
+    hci_packet_buffer_t * packets_in_transport[HCI_TRANSPORT_TX_QUEUE_SIZE];
+    uint8_t   packets_in_transport_head;
+    uint8_t   packets_in_transport_num;
+    // ACL packet currently sent in fragments
+    hci_packet_buffer_t * acl_fragmentation_buffer;
     uint16_t  acl_fragmentation_pos;
     uint16_t  acl_fragmentation_total_size;
-    uint8_t   acl_fragmentation_tx_active;
+    // ACL packets gathered from caller memory in send order, first one is currently sent in fragments
+    btstack_linked_list_t acl_iov_packets;
 
     /* host to controller flow control */
     uint8_t  num_cmd_packets;
@@ -795,6 +950,26 @@ typedef struct hci_stack {
     uint8_t  synchronous_flow_control_enabled;
     uint8_t  le_acl_packets_total_num;
     uint16_t le_data_packets_length;
+    // commands queued with hci_queue_cmd
+    btstack_linked_list_t command_queue;
+    // queued command currently passed to hci_send_cmd_packet
+    hci_command_request_t * command_request_sending;
+
+    // commands waiting for Command Complete/Status
+    hci_command_in_flight_t commands_in_flight[HCI_NUM_CMD_PACKETS_MAX];
+    uint16_t                command_sequence;
+
+#ifdef ENABLE_HCI_COMMAND_STATISTICS
+    hci_command_statistics_t command_statistics[HCI_COMMAND_STATISTICS_NUM];
+#endif
+
+    // event handler calls and calls skipped by event mask
+    uint32_t event_handler_dispatched;
+    uint32_t event_handler_skipped;
+
+    // ACL packets sent but not completed yet, sum of num_packets_sent for Classic and LE connections
+    uint16_t acl_packets_sent_classic;
+    uint16_t acl_packets_sent_le;
     uint8_t  sco_waiting_for_can_send_now;
     uint8_t  sco_can_send_now;
 
@@ -1017,6 +1192,63 @@ void hci_close(btstack_state_t *btstack);
  */
 void hci_add_event_handler(btstack_state_t *btstack, btstack_packet_callback_registration_t * callback_handler);
 
+/**
+ * @brief Queue HCI command. It is sent when the stack is working and the controller accepts commands,
+ *        up to HCI_NUM_CMD_PACKETS_MAX commands are in flight, even if the controller grants more.
+ *        On power off or HCI Reset, commands that cannot complete anymore receive a Command Status event
+ *        with ERROR_CODE_COMMAND_DISALLOWED.
+ * @param request storage for the command, has to stay valid until callback
+ * @param callback receives Command Complete or Command Status event, can be NULL
+ * @param cmd
+ * @return status, ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS if command does not fit into request
+ */
+uint8_t hci_queue_cmd(btstack_state_t *btstack, hci_command_request_t * request, btstack_packet_handler_t callback, const hci_cmd_t * cmd, ...);
+
+/**
+ * @brief Queue HCI command already created in request->packet and request->size, e.g. with hci_cmd_encode_* from hci_cmd_encoder.h
+ * @param request
+ * @param callback
+ * @return status, ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS if size does not match command header
+ */
+uint8_t hci_queue_cmd_packet(btstack_state_t *btstack, hci_command_request_t * request, btstack_packet_handler_t callback);
+
+#ifdef ENABLE_HCI_COMMAND_STATISTICS
+/**
+ * @brief Get latency statistics for HCI command, measured from sending to Command Complete/Status
+ * @param opcode
+ * @return statistics or NULL if no command with this opcode has completed yet
+ */
+const hci_command_statistics_t * hci_get_command_statistics(btstack_state_t *btstack, uint16_t opcode);
+#endif
+
+/**
+ * @brief Add event packet handler that only receives events set in event mask
+ * @param callback_handler
+ * @param event_mask has to stay valid while handler is registered
+ */
+void hci_add_event_handler_with_mask(btstack_state_t *btstack, btstack_packet_callback_registration_t * callback_handler, const btstack_event_mask_t * event_mask);
+
+/**
+ * @brief Subscribe to event in event mask
+ * @param event_mask
+ * @param event_code, for HCI_EVENT_LE_META, all LE Meta subevents are subscribed
+ */
+void hci_event_mask_add_event(btstack_event_mask_t * event_mask, uint8_t event_code);
+
+/**
+ * @brief Subscribe to subevent of HCI_EVENT_LE_META in event mask
+ * @param event_mask
+ * @param subevent_code
+ */
+void hci_event_mask_add_le_meta_subevent(btstack_event_mask_t * event_mask, uint8_t subevent_code);
+
+/**
+ * @brief Get number of event handler calls and of calls skipped due to event mask since hci_init
+ * @param num_dispatched
+ * @param num_skipped
+ */
+void hci_get_event_dispatch_statistics(btstack_state_t *btstack, uint32_t * num_dispatched, uint32_t * num_skipped);
+
 /**
  * @brief Registers a packet handler for ACL data. Used by L2CAP
  */
@@ -1040,6 +1272,13 @@ int hci_can_send_command_packet_now(btstack_state_t *btstack);
  */
 int hci_send_cmd(btstack_state_t *btstack, const hci_cmd_t *cmd, ...);
 
+/**
+ * @brief Sends HCI command created in reserved outgoing packet buffer, e.g. with hci_cmd_encode_* from hci_cmd_encoder.h
+ * @note  Call hci_can_send_command_packet_now and hci_reserve_packet_buffer first
+ * @param size of command packet
+ */
+int hci_send_cmd_packet_buffer(btstack_state_t *btstack, int size);
+
 
 // Sending SCO Packets
 
@@ -1109,7 +1348,7 @@ int hci_send_cmd_va_arg(btstack_state_t *btstack, const hci_cmd_t *cmd, va_list
 /**
  * Get connection iterator. Only used by l2cap.c and sm.c
  */
-void hci_connections_get_iterator(btstack_state_t *btstack, btstack_linked_list_iterator_t *it);
+void hci_connections_get_iterator(btstack_state_t *btstack, btstack_dlist_iterator_t *it);
 
 /**
  * Get internal hci_connection_t for given handle. Used by L2CAP, SM, daemon
@@ -1151,6 +1390,15 @@ int hci_can_send_prepared_acl_packet_now(btstack_state_t *btstack, hci_con_handl
  */
 int hci_send_acl_packet_buffer(btstack_state_t *btstack, int size);
 
+/**
+ * Send acl packet gathered from header and payload in caller memory. Each ACL fragment is assembled
+ * directly in a free outgoing packet buffer and sent as soon as the HCI Transport and the Controller
+ * can accept it. Packet and payload need to stay valid until the packet callback.
+ * @param packet with con_handle, packet_boundary_flag, header, iov, payload_offset, payload_len and callback set
+ * @return ERROR_CODE_SUCCESS, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER or ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS
+ */
+uint8_t hci_send_acl_iov_packet(btstack_state_t *btstack, hci_acl_iov_packet_t * packet);
+
 /**
  * Check if authentication is active. It delays automatic disconnect while no L2CAP connection
  * Called by l2cap.
@@ -1197,6 +1445,11 @@ int hci_remote_esco_supported(btstack_state_t *btstack, hci_con_handle_t con_han
  */
 void hci_emit_state(btstack_state_t *btstack);
 
+/**
+ * Emit BTstack event to all registered event handlers. Called by btstack_instrumentation
+ */
+void hci_emit_btstack_event(btstack_state_t *btstack, uint8_t * event, uint16_t size, int dump);
+
 /**
  * Send complete CMD packet. Called by daemon and hci_send_cmd_va_arg
  * @returns 0 if command was successfully sent to HCI Transport layer
@@ -0,0 +1,2893 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  hci_cmd_encoder.h
+ *
+ *  @brief HCI Command encoders with fixed layout, alternative to hci_cmd_create_from_template
+ *  @note  Don't edit - generated by tool/btstack_hci_cmd_generator.py from src/hci_cmd.c
+ *
+ */
+
+#ifndef HCI_CMD_ENCODER_H
+#define HCI_CMD_ENCODER_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include "bluetooth.h"
+#include "btstack_util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* API_START */
+
+/**
+ * @brief Create HCI_INQUIRY command packet
+ * @param buffer for command packet, at least 8 bytes
+ * @param lap
+ * @param inquiry_length
+ * @param num_responses
+ * @return size of command packet
+ * @note: opcode 0x0401, format string "311"
+ */
+static inline uint16_t hci_cmd_encode_inquiry(uint8_t * buffer, uint32_t lap, uint8_t inquiry_length, uint8_t num_responses){
+    buffer[0] = 0x01;
+    buffer[1] = 0x04;
+    buffer[2] = 5;
+    buffer[3] = (uint8_t) lap;
+    buffer[4] = (uint8_t) (lap >> 8);
+    buffer[5] = (uint8_t) (lap >> 16);
+    buffer[6] = (uint8_t) inquiry_length;
+    buffer[7] = (uint8_t) num_responses;
+    return 8;
+}
+
+/**
+ * @brief Create HCI_INQUIRY_CANCEL command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0402, format string ""
+ */
+static inline uint16_t hci_cmd_encode_inquiry_cancel(uint8_t * buffer){
+    buffer[0] = 0x02;
+    buffer[1] = 0x04;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_CREATE_CONNECTION command packet
+ * @param buffer for command packet, at least 16 bytes
+ * @param bd_addr
+ * @param packet_type
+ * @param page_scan_repetition_mode
+ * @param reserved
+ * @param clock_offset
+ * @param allow_role_switch
+ * @return size of command packet
+ * @note: opcode 0x0405, format string "B21121"
+ */
+static inline uint16_t hci_cmd_encode_create_connection(uint8_t * buffer, const bd_addr_t bd_addr, uint16_t packet_type, uint8_t page_scan_repetition_mode, uint8_t reserved, uint16_t clock_offset, uint8_t allow_role_switch){
+    buffer[0] = 0x05;
+    buffer[1] = 0x04;
+    buffer[2] = 13;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) packet_type;
+    buffer[10] = (uint8_t) (packet_type >> 8);
+    buffer[11] = (uint8_t) page_scan_repetition_mode;
+    buffer[12] = (uint8_t) reserved;
+    buffer[13] = (uint8_t) clock_offset;
+    buffer[14] = (uint8_t) (clock_offset >> 8);
+    buffer[15] = (uint8_t) allow_role_switch;
+    return 16;
+}
+
+/**
+ * @brief Create HCI_DISCONNECT command packet
+ * @param buffer for command packet, at least 6 bytes
+ * @param handle
+ * @param reason
+ * @return size of command packet
+ * @note: opcode 0x0406, format string "H1"
+ */
+static inline uint16_t hci_cmd_encode_disconnect(uint8_t * buffer, hci_con_handle_t handle, uint8_t reason){
+    buffer[0] = 0x06;
+    buffer[1] = 0x04;
+    buffer[2] = 3;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) reason;
+    return 6;
+}
+
+/**
+ * @brief Create HCI_CREATE_CONNECTION_CANCEL command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x0408, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_create_connection_cancel(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x08;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_ACCEPT_CONNECTION_REQUEST command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param bd_addr
+ * @param role
+ * @return size of command packet
+ * @note: opcode 0x0409, format string "B1"
+ */
+static inline uint16_t hci_cmd_encode_accept_connection_request(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t role){
+    buffer[0] = 0x09;
+    buffer[1] = 0x04;
+    buffer[2] = 7;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) role;
+    return 10;
+}
+
+/**
+ * @brief Create HCI_REJECT_CONNECTION_REQUEST command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param bd_addr
+ * @param reason
+ * @return size of command packet
+ * @note: opcode 0x040a, format string "B1"
+ */
+static inline uint16_t hci_cmd_encode_reject_connection_request(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t reason){
+    buffer[0] = 0x0a;
+    buffer[1] = 0x04;
+    buffer[2] = 7;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) reason;
+    return 10;
+}
+
+/**
+ * @brief Create HCI_LINK_KEY_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 25 bytes
+ * @param bd_addr
+ * @param link_key
+ * @return size of command packet
+ * @note: opcode 0x040b, format string "BP"
+ */
+static inline uint16_t hci_cmd_encode_link_key_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, const uint8_t * link_key){
+    buffer[0] = 0x0b;
+    buffer[1] = 0x04;
+    buffer[2] = 22;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    (void)memcpy(&buffer[9], link_key, 16);
+    return 25;
+}
+
+/**
+ * @brief Create HCI_LINK_KEY_REQUEST_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x040c, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_link_key_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x0c;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_PIN_CODE_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 26 bytes
+ * @param bd_addr
+ * @param pin_length
+ * @param pin
+ * @return size of command packet
+ * @note: opcode 0x040d, format string "B1P"
+ */
+static inline uint16_t hci_cmd_encode_pin_code_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t pin_length, const uint8_t * pin){
+    buffer[0] = 0x0d;
+    buffer[1] = 0x04;
+    buffer[2] = 23;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) pin_length;
+    (void)memcpy(&buffer[10], pin, 16);
+    return 26;
+}
+
+/**
+ * @brief Create HCI_PIN_CODE_REQUEST_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x040e, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_pin_code_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x0e;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_CHANGE_CONNECTION_PACKET_TYPE command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param handle
+ * @param packet_type
+ * @return size of command packet
+ * @note: opcode 0x040f, format string "H2"
+ */
+static inline uint16_t hci_cmd_encode_change_connection_packet_type(uint8_t * buffer, hci_con_handle_t handle, uint16_t packet_type){
+    buffer[0] = 0x0f;
+    buffer[1] = 0x04;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) packet_type;
+    buffer[6] = (uint8_t) (packet_type >> 8);
+    return 7;
+}
+
+/**
+ * @brief Create HCI_AUTHENTICATION_REQUESTED command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x0411, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_authentication_requested(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x11;
+    buffer[1] = 0x04;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_SET_CONNECTION_ENCRYPTION command packet
+ * @param buffer for command packet, at least 6 bytes
+ * @param handle
+ * @param encryption_enable
+ * @return size of command packet
+ * @note: opcode 0x0413, format string "H1"
+ */
+static inline uint16_t hci_cmd_encode_set_connection_encryption(uint8_t * buffer, hci_con_handle_t handle, uint8_t encryption_enable){
+    buffer[0] = 0x13;
+    buffer[1] = 0x04;
+    buffer[2] = 3;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) encryption_enable;
+    return 6;
+}
+
+/**
+ * @brief Create HCI_CHANGE_CONNECTION_LINK_KEY command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x0415, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_change_connection_link_key(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x15;
+    buffer[1] = 0x04;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_REMOTE_NAME_REQUEST command packet
+ * @param buffer for command packet, at least 13 bytes
+ * @param bd_addr
+ * @param page_scan_repetition_mode
+ * @param reserved
+ * @param clock_offset
+ * @return size of command packet
+ * @note: opcode 0x0419, format string "B112"
+ */
+static inline uint16_t hci_cmd_encode_remote_name_request(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t page_scan_repetition_mode, uint8_t reserved, uint16_t clock_offset){
+    buffer[0] = 0x19;
+    buffer[1] = 0x04;
+    buffer[2] = 10;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) page_scan_repetition_mode;
+    buffer[10] = (uint8_t) reserved;
+    buffer[11] = (uint8_t) clock_offset;
+    buffer[12] = (uint8_t) (clock_offset >> 8);
+    return 13;
+}
+
+/**
+ * @brief Create HCI_REMOTE_NAME_REQUEST_CANCEL command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x041a, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_remote_name_request_cancel(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x1a;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_READ_REMOTE_SUPPORTED_FEATURES_COMMAND command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x041b, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_read_remote_supported_features_command(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x1b;
+    buffer[1] = 0x04;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_READ_REMOTE_EXTENDED_FEATURES_COMMAND command packet
+ * @param buffer for command packet, at least 6 bytes
+ * @param arg1
+ * @param arg2
+ * @return size of command packet
+ * @note: opcode 0x041c, format string "H1"
+ */
+static inline uint16_t hci_cmd_encode_read_remote_extended_features_command(uint8_t * buffer, hci_con_handle_t arg1, uint8_t arg2){
+    buffer[0] = 0x1c;
+    buffer[1] = 0x04;
+    buffer[2] = 3;
+    buffer[3] = (uint8_t) arg1;
+    buffer[4] = (uint8_t) (arg1 >> 8);
+    buffer[5] = (uint8_t) arg2;
+    return 6;
+}
+
+/**
+ * @brief Create HCI_READ_REMOTE_VERSION_INFORMATION command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x041d, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_read_remote_version_information(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x1d;
+    buffer[1] = 0x04;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_SETUP_SYNCHRONOUS_CONNECTION command packet
+ * @param buffer for command packet, at least 20 bytes
+ * @param handle
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param max_latency
+ * @param voice_settings
+ * @param retransmission_effort
+ * @param packet_type
+ * @return size of command packet
+ * @note: opcode 0x0428, format string "H442212"
+ */
+static inline uint16_t hci_cmd_encode_setup_synchronous_connection(uint8_t * buffer, hci_con_handle_t handle, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint16_t max_latency, uint16_t voice_settings, uint8_t retransmission_effort, uint16_t packet_type){
+    buffer[0] = 0x28;
+    buffer[1] = 0x04;
+    buffer[2] = 17;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) transmit_bandwidth;
+    buffer[6] = (uint8_t) (transmit_bandwidth >> 8);
+    buffer[7] = (uint8_t) (transmit_bandwidth >> 16);
+    buffer[8] = (uint8_t) (transmit_bandwidth >> 24);
+    buffer[9] = (uint8_t) receive_bandwidth;
+    buffer[10] = (uint8_t) (receive_bandwidth >> 8);
+    buffer[11] = (uint8_t) (receive_bandwidth >> 16);
+    buffer[12] = (uint8_t) (receive_bandwidth >> 24);
+    buffer[13] = (uint8_t) max_latency;
+    buffer[14] = (uint8_t) (max_latency >> 8);
+    buffer[15] = (uint8_t) voice_settings;
+    buffer[16] = (uint8_t) (voice_settings >> 8);
+    buffer[17] = (uint8_t) retransmission_effort;
+    buffer[18] = (uint8_t) packet_type;
+    buffer[19] = (uint8_t) (packet_type >> 8);
+    return 20;
+}
+
+/**
+ * @brief Create HCI_ACCEPT_SYNCHRONOUS_CONNECTION command packet
+ * @param buffer for command packet, at least 24 bytes
+ * @param bd_addr
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param max_latency
+ * @param voice_settings
+ * @param retransmission_effort
+ * @param packet_type
+ * @return size of command packet
+ * @note: opcode 0x0429, format string "B442212"
+ */
+static inline uint16_t hci_cmd_encode_accept_synchronous_connection(uint8_t * buffer, const bd_addr_t bd_addr, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint16_t max_latency, uint16_t voice_settings, uint8_t retransmission_effort, uint16_t packet_type){
+    buffer[0] = 0x29;
+    buffer[1] = 0x04;
+    buffer[2] = 21;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) transmit_bandwidth;
+    buffer[10] = (uint8_t) (transmit_bandwidth >> 8);
+    buffer[11] = (uint8_t) (transmit_bandwidth >> 16);
+    buffer[12] = (uint8_t) (transmit_bandwidth >> 24);
+    buffer[13] = (uint8_t) receive_bandwidth;
+    buffer[14] = (uint8_t) (receive_bandwidth >> 8);
+    buffer[15] = (uint8_t) (receive_bandwidth >> 16);
+    buffer[16] = (uint8_t) (receive_bandwidth >> 24);
+    buffer[17] = (uint8_t) max_latency;
+    buffer[18] = (uint8_t) (max_latency >> 8);
+    buffer[19] = (uint8_t) voice_settings;
+    buffer[20] = (uint8_t) (voice_settings >> 8);
+    buffer[21] = (uint8_t) retransmission_effort;
+    buffer[22] = (uint8_t) packet_type;
+    buffer[23] = (uint8_t) (packet_type >> 8);
+    return 24;
+}
+
+/**
+ * @brief Create HCI_IO_CAPABILITY_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 12 bytes
+ * @param bd_addr
+ * @param io_capability
+ * @param oob_data_present
+ * @param authentication_requirements
+ * @return size of command packet
+ * @note: opcode 0x042b, format string "B111"
+ */
+static inline uint16_t hci_cmd_encode_io_capability_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t io_capability, uint8_t oob_data_present, uint8_t authentication_requirements){
+    buffer[0] = 0x2b;
+    buffer[1] = 0x04;
+    buffer[2] = 9;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) io_capability;
+    buffer[10] = (uint8_t) oob_data_present;
+    buffer[11] = (uint8_t) authentication_requirements;
+    return 12;
+}
+
+/**
+ * @brief Create HCI_USER_CONFIRMATION_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x042c, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_user_confirmation_request_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x2c;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_USER_CONFIRMATION_REQUEST_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x042d, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_user_confirmation_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x2d;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_USER_PASSKEY_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 13 bytes
+ * @param bd_addr
+ * @param numeric_value
+ * @return size of command packet
+ * @note: opcode 0x042e, format string "B4"
+ */
+static inline uint16_t hci_cmd_encode_user_passkey_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint32_t numeric_value){
+    buffer[0] = 0x2e;
+    buffer[1] = 0x04;
+    buffer[2] = 10;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) numeric_value;
+    buffer[10] = (uint8_t) (numeric_value >> 8);
+    buffer[11] = (uint8_t) (numeric_value >> 16);
+    buffer[12] = (uint8_t) (numeric_value >> 24);
+    return 13;
+}
+
+/**
+ * @brief Create HCI_USER_PASSKEY_REQUEST_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x042f, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_user_passkey_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x2f;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_REMOTE_OOB_DATA_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 41 bytes
+ * @param bd_addr
+ * @param c
+ * @param r
+ * @return size of command packet
+ * @note: opcode 0x0430, format string "BPP"
+ */
+static inline uint16_t hci_cmd_encode_remote_oob_data_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, const uint8_t * c, const uint8_t * r){
+    buffer[0] = 0x30;
+    buffer[1] = 0x04;
+    buffer[2] = 38;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    (void)memcpy(&buffer[9], c, 16);
+    (void)memcpy(&buffer[25], r, 16);
+    return 41;
+}
+
+/**
+ * @brief Create HCI_REMOTE_OOB_DATA_REQUEST_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x0433, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_remote_oob_data_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    buffer[0] = 0x33;
+    buffer[1] = 0x04;
+    buffer[2] = 6;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    return 9;
+}
+
+/**
+ * @brief Create HCI_IO_CAPABILITY_REQUEST_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param bd_addr
+ * @param reason
+ * @return size of command packet
+ * @note: opcode 0x0434, format string "B1"
+ */
+static inline uint16_t hci_cmd_encode_io_capability_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t reason){
+    buffer[0] = 0x34;
+    buffer[1] = 0x04;
+    buffer[2] = 7;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) reason;
+    return 10;
+}
+
+/**
+ * @brief Create HCI_ENHANCED_SETUP_SYNCHRONOUS_CONNECTION command packet
+ * @param buffer for command packet, at least 62 bytes
+ * @param handle
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param transmit_coding_format_type
+ * @param transmit_coding_format_company
+ * @param transmit_coding_format_codec
+ * @param receive_coding_format_type
+ * @param receive_coding_format_company
+ * @param receive_coding_format_codec
+ * @param transmit_coding_frame_size
+ * @param receive_coding_frame_size
+ * @param input_bandwidth
+ * @param output_bandwidth
+ * @param input_coding_format_type
+ * @param input_coding_format_company
+ * @param input_coding_format_codec
+ * @param output_coding_format_type
+ * @param output_coding_format_company
+ * @param output_coding_format_codec
+ * @param input_coded_data_size
+ * @param outupt_coded_data_size
+ * @param input_pcm_data_format
+ * @param output_pcm_data_format
+ * @param input_pcm_sample_payload_msb_position
+ * @param output_pcm_sample_payload_msb_position
+ * @param input_data_path
+ * @param output_data_path
+ * @param input_transport_unit_size
+ * @param output_transport_unit_size
+ * @param max_latency
+ * @param packet_type
+ * @param retransmission_effort
+ * @return size of command packet
+ * @note: opcode 0x043d, format string "H4412212222441221222211111111221"
+ */
+static inline uint16_t hci_cmd_encode_enhanced_setup_synchronous_connection(uint8_t * buffer, hci_con_handle_t handle, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint8_t transmit_coding_format_type, uint16_t transmit_coding_format_company, uint16_t transmit_coding_format_codec, uint8_t receive_coding_format_type, uint16_t receive_coding_format_company, uint16_t receive_coding_format_codec, uint16_t transmit_coding_frame_size, uint16_t receive_coding_frame_size, uint32_t input_bandwidth, uint32_t output_bandwidth, uint8_t input_coding_format_type, uint16_t input_coding_format_company, uint16_t input_coding_format_codec, uint8_t output_coding_format_type, uint16_t output_coding_format_company, uint16_t output_coding_format_codec, uint16_t input_coded_data_size, uint16_t outupt_coded_data_size, uint8_t input_pcm_data_format, uint8_t output_pcm_data_format, uint8_t input_pcm_sample_payload_msb_position, uint8_t output_pcm_sample_payload_msb_position, uint8_t input_data_path, uint8_t output_data_path, uint8_t input_transport_unit_size, uint8_t output_transport_unit_size, uint16_t max_latency, uint16_t packet_type, uint8_t retransmission_effort){
+    buffer[0] = 0x3d;
+    buffer[1] = 0x04;
+    buffer[2] = 59;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) transmit_bandwidth;
+    buffer[6] = (uint8_t) (transmit_bandwidth >> 8);
+    buffer[7] = (uint8_t) (transmit_bandwidth >> 16);
+    buffer[8] = (uint8_t) (transmit_bandwidth >> 24);
+    buffer[9] = (uint8_t) receive_bandwidth;
+    buffer[10] = (uint8_t) (receive_bandwidth >> 8);
+    buffer[11] = (uint8_t) (receive_bandwidth >> 16);
+    buffer[12] = (uint8_t) (receive_bandwidth >> 24);
+    buffer[13] = (uint8_t) transmit_coding_format_type;
+    buffer[14] = (uint8_t) transmit_coding_format_company;
+    buffer[15] = (uint8_t) (transmit_coding_format_company >> 8);
+    buffer[16] = (uint8_t) transmit_coding_format_codec;
+    buffer[17] = (uint8_t) (transmit_coding_format_codec >> 8);
+    buffer[18] = (uint8_t) receive_coding_format_type;
+    buffer[19] = (uint8_t) receive_coding_format_company;
+    buffer[20] = (uint8_t) (receive_coding_format_company >> 8);
+    buffer[21] = (uint8_t) receive_coding_format_codec;
+    buffer[22] = (uint8_t) (receive_coding_format_codec >> 8);
+    buffer[23] = (uint8_t) transmit_coding_frame_size;
+    buffer[24] = (uint8_t) (transmit_coding_frame_size >> 8);
+    buffer[25] = (uint8_t) receive_coding_frame_size;
+    buffer[26] = (uint8_t) (receive_coding_frame_size >> 8);
+    buffer[27] = (uint8_t) input_bandwidth;
+    buffer[28] = (uint8_t) (input_bandwidth >> 8);
+    buffer[29] = (uint8_t) (input_bandwidth >> 16);
+    buffer[30] = (uint8_t) (input_bandwidth >> 24);
+    buffer[31] = (uint8_t) output_bandwidth;
+    buffer[32] = (uint8_t) (output_bandwidth >> 8);
+    buffer[33] = (uint8_t) (output_bandwidth >> 16);
+    buffer[34] = (uint8_t) (output_bandwidth >> 24);
+    buffer[35] = (uint8_t) input_coding_format_type;
+    buffer[36] = (uint8_t) input_coding_format_company;
+    buffer[37] = (uint8_t) (input_coding_format_company >> 8);
+    buffer[38] = (uint8_t) input_coding_format_codec;
+    buffer[39] = (uint8_t) (input_coding_format_codec >> 8);
+    buffer[40] = (uint8_t) output_coding_format_type;
+    buffer[41] = (uint8_t) output_coding_format_company;
+    buffer[42] = (uint8_t) (output_coding_format_company >> 8);
+    buffer[43] = (uint8_t) output_coding_format_codec;
+    buffer[44] = (uint8_t) (output_coding_format_codec >> 8);
+    buffer[45] = (uint8_t) input_coded_data_size;
+    buffer[46] = (uint8_t) (input_coded_data_size >> 8);
+    buffer[47] = (uint8_t) outupt_coded_data_size;
+    buffer[48] = (uint8_t) (outupt_coded_data_size >> 8);
+    buffer[49] = (uint8_t) input_pcm_data_format;
+    buffer[50] = (uint8_t) output_pcm_data_format;
+    buffer[51] = (uint8_t) input_pcm_sample_payload_msb_position;
+    buffer[52] = (uint8_t) output_pcm_sample_payload_msb_position;
+    buffer[53] = (uint8_t) input_data_path;
+    buffer[54] = (uint8_t) output_data_path;
+    buffer[55] = (uint8_t) input_transport_unit_size;
+    buffer[56] = (uint8_t) output_transport_unit_size;
+    buffer[57] = (uint8_t) max_latency;
+    buffer[58] = (uint8_t) (max_latency >> 8);
+    buffer[59] = (uint8_t) packet_type;
+    buffer[60] = (uint8_t) (packet_type >> 8);
+    buffer[61] = (uint8_t) retransmission_effort;
+    return 62;
+}
+
+/**
+ * @brief Create HCI_ENHANCED_ACCEPT_SYNCHRONOUS_CONNECTION command packet
+ * @param buffer for command packet, at least 66 bytes
+ * @param bd_addr
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param transmit_coding_format_type
+ * @param transmit_coding_format_company
+ * @param transmit_coding_format_codec
+ * @param receive_coding_format_type
+ * @param receive_coding_format_company
+ * @param receive_coding_format_codec
+ * @param transmit_coding_frame_size
+ * @param receive_coding_frame_size
+ * @param input_bandwidth
+ * @param output_bandwidth
+ * @param input_coding_format_type
+ * @param input_coding_format_company
+ * @param input_coding_format_codec
+ * @param output_coding_format_type
+ * @param output_coding_format_company
+ * @param output_coding_format_codec
+ * @param input_coded_data_size
+ * @param outupt_coded_data_size
+ * @param input_pcm_data_format
+ * @param output_pcm_data_format
+ * @param input_pcm_sample_payload_msb_position
+ * @param output_pcm_sample_payload_msb_position
+ * @param input_data_path
+ * @param output_data_path
+ * @param input_transport_unit_size
+ * @param output_transport_unit_size
+ * @param max_latency
+ * @param packet_type
+ * @param retransmission_effort
+ * @return size of command packet
+ * @note: opcode 0x043e, format string "B4412212222441221222211111111221"
+ */
+static inline uint16_t hci_cmd_encode_enhanced_accept_synchronous_connection(uint8_t * buffer, const bd_addr_t bd_addr, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint8_t transmit_coding_format_type, uint16_t transmit_coding_format_company, uint16_t transmit_coding_format_codec, uint8_t receive_coding_format_type, uint16_t receive_coding_format_company, uint16_t receive_coding_format_codec, uint16_t transmit_coding_frame_size, uint16_t receive_coding_frame_size, uint32_t input_bandwidth, uint32_t output_bandwidth, uint8_t input_coding_format_type, uint16_t input_coding_format_company, uint16_t input_coding_format_codec, uint8_t output_coding_format_type, uint16_t output_coding_format_company, uint16_t output_coding_format_codec, uint16_t input_coded_data_size, uint16_t outupt_coded_data_size, uint8_t input_pcm_data_format, uint8_t output_pcm_data_format, uint8_t input_pcm_sample_payload_msb_position, uint8_t output_pcm_sample_payload_msb_position, uint8_t input_data_path, uint8_t output_data_path, uint8_t input_transport_unit_size, uint8_t output_transport_unit_size, uint16_t max_latency, uint16_t packet_type, uint8_t retransmission_effort){
+    buffer[0] = 0x3e;
+    buffer[1] = 0x04;
+    buffer[2] = 63;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) transmit_bandwidth;
+    buffer[10] = (uint8_t) (transmit_bandwidth >> 8);
+    buffer[11] = (uint8_t) (transmit_bandwidth >> 16);
+    buffer[12] = (uint8_t) (transmit_bandwidth >> 24);
+    buffer[13] = (uint8_t) receive_bandwidth;
+    buffer[14] = (uint8_t) (receive_bandwidth >> 8);
+    buffer[15] = (uint8_t) (receive_bandwidth >> 16);
+    buffer[16] = (uint8_t) (receive_bandwidth >> 24);
+    buffer[17] = (uint8_t) transmit_coding_format_type;
+    buffer[18] = (uint8_t) transmit_coding_format_company;
+    buffer[19] = (uint8_t) (transmit_coding_format_company >> 8);
+    buffer[20] = (uint8_t) transmit_coding_format_codec;
+    buffer[21] = (uint8_t) (transmit_coding_format_codec >> 8);
+    buffer[22] = (uint8_t) receive_coding_format_type;
+    buffer[23] = (uint8_t) receive_coding_format_company;
+    buffer[24] = (uint8_t) (receive_coding_format_company >> 8);
+    buffer[25] = (uint8_t) receive_coding_format_codec;
+    buffer[26] = (uint8_t) (receive_coding_format_codec >> 8);
+    buffer[27] = (uint8_t) transmit_coding_frame_size;
+    buffer[28] = (uint8_t) (transmit_coding_frame_size >> 8);
+    buffer[29] = (uint8_t) receive_coding_frame_size;
+    buffer[30] = (uint8_t) (receive_coding_frame_size >> 8);
+    buffer[31] = (uint8_t) input_bandwidth;
+    buffer[32] = (uint8_t) (input_bandwidth >> 8);
+    buffer[33] = (uint8_t) (input_bandwidth >> 16);
+    buffer[34] = (uint8_t) (input_bandwidth >> 24);
+    buffer[35] = (uint8_t) output_bandwidth;
+    buffer[36] = (uint8_t) (output_bandwidth >> 8);
+    buffer[37] = (uint8_t) (output_bandwidth >> 16);
+    buffer[38] = (uint8_t) (output_bandwidth >> 24);
+    buffer[39] = (uint8_t) input_coding_format_type;
+    buffer[40] = (uint8_t) input_coding_format_company;
+    buffer[41] = (uint8_t) (input_coding_format_company >> 8);
+    buffer[42] = (uint8_t) input_coding_format_codec;
+    buffer[43] = (uint8_t) (input_coding_format_codec >> 8);
+    buffer[44] = (uint8_t) output_coding_format_type;
+    buffer[45] = (uint8_t) output_coding_format_company;
+    buffer[46] = (uint8_t) (output_coding_format_company >> 8);
+    buffer[47] = (uint8_t) output_coding_format_codec;
+    buffer[48] = (uint8_t) (output_coding_format_codec >> 8);
+    buffer[49] = (uint8_t) input_coded_data_size;
+    buffer[50] = (uint8_t) (input_coded_data_size >> 8);
+    buffer[51] = (uint8_t) outupt_coded_data_size;
+    buffer[52] = (uint8_t) (outupt_coded_data_size >> 8);
+    buffer[53] = (uint8_t) input_pcm_data_format;
+    buffer[54] = (uint8_t) output_pcm_data_format;
+    buffer[55] = (uint8_t) input_pcm_sample_payload_msb_position;
+    buffer[56] = (uint8_t) output_pcm_sample_payload_msb_position;
+    buffer[57] = (uint8_t) input_data_path;
+    buffer[58] = (uint8_t) output_data_path;
+    buffer[59] = (uint8_t) input_transport_unit_size;
+    buffer[60] = (uint8_t) output_transport_unit_size;
+    buffer[61] = (uint8_t) max_latency;
+    buffer[62] = (uint8_t) (max_latency >> 8);
+    buffer[63] = (uint8_t) packet_type;
+    buffer[64] = (uint8_t) (packet_type >> 8);
+    buffer[65] = (uint8_t) retransmission_effort;
+    return 66;
+}
+
+/**
+ * @brief Create HCI_SNIFF_MODE command packet
+ * @param buffer for command packet, at least 13 bytes
+ * @param handle
+ * @param sniff_max_interval
+ * @param sniff_min_interval
+ * @param sniff_attempt
+ * @param sniff_timeout
+ * @return size of command packet
+ * @note: opcode 0x0803, format string "H2222"
+ */
+static inline uint16_t hci_cmd_encode_sniff_mode(uint8_t * buffer, hci_con_handle_t handle, uint16_t sniff_max_interval, uint16_t sniff_min_interval, uint16_t sniff_attempt, uint16_t sniff_timeout){
+    buffer[0] = 0x03;
+    buffer[1] = 0x08;
+    buffer[2] = 10;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) sniff_max_interval;
+    buffer[6] = (uint8_t) (sniff_max_interval >> 8);
+    buffer[7] = (uint8_t) sniff_min_interval;
+    buffer[8] = (uint8_t) (sniff_min_interval >> 8);
+    buffer[9] = (uint8_t) sniff_attempt;
+    buffer[10] = (uint8_t) (sniff_attempt >> 8);
+    buffer[11] = (uint8_t) sniff_timeout;
+    buffer[12] = (uint8_t) (sniff_timeout >> 8);
+    return 13;
+}
+
+/**
+ * @brief Create HCI_EXIT_SNIFF_MODE command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x0804, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_exit_sniff_mode(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x04;
+    buffer[1] = 0x08;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_QOS_SETUP command packet
+ * @param buffer for command packet, at least 23 bytes
+ * @param handle
+ * @param flags
+ * @param service_type
+ * @param token_rate
+ * @param peak_bandwith
+ * @param latency
+ * @param delay_variation
+ * @return size of command packet
+ * @note: opcode 0x0807, format string "H114444"
+ */
+static inline uint16_t hci_cmd_encode_qos_setup(uint8_t * buffer, hci_con_handle_t handle, uint8_t flags, uint8_t service_type, uint32_t token_rate, uint32_t peak_bandwith, uint32_t latency, uint32_t delay_variation){
+    buffer[0] = 0x07;
+    buffer[1] = 0x08;
+    buffer[2] = 20;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) flags;
+    buffer[6] = (uint8_t) service_type;
+    buffer[7] = (uint8_t) token_rate;
+    buffer[8] = (uint8_t) (token_rate >> 8);
+    buffer[9] = (uint8_t) (token_rate >> 16);
+    buffer[10] = (uint8_t) (token_rate >> 24);
+    buffer[11] = (uint8_t) peak_bandwith;
+    buffer[12] = (uint8_t) (peak_bandwith >> 8);
+    buffer[13] = (uint8_t) (peak_bandwith >> 16);
+    buffer[14] = (uint8_t) (peak_bandwith >> 24);
+    buffer[15] = (uint8_t) latency;
+    buffer[16] = (uint8_t) (latency >> 8);
+    buffer[17] = (uint8_t) (latency >> 16);
+    buffer[18] = (uint8_t) (latency >> 24);
+    buffer[19] = (uint8_t) delay_variation;
+    buffer[20] = (uint8_t) (delay_variation >> 8);
+    buffer[21] = (uint8_t) (delay_variation >> 16);
+    buffer[22] = (uint8_t) (delay_variation >> 24);
+    return 23;
+}
+
+/**
+ * @brief Create HCI_ROLE_DISCOVERY command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x0809, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_role_discovery(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x09;
+    buffer[1] = 0x08;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_SWITCH_ROLE_COMMAND command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param bd_addr
+ * @param role
+ * @return size of command packet
+ * @note: opcode 0x080b, format string "B1"
+ */
+static inline uint16_t hci_cmd_encode_switch_role_command(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t role){
+    buffer[0] = 0x0b;
+    buffer[1] = 0x08;
+    buffer[2] = 7;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) role;
+    return 10;
+}
+
+/**
+ * @brief Create HCI_READ_LINK_POLICY_SETTINGS command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x080c, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_read_link_policy_settings(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x0c;
+    buffer[1] = 0x08;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_WRITE_LINK_POLICY_SETTINGS command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param handle
+ * @param settings
+ * @return size of command packet
+ * @note: opcode 0x080d, format string "H2"
+ */
+static inline uint16_t hci_cmd_encode_write_link_policy_settings(uint8_t * buffer, hci_con_handle_t handle, uint16_t settings){
+    buffer[0] = 0x0d;
+    buffer[1] = 0x08;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) settings;
+    buffer[6] = (uint8_t) (settings >> 8);
+    return 7;
+}
+
+/**
+ * @brief Create HCI_WRITE_DEFAULT_LINK_POLICY_SETTING command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param policy
+ * @return size of command packet
+ * @note: opcode 0x080f, format string "2"
+ */
+static inline uint16_t hci_cmd_encode_write_default_link_policy_setting(uint8_t * buffer, uint16_t policy){
+    buffer[0] = 0x0f;
+    buffer[1] = 0x08;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) policy;
+    buffer[4] = (uint8_t) (policy >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_SET_EVENT_MASK command packet
+ * @param buffer for command packet, at least 11 bytes
+ * @param event_mask_lover_octets
+ * @param event_mask_higher_octets
+ * @return size of command packet
+ * @note: opcode 0x0c01, format string "44"
+ */
+static inline uint16_t hci_cmd_encode_set_event_mask(uint8_t * buffer, uint32_t event_mask_lover_octets, uint32_t event_mask_higher_octets){
+    buffer[0] = 0x01;
+    buffer[1] = 0x0c;
+    buffer[2] = 8;
+    buffer[3] = (uint8_t) event_mask_lover_octets;
+    buffer[4] = (uint8_t) (event_mask_lover_octets >> 8);
+    buffer[5] = (uint8_t) (event_mask_lover_octets >> 16);
+    buffer[6] = (uint8_t) (event_mask_lover_octets >> 24);
+    buffer[7] = (uint8_t) event_mask_higher_octets;
+    buffer[8] = (uint8_t) (event_mask_higher_octets >> 8);
+    buffer[9] = (uint8_t) (event_mask_higher_octets >> 16);
+    buffer[10] = (uint8_t) (event_mask_higher_octets >> 24);
+    return 11;
+}
+
+/**
+ * @brief Create HCI_RESET command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c03, format string ""
+ */
+static inline uint16_t hci_cmd_encode_reset(uint8_t * buffer){
+    buffer[0] = 0x03;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_FLUSH command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x0c08, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_flush(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x08;
+    buffer[1] = 0x0c;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_READ_PIN_TYPE command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c09, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_pin_type(uint8_t * buffer){
+    buffer[0] = 0x09;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_PIN_TYPE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x0c0a, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_pin_type(uint8_t * buffer, uint8_t handle){
+    buffer[0] = 0x0a;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) handle;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_DELETE_STORED_LINK_KEY command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param bd_addr
+ * @param delete_all_flags
+ * @return size of command packet
+ * @note: opcode 0x0c12, format string "B1"
+ */
+static inline uint16_t hci_cmd_encode_delete_stored_link_key(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t delete_all_flags){
+    buffer[0] = 0x12;
+    buffer[1] = 0x0c;
+    buffer[2] = 7;
+    buffer[3] = bd_addr[5];
+    buffer[4] = bd_addr[4];
+    buffer[5] = bd_addr[3];
+    buffer[6] = bd_addr[2];
+    buffer[7] = bd_addr[1];
+    buffer[8] = bd_addr[0];
+    buffer[9] = (uint8_t) delete_all_flags;
+    return 10;
+}
+
+#if defined(ENABLE_CLASSIC)
+/**
+ * @brief Create HCI_WRITE_LOCAL_NAME command packet
+ * @param buffer for command packet, at least 251 bytes
+ * @param local_name
+ * @return size of command packet
+ * @note: opcode 0x0c13, format string "N"
+ */
+static inline uint16_t hci_cmd_encode_write_local_name(uint8_t * buffer, const char * local_name){
+    buffer[0] = 0x13;
+    buffer[1] = 0x0c;
+    buffer[2] = 248;
+    uint16_t local_name_len = (uint16_t) strlen(local_name);
+    if (local_name_len > 248) {
+        local_name_len = 248;
+    }
+    (void)memcpy(&buffer[3], local_name, local_name_len);
+    memset(&buffer[3 + local_name_len], 0, 248 - local_name_len);
+    return 251;
+}
+#endif
+
+/**
+ * @brief Create HCI_READ_LOCAL_NAME command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c14, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_local_name(uint8_t * buffer){
+    buffer[0] = 0x14;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_READ_PAGE_TIMEOUT command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c17, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_page_timeout(uint8_t * buffer){
+    buffer[0] = 0x17;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_PAGE_TIMEOUT command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param page_timeout
+ * @return size of command packet
+ * @note: opcode 0x0c18, format string "2"
+ */
+static inline uint16_t hci_cmd_encode_write_page_timeout(uint8_t * buffer, uint16_t page_timeout){
+    buffer[0] = 0x18;
+    buffer[1] = 0x0c;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) page_timeout;
+    buffer[4] = (uint8_t) (page_timeout >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_WRITE_SCAN_ENABLE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param scan_enable
+ * @return size of command packet
+ * @note: opcode 0x0c1a, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_scan_enable(uint8_t * buffer, uint8_t scan_enable){
+    buffer[0] = 0x1a;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) scan_enable;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_READ_PAGE_SCAN_ACTIVITY command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c1b, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_page_scan_activity(uint8_t * buffer){
+    buffer[0] = 0x1b;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_PAGE_SCAN_ACTIVITY command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param page_scan_interval
+ * @param page_scan_window
+ * @return size of command packet
+ * @note: opcode 0x0c1c, format string "22"
+ */
+static inline uint16_t hci_cmd_encode_write_page_scan_activity(uint8_t * buffer, uint16_t page_scan_interval, uint16_t page_scan_window){
+    buffer[0] = 0x1c;
+    buffer[1] = 0x0c;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) page_scan_interval;
+    buffer[4] = (uint8_t) (page_scan_interval >> 8);
+    buffer[5] = (uint8_t) page_scan_window;
+    buffer[6] = (uint8_t) (page_scan_window >> 8);
+    return 7;
+}
+
+/**
+ * @brief Create HCI_READ_INQUIRY_SCAN_ACTIVITY command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c1d, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_inquiry_scan_activity(uint8_t * buffer){
+    buffer[0] = 0x1d;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_INQUIRY_SCAN_ACTIVITY command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param inquiry_scan_interval
+ * @param inquiry_scan_window
+ * @return size of command packet
+ * @note: opcode 0x0c1e, format string "22"
+ */
+static inline uint16_t hci_cmd_encode_write_inquiry_scan_activity(uint8_t * buffer, uint16_t inquiry_scan_interval, uint16_t inquiry_scan_window){
+    buffer[0] = 0x1e;
+    buffer[1] = 0x0c;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) inquiry_scan_interval;
+    buffer[4] = (uint8_t) (inquiry_scan_interval >> 8);
+    buffer[5] = (uint8_t) inquiry_scan_window;
+    buffer[6] = (uint8_t) (inquiry_scan_window >> 8);
+    return 7;
+}
+
+/**
+ * @brief Create HCI_WRITE_AUTHENTICATION_ENABLE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param authentication_enable
+ * @return size of command packet
+ * @note: opcode 0x0c20, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_authentication_enable(uint8_t * buffer, uint8_t authentication_enable){
+    buffer[0] = 0x20;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) authentication_enable;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_WRITE_CLASS_OF_DEVICE command packet
+ * @param buffer for command packet, at least 6 bytes
+ * @param class_of_device
+ * @return size of command packet
+ * @note: opcode 0x0c24, format string "3"
+ */
+static inline uint16_t hci_cmd_encode_write_class_of_device(uint8_t * buffer, uint32_t class_of_device){
+    buffer[0] = 0x24;
+    buffer[1] = 0x0c;
+    buffer[2] = 3;
+    buffer[3] = (uint8_t) class_of_device;
+    buffer[4] = (uint8_t) (class_of_device >> 8);
+    buffer[5] = (uint8_t) (class_of_device >> 16);
+    return 6;
+}
+
+/**
+ * @brief Create HCI_READ_NUM_BROADCAST_RETRANSMISSIONS command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c29, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_num_broadcast_retransmissions(uint8_t * buffer){
+    buffer[0] = 0x29;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_NUM_BROADCAST_RETRANSMISSIONS command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param num_broadcast_retransmissions
+ * @return size of command packet
+ * @note: opcode 0x0c2a, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_num_broadcast_retransmissions(uint8_t * buffer, uint8_t num_broadcast_retransmissions){
+    buffer[0] = 0x2a;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) num_broadcast_retransmissions;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_READ_TRANSMIT_POWER_LEVEL command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param connection_handle
+ * @param type
+ * @return size of command packet
+ * @note: opcode 0x0c2d, format string "11"
+ */
+static inline uint16_t hci_cmd_encode_read_transmit_power_level(uint8_t * buffer, uint8_t connection_handle, uint8_t type){
+    buffer[0] = 0x2d;
+    buffer[1] = 0x0c;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) connection_handle;
+    buffer[4] = (uint8_t) type;
+    return 5;
+}
+
+/**
+ * @brief Create HCI_WRITE_SYNCHRONOUS_FLOW_CONTROL_ENABLE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param synchronous_flow_control_enable
+ * @return size of command packet
+ * @note: opcode 0x0c2f, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_synchronous_flow_control_enable(uint8_t * buffer, uint8_t synchronous_flow_control_enable){
+    buffer[0] = 0x2f;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) synchronous_flow_control_enable;
+    return 4;
+}
+
+#if defined(ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL)
+/**
+ * @brief Create HCI_SET_CONTROLLER_TO_HOST_FLOW_CONTROL command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param flow_control_enable
+ * @return size of command packet
+ * @note: opcode 0x0c31, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_set_controller_to_host_flow_control(uint8_t * buffer, uint8_t flow_control_enable){
+    buffer[0] = 0x31;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) flow_control_enable;
+    return 4;
+}
+#endif
+
+#if defined(ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL)
+/**
+ * @brief Create HCI_HOST_BUFFER_SIZE command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param host_acl_data_packet_length
+ * @param host_synchronous_data_packet_length
+ * @param host_total_num_acl_data_packets
+ * @param host_total_num_synchronous_data_packets
+ * @return size of command packet
+ * @note: opcode 0x0c33, format string "2122"
+ */
+static inline uint16_t hci_cmd_encode_host_buffer_size(uint8_t * buffer, uint16_t host_acl_data_packet_length, uint8_t host_synchronous_data_packet_length, uint16_t host_total_num_acl_data_packets, uint16_t host_total_num_synchronous_data_packets){
+    buffer[0] = 0x33;
+    buffer[1] = 0x0c;
+    buffer[2] = 7;
+    buffer[3] = (uint8_t) host_acl_data_packet_length;
+    buffer[4] = (uint8_t) (host_acl_data_packet_length >> 8);
+    buffer[5] = (uint8_t) host_synchronous_data_packet_length;
+    buffer[6] = (uint8_t) host_total_num_acl_data_packets;
+    buffer[7] = (uint8_t) (host_total_num_acl_data_packets >> 8);
+    buffer[8] = (uint8_t) host_total_num_synchronous_data_packets;
+    buffer[9] = (uint8_t) (host_total_num_synchronous_data_packets >> 8);
+    return 10;
+}
+#endif
+
+/**
+ * @brief Create HCI_READ_LINK_SUPERVISION_TIMEOUT command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x0c36, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_read_link_supervision_timeout(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x36;
+    buffer[1] = 0x0c;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_WRITE_LINK_SUPERVISION_TIMEOUT command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param handle
+ * @param timeout
+ * @return size of command packet
+ * @note: opcode 0x0c37, format string "H2"
+ */
+static inline uint16_t hci_cmd_encode_write_link_supervision_timeout(uint8_t * buffer, hci_con_handle_t handle, uint16_t timeout){
+    buffer[0] = 0x37;
+    buffer[1] = 0x0c;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) timeout;
+    buffer[6] = (uint8_t) (timeout >> 8);
+    return 7;
+}
+
+/**
+ * @brief Create HCI_WRITE_CURRENT_IAC_LAP_TWO_IACS command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param num_current_iac
+ * @param iac_lap1
+ * @param iac_lap2
+ * @return size of command packet
+ * @note: opcode 0x0c3a, format string "133"
+ */
+static inline uint16_t hci_cmd_encode_write_current_iac_lap_two_iacs(uint8_t * buffer, uint8_t num_current_iac, uint32_t iac_lap1, uint32_t iac_lap2){
+    buffer[0] = 0x3a;
+    buffer[1] = 0x0c;
+    buffer[2] = 7;
+    buffer[3] = (uint8_t) num_current_iac;
+    buffer[4] = (uint8_t) iac_lap1;
+    buffer[5] = (uint8_t) (iac_lap1 >> 8);
+    buffer[6] = (uint8_t) (iac_lap1 >> 16);
+    buffer[7] = (uint8_t) iac_lap2;
+    buffer[8] = (uint8_t) (iac_lap2 >> 8);
+    buffer[9] = (uint8_t) (iac_lap2 >> 16);
+    return 10;
+}
+
+/**
+ * @brief Create HCI_WRITE_INQUIRY_MODE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param inquiry_mode
+ * @return size of command packet
+ * @note: opcode 0x0c45, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_inquiry_mode(uint8_t * buffer, uint8_t inquiry_mode){
+    buffer[0] = 0x45;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) inquiry_mode;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_WRITE_EXTENDED_INQUIRY_RESPONSE command packet
+ * @param buffer for command packet, at least 244 bytes
+ * @param fec_required
+ * @param exstended_inquiry_response
+ * @return size of command packet
+ * @note: opcode 0x0c52, format string "1E"
+ */
+static inline uint16_t hci_cmd_encode_write_extended_inquiry_response(uint8_t * buffer, uint8_t fec_required, const uint8_t * exstended_inquiry_response){
+    buffer[0] = 0x52;
+    buffer[1] = 0x0c;
+    buffer[2] = 241;
+    buffer[3] = (uint8_t) fec_required;
+    (void)memcpy(&buffer[4], exstended_inquiry_response, 240);
+    return 244;
+}
+
+/**
+ * @brief Create HCI_WRITE_SIMPLE_PAIRING_MODE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param mode
+ * @return size of command packet
+ * @note: opcode 0x0c56, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_simple_pairing_mode(uint8_t * buffer, uint8_t mode){
+    buffer[0] = 0x56;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) mode;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_READ_LOCAL_OOB_DATA command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c57, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_local_oob_data(uint8_t * buffer){
+    buffer[0] = 0x57;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_DEFAULT_ERRONEOUS_DATA_REPORTING command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param mode
+ * @return size of command packet
+ * @note: opcode 0x0c5b, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_default_erroneous_data_reporting(uint8_t * buffer, uint8_t mode){
+    buffer[0] = 0x5b;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) mode;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_READ_LE_HOST_SUPPORTED command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c6c, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_le_host_supported(uint8_t * buffer){
+    buffer[0] = 0x6c;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_LE_HOST_SUPPORTED command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param le_supported_host
+ * @param simultaneous_le_host
+ * @return size of command packet
+ * @note: opcode 0x0c6d, format string "11"
+ */
+static inline uint16_t hci_cmd_encode_write_le_host_supported(uint8_t * buffer, uint8_t le_supported_host, uint8_t simultaneous_le_host){
+    buffer[0] = 0x6d;
+    buffer[1] = 0x0c;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) le_supported_host;
+    buffer[4] = (uint8_t) simultaneous_le_host;
+    return 5;
+}
+
+/**
+ * @brief Create HCI_WRITE_SECURE_CONNECTIONS_HOST_SUPPORT command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param secure_connections_host_support
+ * @return size of command packet
+ * @note: opcode 0x0c7a, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_secure_connections_host_support(uint8_t * buffer, uint8_t secure_connections_host_support){
+    buffer[0] = 0x7a;
+    buffer[1] = 0x0c;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) secure_connections_host_support;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_READ_LOCAL_EXTENDED_OB_DATA command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x0c7d, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_local_extended_ob_data(uint8_t * buffer){
+    buffer[0] = 0x7d;
+    buffer[1] = 0x0c;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_READ_LOOPBACK_MODE command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x1801, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_loopback_mode(uint8_t * buffer){
+    buffer[0] = 0x01;
+    buffer[1] = 0x18;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_LOOPBACK_MODE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param loopback_mode
+ * @return size of command packet
+ * @note: opcode 0x1802, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_loopback_mode(uint8_t * buffer, uint8_t loopback_mode){
+    buffer[0] = 0x02;
+    buffer[1] = 0x18;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) loopback_mode;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_ENABLE_DEVICE_UNDER_TEST_MODE command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x1803, format string ""
+ */
+static inline uint16_t hci_cmd_encode_enable_device_under_test_mode(uint8_t * buffer){
+    buffer[0] = 0x03;
+    buffer[1] = 0x18;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_WRITE_SIMPLE_PAIRING_DEBUG_MODE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param simple_pairing_debug_mode
+ * @return size of command packet
+ * @note: opcode 0x1804, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_write_simple_pairing_debug_mode(uint8_t * buffer, uint8_t simple_pairing_debug_mode){
+    buffer[0] = 0x04;
+    buffer[1] = 0x18;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) simple_pairing_debug_mode;
+    return 4;
+}
+
+/**
+ * @brief Create HCI_WRITE_SECURE_CONNECTIONS_TEST_MODE command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param handle
+ * @param dm1_acl_u_mode
+ * @param esco_loopback_mode
+ * @return size of command packet
+ * @note: opcode 0x180a, format string "H11"
+ */
+static inline uint16_t hci_cmd_encode_write_secure_connections_test_mode(uint8_t * buffer, hci_con_handle_t handle, uint8_t dm1_acl_u_mode, uint8_t esco_loopback_mode){
+    buffer[0] = 0x0a;
+    buffer[1] = 0x18;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    buffer[5] = (uint8_t) dm1_acl_u_mode;
+    buffer[6] = (uint8_t) esco_loopback_mode;
+    return 7;
+}
+
+/**
+ * @brief Create HCI_READ_LOCAL_VERSION_INFORMATION command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x1001, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_local_version_information(uint8_t * buffer){
+    buffer[0] = 0x01;
+    buffer[1] = 0x10;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_READ_LOCAL_SUPPORTED_COMMANDS command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x1002, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_local_supported_commands(uint8_t * buffer){
+    buffer[0] = 0x02;
+    buffer[1] = 0x10;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_READ_LOCAL_SUPPORTED_FEATURES command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x1003, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_local_supported_features(uint8_t * buffer){
+    buffer[0] = 0x03;
+    buffer[1] = 0x10;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_READ_BUFFER_SIZE command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x1005, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_buffer_size(uint8_t * buffer){
+    buffer[0] = 0x05;
+    buffer[1] = 0x10;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_READ_BD_ADDR command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x1009, format string ""
+ */
+static inline uint16_t hci_cmd_encode_read_bd_addr(uint8_t * buffer){
+    buffer[0] = 0x09;
+    buffer[1] = 0x10;
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create HCI_READ_RSSI command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x1405, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_read_rssi(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x05;
+    buffer[1] = 0x14;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+/**
+ * @brief Create HCI_READ_ENCRYPTION_KEY_SIZE command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param handle
+ * @return size of command packet
+ * @note: opcode 0x1408, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_read_encryption_key_size(uint8_t * buffer, hci_con_handle_t handle){
+    buffer[0] = 0x08;
+    buffer[1] = 0x14;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) handle;
+    buffer[4] = (uint8_t) (handle >> 8);
+    return 5;
+}
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_EVENT_MASK command packet
+ * @param buffer for command packet, at least 11 bytes
+ * @param event_mask_lower_octets
+ * @param event_mask_higher_octets
+ * @return size of command packet
+ * @note: opcode 0x2001, format string "44"
+ */
+static inline uint16_t hci_cmd_encode_le_set_event_mask(uint8_t * buffer, uint32_t event_mask_lower_octets, uint32_t event_mask_higher_octets){
+    buffer[0] = 0x01;
+    buffer[1] = 0x20;
+    buffer[2] = 8;
+    buffer[3] = (uint8_t) event_mask_lower_octets;
+    buffer[4] = (uint8_t) (event_mask_lower_octets >> 8);
+    buffer[5] = (uint8_t) (event_mask_lower_octets >> 16);
+    buffer[6] = (uint8_t) (event_mask_lower_octets >> 24);
+    buffer[7] = (uint8_t) event_mask_higher_octets;
+    buffer[8] = (uint8_t) (event_mask_higher_octets >> 8);
+    buffer[9] = (uint8_t) (event_mask_higher_octets >> 16);
+    buffer[10] = (uint8_t) (event_mask_higher_octets >> 24);
+    return 11;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_BUFFER_SIZE command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x2002, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_read_buffer_size(uint8_t * buffer){
+    buffer[0] = 0x02;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_SUPPORTED_FEATURES command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x2003, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_read_supported_features(uint8_t * buffer){
+    buffer[0] = 0x03;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_RANDOM_ADDRESS command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param random_bd_addr
+ * @return size of command packet
+ * @note: opcode 0x2005, format string "B"
+ */
+static inline uint16_t hci_cmd_encode_le_set_random_address(uint8_t * buffer, const bd_addr_t random_bd_addr){
+    buffer[0] = 0x05;
+    buffer[1] = 0x20;
+    buffer[2] = 6;
+    buffer[3] = random_bd_addr[5];
+    buffer[4] = random_bd_addr[4];
+    buffer[5] = random_bd_addr[3];
+    buffer[6] = random_bd_addr[2];
+    buffer[7] = random_bd_addr[1];
+    buffer[8] = random_bd_addr[0];
+    return 9;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_ADVERTISING_PARAMETERS command packet
+ * @param buffer for command packet, at least 18 bytes
+ * @param advertising_interval_min
+ * @param advertising_interval_max
+ * @param advertising_type
+ * @param own_address_type
+ * @param direct_address_type
+ * @param direct_address
+ * @param advertising_channel_map
+ * @param advertising_filter_policy
+ * @return size of command packet
+ * @note: opcode 0x2006, format string "22111B11"
+ */
+static inline uint16_t hci_cmd_encode_le_set_advertising_parameters(uint8_t * buffer, uint16_t advertising_interval_min, uint16_t advertising_interval_max, uint8_t advertising_type, uint8_t own_address_type, uint8_t direct_address_type, const bd_addr_t direct_address, uint8_t advertising_channel_map, uint8_t advertising_filter_policy){
+    buffer[0] = 0x06;
+    buffer[1] = 0x20;
+    buffer[2] = 15;
+    buffer[3] = (uint8_t) advertising_interval_min;
+    buffer[4] = (uint8_t) (advertising_interval_min >> 8);
+    buffer[5] = (uint8_t) advertising_interval_max;
+    buffer[6] = (uint8_t) (advertising_interval_max >> 8);
+    buffer[7] = (uint8_t) advertising_type;
+    buffer[8] = (uint8_t) own_address_type;
+    buffer[9] = (uint8_t) direct_address_type;
+    buffer[10] = direct_address[5];
+    buffer[11] = direct_address[4];
+    buffer[12] = direct_address[3];
+    buffer[13] = direct_address[2];
+    buffer[14] = direct_address[1];
+    buffer[15] = direct_address[0];
+    buffer[16] = (uint8_t) advertising_channel_map;
+    buffer[17] = (uint8_t) advertising_filter_policy;
+    return 18;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_ADVERTISING_CHANNEL_TX_POWER command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x2007, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_read_advertising_channel_tx_power(uint8_t * buffer){
+    buffer[0] = 0x07;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_ADVERTISING_DATA command packet
+ * @param buffer for command packet, at least 35 bytes
+ * @param advertising_data_length
+ * @param advertising_data
+ * @return size of command packet
+ * @note: opcode 0x2008, format string "1A"
+ */
+static inline uint16_t hci_cmd_encode_le_set_advertising_data(uint8_t * buffer, uint8_t advertising_data_length, const uint8_t * advertising_data){
+    buffer[0] = 0x08;
+    buffer[1] = 0x20;
+    buffer[2] = 32;
+    buffer[3] = (uint8_t) advertising_data_length;
+    (void)memcpy(&buffer[4], advertising_data, 31);
+    return 35;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_SCAN_RESPONSE_DATA command packet
+ * @param buffer for command packet, at least 35 bytes
+ * @param scan_response_data_length
+ * @param scan_response_data
+ * @return size of command packet
+ * @note: opcode 0x2009, format string "1A"
+ */
+static inline uint16_t hci_cmd_encode_le_set_scan_response_data(uint8_t * buffer, uint8_t scan_response_data_length, const uint8_t * scan_response_data){
+    buffer[0] = 0x09;
+    buffer[1] = 0x20;
+    buffer[2] = 32;
+    buffer[3] = (uint8_t) scan_response_data_length;
+    (void)memcpy(&buffer[4], scan_response_data, 31);
+    return 35;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_ADVERTISE_ENABLE command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param advertise_enable
+ * @return size of command packet
+ * @note: opcode 0x200a, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_le_set_advertise_enable(uint8_t * buffer, uint8_t advertise_enable){
+    buffer[0] = 0x0a;
+    buffer[1] = 0x20;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) advertise_enable;
+    return 4;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_SCAN_PARAMETERS command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param le_scan_type
+ * @param le_scan_interval
+ * @param le_scan_window
+ * @param own_address_type
+ * @param scanning_filter_policy
+ * @return size of command packet
+ * @note: opcode 0x200b, format string "12211"
+ */
+static inline uint16_t hci_cmd_encode_le_set_scan_parameters(uint8_t * buffer, uint8_t le_scan_type, uint16_t le_scan_interval, uint16_t le_scan_window, uint8_t own_address_type, uint8_t scanning_filter_policy){
+    buffer[0] = 0x0b;
+    buffer[1] = 0x20;
+    buffer[2] = 7;
+    buffer[3] = (uint8_t) le_scan_type;
+    buffer[4] = (uint8_t) le_scan_interval;
+    buffer[5] = (uint8_t) (le_scan_interval >> 8);
+    buffer[6] = (uint8_t) le_scan_window;
+    buffer[7] = (uint8_t) (le_scan_window >> 8);
+    buffer[8] = (uint8_t) own_address_type;
+    buffer[9] = (uint8_t) scanning_filter_policy;
+    return 10;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_SCAN_ENABLE command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param le_scan_enable
+ * @param filter_duplices
+ * @return size of command packet
+ * @note: opcode 0x200c, format string "11"
+ */
+static inline uint16_t hci_cmd_encode_le_set_scan_enable(uint8_t * buffer, uint8_t le_scan_enable, uint8_t filter_duplices){
+    buffer[0] = 0x0c;
+    buffer[1] = 0x20;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) le_scan_enable;
+    buffer[4] = (uint8_t) filter_duplices;
+    return 5;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_CREATE_CONNECTION command packet
+ * @param buffer for command packet, at least 28 bytes
+ * @param le_scan_interval
+ * @param le_scan_window
+ * @param initiator_filter_policy
+ * @param peer_address_type
+ * @param peer_address
+ * @param own_address_type
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param minimum_ce_length
+ * @param maximum_ce_length
+ * @return size of command packet
+ * @note: opcode 0x200d, format string "2211B1222222"
+ */
+static inline uint16_t hci_cmd_encode_le_create_connection(uint8_t * buffer, uint16_t le_scan_interval, uint16_t le_scan_window, uint8_t initiator_filter_policy, uint8_t peer_address_type, const bd_addr_t peer_address, uint8_t own_address_type, uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout, uint16_t minimum_ce_length, uint16_t maximum_ce_length){
+    buffer[0] = 0x0d;
+    buffer[1] = 0x20;
+    buffer[2] = 25;
+    buffer[3] = (uint8_t) le_scan_interval;
+    buffer[4] = (uint8_t) (le_scan_interval >> 8);
+    buffer[5] = (uint8_t) le_scan_window;
+    buffer[6] = (uint8_t) (le_scan_window >> 8);
+    buffer[7] = (uint8_t) initiator_filter_policy;
+    buffer[8] = (uint8_t) peer_address_type;
+    buffer[9] = peer_address[5];
+    buffer[10] = peer_address[4];
+    buffer[11] = peer_address[3];
+    buffer[12] = peer_address[2];
+    buffer[13] = peer_address[1];
+    buffer[14] = peer_address[0];
+    buffer[15] = (uint8_t) own_address_type;
+    buffer[16] = (uint8_t) conn_interval_min;
+    buffer[17] = (uint8_t) (conn_interval_min >> 8);
+    buffer[18] = (uint8_t) conn_interval_max;
+    buffer[19] = (uint8_t) (conn_interval_max >> 8);
+    buffer[20] = (uint8_t) conn_latency;
+    buffer[21] = (uint8_t) (conn_latency >> 8);
+    buffer[22] = (uint8_t) supervision_timeout;
+    buffer[23] = (uint8_t) (supervision_timeout >> 8);
+    buffer[24] = (uint8_t) minimum_ce_length;
+    buffer[25] = (uint8_t) (minimum_ce_length >> 8);
+    buffer[26] = (uint8_t) maximum_ce_length;
+    buffer[27] = (uint8_t) (maximum_ce_length >> 8);
+    return 28;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_CREATE_CONNECTION_CANCEL command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x200e, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_create_connection_cancel(uint8_t * buffer){
+    buffer[0] = 0x0e;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_WHITE_LIST_SIZE command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x200f, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_read_white_list_size(uint8_t * buffer){
+    buffer[0] = 0x0f;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_CLEAR_WHITE_LIST command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x2010, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_clear_white_list(uint8_t * buffer){
+    buffer[0] = 0x10;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_ADD_DEVICE_TO_WHITE_LIST command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param address_type
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x2011, format string "1B"
+ */
+static inline uint16_t hci_cmd_encode_le_add_device_to_white_list(uint8_t * buffer, uint8_t address_type, const bd_addr_t bd_addr){
+    buffer[0] = 0x11;
+    buffer[1] = 0x20;
+    buffer[2] = 7;
+    buffer[3] = (uint8_t) address_type;
+    buffer[4] = bd_addr[5];
+    buffer[5] = bd_addr[4];
+    buffer[6] = bd_addr[3];
+    buffer[7] = bd_addr[2];
+    buffer[8] = bd_addr[1];
+    buffer[9] = bd_addr[0];
+    return 10;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_REMOVE_DEVICE_FROM_WHITE_LIST command packet
+ * @param buffer for command packet, at least 10 bytes
+ * @param address_type
+ * @param bd_addr
+ * @return size of command packet
+ * @note: opcode 0x2012, format string "1B"
+ */
+static inline uint16_t hci_cmd_encode_le_remove_device_from_white_list(uint8_t * buffer, uint8_t address_type, const bd_addr_t bd_addr){
+    buffer[0] = 0x12;
+    buffer[1] = 0x20;
+    buffer[2] = 7;
+    buffer[3] = (uint8_t) address_type;
+    buffer[4] = bd_addr[5];
+    buffer[5] = bd_addr[4];
+    buffer[6] = bd_addr[3];
+    buffer[7] = bd_addr[2];
+    buffer[8] = bd_addr[1];
+    buffer[9] = bd_addr[0];
+    return 10;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_CONNECTION_UPDATE command packet
+ * @param buffer for command packet, at least 17 bytes
+ * @param conn_handle
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param minimum_ce_length
+ * @param maximum_ce_length
+ * @return size of command packet
+ * @note: opcode 0x2013, format string "H222222"
+ */
+static inline uint16_t hci_cmd_encode_le_connection_update(uint8_t * buffer, hci_con_handle_t conn_handle, uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout, uint16_t minimum_ce_length, uint16_t maximum_ce_length){
+    buffer[0] = 0x13;
+    buffer[1] = 0x20;
+    buffer[2] = 14;
+    buffer[3] = (uint8_t) conn_handle;
+    buffer[4] = (uint8_t) (conn_handle >> 8);
+    buffer[5] = (uint8_t) conn_interval_min;
+    buffer[6] = (uint8_t) (conn_interval_min >> 8);
+    buffer[7] = (uint8_t) conn_interval_max;
+    buffer[8] = (uint8_t) (conn_interval_max >> 8);
+    buffer[9] = (uint8_t) conn_latency;
+    buffer[10] = (uint8_t) (conn_latency >> 8);
+    buffer[11] = (uint8_t) supervision_timeout;
+    buffer[12] = (uint8_t) (supervision_timeout >> 8);
+    buffer[13] = (uint8_t) minimum_ce_length;
+    buffer[14] = (uint8_t) (minimum_ce_length >> 8);
+    buffer[15] = (uint8_t) maximum_ce_length;
+    buffer[16] = (uint8_t) (maximum_ce_length >> 8);
+    return 17;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_HOST_CHANNEL_CLASSIFICATION command packet
+ * @param buffer for command packet, at least 8 bytes
+ * @param channel_map_lower_32bits
+ * @param channel_map_higher_5bits
+ * @return size of command packet
+ * @note: opcode 0x2014, format string "41"
+ */
+static inline uint16_t hci_cmd_encode_le_set_host_channel_classification(uint8_t * buffer, uint32_t channel_map_lower_32bits, uint8_t channel_map_higher_5bits){
+    buffer[0] = 0x14;
+    buffer[1] = 0x20;
+    buffer[2] = 5;
+    buffer[3] = (uint8_t) channel_map_lower_32bits;
+    buffer[4] = (uint8_t) (channel_map_lower_32bits >> 8);
+    buffer[5] = (uint8_t) (channel_map_lower_32bits >> 16);
+    buffer[6] = (uint8_t) (channel_map_lower_32bits >> 24);
+    buffer[7] = (uint8_t) channel_map_higher_5bits;
+    return 8;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_CHANNEL_MAP command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param conn_handle
+ * @return size of command packet
+ * @note: opcode 0x2015, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_le_read_channel_map(uint8_t * buffer, hci_con_handle_t conn_handle){
+    buffer[0] = 0x15;
+    buffer[1] = 0x20;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) conn_handle;
+    buffer[4] = (uint8_t) (conn_handle >> 8);
+    return 5;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_REMOTE_USED_FEATURES command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param conn_handle
+ * @return size of command packet
+ * @note: opcode 0x2016, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_le_read_remote_used_features(uint8_t * buffer, hci_con_handle_t conn_handle){
+    buffer[0] = 0x16;
+    buffer[1] = 0x20;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) conn_handle;
+    buffer[4] = (uint8_t) (conn_handle >> 8);
+    return 5;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_ENCRYPT command packet
+ * @param buffer for command packet, at least 35 bytes
+ * @param key
+ * @param plain_text
+ * @return size of command packet
+ * @note: opcode 0x2017, format string "PP"
+ */
+static inline uint16_t hci_cmd_encode_le_encrypt(uint8_t * buffer, const uint8_t * key, const uint8_t * plain_text){
+    buffer[0] = 0x17;
+    buffer[1] = 0x20;
+    buffer[2] = 32;
+    (void)memcpy(&buffer[3], key, 16);
+    (void)memcpy(&buffer[19], plain_text, 16);
+    return 35;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_RAND command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x2018, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_rand(uint8_t * buffer){
+    buffer[0] = 0x18;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_START_ENCRYPTION command packet
+ * @param buffer for command packet, at least 31 bytes
+ * @param conn_handle
+ * @param random_number_lower_32bits
+ * @param random_number_higher_32bits
+ * @param encryption_diversifier
+ * @param long_term_key
+ * @return size of command packet
+ * @note: opcode 0x2019, format string "H442P"
+ */
+static inline uint16_t hci_cmd_encode_le_start_encryption(uint8_t * buffer, hci_con_handle_t conn_handle, uint32_t random_number_lower_32bits, uint32_t random_number_higher_32bits, uint16_t encryption_diversifier, const uint8_t * long_term_key){
+    buffer[0] = 0x19;
+    buffer[1] = 0x20;
+    buffer[2] = 28;
+    buffer[3] = (uint8_t) conn_handle;
+    buffer[4] = (uint8_t) (conn_handle >> 8);
+    buffer[5] = (uint8_t) random_number_lower_32bits;
+    buffer[6] = (uint8_t) (random_number_lower_32bits >> 8);
+    buffer[7] = (uint8_t) (random_number_lower_32bits >> 16);
+    buffer[8] = (uint8_t) (random_number_lower_32bits >> 24);
+    buffer[9] = (uint8_t) random_number_higher_32bits;
+    buffer[10] = (uint8_t) (random_number_higher_32bits >> 8);
+    buffer[11] = (uint8_t) (random_number_higher_32bits >> 16);
+    buffer[12] = (uint8_t) (random_number_higher_32bits >> 24);
+    buffer[13] = (uint8_t) encryption_diversifier;
+    buffer[14] = (uint8_t) (encryption_diversifier >> 8);
+    (void)memcpy(&buffer[15], long_term_key, 16);
+    return 31;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_LONG_TERM_KEY_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 21 bytes
+ * @param connection_handle
+ * @param long_term_key
+ * @return size of command packet
+ * @note: opcode 0x201a, format string "HP"
+ */
+static inline uint16_t hci_cmd_encode_le_long_term_key_request_reply(uint8_t * buffer, hci_con_handle_t connection_handle, const uint8_t * long_term_key){
+    buffer[0] = 0x1a;
+    buffer[1] = 0x20;
+    buffer[2] = 18;
+    buffer[3] = (uint8_t) connection_handle;
+    buffer[4] = (uint8_t) (connection_handle >> 8);
+    (void)memcpy(&buffer[5], long_term_key, 16);
+    return 21;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_LONG_TERM_KEY_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param conn_handle
+ * @return size of command packet
+ * @note: opcode 0x201b, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_le_long_term_key_negative_reply(uint8_t * buffer, hci_con_handle_t conn_handle){
+    buffer[0] = 0x1b;
+    buffer[1] = 0x20;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) conn_handle;
+    buffer[4] = (uint8_t) (conn_handle >> 8);
+    return 5;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_SUPPORTED_STATES command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param conn_handle
+ * @return size of command packet
+ * @note: opcode 0x201c, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_le_read_supported_states(uint8_t * buffer, hci_con_handle_t conn_handle){
+    buffer[0] = 0x1c;
+    buffer[1] = 0x20;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) conn_handle;
+    buffer[4] = (uint8_t) (conn_handle >> 8);
+    return 5;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_RECEIVER_TEST command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param rx_frequency
+ * @return size of command packet
+ * @note: opcode 0x201d, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_le_receiver_test(uint8_t * buffer, uint8_t rx_frequency){
+    buffer[0] = 0x1d;
+    buffer[1] = 0x20;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) rx_frequency;
+    return 4;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_TRANSMITTER_TEST command packet
+ * @param buffer for command packet, at least 6 bytes
+ * @param tx_frequency
+ * @param test_payload_lengh
+ * @param packet_payload
+ * @return size of command packet
+ * @note: opcode 0x201e, format string "111"
+ */
+static inline uint16_t hci_cmd_encode_le_transmitter_test(uint8_t * buffer, uint8_t tx_frequency, uint8_t test_payload_lengh, uint8_t packet_payload){
+    buffer[0] = 0x1e;
+    buffer[1] = 0x20;
+    buffer[2] = 3;
+    buffer[3] = (uint8_t) tx_frequency;
+    buffer[4] = (uint8_t) test_payload_lengh;
+    buffer[5] = (uint8_t) packet_payload;
+    return 6;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_TEST_END command packet
+ * @param buffer for command packet, at least 4 bytes
+ * @param end_test_cmd
+ * @return size of command packet
+ * @note: opcode 0x201f, format string "1"
+ */
+static inline uint16_t hci_cmd_encode_le_test_end(uint8_t * buffer, uint8_t end_test_cmd){
+    buffer[0] = 0x1f;
+    buffer[1] = 0x20;
+    buffer[2] = 1;
+    buffer[3] = (uint8_t) end_test_cmd;
+    return 4;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_REMOTE_CONNECTION_PARAMETER_REQUEST_REPLY command packet
+ * @param buffer for command packet, at least 17 bytes
+ * @param conn_handle
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param minimum_ce_length
+ * @param maximum_ce_length
+ * @return size of command packet
+ * @note: opcode 0x2020, format string "H222222"
+ */
+static inline uint16_t hci_cmd_encode_le_remote_connection_parameter_request_reply(uint8_t * buffer, hci_con_handle_t conn_handle, uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout, uint16_t minimum_ce_length, uint16_t maximum_ce_length){
+    buffer[0] = 0x20;
+    buffer[1] = 0x20;
+    buffer[2] = 14;
+    buffer[3] = (uint8_t) conn_handle;
+    buffer[4] = (uint8_t) (conn_handle >> 8);
+    buffer[5] = (uint8_t) conn_interval_min;
+    buffer[6] = (uint8_t) (conn_interval_min >> 8);
+    buffer[7] = (uint8_t) conn_interval_max;
+    buffer[8] = (uint8_t) (conn_interval_max >> 8);
+    buffer[9] = (uint8_t) conn_latency;
+    buffer[10] = (uint8_t) (conn_latency >> 8);
+    buffer[11] = (uint8_t) supervision_timeout;
+    buffer[12] = (uint8_t) (supervision_timeout >> 8);
+    buffer[13] = (uint8_t) minimum_ce_length;
+    buffer[14] = (uint8_t) (minimum_ce_length >> 8);
+    buffer[15] = (uint8_t) maximum_ce_length;
+    buffer[16] = (uint8_t) (maximum_ce_length >> 8);
+    return 17;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_REMOTE_CONNECTION_PARAMETER_REQUEST_NEGATIVE_REPLY command packet
+ * @param buffer for command packet, at least 6 bytes
+ * @param con_handle
+ * @param reason
+ * @return size of command packet
+ * @note: opcode 0x2021, format string "H1"
+ */
+static inline uint16_t hci_cmd_encode_le_remote_connection_parameter_request_negative_reply(uint8_t * buffer, hci_con_handle_t con_handle, uint8_t reason){
+    buffer[0] = 0x21;
+    buffer[1] = 0x20;
+    buffer[2] = 3;
+    buffer[3] = (uint8_t) con_handle;
+    buffer[4] = (uint8_t) (con_handle >> 8);
+    buffer[5] = (uint8_t) reason;
+    return 6;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_DATA_LENGTH command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param con_handle
+ * @param tx_octets
+ * @param tx_time
+ * @return size of command packet
+ * @note: opcode 0x2022, format string "H22"
+ */
+static inline uint16_t hci_cmd_encode_le_set_data_length(uint8_t * buffer, hci_con_handle_t con_handle, uint16_t tx_octets, uint16_t tx_time){
+    buffer[0] = 0x22;
+    buffer[1] = 0x20;
+    buffer[2] = 6;
+    buffer[3] = (uint8_t) con_handle;
+    buffer[4] = (uint8_t) (con_handle >> 8);
+    buffer[5] = (uint8_t) tx_octets;
+    buffer[6] = (uint8_t) (tx_octets >> 8);
+    buffer[7] = (uint8_t) tx_time;
+    buffer[8] = (uint8_t) (tx_time >> 8);
+    return 9;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_SUGGESTED_DEFAULT_DATA_LENGTH command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x2023, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_read_suggested_default_data_length(uint8_t * buffer){
+    buffer[0] = 0x23;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_WRITE_SUGGESTED_DEFAULT_DATA_LENGTH command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param suggested_max_tx_octets
+ * @param suggested_max_tx_time
+ * @return size of command packet
+ * @note: opcode 0x2024, format string "22"
+ */
+static inline uint16_t hci_cmd_encode_le_write_suggested_default_data_length(uint8_t * buffer, uint16_t suggested_max_tx_octets, uint16_t suggested_max_tx_time){
+    buffer[0] = 0x24;
+    buffer[1] = 0x20;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) suggested_max_tx_octets;
+    buffer[4] = (uint8_t) (suggested_max_tx_octets >> 8);
+    buffer[5] = (uint8_t) suggested_max_tx_time;
+    buffer[6] = (uint8_t) (suggested_max_tx_time >> 8);
+    return 7;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_LOCAL_P256_PUBLIC_KEY command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x2025, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_read_local_p256_public_key(uint8_t * buffer){
+    buffer[0] = 0x25;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_GENERATE_DHKEY command packet
+ * @param buffer for command packet, at least 67 bytes
+ * @param public
+ * @param private
+ * @return size of command packet
+ * @note: opcode 0x2026, format string "QQ"
+ */
+static inline uint16_t hci_cmd_encode_le_generate_dhkey(uint8_t * buffer, const uint8_t * public, const uint8_t * private){
+    buffer[0] = 0x26;
+    buffer[1] = 0x20;
+    buffer[2] = 64;
+    reverse_bytes(public, &buffer[3], 32);
+    reverse_bytes(private, &buffer[35], 32);
+    return 67;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_MAXIMUM_DATA_LENGTH command packet
+ * @param buffer for command packet, at least 3 bytes
+ * @return size of command packet
+ * @note: opcode 0x202f, format string ""
+ */
+static inline uint16_t hci_cmd_encode_le_read_maximum_data_length(uint8_t * buffer){
+    buffer[0] = 0x2f;
+    buffer[1] = 0x20;
+    buffer[2] = 0;
+    return 3;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_READ_PHY command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param con_handle
+ * @return size of command packet
+ * @note: opcode 0x2030, format string "H"
+ */
+static inline uint16_t hci_cmd_encode_le_read_phy(uint8_t * buffer, hci_con_handle_t con_handle){
+    buffer[0] = 0x30;
+    buffer[1] = 0x20;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) con_handle;
+    buffer[4] = (uint8_t) (con_handle >> 8);
+    return 5;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_DEFAULT_PHY command packet
+ * @param buffer for command packet, at least 6 bytes
+ * @param all_phys
+ * @param tx_phys
+ * @param rx_phys
+ * @return size of command packet
+ * @note: opcode 0x2031, format string "111"
+ */
+static inline uint16_t hci_cmd_encode_le_set_default_phy(uint8_t * buffer, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys){
+    buffer[0] = 0x31;
+    buffer[1] = 0x20;
+    buffer[2] = 3;
+    buffer[3] = (uint8_t) all_phys;
+    buffer[4] = (uint8_t) tx_phys;
+    buffer[5] = (uint8_t) rx_phys;
+    return 6;
+}
+#endif
+
+#if defined(ENABLE_BLE)
+/**
+ * @brief Create HCI_LE_SET_PHY command packet
+ * @param buffer for command packet, at least 9 bytes
+ * @param con_handle
+ * @param all_phys
+ * @param tx_phys
+ * @param rx_phys
+ * @param phy_options
+ * @return size of command packet
+ * @note: opcode 0x2032, format string "H1111"
+ */
+static inline uint16_t hci_cmd_encode_le_set_phy(uint8_t * buffer, hci_con_handle_t con_handle, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys, uint8_t phy_options){
+    buffer[0] = 0x32;
+    buffer[1] = 0x20;
+    buffer[2] = 6;
+    buffer[3] = (uint8_t) con_handle;
+    buffer[4] = (uint8_t) (con_handle >> 8);
+    buffer[5] = (uint8_t) all_phys;
+    buffer[6] = (uint8_t) tx_phys;
+    buffer[7] = (uint8_t) rx_phys;
+    buffer[8] = (uint8_t) phy_options;
+    return 9;
+}
+#endif
+
+/**
+ * @brief Create HCI_BCM_WRITE_SCO_PCM_INT command packet
+ * @param buffer for command packet, at least 8 bytes
+ * @param sco_routing
+ * @param pcm_interface_rate
+ * @param frame_type
+ * @param sync_mode
+ * @param clock_mode
+ * @return size of command packet
+ * @note: opcode 0xfc1c, format string "11111"
+ */
+static inline uint16_t hci_cmd_encode_bcm_write_sco_pcm_int(uint8_t * buffer, uint8_t sco_routing, uint8_t pcm_interface_rate, uint8_t frame_type, uint8_t sync_mode, uint8_t clock_mode){
+    buffer[0] = 0x1c;
+    buffer[1] = 0xfc;
+    buffer[2] = 5;
+    buffer[3] = (uint8_t) sco_routing;
+    buffer[4] = (uint8_t) pcm_interface_rate;
+    buffer[5] = (uint8_t) frame_type;
+    buffer[6] = (uint8_t) sync_mode;
+    buffer[7] = (uint8_t) clock_mode;
+    return 8;
+}
+
+/**
+ * @brief Create HCI_BCM_SET_SLEEP_MODE command packet
+ * @param buffer for command packet, at least 15 bytes
+ * @param sleep_mode
+ * @param idle_threshold_host
+ * @param idle_threshold_controller
+ * @param bt_wake_active_mode
+ * @param host_wake_active_mode
+ * @param allow_host_sleep_during_sco
+ * @param combine_sleep_mode_and_lpm
+ * @param enable_tristate_control_of_uart_tx_line
+ * @param active_connection_handling_on_suspend
+ * @param resume_timeout
+ * @param enable_break_to_host
+ * @param pulsed_host_wake
+ * @return size of command packet
+ * @note: opcode 0xfc27, format string "111111111111"
+ */
+static inline uint16_t hci_cmd_encode_bcm_set_sleep_mode(uint8_t * buffer, uint8_t sleep_mode, uint8_t idle_threshold_host, uint8_t idle_threshold_controller, uint8_t bt_wake_active_mode, uint8_t host_wake_active_mode, uint8_t allow_host_sleep_during_sco, uint8_t combine_sleep_mode_and_lpm, uint8_t enable_tristate_control_of_uart_tx_line, uint8_t active_connection_handling_on_suspend, uint8_t resume_timeout, uint8_t enable_break_to_host, uint8_t pulsed_host_wake){
+    buffer[0] = 0x27;
+    buffer[1] = 0xfc;
+    buffer[2] = 12;
+    buffer[3] = (uint8_t) sleep_mode;
+    buffer[4] = (uint8_t) idle_threshold_host;
+    buffer[5] = (uint8_t) idle_threshold_controller;
+    buffer[6] = (uint8_t) bt_wake_active_mode;
+    buffer[7] = (uint8_t) host_wake_active_mode;
+    buffer[8] = (uint8_t) allow_host_sleep_during_sco;
+    buffer[9] = (uint8_t) combine_sleep_mode_and_lpm;
+    buffer[10] = (uint8_t) enable_tristate_control_of_uart_tx_line;
+    buffer[11] = (uint8_t) active_connection_handling_on_suspend;
+    buffer[12] = (uint8_t) resume_timeout;
+    buffer[13] = (uint8_t) enable_break_to_host;
+    buffer[14] = (uint8_t) pulsed_host_wake;
+    return 15;
+}
+
+/**
+ * @brief Create HCI_BCM_WRITE_TX_POWER_TABLE command packet
+ * @param buffer for command packet, at least 5 bytes
+ * @param is_le
+ * @param chip_max_tx_pwr_db
+ * @return size of command packet
+ * @note: opcode 0xfdc9, format string "11"
+ */
+static inline uint16_t hci_cmd_encode_bcm_write_tx_power_table(uint8_t * buffer, uint8_t is_le, uint8_t chip_max_tx_pwr_db){
+    buffer[0] = 0xc9;
+    buffer[1] = 0xfd;
+    buffer[2] = 2;
+    buffer[3] = (uint8_t) is_le;
+    buffer[4] = (uint8_t) chip_max_tx_pwr_db;
+    return 5;
+}
+
+/**
+ * @brief Create HCI_BCM_SET_TX_PWR command packet
+ * @param buffer for command packet, at least 7 bytes
+ * @param arg1
+ * @param arg2
+ * @param arg3
+ * @return size of command packet
+ * @note: opcode 0xfda5, format string "11H"
+ */
+static inline uint16_t hci_cmd_encode_bcm_set_tx_pwr(uint8_t * buffer, uint8_t arg1, uint8_t arg2, hci_con_handle_t arg3){
+    buffer[0] = 0xa5;
+    buffer[1] = 0xfd;
+    buffer[2] = 4;
+    buffer[3] = (uint8_t) arg1;
+    buffer[4] = (uint8_t) arg2;
+    buffer[5] = (uint8_t) arg3;
+    buffer[6] = (uint8_t) (arg3 >> 8);
+    return 7;
+}
+
+/**
+ * @brief Create HCI_TI_DRPB_TESTER_CON_TX command packet
+ * @param buffer for command packet, at least 15 bytes
+ * @param modulation
+ * @param test_patern
+ * @param frequency
+ * @param power_level
+ * @param reserved1
+ * @param reserved2
+ * @return size of command packet
+ * @note: opcode 0xfd84, format string "111144"
+ */
+static inline uint16_t hci_cmd_encode_ti_drpb_tester_con_tx(uint8_t * buffer, uint8_t modulation, uint8_t test_patern, uint8_t frequency, uint8_t power_level, uint32_t reserved1, uint32_t reserved2){
+    buffer[0] = 0x84;
+    buffer[1] = 0xfd;
+    buffer[2] = 12;
+    buffer[3] = (uint8_t) modulation;
+    buffer[4] = (uint8_t) test_patern;
+    buffer[5] = (uint8_t) frequency;
+    buffer[6] = (uint8_t) power_level;
+    buffer[7] = (uint8_t) reserved1;
+    buffer[8] = (uint8_t) (reserved1 >> 8);
+    buffer[9] = (uint8_t) (reserved1 >> 16);
+    buffer[10] = (uint8_t) (reserved1 >> 24);
+    buffer[11] = (uint8_t) reserved2;
+    buffer[12] = (uint8_t) (reserved2 >> 8);
+    buffer[13] = (uint8_t) (reserved2 >> 16);
+    buffer[14] = (uint8_t) (reserved2 >> 24);
+    return 15;
+}
+
+/**
+ * @brief Create HCI_TI_DRPB_TESTER_PACKET_TX_RX command packet
+ * @param buffer for command packet, at least 15 bytes
+ * @param arg1
+ * @param arg2
+ * @param arg3
+ * @param arg4
+ * @param arg5
+ * @param arg6
+ * @param arg7
+ * @param arg8
+ * @param arg9
+ * @param arg10
+ * @return size of command packet
+ * @note: opcode 0xfd85, format string "1111112112"
+ */
+static inline uint16_t hci_cmd_encode_ti_drpb_tester_packet_tx_rx(uint8_t * buffer, uint8_t arg1, uint8_t arg2, uint8_t arg3, uint8_t arg4, uint8_t arg5, uint8_t arg6, uint16_t arg7, uint8_t arg8, uint8_t arg9, uint16_t arg10){
+    buffer[0] = 0x85;
+    buffer[1] = 0xfd;
+    buffer[2] = 12;
+    buffer[3] = (uint8_t) arg1;
+    buffer[4] = (uint8_t) arg2;
+    buffer[5] = (uint8_t) arg3;
+    buffer[6] = (uint8_t) arg4;
+    buffer[7] = (uint8_t) arg5;
+    buffer[8] = (uint8_t) arg6;
+    buffer[9] = (uint8_t) arg7;
+    buffer[10] = (uint8_t) (arg7 >> 8);
+    buffer[11] = (uint8_t) arg8;
+    buffer[12] = (uint8_t) arg9;
+    buffer[13] = (uint8_t) arg10;
+    buffer[14] = (uint8_t) (arg10 >> 8);
+    return 15;
+}
+
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HCI_CMD_ENCODER_H
@@ -46,6 +46,9 @@
  *  - Apple's PacketLogger
  *  - stdout hexdump
  *
+ *  With ENABLE_HCI_DUMP_BUFFERED and HAVE_POSIX_FILE_IO, BlueZ and PacketLogger records are stored in a ring buffer
+ *  and written in large chunks - by a writer thread with HAVE_PTHREAD, or when the buffer is half full otherwise.
+ *
  */
 
 #include "btstack_config.h"
@@ -59,6 +62,7 @@
 #include "hci_cmd.h"
 #include "btstack_run_loop.h"
 #include <stdio.h>
+#include <string.h>
 
 #ifdef HAVE_POSIX_FILE_IO
 #include <fcntl.h>        // open
@@ -68,6 +72,13 @@
 #include <sys/stat.h>     // for mode flags
 #endif
 
+#if defined(ENABLE_HCI_DUMP_BUFFERED) && defined(HAVE_POSIX_FILE_IO)
+#define HCI_DUMP_BUFFERED
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#endif
+
 #include "log.h"
 
 #ifdef ENABLE_SEGGER_RTT
@@ -118,8 +129,54 @@ static int  max_nr_packets = -1;
 static int  nr_packets = 0;
 #endif
 
-#if defined(HAVE_POSIX_FILE_IO) || defined (ENABLE_SEGGER_RTT)
 static char log_message_buffer[256];
+
+// run loop of this instance provides timestamps without HAVE_POSIX_FILE_IO
+static btstack_state_t * hci_dump_btstack;
+
+// flight recorder: most recent records in PacketLogger format, oldest record at tail
+static uint8_t * flight_recorder_buffer;
+static uint32_t  flight_recorder_size;
+static uint32_t  flight_recorder_head;
+static uint32_t  flight_recorder_tail;
+static uint32_t  flight_recorder_used;
+
+#ifdef HCI_DUMP_BUFFERED
+
+#ifndef HCI_DUMP_BUFFER_SIZE
+#define HCI_DUMP_BUFFER_SIZE 16384
+#endif
+
+#if (HCI_DUMP_BUFFER_SIZE & (HCI_DUMP_BUFFER_SIZE - 1)) != 0
+#error "HCI_DUMP_BUFFER_SIZE must be a power of two"
+#endif
+
+// max time records stay in buffer with writer thread
+#ifndef HCI_DUMP_BUFFER_FLUSH_INTERVAL_MS
+#define HCI_DUMP_BUFFER_FLUSH_INTERVAL_MS 100
+#endif
+
+static uint8_t  hci_dump_buffer[HCI_DUMP_BUFFER_SIZE];
+// free running positions, buffer index = position & (HCI_DUMP_BUFFER_SIZE - 1)
+static uint32_t hci_dump_buffer_head;   // next byte to store
+static uint32_t hci_dump_buffer_tail;   // next byte to write to file
+// file is truncated before data at this position gets written
+static uint32_t hci_dump_buffer_truncate_position;
+static int      hci_dump_buffer_truncate_pending;
+static uint32_t hci_dump_buffer_num_dropped;
+static uint32_t hci_dump_buffer_num_dropped_reported;
+static hci_dump_buffer_policy_t hci_dump_buffer_policy = HCI_DUMP_BUFFER_POLICY_DROP;
+
+#ifdef HAVE_PTHREAD
+static pthread_t       hci_dump_writer_thread;
+static pthread_mutex_t hci_dump_buffer_mutex      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  hci_dump_buffer_data_cond  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  hci_dump_buffer_space_cond = PTHREAD_COND_INITIALIZER;
+static int             hci_dump_writer_running;
+static int             hci_dump_writer_stop;
+#endif
+
+static void hci_dump_buffer_open(void);
 #endif
 
 // levels: debug, info, error
@@ -142,6 +199,11 @@ void hci_dump_open(const char *filename, hci_dump_format_t format){
         if (dump_file < 0){
             printf("hci_dump_open: failed to open file %s\n", filename);
         }
+#ifdef HCI_DUMP_BUFFERED
+        else {
+            hci_dump_buffer_open();
+        }
+#endif
     }
 #else
 
@@ -168,6 +230,10 @@ void hci_dump_set_max_packets(int packets){
 }
 #endif
 
+void hci_dump_set_btstack(btstack_state_t * btstack){
+    hci_dump_btstack = btstack;
+}
+
 static void hci_dump_packetlogger_setup_header(uint8_t * buffer, uint32_t tv_sec, uint32_t tv_us, uint8_t packet_type, uint8_t in, uint16_t len){
     big_endian_store_32( buffer, 0, PKTLOG_HDR_SIZE - 4 + len);
     big_endian_store_32( buffer, 4, tv_sec);
@@ -204,6 +270,123 @@ static void hci_dump_bluez_setup_header(uint8_t * buffer, uint32_t tv_sec, uint3
     buffer[12] = packet_type;
 }
 
+#ifndef HAVE_POSIX_FILE_IO
+static uint32_t hci_dump_get_time_ms(void){
+    if (hci_dump_btstack == NULL) return 0;
+    if (hci_dump_btstack->run_loop == NULL) return 0;
+    return btstack_run_loop_get_time_ms(hci_dump_btstack);
+}
+#endif
+
+static void hci_dump_get_timestamp(uint32_t * tv_sec, uint32_t * tv_us){
+#ifdef HAVE_POSIX_FILE_IO
+    struct timeval curr_time;
+    gettimeofday(&curr_time, NULL);
+    *tv_sec = curr_time.tv_sec;
+    *tv_us  = curr_time.tv_usec;
+#else
+    uint32_t time_ms = hci_dump_get_time_ms();
+    *tv_us   = (time_ms % 1000) * 1000;
+    *tv_sec  = 946728000UL + (time_ms / 1000);
+#endif
+}
+
+static void hci_dump_flight_recorder_store(const uint8_t * data, uint32_t len){
+    uint32_t bytes_to_end = flight_recorder_size - flight_recorder_head;
+    if (len < bytes_to_end){
+        memcpy(&flight_recorder_buffer[flight_recorder_head], data, len);
+        flight_recorder_head += len;
+    } else {
+        memcpy(&flight_recorder_buffer[flight_recorder_head], data, bytes_to_end);
+        memcpy(&flight_recorder_buffer[0], &data[bytes_to_end], len - bytes_to_end);
+        flight_recorder_head = len - bytes_to_end;
+    }
+}
+
+// size of oldest record, PacketLogger header starts with big endian length of remaining record
+static uint32_t hci_dump_flight_recorder_oldest_record_len(void){
+    uint32_t len = 0;
+    uint32_t pos = flight_recorder_tail;
+    int i;
+    for (i = 0; i < 4; i++){
+        len = (len << 8) | flight_recorder_buffer[pos];
+        pos++;
+        if (pos == flight_recorder_size){
+            pos = 0;
+        }
+    }
+    return 4 + len;
+}
+
+static void hci_dump_flight_recorder_add(uint8_t packet_type, uint8_t in, const uint8_t * packet, uint16_t len){
+    uint32_t record_len = PKTLOG_HDR_SIZE + len;
+    if (record_len > flight_recorder_size) return;
+
+    // drop oldest records
+    while ((flight_recorder_size - flight_recorder_used) < record_len){
+        uint32_t oldest_len = hci_dump_flight_recorder_oldest_record_len();
+        flight_recorder_tail += oldest_len;
+        if (flight_recorder_tail >= flight_recorder_size){
+            flight_recorder_tail -= flight_recorder_size;
+        }
+        flight_recorder_used -= oldest_len;
+    }
+
+    uint8_t header[PKTLOG_HDR_SIZE];
+    uint32_t tv_sec;
+    uint32_t tv_us;
+    hci_dump_get_timestamp(&tv_sec, &tv_us);
+    header[12] = 0;
+    hci_dump_packetlogger_setup_header(header, tv_sec, tv_us, packet_type, in, len);
+    hci_dump_flight_recorder_store(header, PKTLOG_HDR_SIZE);
+    hci_dump_flight_recorder_store(packet, len);
+    flight_recorder_used += record_len;
+}
+
+void hci_dump_flight_recorder_init(uint8_t * buffer, uint32_t size){
+    flight_recorder_buffer = (size > 0) ? buffer : NULL;
+    flight_recorder_size   = size;
+    flight_recorder_head   = 0;
+    flight_recorder_tail   = 0;
+    flight_recorder_used   = 0;
+}
+
+void hci_dump_flight_recorder_read(void (*handler)(void * context, const uint8_t * data, uint32_t len), void * context){
+    if (flight_recorder_buffer == NULL) return;
+    if (flight_recorder_used == 0) return;
+    uint32_t bytes_to_end = flight_recorder_size - flight_recorder_tail;
+    if (flight_recorder_used <= bytes_to_end){
+        (*handler)(context, &flight_recorder_buffer[flight_recorder_tail], flight_recorder_used);
+    } else {
+        (*handler)(context, &flight_recorder_buffer[flight_recorder_tail], bytes_to_end);
+        (*handler)(context, &flight_recorder_buffer[0], flight_recorder_used - bytes_to_end);
+    }
+}
+
+#ifdef HAVE_POSIX_FILE_IO
+static void hci_dump_flight_recorder_write_file(void * context, const uint8_t * data, uint32_t len){
+    int fd = *(int *) context;
+    while (len > 0){
+        ssize_t res = write(fd, data, len);
+        if (res <= 0) return;
+        data += res;
+        len  -= res;
+    }
+}
+
+int hci_dump_flight_recorder_snapshot(const char * filename){
+    int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef _WIN32
+    oflags |= O_BINARY;
+#endif
+    int fd = open(filename, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+    if (fd < 0) return -1;
+    hci_dump_flight_recorder_read(&hci_dump_flight_recorder_write_file, &fd);
+    close(fd);
+    return 0;
+}
+#endif
+
 static void printf_packet(uint8_t packet_type, uint8_t in, uint8_t * packet, uint16_t len){
     switch (packet_type){
         case HCI_COMMAND_DATA_PACKET:
@@ -252,7 +435,7 @@ static void printf_timestamp(void){
     /* Print the formatted time, in seconds, followed by a decimal point and the milliseconds. */
     printf ("%s.%03u] ", time_string, milliseconds);
 #else
-    uint32_t time_ms = 0; //btstack_run_loop_get_time_ms();
+    uint32_t time_ms = hci_dump_get_time_ms();
     int      seconds = time_ms / 1000;
     int      minutes = seconds / 60;
     unsigned int hours = minutes / 60;
@@ -264,7 +447,232 @@ static void printf_timestamp(void){
 #endif
 }
 
+#ifdef HCI_DUMP_BUFFERED
+
+static void hci_dump_buffer_lock(void){
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&hci_dump_buffer_mutex);
+#endif
+}
+
+static void hci_dump_buffer_unlock(void){
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&hci_dump_buffer_mutex);
+#endif
+}
+
+// write buffered data to file, called with lock held, lock is released during file operations
+static void hci_dump_buffer_write(void){
+    while (1){
+        if (hci_dump_buffer_truncate_pending){
+            // data before truncate position would be removed by ftruncate anyway
+            hci_dump_buffer_tail = hci_dump_buffer_truncate_position;
+            hci_dump_buffer_truncate_pending = 0;
+#ifdef HAVE_PTHREAD
+            pthread_cond_broadcast(&hci_dump_buffer_space_cond);
+#endif
+            hci_dump_buffer_unlock();
+            lseek(dump_file, 0, SEEK_SET);
+            // avoid -Wunused-result
+            int res = ftruncate(dump_file, 0);
+            UNUSED(res);
+            hci_dump_buffer_lock();
+            continue;
+        }
+        uint32_t bytes_buffered = hci_dump_buffer_head - hci_dump_buffer_tail;
+        if (bytes_buffered == 0) break;
+        uint32_t offset = hci_dump_buffer_tail & (HCI_DUMP_BUFFER_SIZE - 1);
+        uint32_t len = bytes_buffered;
+        if ((offset + len) > HCI_DUMP_BUFFER_SIZE){
+            len = HCI_DUMP_BUFFER_SIZE - offset;
+        }
+        hci_dump_buffer_unlock();
+        ssize_t res = write(dump_file, &hci_dump_buffer[offset], len);
+        UNUSED(res);
+        hci_dump_buffer_lock();
+        hci_dump_buffer_tail += len;
+#ifdef HAVE_PTHREAD
+        pthread_cond_broadcast(&hci_dump_buffer_space_cond);
+#endif
+    }
+}
+
+static void hci_dump_buffer_store(const uint8_t * data, uint16_t len){
+    uint32_t offset = hci_dump_buffer_head & (HCI_DUMP_BUFFER_SIZE - 1);
+    uint32_t bytes_to_end = HCI_DUMP_BUFFER_SIZE - offset;
+    if (len <= bytes_to_end){
+        memcpy(&hci_dump_buffer[offset], data, len);
+    } else {
+        memcpy(&hci_dump_buffer[offset], data, bytes_to_end);
+        memcpy(&hci_dump_buffer[0], &data[bytes_to_end], len - bytes_to_end);
+    }
+    hci_dump_buffer_head += len;
+}
+
+// store header and packet as one record, called with lock held. returns 0 if dropped
+static int hci_dump_buffer_add_record(const uint8_t * header, uint16_t header_len, const uint8_t * packet, uint16_t len){
+    uint32_t record_len = header_len + len;
+    if (record_len > HCI_DUMP_BUFFER_SIZE) return 0;
+    while ((HCI_DUMP_BUFFER_SIZE - (hci_dump_buffer_head - hci_dump_buffer_tail)) < record_len){
+#ifdef HAVE_PTHREAD
+        if (hci_dump_writer_running){
+            if (hci_dump_buffer_policy == HCI_DUMP_BUFFER_POLICY_DROP) return 0;
+            pthread_cond_signal(&hci_dump_buffer_data_cond);
+            pthread_cond_wait(&hci_dump_buffer_space_cond, &hci_dump_buffer_mutex);
+            continue;
+        }
+#endif
+        // no writer thread: write synchronously
+        hci_dump_buffer_write();
+    }
+    hci_dump_buffer_store(header, header_len);
+    hci_dump_buffer_store(packet, len);
+    return 1;
+}
+
+static void hci_dump_buffer_add(const uint8_t * header, uint16_t header_len, const uint8_t * packet, uint16_t len){
+    hci_dump_buffer_lock();
+
+    // report dropped packets as log message
+    if (hci_dump_buffer_num_dropped != hci_dump_buffer_num_dropped_reported){
+        char message[48];
+        uint8_t message_header[PKTLOG_HDR_SIZE];
+        uint32_t num_dropped = hci_dump_buffer_num_dropped;
+        int message_len = snprintf(message, sizeof(message), "hci_dump: %u packet(s) dropped", (unsigned int) (num_dropped - hci_dump_buffer_num_dropped_reported));
+        // use timestamp of current packet
+        memcpy(message_header, header, header_len);
+        if (dump_format == HCI_DUMP_BLUEZ){
+            hci_dump_bluez_setup_header(message_header, little_endian_read_32(header, 4), little_endian_read_32(header, 8), LOG_MESSAGE_PACKET, 0, message_len);
+        } else {
+            hci_dump_packetlogger_setup_header(message_header, big_endian_read_32(header, 4), big_endian_read_32(header, 8), LOG_MESSAGE_PACKET, 0, message_len);
+        }
+        if (hci_dump_buffer_add_record(message_header, header_len, (const uint8_t *) message, message_len)){
+            hci_dump_buffer_num_dropped_reported = num_dropped;
+        }
+    }
+
+    if (hci_dump_buffer_add_record(header, header_len, packet, len) == 0){
+        hci_dump_buffer_num_dropped++;
+    }
+
+    // start write when half full
+    if ((hci_dump_buffer_head - hci_dump_buffer_tail) >= (HCI_DUMP_BUFFER_SIZE / 2)){
+#ifdef HAVE_PTHREAD
+        if (hci_dump_writer_running){
+            pthread_cond_signal(&hci_dump_buffer_data_cond);
+        } else
+#endif
+        {
+            hci_dump_buffer_write();
+        }
+    }
+
+    hci_dump_buffer_unlock();
+}
+
+static void hci_dump_buffer_truncate(void){
+    hci_dump_buffer_lock();
+    hci_dump_buffer_truncate_position = hci_dump_buffer_head;
+    hci_dump_buffer_truncate_pending  = 1;
+    hci_dump_buffer_unlock();
+}
+
+#ifdef HAVE_PTHREAD
+static void * hci_dump_writer_thread_main(void * context){
+    UNUSED(context);
+    pthread_mutex_lock(&hci_dump_buffer_mutex);
+    while (1){
+        hci_dump_buffer_write();
+        if (hci_dump_writer_stop) break;
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec  += HCI_DUMP_BUFFER_FLUSH_INTERVAL_MS / 1000;
+        timeout.tv_nsec += (HCI_DUMP_BUFFER_FLUSH_INTERVAL_MS % 1000) * 1000000L;
+        timeout.tv_sec  += timeout.tv_nsec / 1000000000L;
+        timeout.tv_nsec  = timeout.tv_nsec % 1000000000L;
+        pthread_cond_timedwait(&hci_dump_buffer_data_cond, &hci_dump_buffer_mutex, &timeout);
+    }
+    pthread_mutex_unlock(&hci_dump_buffer_mutex);
+    return NULL;
+}
+#endif
+
+static void hci_dump_buffer_open(void){
+    hci_dump_buffer_head = 0;
+    hci_dump_buffer_tail = 0;
+    hci_dump_buffer_truncate_pending = 0;
+    hci_dump_buffer_num_dropped = 0;
+    hci_dump_buffer_num_dropped_reported = 0;
+#ifdef HAVE_PTHREAD
+    hci_dump_writer_stop = 0;
+    if (pthread_create(&hci_dump_writer_thread, NULL, &hci_dump_writer_thread_main, NULL) == 0){
+        hci_dump_writer_running = 1;
+    } else {
+        printf("hci_dump_open: failed to start writer thread, writing synchronously\n");
+    }
+#endif
+}
+
+static void hci_dump_buffer_close(void){
+#ifdef HAVE_PTHREAD
+    if (hci_dump_writer_running){
+        pthread_mutex_lock(&hci_dump_buffer_mutex);
+        hci_dump_writer_stop = 1;
+        pthread_cond_signal(&hci_dump_buffer_data_cond);
+        pthread_mutex_unlock(&hci_dump_buffer_mutex);
+        pthread_join(hci_dump_writer_thread, NULL);
+        hci_dump_writer_running = 0;
+        return;
+    }
+#endif
+    hci_dump_buffer_lock();
+    hci_dump_buffer_write();
+    hci_dump_buffer_unlock();
+}
+
+#endif
+
+void hci_dump_set_buffer_policy(hci_dump_buffer_policy_t policy){
+#ifdef HCI_DUMP_BUFFERED
+    hci_dump_buffer_policy = policy;
+#else
+    UNUSED(policy);
+#endif
+}
+
+void hci_dump_flush(void){
+#ifdef HCI_DUMP_BUFFERED
+    if (dump_file < 0) return;
+    if (dump_format == HCI_DUMP_STDOUT) return;
+    hci_dump_buffer_lock();
+#ifdef HAVE_PTHREAD
+    if (hci_dump_writer_running){
+        while ((hci_dump_buffer_head != hci_dump_buffer_tail) || hci_dump_buffer_truncate_pending){
+            pthread_cond_signal(&hci_dump_buffer_data_cond);
+            pthread_cond_wait(&hci_dump_buffer_space_cond, &hci_dump_buffer_mutex);
+        }
+    } else
+#endif
+    {
+        hci_dump_buffer_write();
+    }
+    hci_dump_buffer_unlock();
+#endif
+}
+
+uint32_t hci_dump_get_num_dropped_packets(void){
+#ifdef HCI_DUMP_BUFFERED
+    return hci_dump_buffer_num_dropped;
+#else
+    return 0;
+#endif
+}
+
 void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {
+    if (flight_recorder_buffer != NULL){
+        hci_dump_flight_recorder_add(packet_type, in, packet, len);
+    }
+
 #ifndef forARM
     static union {
         uint8_t header_bluez[HCIDUMP_HDR_SIZE];
@@ -277,10 +685,14 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
     // don't grow bigger than max_nr_packets
     if (dump_format != HCI_DUMP_STDOUT && max_nr_packets > 0){
         if (nr_packets >= max_nr_packets){
+#ifdef HCI_DUMP_BUFFERED
+            hci_dump_buffer_truncate();
+#else
             lseek(dump_file, 0, SEEK_SET);
             // avoid -Wunused-result
             int res = ftruncate(dump_file, 0);
             UNUSED(res);
+#endif
             nr_packets = 0;
         }
         nr_packets++;
@@ -293,20 +705,9 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
         return;
     }
 
-    uint32_t tv_sec = 0;
-    uint32_t tv_us  = 0;
-
-    // get time
-#ifdef HAVE_POSIX_FILE_IO
-    struct timeval curr_time;
-    gettimeofday(&curr_time, NULL);
-    tv_sec = curr_time.tv_sec;
-    tv_us  = curr_time.tv_usec;
-#else
-    uint32_t time_ms = 0; //btstack_run_loop_get_time_ms();
-    tv_us   = time_ms * 1000;
-    tv_sec  = 946728000UL + (time_ms / 1000);
-#endif
+    uint32_t tv_sec;
+    uint32_t tv_us;
+    hci_dump_get_timestamp(&tv_sec, &tv_us);
 
 #ifdef ENABLE_SEGGER_RTT
 #if (SEGGER_RTT_PACKETLOG_MODE == SEGGER_RTT_MODE_NO_BLOCK_SKIP)
@@ -337,12 +738,16 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
     }
 
 #ifdef HAVE_POSIX_FILE_IO
+#ifdef HCI_DUMP_BUFFERED
+    hci_dump_buffer_add((const uint8_t *) &header, header_len, packet, len);
+#else
     // avoid -Wunused-result
     int res = 0;
     res = write (dump_file, &header, header_len);
     res = write (dump_file, packet, len );
     UNUSED(res);
 #endif
+#endif
 
 #ifdef ENABLE_SEGGER_RTT
 
@@ -371,13 +776,15 @@ static int hci_dump_log_level_active(int log_level){
 void hci_dump_log_va_arg(int log_level, const char * format, va_list argptr){
     if (!hci_dump_log_level_active(log_level)) return;
 
-#if defined(HAVE_POSIX_FILE_IO) || defined (ENABLE_SEGGER_RTT)
-    if (dump_file >= 0){
+    if ((dump_file >= 0) || (flight_recorder_buffer != NULL)){
         int len = vsnprintf(log_message_buffer, sizeof(log_message_buffer), format, argptr);
+        if (len < 0) return;
+        if (len >= (int) sizeof(log_message_buffer)){
+            len = sizeof(log_message_buffer) - 1;
+        }
         hci_dump_packet(LOG_MESSAGE_PACKET, 0, (uint8_t*) log_message_buffer, len);
         return;
     }
-#endif
 #if 0
     printf_timestamp();
     printf("LOG -- ");
@@ -406,6 +813,11 @@ void hci_dump_log_P(int log_level, PGM_P format, ...){
 #endif
 
 void hci_dump_close(void){
+#ifdef HCI_DUMP_BUFFERED
+    if ((dump_file >= 0) && (dump_format != HCI_DUMP_STDOUT)){
+        hci_dump_buffer_close();
+    }
+#endif
 #ifdef HAVE_POSIX_FILE_IO
     close(dump_file);
 #endif
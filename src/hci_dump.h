@@ -49,6 +49,8 @@
 #include <stdint.h>
 #include <stdarg.h>       // for va_list
 
+#include "btstack_state.h"
+
 #ifdef __AVR__
 #include <avr/pgmspace.h>
 #endif
@@ -69,6 +71,11 @@ typedef enum {
     HCI_DUMP_STDOUT
 } hci_dump_format_t;
 
+typedef enum {
+    HCI_DUMP_BUFFER_POLICY_DROP = 0,    // drop packets if buffer is full
+    HCI_DUMP_BUFFER_POLICY_BLOCK        // wait for writer if buffer is full
+} hci_dump_buffer_policy_t;
+
 /*
  * @brief 
  */
@@ -79,6 +86,12 @@ void hci_dump_open(const char *filename, hci_dump_format_t format);
  */
 void hci_dump_set_max_packets(int packets); // -1 for unlimited
 
+/*
+ * @brief Set BTstack instance whose run loop provides the timestamps without HAVE_POSIX_FILE_IO, called by hci_init
+ * @param btstack
+ */
+void hci_dump_set_btstack(btstack_state_t * btstack);
+
 /*
  * @brief 
  */
@@ -103,6 +116,44 @@ void hci_dump_enable_log_level(int log_level, int enable);
  */
 void hci_dump_close(void);
 
+/*
+ * @brief Set policy for full buffer with ENABLE_HCI_DUMP_BUFFERED, default: HCI_DUMP_BUFFER_POLICY_DROP
+ * @param policy
+ */
+void hci_dump_set_buffer_policy(hci_dump_buffer_policy_t policy);
+
+/*
+ * @brief Write all buffered packets to file with ENABLE_HCI_DUMP_BUFFERED
+ */
+void hci_dump_flush(void);
+
+/*
+ * @brief Get number of packets dropped with ENABLE_HCI_DUMP_BUFFERED and HCI_DUMP_BUFFER_POLICY_DROP
+ * @return num packets dropped since hci_dump_open
+ */
+uint32_t hci_dump_get_num_dropped_packets(void);
+
+/*
+ * @brief Keep most recent packets and log messages in PacketLogger format in provided buffer (flight recorder), independent of hci_dump_open
+ * @param buffer
+ * @param size of buffer, 0 disables flight recorder
+ */
+void hci_dump_flight_recorder_init(uint8_t * buffer, uint32_t size);
+
+/*
+ * @brief Get flight recorder content as PacketLogger records, oldest first. Handler is called twice if content wraps around
+ * @param handler
+ * @param context passed to handler
+ */
+void hci_dump_flight_recorder_read(void (*handler)(void * context, const uint8_t * data, uint32_t len), void * context);
+
+/*
+ * @brief Write flight recorder content to PacketLogger file, requires HAVE_POSIX_FILE_IO. Only uses open/write/close
+ * @param filename
+ * @return 0 on success
+ */
+int hci_dump_flight_recorder_snapshot(const char * filename);
+
 /* API_END */
 
 void hci_dump_log_va_arg(int log_level, const char * format, va_list argtr);
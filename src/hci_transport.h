@@ -50,7 +50,10 @@
 #include "btstack_uart_block.h"
 #include "btstack_em9304_spi.h"
 #include "btstack_defines.h"
+#include "btstack_linked_list.h"
 #include "btstack_state.h"
+#include "bluetooth.h"
+#include "hci_dump.h"
 
 #if defined __cplusplus
 extern "C" {
@@ -105,7 +108,7 @@ typedef struct {
     /**
      * extension for UART H5 on CSR: reset BCSP/H5 Link
      */
-    void   (*reset_link)(void);
+    void   (*reset_link)(btstack_state_t *btstack);
 
     /**
      * extension for USB transport implementations: config SCO connections
@@ -116,7 +119,9 @@ typedef struct {
 
 typedef enum {
     HCI_TRANSPORT_CONFIG_UART,
-    HCI_TRANSPORT_CONFIG_USB
+    HCI_TRANSPORT_CONFIG_USB,
+    HCI_TRANSPORT_CONFIG_VIRTUAL,
+    HCI_TRANSPORT_CONFIG_REPLAY
 } hci_transport_config_type_t;
 
 typedef struct {
@@ -131,6 +136,81 @@ typedef struct {
     const char *device_name;
 } hci_transport_config_uart_t;
 
+// H4 receive and transmit statistics
+typedef struct {
+    uint32_t num_reads;             // completed UART reads
+    uint32_t num_bytes;             // received bytes
+    uint32_t num_packets;           // HCI packets delivered to stack
+    uint16_t max_packets_per_read;  // most HCI packets parsed from a single read
+    uint32_t num_writes;            // UART writes started
+    uint32_t num_packets_sent;      // HCI packets sent
+    uint16_t max_packets_per_write; // most HCI packets sent with a single write
+} hci_transport_h4_statistics_t;
+
+// Virtual link shared by all virtual controllers that can see each other, knobs can be changed at any time
+typedef struct {
+    btstack_linked_list_t controllers;  // attached controllers, managed by virtual transport
+    uint32_t latency_ms;                // one-way delay from end of transmission to arrival at peer controller
+    uint32_t bandwidth;                 // air throughput per controller in bytes/s, 0 = unlimited
+    uint16_t loss_permille;             // probability that a transmission fails: ACL is retransmitted, reports are lost
+    uint32_t random_state;              // pseudo random generator state for loss, set by hci_transport_virtual_link_init
+} hci_transport_virtual_link_t;
+
+typedef struct {
+    hci_transport_config_type_t type; // == HCI_TRANSPORT_CONFIG_VIRTUAL
+    hci_transport_virtual_link_t * link;
+    bd_addr_t bd_addr;                // public address of this controller
+    uint16_t  acl_data_packet_length; // BR/EDR ACL buffers reported by HCI Read Buffer Size
+    uint16_t  acl_packets_total_num;
+    uint16_t  le_data_packet_length;  // LE ACL buffers reported by HCI LE Read Buffer Size, 0 = shared with BR/EDR
+    uint8_t   le_packets_total_num;
+} hci_transport_config_virtual_t;
+
+// Virtual controller statistics
+typedef struct {
+    uint32_t num_commands;          // HCI Commands received from host
+    uint32_t num_events;            // HCI Events delivered to host
+    uint32_t num_acl_packets_sent;  // ACL packets transmitted to peer controller
+    uint32_t num_acl_bytes_sent;    // ACL bytes transmitted to peer controller, incl. ACL header
+    uint32_t num_acl_packets_received; // ACL packets delivered to host
+    uint32_t num_retransmissions;   // ACL retransmissions due to simulated loss
+    uint32_t num_reports_lost;      // advertising and inquiry reports lost due to simulated loss
+    uint32_t num_packets_dropped;   // packets dropped as HCI_TRANSPORT_VIRTUAL_QUEUE_SIZE or ACL buffers were exceeded
+} hci_transport_virtual_statistics_t;
+
+
+typedef struct {
+    hci_transport_config_type_t type; // == HCI_TRANSPORT_CONFIG_REPLAY
+    hci_dump_format_t format;         // HCI_DUMP_PACKETLOGGER or HCI_DUMP_BLUEZ
+    const uint8_t * capture;          // capture in memory, e.g. from hci_dump_flight_recorder_read
+    uint32_t capture_len;
+    const char * filename;            // or capture file, used if capture == NULL, requires HAVE_POSIX_FILE_IO
+    uint16_t speedup;                 // 1 = original timing, N = N times faster, 0 = as fast as possible
+} hci_transport_config_replay_t;
+
+// CPU time spent by the stack to process replayed packets of one type
+typedef struct {
+    uint32_t num_packets;
+    uint64_t total_ns;
+    uint32_t max_ns;
+} hci_transport_replay_cpu_time_t;
+
+// Replay statistics
+typedef struct {
+    uint32_t num_records;               // HCI packets in capture, valid if completed
+    uint32_t num_packets_replayed;      // controller to host packets delivered to host
+    uint32_t num_packets_matched;       // host to controller packets identical to capture
+    uint32_t num_divergences;           // host to controller packets that differ from capture, were not expected or are missing
+    uint32_t num_packets_missing;       // host to controller packets not sent within HCI_TRANSPORT_REPLAY_TX_TIMEOUT_MS
+    uint32_t first_divergence_record;   // index of first diverging record, starting at 0, valid if num_divergences > 0
+    uint32_t max_delivery_delay_ms;     // max delay of a delivery compared to the (scaled) capture timing
+    uint32_t duration_ms;               // time from open until capture was completed
+    uint8_t  completed;                 // all records processed
+    hci_transport_replay_cpu_time_t cpu_event;  // requires HAVE_POSIX_TIME
+    hci_transport_replay_cpu_time_t cpu_acl;
+    hci_transport_replay_cpu_time_t cpu_sco;
+} hci_transport_replay_statistics_t;
+
 
 // inline various hci_transport_X.h files
 
@@ -140,11 +220,17 @@ typedef struct {
  */
 const hci_transport_t * hci_transport_h4_instance(btstack_state_t *btstack, const btstack_uart_block_t * uart_driver);
 
+/*
+ * @brief Get H4 statistics. Average bytes per read = num_bytes / num_reads, packets per read = num_packets / num_reads
+ * @returns statistics
+ */
+const hci_transport_h4_statistics_t * hci_transport_h4_get_statistics(btstack_state_t *btstack);
+
 /*
  * @brief Setup H5 instance with uart_driver
  * @param uart_driver to use
  */
-const hci_transport_t * hci_transport_h5_instance(const btstack_uart_block_t * uart_driver);
+const hci_transport_t * hci_transport_h5_instance(btstack_state_t *btstack, const btstack_uart_block_t * uart_driver);
 
 /*
  * @brief Setup H4 over SPI instance for EM9304 with em9304_spi_driver
@@ -153,15 +239,59 @@ const hci_transport_t * hci_transport_h5_instance(const btstack_uart_block_t * u
 const hci_transport_t * hci_transport_em9304_spi_instance(const btstack_em9304_spi_t * em9304_spi_driver);
 
 /*
- * @brief Enable H5 Low Power Mode: enter sleep mode after x ms of inactivity
+ * @brief Enable H5 Low Power Mode: enter sleep mode after x ms of inactivity. Call after hci_transport_h5_instance
  * @param inactivity_timeout_ms or 0 for off
  */
-void hci_transport_h5_set_auto_sleep(uint16_t inactivity_timeout_ms);
+void hci_transport_h5_set_auto_sleep(btstack_state_t *btstack, uint16_t inactivity_timeout_ms);
+
+/*
+ * @brief Enable BSCP mode H5, by enabling event parity. Call after hci_transport_h5_instance
+ */
+void hci_transport_h5_enable_bcsp_mode(btstack_state_t *btstack);
+
+/*
+ * @brief Init virtual link with knobs for latency, loss, and bandwidth
+ * @param link
+ * @param latency_ms one-way delay
+ * @param loss_permille probability of failed transmission in 1/1000
+ * @param bandwidth in bytes/s per controller, 0 = unlimited
+ * @param seed for pseudo random generator
+ */
+void hci_transport_virtual_link_init(hci_transport_virtual_link_t * link, uint32_t latency_ms, uint16_t loss_permille, uint32_t bandwidth, uint32_t seed);
+
+/*
+ * @brief Setup virtual HCI transport that emulates a Bluetooth Controller attached to a virtual link
+ * @note All instances attached to a link need to be run from the same thread, e.g. by alternating btstack_run_loop_embedded_execute_once
+ * @note Pass hci_transport_config_virtual_t as config to hci_init
+ */
+const hci_transport_t * hci_transport_virtual_instance(btstack_state_t *btstack);
+
+/*
+ * @brief Get virtual controller statistics
+ * @returns statistics
+ */
+const hci_transport_virtual_statistics_t * hci_transport_virtual_get_statistics(btstack_state_t *btstack);
+
+/*
+ * @brief Setup HCI transport that replays controller to host packets from a PacketLogger or BlueZ capture
+ *        and compares host to controller packets against it
+ * @note A controller to host packet is delivered after all host to controller packets that precede it in the capture
+ *       have been sent by the host, with the original delay scaled by config speedup.
+ * @note Pass hci_transport_config_replay_t as config to hci_init. Capture needs to start with HCI Reset.
+ */
+const hci_transport_t * hci_transport_replay_instance(btstack_state_t *btstack);
+
+/*
+ * @brief Register handler called when all records of the capture have been processed
+ * @param handler
+ */
+void hci_transport_replay_register_done_handler(btstack_state_t *btstack, void (*handler)(btstack_state_t *btstack));
 
 /*
- * @brief Enable BSCP mode H5, by enabling event parity
+ * @brief Get replay statistics. Average CPU time per event = cpu_event.total_ns / cpu_event.num_packets
+ * @returns statistics
  */
-void hci_transport_h5_enable_bcsp_mode(void);
+const hci_transport_replay_statistics_t * hci_transport_replay_get_statistics(btstack_state_t *btstack);
 
 /*
  * @brief
@@ -46,11 +46,13 @@
  */
 
 #include <inttypes.h>
+#include <string.h>
 
 #include "btstack_config.h"
 #include "btstack_state.h"
 
 #include "btstack_debug.h"
+#include "btstack_instrumentation.h"
 #include "hci.h"
 #include "hci_transport.h"
 #include "bluetooth_company_id.h"
@@ -105,6 +107,23 @@ static btstack_timer_source_t ehcill_sleep_ack_timer;
 #error HCI_OUTGOING_PRE_BUFFER_SIZE not defined. Please update hci.h
 #endif
 
+#if defined(ENABLE_EHCILL) && (HCI_TRANSPORT_TX_QUEUE_SIZE > 1)
+#error "eHCILL requires HCI_TRANSPORT_TX_QUEUE_SIZE == 1"
+#endif
+
+#ifdef ENABLE_H4_BULK_READ
+// bulk read buffer, needs to hold at least one complete packet incl. packet type
+#ifndef HCI_TRANSPORT_H4_RX_BUFFER_SIZE
+#define HCI_TRANSPORT_H4_RX_BUFFER_SIZE (2 * (1 + HCI_INCOMING_PACKET_BUFFER_SIZE))
+#endif
+#if HCI_TRANSPORT_H4_RX_BUFFER_SIZE < (1 + HCI_INCOMING_PACKET_BUFFER_SIZE)
+#error HCI_TRANSPORT_H4_RX_BUFFER_SIZE too small, needs to be at least 1 + HCI_INCOMING_PACKET_BUFFER_SIZE
+#endif
+#if defined(ENABLE_EHCILL) || defined(ENABLE_CC256X_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND) || defined(ENABLE_CYPRESS_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND)
+#error "ENABLE_H4_BULK_READ cannot be combined with eHCILL or the baudrate change workarounds"
+#endif
+#endif
+
 typedef enum {
     H4_OFF,
     H4_W4_PACKET_TYPE,
@@ -132,6 +151,17 @@ struct btstack_hci_h4_state {
 
     // write state
     TX_STATE tx_state;
+
+    // tx queue: packets incl. packet type in send order, the first tx_num_in_uart ones are sent by the UART driver
+    btstack_uart_block_iov_t tx_queue[HCI_TRANSPORT_TX_QUEUE_SIZE];
+    btstack_uart_block_iov_t tx_blocks[HCI_TRANSPORT_TX_QUEUE_SIZE];
+    uint8_t tx_queue_head;
+    uint8_t tx_queue_num;
+    uint8_t tx_num_in_uart;
+#ifdef ENABLE_BTSTACK_INSTRUMENTATION
+    // time packet was queued, same index as tx_queue
+    uint32_t tx_queued_us[HCI_TRANSPORT_TX_QUEUE_SIZE];
+#endif
 #ifdef ENABLE_EHCILL
     uint8_t * ehcill_tx_data;
     uint16_t  ehcill_tx_len;   // 0 == no outgoing packet
@@ -147,6 +177,17 @@ struct btstack_hci_h4_state {
     // incoming packet buffer
     uint8_t hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_INCOMING_PACKET_BUFFER_SIZE + 1]; // packet type + max(acl header + acl payload, event header + event data)
     uint8_t * hci_packet;
+
+#ifdef ENABLE_H4_BULK_READ
+    // bulk read: received data in rx_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + rx_start .. rx_end], packets are delivered in place
+    uint8_t  rx_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_TRANSPORT_H4_RX_BUFFER_SIZE];
+    uint16_t rx_start;
+    uint16_t rx_end;
+    // set if UART driver supports receive_data
+    int      bulk_read;
+#endif
+
+    hci_transport_h4_statistics_t statistics;
 };
 
 // Baudrate change bugs in TI CC256x and CYW20704
@@ -221,13 +262,21 @@ static void hci_transport_h4_packet_complete(btstack_state_t *btstack){
     uint16_t packet_len = btstack->hci_h4->read_pos-1;
     einstein_log(90, __func__, __LINE__, "%d", packet_len);
 
+    btstack->hci_h4->statistics.num_packets++;
+    btstack->hci_h4->statistics.max_packets_per_read = 1;
+
     // reset state machine before delivering packet to stack as it might close the transport
     hci_transport_h4_reset_statemachine(btstack);
-    btstack->hci_h4->packet_handler(btstack, btstack->hci_h4->hci_packet[0], &btstack->hci_h4->hci_packet[1], packet_len);
+    uint8_t packet_type = btstack->hci_h4->hci_packet[0];
+    BTSTACK_INSTRUMENTATION_START(handler_start_us);
+    btstack->hci_h4->packet_handler(btstack, packet_type, &btstack->hci_h4->hci_packet[1], packet_len);
+    BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_HCI_TRANSPORT, packet_type, packet_len, handler_start_us);
 }
 
 static void hci_transport_h4_block_read(btstack_state_t *btstack){
 
+    btstack->hci_h4->statistics.num_reads++;
+    btstack->hci_h4->statistics.num_bytes += btstack->hci_h4->bytes_to_read;
     btstack->hci_h4->read_pos += btstack->hci_h4->bytes_to_read;
     einstein_log(33, __func__, __LINE__, "%d", btstack->hci_h4->h4_state);
     switch (btstack->hci_h4->h4_state) {
@@ -323,24 +372,175 @@ static void hci_transport_h4_block_read(btstack_state_t *btstack){
     }
 }
 
+#ifdef ENABLE_H4_BULK_READ
+
+// returns size of complete packet incl. packet type, 0 if more data is needed, or -1 if packet type or length is invalid
+static int hci_transport_h4_bulk_packet_size(const uint8_t * data, uint16_t len){
+    uint16_t header_size;
+    uint16_t payload_len;
+    if (len < 1) return 0;
+    switch (data[0]){
+        case HCI_EVENT_PACKET:
+            header_size = HCI_EVENT_HEADER_SIZE;
+            if (len < (1 + header_size)) return 0;
+            payload_len = data[2];
+            break;
+        case HCI_ACL_DATA_PACKET:
+            header_size = HCI_ACL_HEADER_SIZE;
+            if (len < (1 + header_size)) return 0;
+            payload_len = little_endian_read_16(data, 3);
+            break;
+        case HCI_SCO_DATA_PACKET:
+            header_size = HCI_SCO_HEADER_SIZE;
+            if (len < (1 + header_size)) return 0;
+            payload_len = data[3];
+            break;
+        default:
+            log_error("hci_transport_h4: invalid packet type 0x%02x", data[0]);
+            return -1;
+    }
+    if (payload_len > (HCI_INCOMING_PACKET_BUFFER_SIZE - header_size)){
+        log_error("hci_transport_h4: invalid payload len %u for packet type 0x%02x - only space for %u", payload_len, data[0], HCI_INCOMING_PACKET_BUFFER_SIZE - header_size);
+        return -1;
+    }
+    uint16_t size = 1 + header_size + payload_len;
+    if (len < size) return 0;
+    return size;
+}
+
+static void hci_transport_h4_bulk_trigger_next_read(btstack_state_t *btstack){
+    struct btstack_hci_h4_state * h4 = btstack->hci_h4;
+    uint8_t * rx = &h4->rx_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    // move partial packet to start of buffer
+    if (h4->rx_start > 0){
+        uint16_t pending = h4->rx_end - h4->rx_start;
+        memmove(rx, &rx[h4->rx_start], pending);
+        h4->rx_start = 0;
+        h4->rx_end   = pending;
+    }
+    h4->btstack_uart->receive_data(btstack, &rx[h4->rx_end], HCI_TRANSPORT_H4_RX_BUFFER_SIZE - h4->rx_end);
+}
+
+static void hci_transport_h4_bulk_data_received(btstack_state_t *btstack, uint16_t len){
+    struct btstack_hci_h4_state * h4 = btstack->hci_h4;
+    if (h4->h4_state == H4_OFF) return;
+
+    uint8_t * rx = &h4->rx_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    h4->rx_end += len;
+    h4->statistics.num_reads++;
+    h4->statistics.num_bytes += len;
+
+    // deliver all complete packets in place, the bytes before each packet have been consumed and can be used as pre buffer
+    uint16_t num_packets = 0;
+    while (h4->h4_state != H4_OFF){
+        uint8_t * packet = &rx[h4->rx_start];
+        int size = hci_transport_h4_bulk_packet_size(packet, h4->rx_end - h4->rx_start);
+        if (size == 0) break;
+        if (size < 0){
+            // drop first byte and try to re-sync
+            h4->rx_start++;
+            continue;
+        }
+        h4->rx_start += size;
+        num_packets++;
+        uint8_t packet_type = packet[0];
+        BTSTACK_INSTRUMENTATION_START(handler_start_us);
+        h4->packet_handler(btstack, packet_type, &packet[1], size - 1);
+        BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_HCI_TRANSPORT, packet_type, size - 1, handler_start_us);
+    }
+
+    h4->statistics.num_packets += num_packets;
+    if (num_packets > h4->statistics.max_packets_per_read){
+        h4->statistics.max_packets_per_read = num_packets;
+    }
+
+    if (h4->h4_state != H4_OFF){
+        hci_transport_h4_bulk_trigger_next_read(btstack);
+    }
+}
+#endif
+
+static void hci_transport_h4_tx_reset(btstack_state_t *btstack){
+    struct btstack_hci_h4_state * h4 = btstack->hci_h4;
+    h4->tx_queue_head  = 0;
+    h4->tx_queue_num   = 0;
+    h4->tx_num_in_uart = 0;
+}
+
+// start UART write for all queued packets, coalesced into a single write if supported by the UART driver
+static void hci_transport_h4_tx_start(btstack_state_t *btstack){
+    struct btstack_hci_h4_state * h4 = btstack->hci_h4;
+    if (h4->tx_state != TX_IDLE) return;
+    if (h4->tx_queue_num == 0) return;
+
+    h4->tx_state = TX_W4_PACKET_SENT;
+    h4->statistics.num_writes++;
+
+    const btstack_uart_block_t * uart = h4->btstack_uart;
+    if ((h4->tx_queue_num > 1) && (uart->send_blocks != NULL)){
+        uint8_t i;
+        for (i = 0; i < h4->tx_queue_num; i++){
+            h4->tx_blocks[i] = h4->tx_queue[(h4->tx_queue_head + i) % HCI_TRANSPORT_TX_QUEUE_SIZE];
+        }
+        h4->tx_num_in_uart = h4->tx_queue_num;
+        uart->send_blocks(btstack, h4->tx_blocks, h4->tx_num_in_uart);
+    } else {
+        const btstack_uart_block_iov_t * block = &h4->tx_queue[h4->tx_queue_head];
+        h4->tx_num_in_uart = 1;
+        uart->send_block(btstack, block->data, block->len);
+    }
+}
+
 static void hci_transport_h4_block_sent(btstack_state_t *btstack){
 
     static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
 
-    switch (btstack->hci_h4->tx_state){
+    struct btstack_hci_h4_state * h4 = btstack->hci_h4;
+    uint8_t num_packets_sent;
+
+    switch (h4->tx_state){
         case TX_W4_PACKET_SENT:
-            // packet fully sent, reset state
+            // packets fully sent, remove from queue
 #ifdef ENABLE_EHCILL
             ehcill_tx_len = 0;
 #endif
-            btstack->hci_h4->tx_state = TX_IDLE;
+            num_packets_sent = h4->tx_num_in_uart;
+            h4->tx_num_in_uart = 0;
+#ifdef ENABLE_BTSTACK_INSTRUMENTATION
+            {
+                uint32_t now_us = btstack_instrumentation_get_time_us();
+                uint8_t i;
+                for (i = 0; i < num_packets_sent; i++){
+                    uint8_t index = (h4->tx_queue_head + i) % HCI_TRANSPORT_TX_QUEUE_SIZE;
+                    btstack_instrumentation_packet_queued(BTSTACK_INSTRUMENTATION_LAYER_HCI_TRANSPORT, h4->tx_queue[index].data[0], now_us - h4->tx_queued_us[index]);
+                }
+            }
+#endif
+            h4->tx_queue_head = (h4->tx_queue_head + num_packets_sent) % HCI_TRANSPORT_TX_QUEUE_SIZE;
+            h4->tx_queue_num -= num_packets_sent;
+            h4->statistics.num_packets_sent += num_packets_sent;
+            if (num_packets_sent > h4->statistics.max_packets_per_write){
+                h4->statistics.max_packets_per_write = num_packets_sent;
+            }
 
 #ifdef ENABLE_EHCILL
+            h4->tx_state = TX_IDLE;
             // notify eHCILL engine
             hci_transport_h4_ehcill_handle_packet_sent();
-#endif
             // notify upper stack that it can send again
-            btstack->hci_h4->packet_handler(btstack, HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+            h4->packet_handler(btstack, HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+#else
+            // notify upper stack once per packet. tx_state stays TX_W4_PACKET_SENT meanwhile,
+            // so packets sent from the event handler only get queued and are sent together afterwards
+            while (num_packets_sent > 0){
+                num_packets_sent--;
+                h4->packet_handler(btstack, HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+                // transport closed by upper stack
+                if (h4->tx_state == TX_OFF) return;
+            }
+            h4->tx_state = TX_IDLE;
+            hci_transport_h4_tx_start(btstack);
+#endif
             break;
 
 #ifdef ENABLE_EHCILL
@@ -357,7 +557,12 @@ static void hci_transport_h4_block_sent(btstack_state_t *btstack){
 
 static int hci_transport_h4_can_send_now(btstack_state_t *btstack, uint8_t packet_type){
     UNUSED(packet_type);
-    return btstack->hci_h4->tx_state == TX_IDLE;
+    struct btstack_hci_h4_state * h4 = btstack->hci_h4;
+    if (h4->tx_state == TX_OFF) return 0;
+#ifdef ENABLE_EHCILL
+    if (h4->tx_state != TX_IDLE) return 0;
+#endif
+    return h4->tx_queue_num < HCI_TRANSPORT_TX_QUEUE_SIZE;
 }
 
 static int hci_transport_h4_send_packet(btstack_state_t *btstack, uint8_t packet_type, uint8_t * packet, int size){
@@ -391,9 +596,17 @@ static int hci_transport_h4_send_packet(btstack_state_t *btstack, uint8_t packet
     }
 #endif
 
-    // start sending
-    btstack->hci_h4->tx_state = TX_W4_PACKET_SENT;
-    btstack->hci_h4->btstack_uart->send_block(btstack, packet, size);
+    // queue packet and start sending if idle
+    struct btstack_hci_h4_state * h4 = btstack->hci_h4;
+    uint8_t index = (h4->tx_queue_head + h4->tx_queue_num) % HCI_TRANSPORT_TX_QUEUE_SIZE;
+    btstack_uart_block_iov_t * block = &h4->tx_queue[index];
+    block->data = packet;
+    block->len  = (uint16_t) size;
+#ifdef ENABLE_BTSTACK_INSTRUMENTATION
+    h4->tx_queued_us[index] = btstack_instrumentation_get_time_us();
+#endif
+    h4->tx_queue_num++;
+    hci_transport_h4_tx_start(btstack);
     return 0;
 }
 
@@ -424,6 +637,14 @@ static void hci_transport_h4_init(btstack_state_t *btstack, const void * transpo
     btstack->hci_h4->btstack_uart->set_block_received(btstack, &hci_transport_h4_block_read);
     btstack->hci_h4->btstack_uart->set_block_sent(btstack, &hci_transport_h4_block_sent);
     btstack->hci_h4->hci_packet = &btstack->hci_h4->hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+
+#ifdef ENABLE_H4_BULK_READ
+    // use bulk read if supported by UART driver
+    btstack->hci_h4->bulk_read = (btstack->hci_h4->btstack_uart->receive_data != NULL) && (btstack->hci_h4->btstack_uart->set_data_received != NULL);
+    if (btstack->hci_h4->bulk_read){
+        btstack->hci_h4->btstack_uart->set_data_received(btstack, &hci_transport_h4_bulk_data_received);
+    }
+#endif
 }
 
 static int hci_transport_h4_open(btstack_state_t *btstack){
@@ -436,8 +657,20 @@ static int hci_transport_h4_open(btstack_state_t *btstack){
 
     // init rx + tx state machines
     btstack->hci_h4->tx_state = TX_IDLE;
+    hci_transport_h4_tx_reset(btstack);
     hci_transport_h4_reset_statemachine(btstack);
+    memset(&btstack->hci_h4->statistics, 0, sizeof(hci_transport_h4_statistics_t));
+#ifdef ENABLE_H4_BULK_READ
+    if (btstack->hci_h4->bulk_read){
+        btstack->hci_h4->rx_start = 0;
+        btstack->hci_h4->rx_end   = 0;
+        hci_transport_h4_bulk_trigger_next_read(btstack);
+    } else {
+        hci_transport_h4_trigger_next_read(btstack);
+    }
+#else
     hci_transport_h4_trigger_next_read(btstack);
+#endif
 
 #ifdef ENABLE_EHCILL
     hci_transport_h4_ehcill_open();
@@ -448,6 +681,7 @@ static int hci_transport_h4_open(btstack_state_t *btstack){
 static int hci_transport_h4_close(btstack_state_t *btstack){
     // set state to off
     btstack->hci_h4->tx_state = TX_OFF;
+    hci_transport_h4_tx_reset(btstack);
     btstack->hci_h4->h4_state = H4_OFF;
 
     // close uart driver
@@ -726,6 +960,10 @@ static void hci_transport_h4_ehcill_handle_ehcill_command_sent(void){
 // --- end of eHCILL implementation ---------
 
 
+const hci_transport_h4_statistics_t * hci_transport_h4_get_statistics(btstack_state_t *btstack){
+    return &btstack->hci_h4->statistics;
+}
+
 // configure and return h4 singleton
 const hci_transport_t * hci_transport_h4_instance(btstack_state_t *btstack, const btstack_uart_block_t * uart_driver) {
 
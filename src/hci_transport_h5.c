@@ -46,8 +46,14 @@
  */
 
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_config.h"
+#include "btstack_state.h"
 
 #include "hci.h"
+#include "btstack_crc.h"
 #include "btstack_slip.h"
 #include "btstack_debug.h"
 #include "hci_transport.h"
@@ -74,9 +80,27 @@ typedef enum {
 
 } hci_transport_link_actions_t;
 
-// Configuration Field. No packet buffers -> sliding window = 1, no OOF flow control, support data integrity check
-#define LINK_CONFIG_SLIDING_WINDOW_SIZE 1
+// Sliding window size: max number of unacknowledged reliable packets, limited by packets HCI hands over before PACKET_SENT
+#ifndef HCI_TRANSPORT_H5_WINDOW_SIZE
+#if HCI_TRANSPORT_TX_QUEUE_SIZE > 7
+#define HCI_TRANSPORT_H5_WINDOW_SIZE 7
+#else
+#define HCI_TRANSPORT_H5_WINDOW_SIZE HCI_TRANSPORT_TX_QUEUE_SIZE
+#endif
+#endif
+
+#if (HCI_TRANSPORT_H5_WINDOW_SIZE < 1) || (HCI_TRANSPORT_H5_WINDOW_SIZE > 7)
+#error "HCI_TRANSPORT_H5_WINDOW_SIZE must be in range 1..7"
+#endif
+
+#ifdef ENABLE_H5_OOF_FLOW_CONTROL
+#define LINK_CONFIG_OOF_FLOW_CONTROL 1
+#else
 #define LINK_CONFIG_OOF_FLOW_CONTROL 0
+#endif
+
+// Configuration Field. Sliding window, optional OOF flow control, support data integrity check
+#define LINK_CONFIG_SLIDING_WINDOW_SIZE HCI_TRANSPORT_H5_WINDOW_SIZE
 #define LINK_CONFIG_DATA_INTEGRITY_CHECK 1
 #define LINK_CONFIG_VERSION_NR 0
 #define LINK_CONFIG_FIELD (LINK_CONFIG_SLIDING_WINDOW_SIZE | (LINK_CONFIG_OOF_FLOW_CONTROL << 3) | (LINK_CONFIG_DATA_INTEGRITY_CHECK << 4) | (LINK_CONFIG_VERSION_NR << 5))
@@ -94,6 +118,9 @@ typedef enum {
 // max size of write requests
 #define LINK_SLIP_TX_CHUNK_LEN 64
 
+// max size of read requests if UART driver supports receive_data
+#define LINK_SLIP_RX_CHUNK_LEN 64
+
 // ---
 static const uint8_t link_control_sync[] =   { 0x01, 0x7e};
 static const uint8_t link_control_sync_response[] = { 0x02, 0x7d};
@@ -106,70 +133,80 @@ static const uint8_t link_control_sleep[] =  { 0x07, 0x78};
 // max size of link control messages
 #define LINK_CONTROL_MAX_LEN 3
 
-// incoming pre-bufffer + 4 bytes H5 header + max(acl header + acl payload, event header + event data) + 2 bytes opt CRC
-static uint8_t   hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 6 + HCI_INCOMING_PACKET_BUFFER_SIZE];
-
-// outgoing slip encoded buffer. +4 to assert that DIC fits in buffer. +1 to assert that last SOF fits in buffer.
-static uint8_t   slip_outgoing_buffer[LINK_SLIP_TX_CHUNK_LEN+4+1];
-static uint16_t  slip_outgoing_dic;
-static uint16_t  slip_outgoing_dic_present;
-static int       slip_write_active;
-
-// H5 Link State
-static hci_transport_link_state_t link_state;
-static btstack_timer_source_t link_timer;
-static uint8_t  link_seq_nr;
-static uint8_t  link_ack_nr;
-static uint16_t link_resend_timeout_ms;
-static uint8_t  link_peer_asleep;
-static uint8_t  link_peer_supports_data_integrity_check;
-
-// auto sleep-mode
-static btstack_timer_source_t inactivity_timer;
-static uint16_t link_inactivity_timeout_ms; // auto-sleep if set
-
-// Outgoing packet
-static uint8_t   hci_packet_type;
-static uint16_t  hci_packet_size;
-static uint8_t * hci_packet;
-
-// hci packet handler
-static  void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
-
-static int hci_transport_link_actions;
-
-// UART Driver + Config
-static const btstack_uart_block_t * btstack_uart;
-static btstack_uart_config_t uart_config;
-static btstack_uart_sleep_mode_t btstack_uart_sleep_mode;
-static int hci_transport_bcsp_mode;
+// outgoing reliable packet
+typedef struct {
+    uint8_t * packet;
+    uint16_t  size;
+    uint8_t   packet_type;
+    uint8_t   seq_nr;
+} hci_transport_link_packet_t;
+
+struct btstack_hci_h5_state {
+    // UART Driver + Config
+    const btstack_uart_block_t * btstack_uart;
+    btstack_uart_config_t uart_config;
+    btstack_uart_sleep_mode_t btstack_uart_sleep_mode;
+    int bcsp_mode;
+    int active;
+
+    // hci packet handler
+    void (*packet_handler)(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+    // incoming pre-bufffer + 4 bytes H5 header + max(acl header + acl payload, event header + event data) + 2 bytes opt CRC
+    uint8_t  hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 6 + HCI_INCOMING_PACKET_BUFFER_SIZE];
+    btstack_slip_decoder_t slip_decoder;
+    uint8_t  read_byte;
+    // bulk read: set if UART driver supports receive_data
+    int      bulk_read;
+    uint8_t  read_buffer[LINK_SLIP_RX_CHUNK_LEN];
+    // track time receiving SLIP frame
+    uint32_t receive_start;
+
+    // outgoing slip encoded buffer. +4 to assert that DIC fits in buffer. +1 to assert that last SOF fits in buffer.
+    uint8_t  slip_outgoing_buffer[LINK_SLIP_TX_CHUNK_LEN+4+1];
+    btstack_slip_encoder_t slip_encoder;
+    uint16_t slip_outgoing_dic;
+    uint16_t slip_outgoing_dic_present;
+    int      slip_write_active;
+    // chunk sent while peer requested XOFF, continue on XON
+    int      slip_write_paused;
+
+    // H5 Link State
+    hci_transport_link_state_t link_state;
+    btstack_timer_source_t link_timer;
+    uint8_t  link_seq_nr;       // seq nr for next queued packet
+    uint8_t  link_ack_nr;
+    uint16_t link_resend_timeout_ms;
+    uint8_t  link_peer_asleep;
+    uint8_t  link_peer_supports_data_integrity_check;
+    uint8_t  link_window_size;  // negotiated sliding window size
+    uint8_t  link_oof_flow_control; // negotiated out-of-frame software flow control
+    uint8_t  link_tx_paused;    // XOFF received
+    int      link_actions;
+    int      sleep_active;
+
+    // retransmit queue: unacknowledged packets ordered by seq nr, the first link_tx_num_sent have been sent at least once,
+    // link_tx_next is the next one to (re)send
+    hci_transport_link_packet_t link_tx_queue[HCI_TRANSPORT_H5_WINDOW_SIZE];
+    uint8_t  link_tx_queue_head;
+    uint8_t  link_tx_queue_num;
+    uint8_t  link_tx_num_sent;
+    uint8_t  link_tx_next;
+
+    // auto sleep-mode
+    btstack_timer_source_t inactivity_timer;
+    uint16_t link_inactivity_timeout_ms; // auto-sleep if set
+};
 
 // Prototypes
-static void hci_transport_h5_process_frame(uint16_t frame_size);
-static int  hci_transport_link_have_outgoing_packet(void);
-static void hci_transport_link_send_queued_packet(void);
-static void hci_transport_link_set_timer(uint16_t timeout_ms);
-static void hci_transport_link_timeout_handler(btstack_timer_source_t * timer);
-static void hci_transport_link_run(void);
-static void hci_transport_slip_init(void);
+static int  hci_transport_link_have_outgoing_packet(btstack_state_t *btstack);
+static void hci_transport_link_set_timer(btstack_state_t *btstack, uint16_t timeout_ms);
+static void hci_transport_link_timeout_handler(btstack_state_t *btstack, btstack_timer_source_t * timer);
+static void hci_transport_link_run(btstack_state_t *btstack);
+static void hci_transport_h5_block_sent(btstack_state_t *btstack);
 
 // -----------------------------
-// CRC16-CCITT Calculation - compromise: use 32 byte table - 512 byte table would be faster, but that's too large
-
-
-static uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
-
-    static const uint16_t crc16_ccitt_table[] ={
-            0x0000, 0x1081, 0x2102, 0x3183,
-            0x4204, 0x5285, 0x6306, 0x7387,
-            0x8408, 0x9489, 0xa50a, 0xb58b,
-            0xc60c, 0xd68d, 0xe70e, 0xf78f
-    };
-
-    crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ ch) & 0x000f];
-    crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ (ch >> 4)) & 0x000f];
-    return crc;
-}
+// CRC16-CCITT Calculation
 
 static uint16_t btstack_reverse_bits_16(uint16_t value){
     int reverse = 0;
@@ -183,100 +220,95 @@ static uint16_t btstack_reverse_bits_16(uint16_t value){
 }
 
 static uint16_t crc16_calc_for_slip_frame(const uint8_t * header, const uint8_t * payload, uint16_t len){
-    int i;
-    uint16_t crc = 0xffff;
-    for (i=0 ; i < 4 ; i++){
-        crc = crc16_ccitt_update(crc, header[i]);
-    }
-    for (i=0 ; i < len ; i++){
-        crc = crc16_ccitt_update(crc, payload[i]);
-    }
+    uint16_t crc = btstack_crc16_ccitt_update(0xffff, header, 4);
+    crc = btstack_crc16_ccitt_update(crc, payload, len);
     return btstack_reverse_bits_16(crc);
 }
 
 // -----------------------------
-static void hci_transport_inactivity_timeout_handler(btstack_timer_source_t * ts){
+static void hci_transport_inactivity_timeout_handler(btstack_state_t *btstack, btstack_timer_source_t * ts){
     UNUSED(ts);
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
     log_info("inactivity timeout. link state %d, peer asleep %u, actions 0x%02x, outgoing packet %u",
-        link_state, link_peer_asleep, hci_transport_link_actions, hci_transport_link_have_outgoing_packet());
-    if (hci_transport_link_have_outgoing_packet()) return;
-    if (link_state != LINK_ACTIVE) return;
-    if (hci_transport_link_actions) return;
-    if (link_peer_asleep) return;
-    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SLEEP;
-    hci_transport_link_run();
+        h5->link_state, h5->link_peer_asleep, h5->link_actions, hci_transport_link_have_outgoing_packet(btstack));
+    if (hci_transport_link_have_outgoing_packet(btstack)) return;
+    if (h5->link_state != LINK_ACTIVE) return;
+    if (h5->link_actions) return;
+    if (h5->link_peer_asleep) return;
+    h5->link_actions |= HCI_TRANSPORT_LINK_SEND_SLEEP;
+    hci_transport_link_run(btstack);
 }
 
-static void hci_transport_inactivity_timer_set(void){
-    if (!link_inactivity_timeout_ms) return;
-    btstack_run_loop_set_timer_handler(&inactivity_timer, &hci_transport_inactivity_timeout_handler);
-    btstack_run_loop_set_timer(&inactivity_timer, link_inactivity_timeout_ms);
-    btstack_run_loop_remove_timer(&inactivity_timer);
-    btstack_run_loop_add_timer(&inactivity_timer);
+static void hci_transport_inactivity_timer_set(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (!h5->link_inactivity_timeout_ms) return;
+    btstack_run_loop_set_timer_handler(&h5->inactivity_timer, &hci_transport_inactivity_timeout_handler);
+    btstack_run_loop_remove_timer(btstack, &h5->inactivity_timer);
+    btstack_run_loop_set_timer(btstack, &h5->inactivity_timer, h5->link_inactivity_timeout_ms);
+    btstack_run_loop_add_timer(btstack, &h5->inactivity_timer);
 }
 
 // -----------------------------
 // SLIP Outgoing
 
 // Fill chunk and write
-static void hci_transport_slip_encode_chunk_and_send(int pos){
-    while (btstack_slip_encoder_has_data() & (pos < LINK_SLIP_TX_CHUNK_LEN)) {
-        slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-    }
+static void hci_transport_slip_encode_chunk_and_send(btstack_state_t *btstack, int pos){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    btstack_slip_encoder_t * encoder = &h5->slip_encoder;
+    pos += btstack_slip_encoder_encode(encoder, &h5->slip_outgoing_buffer[pos], LINK_SLIP_TX_CHUNK_LEN - pos);
 
-    if (!btstack_slip_encoder_has_data()){
+    if (!btstack_slip_encoder_has_data(encoder)){
         // Payload encoded, append DIC if present.
         // note: slip_outgoing_buffer is guaranteed to be big enough to add DIC + SOF after LINK_SLIP_TX_CHUNK_LEN
-        if (slip_outgoing_dic_present){
+        if (h5->slip_outgoing_dic_present){
             uint8_t dic_buffer[2];
-            big_endian_store_16(dic_buffer, 0, slip_outgoing_dic);
-            btstack_slip_encoder_start(dic_buffer, 2);
-            while (btstack_slip_encoder_has_data()){
-                slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-            } 
+            big_endian_store_16(dic_buffer, 0, h5->slip_outgoing_dic);
+            btstack_slip_encoder_start(encoder, dic_buffer, 2);
+            pos += btstack_slip_encoder_encode(encoder, &h5->slip_outgoing_buffer[pos], sizeof(h5->slip_outgoing_buffer) - pos);
         }
         // Start of Frame
-        slip_outgoing_buffer[pos++] = BTSTACK_SLIP_SOF;
+        h5->slip_outgoing_buffer[pos++] = BTSTACK_SLIP_SOF;
     }
-    slip_write_active = 1;
+    h5->slip_write_active = 1;
     log_debug("slip: send %d bytes", pos);
-    btstack_uart->send_block(slip_outgoing_buffer, pos);
+    h5->btstack_uart->send_block(btstack, h5->slip_outgoing_buffer, pos);
 }
 
-static inline void hci_transport_slip_send_next_chunk(void){
-    hci_transport_slip_encode_chunk_and_send(0);
+static inline void hci_transport_slip_send_next_chunk(btstack_state_t *btstack){
+    hci_transport_slip_encode_chunk_and_send(btstack, 0);
 }
 
 // format: 0xc0 HEADER PACKET [DIC] 0xc0
 // @param uint8_t header[4]
-static void hci_transport_slip_send_frame(const uint8_t * header, const uint8_t * packet, uint16_t packet_size, uint16_t data_integrity_check){
-    
+static void hci_transport_slip_send_frame(btstack_state_t *btstack, const uint8_t * header, const uint8_t * packet, uint16_t packet_size, uint16_t data_integrity_check){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    btstack_slip_encoder_t * encoder = &h5->slip_encoder;
+
     int pos = 0;
     
     // store data integrity check info
-    slip_outgoing_dic         = data_integrity_check;
-    slip_outgoing_dic_present = header[0] & 0x40;
+    h5->slip_outgoing_dic         = data_integrity_check;
+    h5->slip_outgoing_dic_present = header[0] & 0x40;
 
     // Start of Frame
-    slip_outgoing_buffer[pos++] = BTSTACK_SLIP_SOF;
+    h5->slip_outgoing_buffer[pos++] = BTSTACK_SLIP_SOF;
 
     // Header
-    btstack_slip_encoder_start(header, 4);
-    while (btstack_slip_encoder_has_data()){
-        slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-    }
+    btstack_slip_encoder_start(encoder, header, 4);
+    pos += btstack_slip_encoder_encode(encoder, &h5->slip_outgoing_buffer[pos], sizeof(h5->slip_outgoing_buffer) - pos);
 
     // Packet
-    btstack_slip_encoder_start(packet, packet_size);
+    btstack_slip_encoder_start(encoder, packet, packet_size);
 
     // Fill rest of chunk from packet and send
-    hci_transport_slip_encode_chunk_and_send(pos);
+    hci_transport_slip_encode_chunk_and_send(btstack, pos);
 }
 
 // SLIP Incoming
 
-static void hci_transport_slip_init(void){
-    btstack_slip_decoder_init(&hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE], 6 + HCI_INCOMING_PACKET_BUFFER_SIZE);
+static void hci_transport_slip_init(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    btstack_slip_decoder_init(&h5->slip_decoder, &h5->hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE], 6 + HCI_INCOMING_PACKET_BUFFER_SIZE);
 }
 
 // H5 Three-Wire Implementation
@@ -295,236 +327,332 @@ static void hci_transport_link_calc_header(uint8_t * header,
     header[3] = 0xff - (header[0] + header[1] + header[2]);
 }
 
-static void hci_transport_link_send_control(const uint8_t * message, int message_len){
+static void hci_transport_link_send_control(btstack_state_t *btstack, const uint8_t * message, int message_len){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
     uint8_t header[4];
-    hci_transport_link_calc_header(header, 0, 0, link_peer_supports_data_integrity_check, 0, LINK_CONTROL_PACKET_TYPE, message_len);
+    hci_transport_link_calc_header(header, 0, 0, h5->link_peer_supports_data_integrity_check, 0, LINK_CONTROL_PACKET_TYPE, message_len);
     uint16_t data_integrity_check = 0;    
-    if (link_peer_supports_data_integrity_check){
+    if (h5->link_peer_supports_data_integrity_check){
         data_integrity_check = crc16_calc_for_slip_frame(header, message, message_len);
     }
-    log_debug("hci_transport_link_send_control: size %u, append dic %u", message_len, link_peer_supports_data_integrity_check);
+    log_debug("hci_transport_link_send_control: size %u, append dic %u", message_len, h5->link_peer_supports_data_integrity_check);
     log_debug_hexdump(message, message_len);
-    hci_transport_slip_send_frame(header, message, message_len, data_integrity_check);
+    hci_transport_slip_send_frame(btstack, header, message, message_len, data_integrity_check);
 }
 
-static void hci_transport_link_send_sync(void){
+static void hci_transport_link_send_sync(btstack_state_t *btstack){
     log_debug("link send sync");
-    hci_transport_link_send_control(link_control_sync, sizeof(link_control_sync));
+    hci_transport_link_send_control(btstack, link_control_sync, sizeof(link_control_sync));
 }
 
-static void hci_transport_link_send_sync_response(void){
+static void hci_transport_link_send_sync_response(btstack_state_t *btstack){
     log_debug("link send sync response");
-    hci_transport_link_send_control(link_control_sync_response, sizeof(link_control_sync_response));
+    hci_transport_link_send_control(btstack, link_control_sync_response, sizeof(link_control_sync_response));
 }
 
-static void hci_transport_link_send_config(void){
+static void hci_transport_link_send_config(btstack_state_t *btstack){
     log_debug("link send config");
-    hci_transport_link_send_control(link_control_config, sizeof(link_control_config));
+    hci_transport_link_send_control(btstack, link_control_config, sizeof(link_control_config));
 }
 
-static void hci_transport_link_send_config_response(void){
+static void hci_transport_link_send_config_response(btstack_state_t *btstack){
     log_debug("link send config response");
-    hci_transport_link_send_control(link_control_config_response, sizeof(link_control_config_response));
+    hci_transport_link_send_control(btstack, link_control_config_response, sizeof(link_control_config_response));
 }
 
-static void hci_transport_link_send_config_response_empty(void){
+static void hci_transport_link_send_config_response_empty(btstack_state_t *btstack){
     log_debug("link send config response empty");
     static const uint8_t link_control_config_response_empty[] = { 0x04, 0x7b};
-    hci_transport_link_send_control(link_control_config_response_empty, sizeof(link_control_config_response_empty));
+    hci_transport_link_send_control(btstack, link_control_config_response_empty, sizeof(link_control_config_response_empty));
 }
 
-static void hci_transport_link_send_woken(void){
+static void hci_transport_link_send_woken(btstack_state_t *btstack){
     log_debug("link send woken");
-    hci_transport_link_send_control(link_control_woken, sizeof(link_control_woken));
+    hci_transport_link_send_control(btstack, link_control_woken, sizeof(link_control_woken));
 }
 
-static void hci_transport_link_send_wakeup(void){
+static void hci_transport_link_send_wakeup(btstack_state_t *btstack){
     log_debug("link send wakeup");
-    hci_transport_link_send_control(link_control_wakeup, sizeof(link_control_wakeup));
+    hci_transport_link_send_control(btstack, link_control_wakeup, sizeof(link_control_wakeup));
 }
 
-static void hci_transport_link_send_sleep(void){
+static void hci_transport_link_send_sleep(btstack_state_t *btstack){
     log_debug("link send sleep");
-    hci_transport_link_send_control(link_control_sleep, sizeof(link_control_sleep));
+    hci_transport_link_send_control(btstack, link_control_sleep, sizeof(link_control_sleep));
 }
 
-static void hci_transport_link_send_queued_packet(void){
+static int hci_transport_link_have_unsent_packet(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    return h5->link_tx_next < h5->link_tx_queue_num;
+}
+
+// send next packet from retransmit queue
+static void hci_transport_link_send_queued_packet(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+
+    // (re)start resend timer when sending oldest unacknowledged packet
+    if (h5->link_tx_next == 0){
+        hci_transport_link_set_timer(btstack, h5->link_resend_timeout_ms);
+    }
+
+    hci_transport_link_packet_t * queued_packet = &h5->link_tx_queue[(h5->link_tx_queue_head + h5->link_tx_next) % HCI_TRANSPORT_H5_WINDOW_SIZE];
+    h5->link_tx_next++;
+    if (h5->link_tx_next > h5->link_tx_num_sent){
+        h5->link_tx_num_sent = h5->link_tx_next;
+    }
 
     uint8_t header[4];
-    hci_transport_link_calc_header(header, link_seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, 1, hci_packet_type, hci_packet_size);
+    hci_transport_link_calc_header(header, queued_packet->seq_nr, h5->link_ack_nr, h5->link_peer_supports_data_integrity_check, 1, queued_packet->packet_type, queued_packet->size);
 
     uint16_t data_integrity_check = 0;
-    if (link_peer_supports_data_integrity_check){
-        data_integrity_check = crc16_calc_for_slip_frame(header, hci_packet, hci_packet_size);
+    if (h5->link_peer_supports_data_integrity_check){
+        data_integrity_check = crc16_calc_for_slip_frame(header, queued_packet->packet, queued_packet->size);
     }
-    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", link_seq_nr, link_ack_nr, hci_packet_size, link_peer_supports_data_integrity_check, data_integrity_check);
-    log_debug_hexdump(hci_packet, hci_packet_size);
+    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", queued_packet->seq_nr, h5->link_ack_nr, queued_packet->size, h5->link_peer_supports_data_integrity_check, data_integrity_check);
+    log_debug_hexdump(queued_packet->packet, queued_packet->size);
 
-    hci_transport_slip_send_frame(header, hci_packet, hci_packet_size, data_integrity_check);
+    hci_transport_slip_send_frame(btstack, header, queued_packet->packet, queued_packet->size, data_integrity_check);
 
     // reset inactvitiy timer
-    hci_transport_inactivity_timer_set();
+    hci_transport_inactivity_timer_set(btstack);
 }
 
-static void hci_transport_link_send_ack_packet(void){
+static void hci_transport_link_send_ack_packet(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
     // Pure ACK package is without DIC as there is no payload either
-    log_debug("send ack %u", link_ack_nr);
+    log_debug("send ack %u", h5->link_ack_nr);
     uint8_t header[4];
-    hci_transport_link_calc_header(header, 0, link_ack_nr, 0, 0, LINK_ACKNOWLEDGEMENT_TYPE, 0);
-    hci_transport_slip_send_frame(header, NULL, 0, 0);
+    hci_transport_link_calc_header(header, 0, h5->link_ack_nr, 0, 0, LINK_ACKNOWLEDGEMENT_TYPE, 0);
+    hci_transport_slip_send_frame(btstack, header, NULL, 0, 0);
 }
 
-static void hci_transport_link_run(void){
+static void hci_transport_link_run(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+
     // exit if outgoing active
-    if (slip_write_active) return;
+    if (h5->slip_write_active) return;
+
+    // exit if peer sent XOFF
+    if (h5->link_tx_paused) return;
 
     // process queued requests
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_SYNC){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_SYNC;
-        hci_transport_link_send_sync();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_SYNC){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_SYNC;
+        hci_transport_link_send_sync(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE;
-        hci_transport_link_send_sync_response();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE;
+        hci_transport_link_send_sync_response(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_CONFIG){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_CONFIG;
-        hci_transport_link_send_config();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_CONFIG){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_CONFIG;
+        hci_transport_link_send_config(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE;
-        hci_transport_link_send_config_response();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE;
+        hci_transport_link_send_config_response(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY;
-        hci_transport_link_send_config_response_empty();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY;
+        hci_transport_link_send_config_response_empty(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_WOKEN){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_WOKEN;
-        hci_transport_link_send_woken();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_WOKEN){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_WOKEN;
+        hci_transport_link_send_woken(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_WAKEUP){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_WAKEUP;
-        hci_transport_link_send_wakeup();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_WAKEUP){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_WAKEUP;
+        hci_transport_link_send_wakeup(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        // packet already contains ack, no need to send addtitional one
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
-        hci_transport_link_send_queued_packet();
-        return;
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET){
+        if (hci_transport_link_have_unsent_packet(btstack) && !h5->link_peer_asleep){
+            // packet already contains ack, no need to send addtitional one
+            h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+            hci_transport_link_send_queued_packet(btstack);
+            if (!hci_transport_link_have_unsent_packet(btstack)){
+                h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
+            }
+            return;
+        }
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_ACK_PACKET){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
-        hci_transport_link_send_ack_packet();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_ACK_PACKET){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+        hci_transport_link_send_ack_packet(btstack);
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_SLEEP){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_SLEEP;
-        hci_transport_link_actions |=  HCI_TRANSPORT_LINK_ENTER_SLEEP;
-        link_peer_asleep = 1;
-        hci_transport_link_send_sleep();
+    if (h5->link_actions & HCI_TRANSPORT_LINK_SEND_SLEEP){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_SEND_SLEEP;
+        h5->link_actions |=  HCI_TRANSPORT_LINK_ENTER_SLEEP;
+        h5->link_peer_asleep = 1;
+        hci_transport_link_send_sleep(btstack);
         return;
     }
 }
 
-static void hci_transport_link_set_timer(uint16_t timeout_ms){
-    btstack_run_loop_set_timer_handler(&link_timer, &hci_transport_link_timeout_handler);
-    btstack_run_loop_set_timer(&link_timer, timeout_ms);
-    btstack_run_loop_add_timer(&link_timer);
+static void hci_transport_link_set_timer(btstack_state_t *btstack, uint16_t timeout_ms){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    btstack_run_loop_remove_timer(btstack, &h5->link_timer);
+    btstack_run_loop_set_timer_handler(&h5->link_timer, &hci_transport_link_timeout_handler);
+    btstack_run_loop_set_timer(btstack, &h5->link_timer, timeout_ms);
+    btstack_run_loop_add_timer(btstack, &h5->link_timer);
 }
 
-static void hci_transport_link_timeout_handler(btstack_timer_source_t * ts){
+static void hci_transport_link_timeout_handler(btstack_state_t *btstack, btstack_timer_source_t * ts){
     UNUSED(ts);
-    switch (link_state){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    switch (h5->link_state){
         case LINK_UNINITIALIZED:
-            hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC;
-            hci_transport_link_set_timer(LINK_PERIOD_MS);
+            h5->link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC;
+            hci_transport_link_set_timer(btstack, LINK_PERIOD_MS);
             break;            
         case LINK_INITIALIZED:
-            hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG;
-            hci_transport_link_set_timer(LINK_PERIOD_MS);
+            h5->link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG;
+            hci_transport_link_set_timer(btstack, LINK_PERIOD_MS);
             break;
         case LINK_ACTIVE:
-            if (!hci_transport_link_have_outgoing_packet()){
+            if (!hci_transport_link_have_outgoing_packet(btstack)){
                 log_info("h5 timeout while active, but no outgoing packet");
                 return;
             }
-            if (link_peer_asleep){
-                hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_WAKEUP;
-                hci_transport_link_set_timer(LINK_WAKEUP_MS);
+            if (h5->link_peer_asleep){
+                h5->link_actions |= HCI_TRANSPORT_LINK_SEND_WAKEUP;
+                hci_transport_link_set_timer(btstack, LINK_WAKEUP_MS);
                 return;
             }
-            // resend packet
-            hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-            hci_transport_link_set_timer(link_resend_timeout_ms);
+            // assume XON got lost
+            if (h5->link_tx_paused){
+                log_info("h5 timeout while paused by XOFF, resume");
+                h5->link_tx_paused = 0;
+                if (h5->slip_write_paused){
+                    h5->slip_write_paused = 0;
+                    hci_transport_h5_block_sent(btstack);
+                }
+            }
+            // go back n: resend all unacknowledged packets, timer is restarted when first one is sent
+            log_info("h5 resend %u packets starting with seq %u", h5->link_tx_num_sent, h5->link_tx_queue[h5->link_tx_queue_head].seq_nr);
+            h5->link_tx_next = 0;
+            h5->link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
             break;
         default:
             break;
     }
 
-    hci_transport_link_run();
+    hci_transport_link_run(btstack);
+}
+
+static void hci_transport_link_set_oof_flow_control(btstack_state_t *btstack, uint8_t enabled){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    h5->link_oof_flow_control = enabled;
+    h5->link_tx_paused = 0;
+    btstack_slip_encoder_set_escape_xon_xoff(&h5->slip_encoder, enabled);
 }
 
-static void hci_transport_link_init(void){
-    link_state = LINK_UNINITIALIZED;
-    link_peer_asleep = 0;
-    link_peer_supports_data_integrity_check = 0;
+static void hci_transport_link_init(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    h5->link_state = LINK_UNINITIALIZED;
+    h5->link_peer_asleep = 0;
+    h5->link_peer_supports_data_integrity_check = 0;
+    h5->link_window_size = 1;
+    hci_transport_link_set_oof_flow_control(btstack, 0);
  
     // get started
-    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC;
-    hci_transport_link_set_timer(LINK_PERIOD_MS);
-    hci_transport_link_run();
+    h5->link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC;
+    hci_transport_link_set_timer(btstack, LINK_PERIOD_MS);
+    hci_transport_link_run(btstack);
 }
 
 static int hci_transport_link_inc_seq_nr(int seq_nr){
     return (seq_nr + 1) & 0x07;    
 }
 
-static int hci_transport_link_have_outgoing_packet(void){
-    return hci_packet != NULL;
+static int hci_transport_link_have_outgoing_packet(btstack_state_t *btstack){
+    return btstack->hci_h5->link_tx_queue_num > 0;
 }
 
-static void hci_transport_link_clear_queue(void){
-    btstack_run_loop_remove_timer(&link_timer);
-    hci_packet = NULL;
+static void hci_transport_link_clear_queue(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    btstack_run_loop_remove_timer(btstack, &h5->link_timer);
+    h5->link_tx_queue_head = 0;
+    h5->link_tx_queue_num  = 0;
+    h5->link_tx_num_sent   = 0;
+    h5->link_tx_next       = 0;
 }
 
-static void hci_transport_h5_queue_packet(uint8_t packet_type, uint8_t *packet, int size){
-    hci_packet = packet;
-    hci_packet_type = packet_type;
-    hci_packet_size = size;
+static void hci_transport_h5_queue_packet(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, int size){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    hci_transport_link_packet_t * queued_packet = &h5->link_tx_queue[(h5->link_tx_queue_head + h5->link_tx_queue_num) % HCI_TRANSPORT_H5_WINDOW_SIZE];
+    queued_packet->packet      = packet;
+    queued_packet->packet_type = packet_type;
+    queued_packet->size        = size;
+    queued_packet->seq_nr      = h5->link_seq_nr;
+    h5->link_seq_nr = hci_transport_link_inc_seq_nr(h5->link_seq_nr);
+    h5->link_tx_queue_num++;
 }
 
-static void hci_transport_h5_emit_sleep_state(int sleep_active){
-    static int last_state = 0;
-    if (sleep_active == last_state) return;
-    last_state = sleep_active;
+// remove packets acknowledged by ack_nr from retransmit queue
+static void hci_transport_link_process_ack(btstack_state_t *btstack, uint8_t ack_nr){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (h5->link_tx_num_sent == 0) return;
+
+    // peer expects ack_nr next, so all packets before ack_nr have been received
+    uint8_t num_acked = (ack_nr - h5->link_tx_queue[h5->link_tx_queue_head].seq_nr) & 0x07;
+    if (num_acked == 0) return;
+    if (num_acked > h5->link_tx_num_sent){
+        log_info("ack nr %u for packet not sent yet", ack_nr);
+        return;
+    }
+    log_debug("outgoing packets with seq %u..%u ack'ed", h5->link_tx_queue[h5->link_tx_queue_head].seq_nr, (ack_nr - 1) & 0x07);
+
+    h5->link_tx_queue_head = (h5->link_tx_queue_head + num_acked) % HCI_TRANSPORT_H5_WINDOW_SIZE;
+    h5->link_tx_queue_num -= num_acked;
+    h5->link_tx_num_sent  -= num_acked;
+    h5->link_tx_next = (h5->link_tx_next > num_acked) ? (h5->link_tx_next - num_acked) : 0;
+
+    // restart resend timer for remaining unacknowledged packets
+    btstack_run_loop_remove_timer(btstack, &h5->link_timer);
+    if (h5->link_tx_num_sent > 0){
+        hci_transport_link_set_timer(btstack, h5->link_resend_timeout_ms);
+    }
+
+    // notify upper stack that it can send again, once per packet
+    while (num_acked > 0){
+        num_acked--;
+        uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+        h5->packet_handler(btstack, HCI_EVENT_PACKET, &event[0], sizeof(event));
+    }
+}
+
+static void hci_transport_h5_emit_sleep_state(btstack_state_t *btstack, int sleep_active){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (sleep_active == h5->sleep_active) return;
+    h5->sleep_active = sleep_active;
     
     log_info("emit_sleep_state: %u", sleep_active);
     uint8_t event[3];
     event[0] = HCI_EVENT_TRANSPORT_SLEEP_MODE;
     event[1] = sizeof(event) - 2;
     event[2] = sleep_active;
-    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));        
+    h5->packet_handler(btstack, HCI_EVENT_PACKET, &event[0], sizeof(event));
 }
 
-static void hci_transport_h5_process_frame(uint16_t frame_size){
+static void hci_transport_h5_process_frame(btstack_state_t *btstack, uint16_t frame_size){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
 
     static const uint8_t link_control_config_prefix_len  = 2;
     static const uint8_t link_control_config_response_prefix_len  = 2;
 
     if (frame_size < 4) return;
 
-    uint8_t * slip_header  = &hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
-    uint8_t * slip_payload = &hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 4];
+    uint8_t * slip_header  = &h5->hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    uint8_t * slip_payload = &h5->hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 4];
     int       frame_size_without_header = frame_size - 4;
 
     uint8_t  seq_nr =  slip_header[0] & 0x07;
@@ -543,7 +671,7 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
     const uint8_t sync_response_bcsp[] = {0x01, 0x7a, 0x06, 0x10};
     if (memcmp(sync_response_bcsp, slip_header, 4) == 0){
         log_info("detected BSCP SYNC sent with Even Parity -> discard frame and enable Even Parity");
-        btstack_uart->set_parity(1);
+        h5->btstack_uart->set_parity(btstack, 1);
         return;
     }
 
@@ -572,22 +700,22 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
         }
     }
 
-    switch (link_state){
+    switch (h5->link_state){
         case LINK_UNINITIALIZED:
             if (link_packet_type != LINK_CONTROL_PACKET_TYPE) break;
             if (memcmp(slip_payload, link_control_sync, sizeof(link_control_sync)) == 0){
                 log_debug("link received sync");
-                hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE;
+                h5->link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE;
                 break;
             }
             if (memcmp(slip_payload, link_control_sync_response, sizeof(link_control_sync_response)) == 0){
                 log_debug("link received sync response");
-                link_state = LINK_INITIALIZED;
-                btstack_run_loop_remove_timer(&link_timer);
+                h5->link_state = LINK_INITIALIZED;
+                btstack_run_loop_remove_timer(btstack, &h5->link_timer);
                 log_info("link initialized");
                 //
-                hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG;
-                hci_transport_link_set_timer(LINK_PERIOD_MS);
+                h5->link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG;
+                hci_transport_link_set_timer(btstack, LINK_PERIOD_MS);
                 break;
             }
             break;
@@ -595,73 +723,71 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
             if (link_packet_type != LINK_CONTROL_PACKET_TYPE) break;
             if (memcmp(slip_payload, link_control_sync, sizeof(link_control_sync)) == 0){
                 log_debug("link received sync");
-                hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE;
+                h5->link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC_RESPONSE;
                 break;
             }
             if (memcmp(slip_payload, link_control_config, link_control_config_prefix_len) == 0){
                 if (link_payload_len == link_control_config_prefix_len){
                     log_debug("link received config, no config field");
-                    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY;
+                    h5->link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY;
                 } else {
                     log_debug("link received config, 0x%02x", slip_payload[2]);
-                    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE;
+                    h5->link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE;
                 }
                 break;
             }
             if (memcmp(slip_payload, link_control_config_response, link_control_config_response_prefix_len) == 0){
-                uint8_t config = slip_payload[2];
-                link_peer_supports_data_integrity_check = (config & 0x10) != 0;
-                log_info("link received config response 0x%02x, data integrity check supported %u", config, link_peer_supports_data_integrity_check);
-                link_state = LINK_ACTIVE;
-                btstack_run_loop_remove_timer(&link_timer);
+                // peer without config field uses defaults: sliding window 1, no flow control, no data integrity check
+                uint8_t config = (link_payload_len > link_control_config_response_prefix_len) ? slip_payload[2] : 0x01;
+                uint8_t peer_window_size = config & 0x07;
+                if (peer_window_size == 0){
+                    peer_window_size = 1;
+                }
+                h5->link_window_size = btstack_min(LINK_CONFIG_SLIDING_WINDOW_SIZE, peer_window_size);
+                h5->link_peer_supports_data_integrity_check = (config & 0x10) != 0;
+                hci_transport_link_set_oof_flow_control(btstack, LINK_CONFIG_OOF_FLOW_CONTROL && ((config & 0x08) != 0));
+                log_info("link received config response 0x%02x, sliding window %u, oof flow control %u, data integrity check supported %u", config,
+                    h5->link_window_size, h5->link_oof_flow_control, h5->link_peer_supports_data_integrity_check);
+                h5->link_state = LINK_ACTIVE;
+                btstack_run_loop_remove_timer(btstack, &h5->link_timer);
                 log_info("link activated");
                 // 
-                link_seq_nr = 0;
-                link_ack_nr = 0;
+                h5->link_seq_nr = 0;
+                h5->link_ack_nr = 0;
                 // notify upper stack that it can start
                 uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-                packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+                h5->packet_handler(btstack, HCI_EVENT_PACKET, &event[0], sizeof(event));
                 break;
             }
             break;
         case LINK_ACTIVE:
 
+            // Process ACKs in reliable packet and explicit ack packets
+            if (reliable_packet || (link_packet_type == LINK_ACKNOWLEDGEMENT_TYPE)){
+                hci_transport_link_process_ack(btstack, ack_nr);
+            }
+
             // validate packet sequence nr in reliable packets (check for out of sequence error)
             if (reliable_packet){
-                if (seq_nr != link_ack_nr){
-                    log_info("expected seq nr %u, but received %u", link_ack_nr, seq_nr);
-                    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+                if (seq_nr != h5->link_ack_nr){
+                    log_info("expected seq nr %u, but received %u", h5->link_ack_nr, seq_nr);
+                    h5->link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
                     break;
                 }
                 // ack packet right away
-                link_ack_nr = hci_transport_link_inc_seq_nr(link_ack_nr);
-                hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+                h5->link_ack_nr = hci_transport_link_inc_seq_nr(h5->link_ack_nr);
+                h5->link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
             }
 
-            // Process ACKs in reliable packet and explicit ack packets
-            if (reliable_packet || (link_packet_type == LINK_ACKNOWLEDGEMENT_TYPE)){
-                // our packet is good if the remote expects our seq nr + 1
-                int next_seq_nr = hci_transport_link_inc_seq_nr(link_seq_nr);
-                if (hci_transport_link_have_outgoing_packet() && (next_seq_nr == ack_nr)){
-                    log_debug("outoing packet with seq %u ack'ed", link_seq_nr);
-                    link_seq_nr = next_seq_nr;
-                    hci_transport_link_clear_queue();
-
-                    // notify upper stack that it can send again
-                    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-                    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
-                }
-            } 
-
             switch (link_packet_type){
                 case LINK_CONTROL_PACKET_TYPE:
                     if (memcmp(slip_payload, link_control_config, sizeof(link_control_config)) == 0){
                         if (link_payload_len == link_control_config_prefix_len){
                             log_debug("link received config, no config field");
-                            hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY;
+                            h5->link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE_EMPTY;
                         } else {
                             log_debug("link received config, 0x%02x", slip_payload[2]);
-                            hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE;
+                            h5->link_actions |= HCI_TRANSPORT_LINK_SEND_CONFIG_RESPONSE;
                         }
                         break;
                     }
@@ -671,26 +797,29 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
                         break;
                     }
                     if (memcmp(slip_payload, link_control_sleep, sizeof(link_control_sleep)) == 0){
-                        if (btstack_uart_sleep_mode){
+                        if (h5->btstack_uart_sleep_mode){
                             log_info("link: received sleep message. Enabling UART Sleep.");
-                            btstack_uart->set_sleep(btstack_uart_sleep_mode);
-                            hci_transport_h5_emit_sleep_state(1);
+                            h5->btstack_uart->set_sleep(h5->btstack_uart_sleep_mode);
+                            hci_transport_h5_emit_sleep_state(btstack, 1);
                         } else {
                             log_info("link: received sleep message. UART Sleep not supported");
                         }
-                        link_peer_asleep = 1;
+                        h5->link_peer_asleep = 1;
                         break;
                     }
                     if (memcmp(slip_payload, link_control_wakeup, sizeof(link_control_wakeup)) == 0){
                         log_info("link: received wakupe message -> send woken");
-                        link_peer_asleep = 0;
-                        hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_WOKEN;
+                        h5->link_peer_asleep = 0;
+                        h5->link_actions |= HCI_TRANSPORT_LINK_SEND_WOKEN;
                         break;
                     }
                     if (memcmp(slip_payload, link_control_woken, sizeof(link_control_woken)) == 0){
                         log_info("link: received woken message");
-                        link_peer_asleep = 0;
-                        // queued packet will be sent in hci_transport_link_run if needed
+                        h5->link_peer_asleep = 0;
+                        // send queued packets
+                        if (hci_transport_link_have_unsent_packet(btstack)){
+                            h5->link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
+                        }
                         break;
                     }
                     break;
@@ -698,11 +827,11 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
                 case HCI_ACL_DATA_PACKET:
                 case HCI_SCO_DATA_PACKET:
                     // seems like peer is awake
-                    link_peer_asleep = 0;
+                    h5->link_peer_asleep = 0;
                     // forward packet to stack
-                    packet_handler(link_packet_type, slip_payload, link_payload_len);
+                    h5->packet_handler(btstack, link_packet_type, slip_payload, link_payload_len);
                     // reset inactvitiy timer
-                    hci_transport_inactivity_timer_set();
+                    hci_transport_inactivity_timer_set(btstack);
                     break;
             }
 
@@ -711,7 +840,7 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
             break;
     }
 
-    hci_transport_link_run();
+    hci_transport_link_run(btstack);
 }
 
 // recommendet time until resend: 3 * time of largest packet
@@ -726,74 +855,148 @@ static uint16_t hci_transport_link_calc_resend_timeout(uint32_t baudrate){
     return t_max_x3_ms;
 }
 
-static void hci_transport_link_update_resend_timeout(uint32_t baudrate){
-    link_resend_timeout_ms = hci_transport_link_calc_resend_timeout(baudrate);
+static void hci_transport_link_update_resend_timeout(btstack_state_t *btstack, uint32_t baudrate){
+    btstack->hci_h5->link_resend_timeout_ms = hci_transport_link_calc_resend_timeout(baudrate);
 }
 
 /// H5 Interface
 
-static uint8_t hci_transport_link_read_byte;
-static int hci_transport_h5_active;
+static void hci_transport_h5_read_next_byte(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (h5->bulk_read){
+        h5->btstack_uart->receive_data(btstack, h5->read_buffer, sizeof(h5->read_buffer));
+    } else {
+        h5->btstack_uart->receive_block(btstack, &h5->read_byte, 1);
+    }
+}
 
-static void hci_transport_h5_read_next_byte(void){
-    btstack_uart->receive_block(&hci_transport_link_read_byte, 1);    
+// handle XON/XOFF outside of SLIP frames
+static void hci_transport_h5_process_flow_control(btstack_state_t *btstack, uint8_t flow_control){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (flow_control == BTSTACK_SLIP_XOFF){
+        log_debug("link: received XOFF");
+        h5->link_tx_paused = 1;
+        return;
+    }
+    log_debug("link: received XON");
+    h5->link_tx_paused = 0;
+    if (h5->slip_write_paused){
+        // continue with current frame
+        h5->slip_write_paused = 0;
+        hci_transport_h5_block_sent(btstack);
+    } else {
+        hci_transport_link_run(btstack);
+    }
+}
+
+static void hci_transport_h5_check_frame_complete(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    uint16_t frame_size = btstack_slip_decoder_frame_size(&h5->slip_decoder);
+    if (frame_size == 0) return;
+
+    // track time
+    uint32_t packet_receive_time = btstack_run_loop_get_time_ms(btstack) - h5->receive_start;
+    uint32_t nominal_time = (frame_size + 6) * 10 * 1000 / h5->uart_config.baudrate;
+    UNUSED(nominal_time);
+    UNUSED(packet_receive_time);
+    log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominal_time);
+    // reset state
+    h5->receive_start = 0;
+    // 
+    hci_transport_h5_process_frame(btstack, frame_size);
+    hci_transport_slip_init(btstack);
 }
 
-// track time receiving SLIP frame
-static uint32_t hci_transport_h5_receive_start;
-static void hci_transport_h5_block_received(void){
-    if (hci_transport_h5_active == 0) return;
+static void hci_transport_h5_block_received(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (h5->active == 0) return;
+
+    uint8_t read_byte = h5->read_byte;
+    if (h5->link_oof_flow_control && ((read_byte == BTSTACK_SLIP_XON) || (read_byte == BTSTACK_SLIP_XOFF))){
+        hci_transport_h5_read_next_byte(btstack);
+        hci_transport_h5_process_flow_control(btstack, read_byte);
+        return;
+    }
 
     // track start time when receiving first byte // a bit hackish
-    if ((hci_transport_h5_receive_start == 0) && (hci_transport_link_read_byte != BTSTACK_SLIP_SOF)){
-        hci_transport_h5_receive_start = btstack_run_loop_get_time_ms();
-    }
-    btstack_slip_decoder_process(hci_transport_link_read_byte);
-    uint16_t frame_size = btstack_slip_decoder_frame_size();
-    if (frame_size) {
-        // track time
-        uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
-        uint32_t nominal_time = (frame_size + 6) * 10 * 1000 / uart_config.baudrate;
-        UNUSED(nominal_time);
-        UNUSED(packet_receive_time);
-        log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominal_time);
-        // reset state
-        hci_transport_h5_receive_start = 0;
-        // 
-        hci_transport_h5_process_frame(frame_size);
-        hci_transport_slip_init();
-    }
-    hci_transport_h5_read_next_byte();
-}
-
-static void hci_transport_h5_block_sent(void){
-    if (hci_transport_h5_active == 0) return;
+    if ((h5->receive_start == 0) && (read_byte != BTSTACK_SLIP_SOF)){
+        h5->receive_start = btstack_run_loop_get_time_ms(btstack);
+    }
+    btstack_slip_decoder_process(&h5->slip_decoder, read_byte);
+    hci_transport_h5_check_frame_complete(btstack);
+    hci_transport_h5_read_next_byte(btstack);
+}
+
+static void hci_transport_h5_data_received(btstack_state_t *btstack, uint16_t len){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (h5->active == 0) return;
+
+    uint16_t pos = 0;
+    while (pos < len){
+        // decode up to next XON/XOFF
+        uint16_t end = len;
+        if (h5->link_oof_flow_control){
+            uint16_t i;
+            for (i = pos; i < len; i++){
+                if ((h5->read_buffer[i] == BTSTACK_SLIP_XON) || (h5->read_buffer[i] == BTSTACK_SLIP_XOFF)){
+                    end = i;
+                    break;
+                }
+            }
+        }
+        while (pos < end){
+            if (h5->receive_start == 0){
+                h5->receive_start = btstack_run_loop_get_time_ms(btstack);
+            }
+            pos += btstack_slip_decoder_process_data(&h5->slip_decoder, &h5->read_buffer[pos], end - pos);
+            hci_transport_h5_check_frame_complete(btstack);
+            if (h5->active == 0) return;
+        }
+        if (pos < len){
+            hci_transport_h5_process_flow_control(btstack, h5->read_buffer[pos]);
+            pos++;
+        }
+    }
+    hci_transport_h5_read_next_byte(btstack);
+}
+
+static void hci_transport_h5_block_sent(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (h5->active == 0) return;
+
+    // stop sending after XOFF
+    if (h5->link_tx_paused){
+        h5->slip_write_paused = 1;
+        return;
+    }
 
     // check if more data to send
-    if (btstack_slip_encoder_has_data()){
-        hci_transport_slip_send_next_chunk();
+    if (btstack_slip_encoder_has_data(&h5->slip_encoder)){
+        hci_transport_slip_send_next_chunk(btstack);
         return;
     }
 
     // done
-    slip_write_active = 0;
+    h5->slip_write_active = 0;
 
     // enter sleep mode after sending sleep message
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_ENTER_SLEEP){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_ENTER_SLEEP;
-        if (btstack_uart_sleep_mode){
+    if (h5->link_actions & HCI_TRANSPORT_LINK_ENTER_SLEEP){
+        h5->link_actions &= ~HCI_TRANSPORT_LINK_ENTER_SLEEP;
+        if (h5->btstack_uart_sleep_mode){
             log_info("link: sent sleep message. Enabling UART Sleep.");
-            btstack_uart->set_sleep(btstack_uart_sleep_mode);
+            h5->btstack_uart->set_sleep(h5->btstack_uart_sleep_mode);
         } else {
             log_info("link: sent sleep message. UART Sleep not supported");
         }
-        hci_transport_h5_emit_sleep_state(1);
+        hci_transport_h5_emit_sleep_state(btstack, 1);
     }
 
-    hci_transport_link_run();
+    hci_transport_link_run(btstack);
 }
 
-static void hci_transport_h5_init(const void * transport_config){
+static void hci_transport_h5_init(btstack_state_t *btstack, const void * transport_config){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+
     // check for hci_transport_config_uart_t
     if (!transport_config) {
         log_error("hci_transport_h5: no config!");
@@ -804,129 +1007,147 @@ static void hci_transport_h5_init(const void * transport_config){
         return;
     }
 
-    hci_transport_h5_active = 0;
+    h5->active = 0;
 
     // extract UART config from transport config
     hci_transport_config_uart_t * hci_transport_config_uart = (hci_transport_config_uart_t*) transport_config;
-    uart_config.baudrate    = hci_transport_config_uart->baudrate_init;
-    uart_config.flowcontrol = hci_transport_config_uart->flowcontrol;
-    uart_config.device_name = hci_transport_config_uart->device_name;
+    h5->uart_config.baudrate    = hci_transport_config_uart->baudrate_init;
+    h5->uart_config.flowcontrol = hci_transport_config_uart->flowcontrol;
+    h5->uart_config.device_name = hci_transport_config_uart->device_name;
 
     // setup UART driver
-    btstack_uart->init(&uart_config);
-    btstack_uart->set_block_received(&hci_transport_h5_block_received);
-    btstack_uart->set_block_sent(&hci_transport_h5_block_sent);
+    h5->btstack_uart->init(btstack, &h5->uart_config);
+    h5->btstack_uart->set_block_received(btstack, &hci_transport_h5_block_received);
+    h5->btstack_uart->set_block_sent(btstack, &hci_transport_h5_block_sent);
+
+    // use bulk read if supported by UART driver
+    h5->bulk_read = (h5->btstack_uart->receive_data != NULL) && (h5->btstack_uart->set_data_received != NULL);
+    if (h5->bulk_read){
+        h5->btstack_uart->set_data_received(btstack, &hci_transport_h5_data_received);
+    }
 }
 
-static int hci_transport_h5_open(void){
-    int res = btstack_uart->open();
+static int hci_transport_h5_open(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    int res = h5->btstack_uart->open(btstack);
     if (res){
         return res;
     }        
     
     // 
-    if (hci_transport_bcsp_mode){
+    if (h5->bcsp_mode){
         log_info("enable even parity for BCSP mode");
-        btstack_uart->set_parity(1);
+        h5->btstack_uart->set_parity(btstack, 1);
     }
 
     // check if wake on RX can be used
-    btstack_uart_sleep_mode = BTSTACK_UART_SLEEP_OFF;
+    h5->btstack_uart_sleep_mode = BTSTACK_UART_SLEEP_OFF;
     int supported_sleep_modes = 0;
-    if (btstack_uart->get_supported_sleep_modes){
-        supported_sleep_modes = btstack_uart->get_supported_sleep_modes();
+    if (h5->btstack_uart->get_supported_sleep_modes){
+        supported_sleep_modes = h5->btstack_uart->get_supported_sleep_modes();
     }
     if (supported_sleep_modes & BTSTACK_UART_SLEEP_MASK_RTS_LOW_WAKE_ON_RX_EDGE){
         log_info("using wake on RX");
-        btstack_uart_sleep_mode = BTSTACK_UART_SLEEP_RTS_LOW_WAKE_ON_RX_EDGE;
+        h5->btstack_uart_sleep_mode = BTSTACK_UART_SLEEP_RTS_LOW_WAKE_ON_RX_EDGE;
     } else {
         log_info("UART driver does not provide compatible sleep mode");
     }
 
     // setup resend timeout
-    hci_transport_link_update_resend_timeout(uart_config.baudrate);
+    hci_transport_link_update_resend_timeout(btstack, h5->uart_config.baudrate);
+
+    // reset outgoing state
+    h5->slip_write_active = 0;
+    h5->slip_write_paused = 0;
+    hci_transport_link_clear_queue(btstack);
 
     // init slip parser state machine
-    hci_transport_slip_init();
+    hci_transport_slip_init(btstack);
 
     // init link management - already starts syncing
-    hci_transport_link_init();
+    hci_transport_link_init(btstack);
 
     // start receiving
-    hci_transport_h5_active = 1;
-    hci_transport_h5_read_next_byte();
+    h5->active = 1;
+    hci_transport_h5_read_next_byte(btstack);
 
     return 0;
 }
 
-static int hci_transport_h5_close(void){
-    hci_transport_h5_active = 0;
-    return btstack_uart->close();
+static int hci_transport_h5_close(btstack_state_t *btstack){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    h5->active = 0;
+    hci_transport_link_clear_queue(btstack);
+    btstack_run_loop_remove_timer(btstack, &h5->inactivity_timer);
+    return h5->btstack_uart->close(btstack);
 }
 
-static void hci_transport_h5_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
-    packet_handler = handler;
+static void hci_transport_h5_register_packet_handler(btstack_state_t *btstack, void (*handler)(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    btstack->hci_h5->packet_handler = handler;
 }
 
-static int hci_transport_h5_can_send_packet_now(uint8_t packet_type){
-    int res = !hci_transport_link_have_outgoing_packet() && (link_state == LINK_ACTIVE);
+static int hci_transport_h5_can_send_packet_now(btstack_state_t *btstack, uint8_t packet_type){
+    UNUSED(packet_type);
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    int res = (h5->link_state == LINK_ACTIVE) && (h5->link_tx_queue_num < h5->link_window_size);
     // log_info("can_send_packet_now: %u", res);
     return res;
 }
 
-static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, int size){
-    if (!hci_transport_h5_can_send_packet_now(packet_type)){
-        log_error("hci_transport_h5_send_packet called but in state %d", link_state);
+static int hci_transport_h5_send_packet(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, int size){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
+    if (!hci_transport_h5_can_send_packet_now(btstack, packet_type)){
+        log_error("hci_transport_h5_send_packet called but in state %d, %u packets queued", h5->link_state, h5->link_tx_queue_num);
         return -1;
     }
 
     // store request
-    hci_transport_h5_queue_packet(packet_type, packet, size);
+    hci_transport_h5_queue_packet(btstack, packet_type, packet, size);
 
     // send wakeup first
-    if (link_peer_asleep){
-        hci_transport_h5_emit_sleep_state(0);
-        if (btstack_uart_sleep_mode){
+    if (h5->link_peer_asleep){
+        hci_transport_h5_emit_sleep_state(btstack, 0);
+        if (h5->btstack_uart_sleep_mode){
             log_info("disable UART sleep");
-            btstack_uart->set_sleep(BTSTACK_UART_SLEEP_OFF);
+            h5->btstack_uart->set_sleep(BTSTACK_UART_SLEEP_OFF);
         }
-        hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_WAKEUP;
-        hci_transport_link_set_timer(LINK_WAKEUP_MS);
+        h5->link_actions |= HCI_TRANSPORT_LINK_SEND_WAKEUP;
+        hci_transport_link_set_timer(btstack, LINK_WAKEUP_MS);
     } else {
-        hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        hci_transport_link_set_timer(link_resend_timeout_ms);
+        h5->link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
     }
-    hci_transport_link_run();
+    hci_transport_link_run(btstack);
     return 0;
 }
 
-static int hci_transport_h5_set_baudrate(uint32_t baudrate){
+static int hci_transport_h5_set_baudrate(btstack_state_t *btstack, uint32_t baudrate){
+    struct btstack_hci_h5_state * h5 = btstack->hci_h5;
 
     log_info("set_baudrate %"PRIu32, baudrate);
-    int res = btstack_uart->set_baudrate(baudrate);
+    int res = h5->btstack_uart->set_baudrate(btstack, baudrate);
 
     if (res) return res;
-    uart_config.baudrate = baudrate;
-    hci_transport_link_update_resend_timeout(baudrate);
+    h5->uart_config.baudrate = baudrate;
+    hci_transport_link_update_resend_timeout(btstack, baudrate);
     return 0;
 }
 
-static void hci_transport_h5_reset_link(void){
+static void hci_transport_h5_reset_link(btstack_state_t *btstack){
 
     log_info("reset_link");
 
     // clear outgoing queue
-    hci_transport_link_clear_queue();
+    hci_transport_link_clear_queue(btstack);
 
     // init slip parser state machine
-    hci_transport_slip_init();
+    hci_transport_slip_init(btstack);
     
     // init link management - already starts syncing
-    hci_transport_link_init();
+    hci_transport_link_init(btstack);
 }
 
-// configure and return h5 singleton
-const hci_transport_t * hci_transport_h5_instance(const btstack_uart_block_t * uart_driver) {
+// configure and return h5 instance
+const hci_transport_t * hci_transport_h5_instance(btstack_state_t *btstack, const btstack_uart_block_t * uart_driver) {
 
     static const hci_transport_t hci_transport_h5 = {
             /* const char * name; */                                        "H5",
@@ -941,14 +1162,15 @@ const hci_transport_t * hci_transport_h5_instance(const btstack_uart_block_t * u
             /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
     };
 
-    btstack_uart = uart_driver;
+    btstack->hci_h5 = calloc(1, sizeof(struct btstack_hci_h5_state));
+    btstack->hci_h5->btstack_uart = uart_driver;
     return &hci_transport_h5;
 }
 
-void hci_transport_h5_set_auto_sleep(uint16_t inactivity_timeout_ms){
-    link_inactivity_timeout_ms = inactivity_timeout_ms;
+void hci_transport_h5_set_auto_sleep(btstack_state_t *btstack, uint16_t inactivity_timeout_ms){
+    btstack->hci_h5->link_inactivity_timeout_ms = inactivity_timeout_ms;
 }
 
-void hci_transport_h5_enable_bcsp_mode(void){
-    hci_transport_bcsp_mode = 1;
+void hci_transport_h5_enable_bcsp_mode(btstack_state_t *btstack){
+    btstack->hci_h5->bcsp_mode = 1;
 }
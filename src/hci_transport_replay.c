@@ -0,0 +1,570 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_transport_replay.c"
+
+/*
+ *  hci_transport_replay.c
+ *
+ *  HCI Transport API implementation that replays a PacketLogger or BlueZ capture, e.g. from hci_dump
+ *
+ *  Two cursors walk the capture: the tx cursor points to the next host to controller packet, which is
+ *  compared with the packet sent by the host, the rx cursor to the next controller to host packet. A
+ *  controller to host packet is delivered once the host has sent all packets that precede it in the
+ *  capture and its delay relative to the previous delivered or sent packet has passed. Divergences are
+ *  counted and the replay continues, also if the host does not send an expected packet in time. The CPU
+ *  time the host spends in the packet handler is measured per packet type with HAVE_POSIX_TIME.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "btstack_config.h"
+#include "btstack_state.h"
+
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_dump.h"
+#include "hci_transport.h"
+
+#ifdef HAVE_POSIX_FILE_IO
+#include <fcntl.h>        // open
+#include <unistd.h>       // read, close
+#endif
+
+#ifdef HAVE_POSIX_TIME
+#include <time.h>
+#endif
+
+// PacketLogger and BlueZ record header: length, timestamp, type
+#define HCI_TRANSPORT_REPLAY_HEADER_SIZE 13
+
+#define HCI_TRANSPORT_REPLAY_PACKET_BUFFER_SIZE (HCI_INCOMING_PRE_BUFFER_SIZE + HCI_INCOMING_PACKET_BUFFER_SIZE)
+
+// max time the host may send a host to controller packet later than in the capture before it is reported missing
+#ifndef HCI_TRANSPORT_REPLAY_TX_TIMEOUT_MS
+#define HCI_TRANSPORT_REPLAY_TX_TIMEOUT_MS 5000
+#endif
+
+typedef struct {
+    // position in capture
+    uint32_t offset;
+#ifdef HAVE_POSIX_FILE_IO
+    int fd;
+#endif
+    // current record
+    uint32_t index;
+    uint8_t  valid;
+    uint8_t  packet_type;
+    uint8_t  in;
+    uint32_t timestamp_ms;
+    uint16_t size;
+    uint8_t * packet;
+    // packet is delivered in place, pre-buffer allows host to prepend headers
+    uint8_t  buffer[HCI_TRANSPORT_REPLAY_PACKET_BUFFER_SIZE];
+} hci_transport_replay_cursor_t;
+
+struct btstack_hci_replay_state {
+    btstack_state_t * btstack;
+
+    // config
+    hci_dump_format_t format;
+    const uint8_t * capture;
+    uint32_t capture_len;
+    const char * filename;
+    uint16_t speedup;
+
+    void (*packet_handler)(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, uint16_t size);
+    void (*done_handler)(btstack_state_t *btstack);
+
+    hci_transport_replay_cursor_t rx;
+    hci_transport_replay_cursor_t tx;
+    // tx record was matched, advance after packet handler returned to keep reads out of CPU time
+    uint8_t tx_consumed;
+
+    // capture timestamps are relative to first record
+    uint8_t  have_first_timestamp;
+    uint32_t first_timestamp_sec;
+
+    // last delivered or sent packet: local time and capture time
+    uint32_t anchor_local_ms;
+    uint32_t anchor_capture_ms;
+
+    btstack_timer_source_t timer;
+    uint8_t  timer_active;
+    uint8_t  opened;
+    uint8_t  delivering;
+    uint32_t open_time_ms;
+
+    hci_transport_replay_statistics_t statistics;
+};
+
+static void hci_transport_replay_timeout(btstack_state_t * btstack, btstack_timer_source_t * ts);
+
+// capture access
+
+static int hci_transport_replay_read(struct btstack_hci_replay_state * replay, hci_transport_replay_cursor_t * cursor, uint8_t * buffer, uint32_t len){
+#ifdef HAVE_POSIX_FILE_IO
+    if (replay->capture == NULL){
+        if (cursor->fd < 0) return -1;
+        uint32_t pos = 0;
+        while (pos < len){
+            ssize_t bytes_read = read(cursor->fd, &buffer[pos], len - pos);
+            if (bytes_read <= 0) return -1;
+            pos += (uint32_t) bytes_read;
+        }
+        cursor->offset += len;
+        return 0;
+    }
+#endif
+    if ((replay->capture_len - cursor->offset) < len) return -1;
+    (void)memcpy(buffer, &replay->capture[cursor->offset], len);
+    cursor->offset += len;
+    return 0;
+}
+
+static int hci_transport_replay_skip(struct btstack_hci_replay_state * replay, hci_transport_replay_cursor_t * cursor, uint32_t len){
+#ifdef HAVE_POSIX_FILE_IO
+    if (replay->capture == NULL){
+        if (cursor->fd < 0) return -1;
+        if (lseek(cursor->fd, (off_t) len, SEEK_CUR) < 0) return -1;
+        cursor->offset += len;
+        return 0;
+    }
+#endif
+    if ((replay->capture_len - cursor->offset) < len) return -1;
+    cursor->offset += len;
+    return 0;
+}
+
+// map PacketLogger type to HCI packet type and direction, returns false for notes and unknown types
+static bool hci_transport_replay_packetlogger_type(uint8_t type, uint8_t * packet_type, uint8_t * in){
+    switch (type){
+        case 0x00:
+            *packet_type = HCI_COMMAND_DATA_PACKET;
+            *in = 0;
+            return true;
+        case 0x01:
+            *packet_type = HCI_EVENT_PACKET;
+            *in = 1;
+            return true;
+        case 0x02:
+        case 0x03:
+            *packet_type = HCI_ACL_DATA_PACKET;
+            *in = type & 1;
+            return true;
+        case 0x08:
+        case 0x09:
+            *packet_type = HCI_SCO_DATA_PACKET;
+            *in = type & 1;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// advance cursor to next HCI packet record, skips log messages
+static void hci_transport_replay_cursor_next(struct btstack_hci_replay_state * replay, hci_transport_replay_cursor_t * cursor){
+    uint8_t header[HCI_TRANSPORT_REPLAY_HEADER_SIZE];
+    if (cursor->valid){
+        cursor->index++;
+    }
+    cursor->valid = 0;
+    while (hci_transport_replay_read(replay, cursor, header, sizeof(header)) == 0){
+        uint32_t size;
+        uint32_t timestamp_sec;
+        uint32_t timestamp_usec;
+        bool is_packet;
+        if (replay->format == HCI_DUMP_BLUEZ){
+            // length includes packet type
+            size = little_endian_read_16(header, 0);
+            if (size < 1) break;
+            size -= 1;
+            timestamp_sec  = little_endian_read_32(header, 4);
+            timestamp_usec = little_endian_read_32(header, 8);
+            cursor->in          = header[2];
+            cursor->packet_type = header[12];
+            is_packet = (cursor->packet_type == HCI_COMMAND_DATA_PACKET) || (cursor->packet_type == HCI_EVENT_PACKET)
+                     || (cursor->packet_type == HCI_ACL_DATA_PACKET) || (cursor->packet_type == HCI_SCO_DATA_PACKET);
+        } else {
+            // length includes timestamp and type
+            size = big_endian_read_32(header, 0);
+            if (size < (HCI_TRANSPORT_REPLAY_HEADER_SIZE - 4)) break;
+            size -= HCI_TRANSPORT_REPLAY_HEADER_SIZE - 4;
+            timestamp_sec  = big_endian_read_32(header, 4);
+            timestamp_usec = big_endian_read_32(header, 8);
+            is_packet = hci_transport_replay_packetlogger_type(header[12], &cursor->packet_type, &cursor->in);
+        }
+
+        if (replay->have_first_timestamp == 0){
+            replay->have_first_timestamp = 1;
+            replay->first_timestamp_sec = timestamp_sec;
+        }
+
+        if (!is_packet || (size > HCI_INCOMING_PACKET_BUFFER_SIZE)){
+            if (is_packet){
+                log_error("replay: record %u with %u bytes too large, skipped", cursor->index, size);
+            }
+            if (hci_transport_replay_skip(replay, cursor, size) != 0) break;
+            continue;
+        }
+
+        cursor->packet = &cursor->buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+        if (hci_transport_replay_read(replay, cursor, cursor->packet, size) != 0) break;
+        cursor->size = (uint16_t) size;
+        cursor->timestamp_ms = ((timestamp_sec - replay->first_timestamp_sec) * 1000u) + (timestamp_usec / 1000u);
+        cursor->valid = 1;
+        return;
+    }
+}
+
+// advance tx cursor to next host to controller packet
+static void hci_transport_replay_tx_next(struct btstack_hci_replay_state * replay){
+    replay->tx_consumed = 0;
+    do {
+        hci_transport_replay_cursor_next(replay, &replay->tx);
+    } while (replay->tx.valid && replay->tx.in);
+}
+
+static void hci_transport_replay_cursor_open(struct btstack_hci_replay_state * replay, hci_transport_replay_cursor_t * cursor){
+    cursor->offset = 0;
+    cursor->index  = 0;
+    cursor->valid  = 0;
+#ifdef HAVE_POSIX_FILE_IO
+    cursor->fd = -1;
+    if (replay->capture == NULL){
+        cursor->fd = open(replay->filename, O_RDONLY);
+        if (cursor->fd < 0){
+            log_error("replay: cannot open %s", replay->filename);
+        }
+    }
+#else
+    UNUSED(replay);
+#endif
+}
+
+static void hci_transport_replay_cursor_close(hci_transport_replay_cursor_t * cursor){
+#ifdef HAVE_POSIX_FILE_IO
+    if (cursor->fd >= 0){
+        close(cursor->fd);
+        cursor->fd = -1;
+    }
+#endif
+    cursor->valid = 0;
+}
+
+// statistics
+
+static void hci_transport_replay_divergence(struct btstack_hci_replay_state * replay, uint32_t record){
+    if (replay->statistics.num_divergences == 0){
+        replay->statistics.first_divergence_record = record;
+    }
+    replay->statistics.num_divergences++;
+}
+
+#ifdef HAVE_POSIX_TIME
+static uint64_t hci_transport_replay_cpu_time_ns(void){
+    struct timespec now_ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now_ts);
+    return ((uint64_t) now_ts.tv_sec * 1000000000u) + (uint64_t) now_ts.tv_nsec;
+}
+#endif
+
+static void hci_transport_replay_deliver(struct btstack_hci_replay_state * replay, uint8_t packet_type, uint8_t * packet, uint16_t size){
+#ifdef HAVE_POSIX_TIME
+    uint64_t start_ns = hci_transport_replay_cpu_time_ns();
+#endif
+    (*replay->packet_handler)(replay->btstack, packet_type, packet, size);
+    replay->statistics.num_packets_replayed++;
+#ifdef HAVE_POSIX_TIME
+    uint32_t cpu_ns = (uint32_t) (hci_transport_replay_cpu_time_ns() - start_ns);
+    hci_transport_replay_cpu_time_t * cpu_time;
+    switch (packet_type){
+        case HCI_ACL_DATA_PACKET:
+            cpu_time = &replay->statistics.cpu_acl;
+            break;
+        case HCI_SCO_DATA_PACKET:
+            cpu_time = &replay->statistics.cpu_sco;
+            break;
+        default:
+            cpu_time = &replay->statistics.cpu_event;
+            break;
+    }
+    cpu_time->num_packets++;
+    cpu_time->total_ns += cpu_ns;
+    cpu_time->max_ns = btstack_max(cpu_time->max_ns, cpu_ns);
+#endif
+}
+
+// replay
+
+static void hci_transport_replay_set_timer(struct btstack_hci_replay_state * replay, uint32_t timeout_ms){
+    if (replay->timer_active){
+        btstack_run_loop_remove_timer(replay->btstack, &replay->timer);
+    }
+    btstack_run_loop_set_timer(replay->btstack, &replay->timer, timeout_ms);
+    btstack_run_loop_add_timer(replay->btstack, &replay->timer);
+    replay->timer_active = 1;
+}
+
+static void hci_transport_replay_check_completed(struct btstack_hci_replay_state * replay){
+    if (replay->statistics.completed) return;
+    if (replay->rx.valid || replay->tx.valid) return;
+    replay->statistics.completed = 1;
+    replay->statistics.num_records = replay->rx.index;
+    replay->statistics.duration_ms = btstack_run_loop_get_time_ms(replay->btstack) - replay->open_time_ms;
+    log_info("replay: completed, %u divergences", replay->statistics.num_divergences);
+    if (replay->done_handler != NULL){
+        (*replay->done_handler)(replay->btstack);
+    }
+}
+
+// transport closed: capture is completed if no controller to host packets are left
+static void hci_transport_replay_stop(struct btstack_hci_replay_state * replay){
+    if (replay->tx_consumed){
+        hci_transport_replay_tx_next(replay);
+    }
+    while (replay->rx.valid && !replay->rx.in){
+        hci_transport_replay_cursor_next(replay, &replay->rx);
+    }
+    hci_transport_replay_check_completed(replay);
+    hci_transport_replay_cursor_close(&replay->rx);
+    hci_transport_replay_cursor_close(&replay->tx);
+}
+
+static void hci_transport_replay_run(struct btstack_hci_replay_state * replay){
+    replay->delivering = 1;
+    while (replay->opened){
+        hci_transport_replay_cursor_t * rx = &replay->rx;
+
+        if (replay->tx_consumed){
+            hci_transport_replay_tx_next(replay);
+        }
+
+        // skip host to controller packets, they are handled by tx cursor
+        while (rx->valid && !rx->in){
+            hci_transport_replay_cursor_next(replay, rx);
+        }
+        if (!rx->valid) break;
+
+        // wait until host sent all packets before this one. host timers are not scaled, so the original
+        // delay of the expected packet is used for the timeout
+        uint32_t now = btstack_run_loop_get_time_ms(replay->btstack);
+        if (replay->tx.valid && (replay->tx.index < rx->index)){
+            int32_t tx_delay_ms = (int32_t) (replay->tx.timestamp_ms - replay->anchor_capture_ms);
+            if (tx_delay_ms < 0){
+                tx_delay_ms = 0;
+            }
+            uint32_t tx_deadline_ms = replay->anchor_local_ms + (uint32_t) tx_delay_ms + HCI_TRANSPORT_REPLAY_TX_TIMEOUT_MS;
+            int32_t  wait_ms = (int32_t) (tx_deadline_ms - now);
+            if (wait_ms > 0){
+                hci_transport_replay_set_timer(replay, (uint32_t) wait_ms);
+                break;
+            }
+            log_error("replay: record %u, type %u, len %u not sent by host", replay->tx.index, replay->tx.packet_type, replay->tx.size);
+            hci_transport_replay_divergence(replay, replay->tx.index);
+            replay->statistics.num_packets_missing++;
+            // continue as if the packet was sent now
+            replay->anchor_local_ms   = now;
+            replay->anchor_capture_ms = replay->tx.timestamp_ms;
+            hci_transport_replay_tx_next(replay);
+            continue;
+        }
+
+        // wait for scaled delay since last packet, next delay is relative to due time to avoid drift
+        uint32_t due_ms = now;
+        if (replay->speedup != 0){
+            int32_t delay_ms = (int32_t) (rx->timestamp_ms - replay->anchor_capture_ms);
+            if (delay_ms < 0){
+                delay_ms = 0;
+            }
+            due_ms = replay->anchor_local_ms + ((uint32_t) delay_ms / replay->speedup);
+            int32_t  wait_ms = (int32_t) (due_ms - now);
+            if (wait_ms > 0){
+                hci_transport_replay_set_timer(replay, (uint32_t) wait_ms);
+                break;
+            }
+            replay->statistics.max_delivery_delay_ms = btstack_max(replay->statistics.max_delivery_delay_ms, (uint32_t) -wait_ms);
+        }
+        replay->anchor_local_ms   = due_ms;
+        replay->anchor_capture_ms = rx->timestamp_ms;
+
+        // deliver in place, packets sent by host in packet handler only advance tx cursor
+        hci_transport_replay_deliver(replay, rx->packet_type, rx->packet, rx->size);
+        hci_transport_replay_cursor_next(replay, rx);
+    }
+    replay->delivering = 0;
+    if (replay->opened){
+        hci_transport_replay_check_completed(replay);
+    } else {
+        // closed by host in packet handler
+        hci_transport_replay_stop(replay);
+    }
+}
+
+static void hci_transport_replay_timeout(btstack_state_t * btstack, btstack_timer_source_t * ts){
+    UNUSED(ts);
+    struct btstack_hci_replay_state * replay = btstack->hci_replay;
+    replay->timer_active = 0;
+    hci_transport_replay_run(replay);
+}
+
+// hci_transport_t
+
+static void hci_transport_replay_init(btstack_state_t *btstack, const void * transport_config){
+    struct btstack_hci_replay_state * replay = btstack->hci_replay;
+    const hci_transport_config_replay_t * config = (const hci_transport_config_replay_t *) transport_config;
+    btstack_assert(config != NULL);
+    btstack_assert(config->type == HCI_TRANSPORT_CONFIG_REPLAY);
+
+    replay->format      = config->format;
+    replay->capture     = config->capture;
+    replay->capture_len = config->capture_len;
+    replay->filename    = config->filename;
+    replay->speedup     = config->speedup;
+
+    btstack_run_loop_set_timer_handler(&replay->timer, &hci_transport_replay_timeout);
+}
+
+static int hci_transport_replay_open(btstack_state_t *btstack){
+    struct btstack_hci_replay_state * replay = btstack->hci_replay;
+    memset(&replay->statistics, 0, sizeof(hci_transport_replay_statistics_t));
+    replay->have_first_timestamp = 0;
+    replay->tx_consumed = 0;
+    hci_transport_replay_cursor_open(replay, &replay->rx);
+    hci_transport_replay_cursor_open(replay, &replay->tx);
+    hci_transport_replay_cursor_next(replay, &replay->rx);
+    hci_transport_replay_tx_next(replay);
+    replay->open_time_ms      = btstack_run_loop_get_time_ms(btstack);
+    replay->anchor_local_ms   = replay->open_time_ms;
+    replay->anchor_capture_ms = 0;
+    replay->opened = 1;
+    // start replay from run loop
+    hci_transport_replay_set_timer(replay, 0);
+    return 0;
+}
+
+static int hci_transport_replay_close(btstack_state_t *btstack){
+    struct btstack_hci_replay_state * replay = btstack->hci_replay;
+    if (replay->timer_active){
+        btstack_run_loop_remove_timer(btstack, &replay->timer);
+        replay->timer_active = 0;
+    }
+    replay->opened = 0;
+    if (replay->delivering == 0){
+        hci_transport_replay_stop(replay);
+    }
+    return 0;
+}
+
+static void hci_transport_replay_register_packet_handler(btstack_state_t *btstack, void (*handler)(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    btstack->hci_replay->packet_handler = handler;
+}
+
+static int hci_transport_replay_send_packet(btstack_state_t *btstack, uint8_t packet_type, uint8_t * packet, int size){
+    struct btstack_hci_replay_state * replay = btstack->hci_replay;
+    hci_transport_replay_cursor_t * tx = &replay->tx;
+
+    // host sent more than one packet from packet handler
+    if (replay->tx_consumed){
+        hci_transport_replay_tx_next(replay);
+    }
+
+    if (!tx->valid){
+        log_error("replay: packet type %u, len %u sent after end of capture", packet_type, size);
+        hci_transport_replay_divergence(replay, tx->index);
+        return 0;
+    }
+
+    if ((tx->packet_type == packet_type) && (tx->size == size) && (memcmp(tx->packet, packet, size) == 0)){
+        replay->statistics.num_packets_matched++;
+    } else {
+        log_error("replay: record %u differs, expected type %u, len %u - got type %u, len %u", tx->index, tx->packet_type, tx->size, packet_type, size);
+        hci_transport_replay_divergence(replay, tx->index);
+    }
+
+    // packet sent in response to delivered packet keeps its due time as reference
+    if (replay->delivering == 0){
+        replay->anchor_local_ms = btstack_run_loop_get_time_ms(btstack);
+    }
+    replay->anchor_capture_ms = tx->timestamp_ms;
+
+    // continue replay from run loop, unless called from packet handler
+    if (replay->delivering == 0){
+        hci_transport_replay_tx_next(replay);
+        hci_transport_replay_set_timer(replay, 0);
+    } else {
+        replay->tx_consumed = 1;
+    }
+    return 0;
+}
+
+void hci_transport_replay_register_done_handler(btstack_state_t *btstack, void (*handler)(btstack_state_t *btstack)){
+    btstack->hci_replay->done_handler = handler;
+}
+
+const hci_transport_replay_statistics_t * hci_transport_replay_get_statistics(btstack_state_t *btstack){
+    return &btstack->hci_replay->statistics;
+}
+
+// get replay transport singleton, packet is compared in send_packet, so can_send_packet_now is not needed
+const hci_transport_t * hci_transport_replay_instance(btstack_state_t *btstack) {
+
+    static const hci_transport_t hci_transport_replay = {
+            /* const char * name; */                                        "Replay",
+            /* void   (*init) (const void *transport_config); */            &hci_transport_replay_init,
+            /* int    (*open)(void); */                                     &hci_transport_replay_open,
+            /* int    (*close)(void); */                                    &hci_transport_replay_close,
+            /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_replay_register_packet_handler,
+            /* int    (*can_send_packet_now)(uint8_t packet_type); */       NULL,
+            /* int    (*send_packet)(...); */                               &hci_transport_replay_send_packet,
+            /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+            /* void   (*reset_link)(void); */                               NULL,
+            /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+    };
+
+    struct btstack_hci_replay_state * replay = calloc(1, sizeof(struct btstack_hci_replay_state));
+    replay->btstack = btstack;
+#ifdef HAVE_POSIX_FILE_IO
+    replay->rx.fd = -1;
+    replay->tx.fd = -1;
+#endif
+    btstack->hci_replay = replay;
+    return &hci_transport_replay;
+}
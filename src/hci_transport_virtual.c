@@ -0,0 +1,1328 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_transport_virtual.c"
+
+/*
+ *  hci_transport_virtual.c
+ *
+ *  HCI Transport API implementation that emulates a Bluetooth Controller in-process
+ *
+ *  Controllers attached to the same hci_transport_virtual_link_t can discover and connect to each other,
+ *  which allows to run two or more btstack_state_t instances against each other without hardware, e.g. for
+ *  benchmarking. Emulated: HCI Reset and init, LE Advertising, Scanning and Connect, BR/EDR Inquiry, Page and
+ *  Remote Name Request, ACL Data with Number Of Completed Packets, Disconnect. Security procedures are not emulated.
+ *
+ *  Packets for the host are queued with a due time and delivered from a run loop timer. ACL packets are
+ *  serialized per controller according to the link bandwidth, failed transmissions are retransmitted, and the
+ *  packet arrives at the peer controller link latency ms after it was sent. Number Of Completed Packets is
+ *  reported when the packet arrived. While the queue of the peer is full, ACL packets are held in the sending
+ *  controller and transmitted in order once the peer host has received queued packets. All other commands are
+ *  answered immediately.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_config.h"
+#include "btstack_state.h"
+
+#include "bluetooth.h"
+#include "bluetooth_company_id.h"
+#include "btstack_debug.h"
+#include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_transport.h"
+
+// packets queued for the host: events and ACL packets from peer controllers
+#ifndef HCI_TRANSPORT_VIRTUAL_QUEUE_SIZE
+#define HCI_TRANSPORT_VIRTUAL_QUEUE_SIZE 32
+#endif
+
+#ifndef HCI_TRANSPORT_VIRTUAL_MAX_CONNECTIONS
+#define HCI_TRANSPORT_VIRTUAL_MAX_CONNECTIONS 4
+#endif
+
+// defaults if not set in hci_transport_config_virtual_t
+#define HCI_TRANSPORT_VIRTUAL_DEFAULT_ACL_PACKETS 8
+
+// failed transmission is repeated after air time + 2 slots
+#define HCI_TRANSPORT_VIRTUAL_RETRANSMISSION_DELAY_US 1250
+#define HCI_TRANSPORT_VIRTUAL_MAX_RETRANSMISSIONS 100
+
+#define HCI_TRANSPORT_VIRTUAL_RSSI ((uint8_t) -40)
+#define HCI_TRANSPORT_VIRTUAL_WHITE_LIST_SIZE 8
+
+#define OPCODE(ogf, ocf) ((ocf) | ((ogf) << 10))
+
+enum {
+    VIRTUAL_OPCODE_INQUIRY                         = OPCODE(OGF_LINK_CONTROL, 0x01),
+    VIRTUAL_OPCODE_INQUIRY_CANCEL                  = OPCODE(OGF_LINK_CONTROL, 0x02),
+    VIRTUAL_OPCODE_CREATE_CONNECTION               = OPCODE(OGF_LINK_CONTROL, 0x05),
+    VIRTUAL_OPCODE_DISCONNECT                      = OPCODE(OGF_LINK_CONTROL, 0x06),
+    VIRTUAL_OPCODE_CREATE_CONNECTION_CANCEL        = OPCODE(OGF_LINK_CONTROL, 0x08),
+    VIRTUAL_OPCODE_ACCEPT_CONNECTION_REQUEST       = OPCODE(OGF_LINK_CONTROL, 0x09),
+    VIRTUAL_OPCODE_REJECT_CONNECTION_REQUEST       = OPCODE(OGF_LINK_CONTROL, 0x0a),
+    VIRTUAL_OPCODE_AUTHENTICATION_REQUESTED        = OPCODE(OGF_LINK_CONTROL, 0x11),
+    VIRTUAL_OPCODE_SET_CONNECTION_ENCRYPTION       = OPCODE(OGF_LINK_CONTROL, 0x13),
+    VIRTUAL_OPCODE_REMOTE_NAME_REQUEST             = OPCODE(OGF_LINK_CONTROL, 0x19),
+    VIRTUAL_OPCODE_REMOTE_NAME_REQUEST_CANCEL      = OPCODE(OGF_LINK_CONTROL, 0x1a),
+    VIRTUAL_OPCODE_READ_REMOTE_SUPPORTED_FEATURES  = OPCODE(OGF_LINK_CONTROL, 0x1b),
+    VIRTUAL_OPCODE_READ_REMOTE_EXTENDED_FEATURES   = OPCODE(OGF_LINK_CONTROL, 0x1c),
+    VIRTUAL_OPCODE_READ_REMOTE_VERSION_INFORMATION = OPCODE(OGF_LINK_CONTROL, 0x1d),
+    VIRTUAL_OPCODE_RESET                           = OPCODE(OGF_CONTROLLER_BASEBAND, 0x03),
+    VIRTUAL_OPCODE_WRITE_LOCAL_NAME                = OPCODE(OGF_CONTROLLER_BASEBAND, 0x13),
+    VIRTUAL_OPCODE_READ_LOCAL_NAME                 = OPCODE(OGF_CONTROLLER_BASEBAND, 0x14),
+    VIRTUAL_OPCODE_WRITE_SCAN_ENABLE               = OPCODE(OGF_CONTROLLER_BASEBAND, 0x1a),
+    VIRTUAL_OPCODE_WRITE_CLASS_OF_DEVICE           = OPCODE(OGF_CONTROLLER_BASEBAND, 0x24),
+    VIRTUAL_OPCODE_WRITE_INQUIRY_MODE              = OPCODE(OGF_CONTROLLER_BASEBAND, 0x45),
+    VIRTUAL_OPCODE_WRITE_EXTENDED_INQUIRY_RESPONSE = OPCODE(OGF_CONTROLLER_BASEBAND, 0x52),
+    VIRTUAL_OPCODE_READ_LOCAL_VERSION_INFORMATION  = OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x01),
+    VIRTUAL_OPCODE_READ_LOCAL_SUPPORTED_COMMANDS   = OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x02),
+    VIRTUAL_OPCODE_READ_LOCAL_SUPPORTED_FEATURES   = OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x03),
+    VIRTUAL_OPCODE_READ_BUFFER_SIZE                = OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x05),
+    VIRTUAL_OPCODE_READ_BD_ADDR                    = OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x09),
+    VIRTUAL_OPCODE_READ_RSSI                       = OPCODE(OGF_STATUS_PARAMETERS, 0x05),
+    VIRTUAL_OPCODE_LE_READ_BUFFER_SIZE             = OPCODE(OGF_LE_CONTROLLER, 0x02),
+    VIRTUAL_OPCODE_LE_SET_RANDOM_ADDRESS           = OPCODE(OGF_LE_CONTROLLER, 0x05),
+    VIRTUAL_OPCODE_LE_SET_ADVERTISING_PARAMETERS   = OPCODE(OGF_LE_CONTROLLER, 0x06),
+    VIRTUAL_OPCODE_LE_SET_ADVERTISING_DATA         = OPCODE(OGF_LE_CONTROLLER, 0x08),
+    VIRTUAL_OPCODE_LE_SET_SCAN_RESPONSE_DATA       = OPCODE(OGF_LE_CONTROLLER, 0x09),
+    VIRTUAL_OPCODE_LE_SET_ADVERTISE_ENABLE         = OPCODE(OGF_LE_CONTROLLER, 0x0a),
+    VIRTUAL_OPCODE_LE_SET_SCAN_PARAMETERS          = OPCODE(OGF_LE_CONTROLLER, 0x0b),
+    VIRTUAL_OPCODE_LE_SET_SCAN_ENABLE              = OPCODE(OGF_LE_CONTROLLER, 0x0c),
+    VIRTUAL_OPCODE_LE_CREATE_CONNECTION            = OPCODE(OGF_LE_CONTROLLER, 0x0d),
+    VIRTUAL_OPCODE_LE_CREATE_CONNECTION_CANCEL     = OPCODE(OGF_LE_CONTROLLER, 0x0e),
+    VIRTUAL_OPCODE_LE_READ_WHITE_LIST_SIZE         = OPCODE(OGF_LE_CONTROLLER, 0x0f),
+    VIRTUAL_OPCODE_LE_CLEAR_WHITE_LIST             = OPCODE(OGF_LE_CONTROLLER, 0x10),
+    VIRTUAL_OPCODE_LE_ADD_DEVICE_TO_WHITE_LIST     = OPCODE(OGF_LE_CONTROLLER, 0x11),
+    VIRTUAL_OPCODE_LE_REMOVE_DEVICE_FROM_WHITE_LIST = OPCODE(OGF_LE_CONTROLLER, 0x12),
+    VIRTUAL_OPCODE_LE_CONNECTION_UPDATE            = OPCODE(OGF_LE_CONTROLLER, 0x13),
+    VIRTUAL_OPCODE_LE_READ_REMOTE_USED_FEATURES    = OPCODE(OGF_LE_CONTROLLER, 0x16),
+    VIRTUAL_OPCODE_LE_START_ENCRYPTION             = OPCODE(OGF_LE_CONTROLLER, 0x19),
+    VIRTUAL_OPCODE_LE_READ_MAXIMUM_DATA_LENGTH     = OPCODE(OGF_LE_CONTROLLER, 0x2f),
+};
+
+typedef enum {
+    VIRTUAL_CONNECTION_FREE = 0,
+    VIRTUAL_CONNECTION_W4_ACCEPT,   // outgoing BR/EDR connection, waiting for peer host
+    VIRTUAL_CONNECTION_INCOMING,    // Connection Request sent to host, waiting for accept/reject
+    VIRTUAL_CONNECTION_OPEN,
+} VIRTUAL_CONNECTION_STATE;
+
+typedef struct virtual_connection {
+    VIRTUAL_CONNECTION_STATE state;
+    hci_con_handle_t handle;
+    uint8_t   le;
+    uint8_t   role;
+    // peer as seen by this controller
+    bd_addr_type_t address_type;
+    bd_addr_t address;
+    struct btstack_hci_virtual_state * peer;
+    struct virtual_connection * peer_connection;
+} virtual_connection_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    uint32_t due_ms;
+    uint8_t  packet_type;
+    uint16_t size;
+    // packet is delivered in place, pre-buffer allows host to prepend headers
+    uint8_t  buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_INCOMING_PACKET_BUFFER_SIZE + 1];
+} virtual_packet_t;
+
+typedef struct {
+    bd_addr_type_t address_type;
+    bd_addr_t address;
+} virtual_white_list_entry_t;
+
+struct btstack_hci_virtual_state {
+    // in link->controllers
+    btstack_linked_item_t item;
+    btstack_state_t * btstack;
+    hci_transport_virtual_link_t * link;
+
+    // buffers reported to host
+    uint16_t acl_data_packet_length;
+    uint16_t acl_packets_total_num;
+    uint16_t le_data_packet_length;
+    uint8_t  le_packets_total_num;
+    bd_addr_t public_address;
+
+    void (*packet_handler)(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+    // packets for host sorted by due time, delivered by rx_timer
+    btstack_linked_list_t rx_queue;
+    btstack_linked_list_t free_packets;
+    btstack_timer_source_t rx_timer;
+    virtual_packet_t packets[HCI_TRANSPORT_VIRTUAL_QUEUE_SIZE];
+
+    // ACL packets from host waiting for room in the queue of the peer, one per controller ACL buffer
+    btstack_linked_list_t tx_queue;
+    btstack_linked_list_t tx_free_packets;
+    virtual_packet_t * tx_packets;
+
+    // transmitter busy until, in us
+    uint32_t tx_busy_until_us;
+
+    virtual_connection_t connections[HCI_TRANSPORT_VIRTUAL_MAX_CONNECTIONS];
+
+    // BR/EDR
+    uint8_t  local_name[DEVICE_NAME_LEN];
+    uint32_t class_of_device;
+    uint8_t  scan_enable;
+    uint8_t  inquiry_mode;
+    uint8_t  eir_data[EXTENDED_INQUIRY_RESPONSE_DATA_LEN];
+
+    // LE
+    bd_addr_t random_address;
+    uint8_t  advertising_type;
+    uint8_t  advertising_own_address_type;
+    uint16_t advertising_interval_ms;
+    uint8_t  advertising_data_len;
+    uint8_t  advertising_data[LE_ADVERTISING_DATA_SIZE];
+    uint8_t  scan_response_data_len;
+    uint8_t  scan_response_data[LE_ADVERTISING_DATA_SIZE];
+    uint8_t  advertising_enabled;
+    btstack_timer_source_t advertising_timer;
+    uint8_t  le_scan_enabled;
+    uint8_t  le_scan_type;
+    uint8_t  le_initiating;
+    uint8_t  le_initiator_filter_policy;
+    bd_addr_type_t le_initiator_peer_address_type;
+    bd_addr_t le_initiator_peer_address;
+    uint8_t  le_initiator_own_address_type;
+    uint16_t le_initiator_conn_interval;
+    uint16_t le_initiator_conn_latency;
+    uint16_t le_initiator_supervision_timeout;
+    virtual_white_list_entry_t white_list[HCI_TRANSPORT_VIRTUAL_WHITE_LIST_SIZE];
+    uint8_t  white_list_num;
+
+    hci_transport_virtual_statistics_t statistics;
+};
+
+// 3-slot, 5-slot, LE supported (controller), SSP
+static const uint8_t hci_transport_virtual_features[8] = { 0x03, 0x00, 0x00, 0x00, 0x40, 0x00, 0x08, 0x00 };
+
+static void hci_transport_virtual_rx_timeout(btstack_state_t * btstack, btstack_timer_source_t * ts);
+static void hci_transport_virtual_advertising_timeout(btstack_state_t * btstack, btstack_timer_source_t * ts);
+static void hci_transport_virtual_send_held_packets(struct btstack_hci_virtual_state * controller);
+
+// link
+
+void hci_transport_virtual_link_init(hci_transport_virtual_link_t * link, uint32_t latency_ms, uint16_t loss_permille, uint32_t bandwidth, uint32_t seed){
+    memset(link, 0, sizeof(hci_transport_virtual_link_t));
+    link->latency_ms    = latency_ms;
+    link->loss_permille = loss_permille;
+    link->bandwidth     = bandwidth;
+    link->random_state  = (seed != 0) ? seed : 1;
+}
+
+static bool hci_transport_virtual_link_transmission_failed(hci_transport_virtual_link_t * link){
+    if (link->loss_permille == 0) return false;
+    // xorshift32
+    uint32_t x = link->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    link->random_state = x;
+    return (x % 1000u) < link->loss_permille;
+}
+
+// queue for host
+
+static uint32_t hci_transport_virtual_now(struct btstack_hci_virtual_state * controller){
+    return btstack_run_loop_get_time_ms(controller->btstack);
+}
+
+static void hci_transport_virtual_schedule_rx(struct btstack_hci_virtual_state * controller){
+    virtual_packet_t * packet = (virtual_packet_t *) controller->rx_queue;
+    if (packet == NULL) return;
+    int32_t delay_ms = btstack_time_delta(packet->due_ms, hci_transport_virtual_now(controller));
+    if (delay_ms < 0){
+        delay_ms = 0;
+    }
+    btstack_run_loop_remove_timer(controller->btstack, &controller->rx_timer);
+    btstack_run_loop_set_timer(controller->btstack, &controller->rx_timer, (uint32_t) delay_ms);
+    btstack_run_loop_add_timer(controller->btstack, &controller->rx_timer);
+}
+
+static uint8_t * hci_transport_virtual_queue_packet(struct btstack_hci_virtual_state * controller, uint8_t packet_type, uint16_t size, uint32_t delay_ms){
+    if (size > HCI_INCOMING_PACKET_BUFFER_SIZE){
+        log_error("virtual: packet type %u, size %u exceeds HCI_INCOMING_PACKET_BUFFER_SIZE", packet_type, size);
+        controller->statistics.num_packets_dropped++;
+        return NULL;
+    }
+    virtual_packet_t * packet = (virtual_packet_t *) btstack_linked_list_pop(&controller->free_packets);
+    if (packet == NULL){
+        log_error("virtual: queue full, packet type %u dropped, please increase HCI_TRANSPORT_VIRTUAL_QUEUE_SIZE", packet_type);
+        controller->statistics.num_packets_dropped++;
+        return NULL;
+    }
+    packet->packet_type = packet_type;
+    packet->size = size;
+    packet->due_ms = hci_transport_virtual_now(controller) + delay_ms;
+
+    // insert after all packets that are due earlier or at the same time
+    btstack_linked_item_t ** next = &controller->rx_queue;
+    while (*next != NULL){
+        if (btstack_time_delta(((virtual_packet_t *) *next)->due_ms, packet->due_ms) > 0) break;
+        next = &(*next)->next;
+    }
+    packet->item.next = *next;
+    *next = &packet->item;
+
+    if (controller->rx_queue == (btstack_linked_item_t *) packet){
+        hci_transport_virtual_schedule_rx(controller);
+    }
+    return &packet->buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+}
+
+static void hci_transport_virtual_free_packet(struct btstack_hci_virtual_state * controller, virtual_packet_t * packet){
+    packet->item.next = controller->free_packets;
+    controller->free_packets = (btstack_linked_item_t *) packet;
+}
+
+static void hci_transport_virtual_emit_event(struct btstack_hci_virtual_state * controller, const uint8_t * event, uint16_t size, uint32_t delay_ms){
+    uint8_t * buffer = hci_transport_virtual_queue_packet(controller, HCI_EVENT_PACKET, size, delay_ms);
+    if (buffer == NULL) return;
+    (void)memcpy(buffer, event, size);
+}
+
+// drop queued events of given type, e.g. inquiry results after inquiry cancel
+static void hci_transport_virtual_remove_events(struct btstack_hci_virtual_state * controller, uint8_t event_type){
+    btstack_linked_item_t ** next = &controller->rx_queue;
+    while (*next != NULL){
+        virtual_packet_t * packet = (virtual_packet_t *) *next;
+        uint8_t * data = &packet->buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+        if ((packet->packet_type == HCI_EVENT_PACKET) && (data[0] == event_type)){
+            *next = packet->item.next;
+            hci_transport_virtual_free_packet(controller, packet);
+        } else {
+            next = &packet->item.next;
+        }
+    }
+}
+
+// ACL packets held for a handle that is disconnected are not sent
+static void hci_transport_virtual_remove_held_packets(struct btstack_hci_virtual_state * controller, hci_con_handle_t handle){
+    btstack_linked_item_t ** next = &controller->tx_queue;
+    while (*next != NULL){
+        virtual_packet_t * packet = (virtual_packet_t *) *next;
+        if ((little_endian_read_16(packet->buffer, 0) & 0x0fff) == handle){
+            *next = packet->item.next;
+            btstack_linked_list_add(&controller->tx_free_packets, &packet->item);
+        } else {
+            next = &packet->item.next;
+        }
+    }
+}
+
+// Number Of Completed Packets for a handle that is disconnected would confuse the host
+static void hci_transport_virtual_remove_completed_packets(struct btstack_hci_virtual_state * controller, hci_con_handle_t handle){
+    btstack_linked_item_t ** next = &controller->rx_queue;
+    while (*next != NULL){
+        virtual_packet_t * packet = (virtual_packet_t *) *next;
+        uint8_t * data = &packet->buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+        if ((packet->packet_type == HCI_EVENT_PACKET) && (data[0] == HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS)
+            && (little_endian_read_16(data, 3) == handle)){
+            *next = packet->item.next;
+            hci_transport_virtual_free_packet(controller, packet);
+        } else {
+            next = &packet->item.next;
+        }
+    }
+}
+
+static void hci_transport_virtual_rx_timeout(btstack_state_t * btstack, btstack_timer_source_t * ts){
+    UNUSED(ts);
+    struct btstack_hci_virtual_state * controller = btstack->hci_virtual;
+    uint32_t now = hci_transport_virtual_now(controller);
+    while (true){
+        virtual_packet_t * packet = (virtual_packet_t *) controller->rx_queue;
+        if (packet == NULL) break;
+        if (btstack_time_delta(packet->due_ms, now) > 0) break;
+        controller->rx_queue = packet->item.next;
+        if (packet->packet_type == HCI_EVENT_PACKET){
+            controller->statistics.num_events++;
+        } else {
+            controller->statistics.num_acl_packets_received++;
+        }
+        // deliver in place, host may send commands from the handler
+        if (controller->packet_handler){
+            controller->packet_handler(controller->btstack, packet->packet_type, &packet->buffer[HCI_INCOMING_PRE_BUFFER_SIZE], packet->size);
+        }
+        hci_transport_virtual_free_packet(controller, packet);
+    }
+    hci_transport_virtual_schedule_rx(controller);
+
+    // delivered packets made room for ACL packets held by other controllers
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &controller->link->controllers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        struct btstack_hci_virtual_state * sender = (struct btstack_hci_virtual_state *) btstack_linked_list_iterator_next(&it);
+        hci_transport_virtual_send_held_packets(sender);
+    }
+}
+
+// events
+
+static void hci_transport_virtual_emit_command_complete(struct btstack_hci_virtual_state * controller, uint16_t opcode, const uint8_t * return_parameters, uint8_t return_parameters_len){
+    uint8_t event[5 + 255];
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 3 + return_parameters_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    (void)memcpy(&event[5], return_parameters, return_parameters_len);
+    hci_transport_virtual_emit_event(controller, event, 5 + return_parameters_len, 0);
+}
+
+static void hci_transport_virtual_emit_command_status(struct btstack_hci_virtual_state * controller, uint16_t opcode, uint8_t status){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_COMMAND_STATUS;
+    event[1] = 4;
+    event[2] = status;
+    event[3] = 1;
+    little_endian_store_16(event, 4, opcode);
+    hci_transport_virtual_emit_event(controller, event, sizeof(event), 0);
+}
+
+static void hci_transport_virtual_emit_connection_complete(struct btstack_hci_virtual_state * controller, uint8_t status, hci_con_handle_t handle, const bd_addr_t address, uint32_t delay_ms){
+    uint8_t event[13];
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = 11;
+    event[2] = status;
+    little_endian_store_16(event, 3, handle);
+    reverse_bd_addr(address, &event[5]);
+    event[11] = 1;  // ACL
+    event[12] = 0;  // encryption disabled
+    hci_transport_virtual_emit_event(controller, event, sizeof(event), delay_ms);
+}
+
+static void hci_transport_virtual_emit_disconnection_complete(struct btstack_hci_virtual_state * controller, hci_con_handle_t handle, uint8_t reason, uint32_t delay_ms){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = 4;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, handle);
+    event[5] = reason;
+    hci_transport_virtual_emit_event(controller, event, sizeof(event), delay_ms);
+}
+
+static void hci_transport_virtual_emit_le_connection_complete(struct btstack_hci_virtual_state * controller, uint8_t status, const virtual_connection_t * connection,
+                                                              uint16_t conn_interval, uint16_t conn_latency, uint16_t supervision_timeout, uint32_t delay_ms){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = 19;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = status;
+    if (connection != NULL){
+        little_endian_store_16(event, 4, connection->handle);
+        event[6] = connection->role;
+        event[7] = (uint8_t) connection->address_type;
+        reverse_bd_addr(connection->address, &event[8]);
+        little_endian_store_16(event, 14, conn_interval);
+        little_endian_store_16(event, 16, conn_latency);
+        little_endian_store_16(event, 18, supervision_timeout);
+    }
+    hci_transport_virtual_emit_event(controller, event, sizeof(event), delay_ms);
+}
+
+static void hci_transport_virtual_emit_number_of_completed_packets(struct btstack_hci_virtual_state * controller, hci_con_handle_t handle, uint32_t delay_ms){
+    uint8_t event[7];
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 5;
+    event[2] = 1;
+    little_endian_store_16(event, 3, handle);
+    little_endian_store_16(event, 5, 1);
+    hci_transport_virtual_emit_event(controller, event, sizeof(event), delay_ms);
+}
+
+// connections
+
+static virtual_connection_t * hci_transport_virtual_connection_create(struct btstack_hci_virtual_state * controller){
+    int i;
+    for (i = 0; i < HCI_TRANSPORT_VIRTUAL_MAX_CONNECTIONS; i++){
+        virtual_connection_t * connection = &controller->connections[i];
+        if (connection->state != VIRTUAL_CONNECTION_FREE) continue;
+        memset(connection, 0, sizeof(virtual_connection_t));
+        connection->handle = (hci_con_handle_t) (i + 1);
+        return connection;
+    }
+    return NULL;
+}
+
+static virtual_connection_t * hci_transport_virtual_connection_for_handle(struct btstack_hci_virtual_state * controller, hci_con_handle_t handle){
+    int i;
+    for (i = 0; i < HCI_TRANSPORT_VIRTUAL_MAX_CONNECTIONS; i++){
+        virtual_connection_t * connection = &controller->connections[i];
+        if (connection->state != VIRTUAL_CONNECTION_OPEN) continue;
+        if (connection->handle != handle) continue;
+        return connection;
+    }
+    return NULL;
+}
+
+static virtual_connection_t * hci_transport_virtual_connection_for_address(struct btstack_hci_virtual_state * controller, const bd_addr_t address, VIRTUAL_CONNECTION_STATE state){
+    int i;
+    for (i = 0; i < HCI_TRANSPORT_VIRTUAL_MAX_CONNECTIONS; i++){
+        virtual_connection_t * connection = &controller->connections[i];
+        if (connection->state != state) continue;
+        if (connection->le) continue;
+        if (bd_addr_cmp(connection->address, address) != 0) continue;
+        return connection;
+    }
+    return NULL;
+}
+
+static void hci_transport_virtual_connection_setup(virtual_connection_t * connection, struct btstack_hci_virtual_state * peer, virtual_connection_t * peer_connection,
+                                                   VIRTUAL_CONNECTION_STATE state, uint8_t role){
+    connection->state = state;
+    connection->role  = role;
+    connection->peer  = peer;
+    connection->peer_connection = peer_connection;
+}
+
+static struct btstack_hci_virtual_state * hci_transport_virtual_controller_for_public_address(struct btstack_hci_virtual_state * controller, const bd_addr_t address){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &controller->link->controllers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        struct btstack_hci_virtual_state * peer = (struct btstack_hci_virtual_state *) btstack_linked_list_iterator_next(&it);
+        if (peer == controller) continue;
+        if (bd_addr_cmp(peer->public_address, address) != 0) continue;
+        return peer;
+    }
+    return NULL;
+}
+
+// connection lost as controller was reset or closed
+static void hci_transport_virtual_connection_lost(virtual_connection_t * connection){
+    virtual_connection_t * peer_connection = connection->peer_connection;
+    struct btstack_hci_virtual_state * peer = connection->peer;
+    uint32_t latency_ms = peer->link->latency_ms;
+    switch (peer_connection->state){
+        case VIRTUAL_CONNECTION_OPEN:
+            hci_transport_virtual_remove_held_packets(peer, peer_connection->handle);
+            hci_transport_virtual_remove_completed_packets(peer, peer_connection->handle);
+            hci_transport_virtual_emit_disconnection_complete(peer, peer_connection->handle, ERROR_CODE_CONNECTION_TIMEOUT, latency_ms);
+            break;
+        case VIRTUAL_CONNECTION_W4_ACCEPT:
+        case VIRTUAL_CONNECTION_INCOMING:
+            hci_transport_virtual_emit_connection_complete(peer, ERROR_CODE_CONNECTION_TIMEOUT, 0, peer_connection->address, latency_ms);
+            break;
+        default:
+            break;
+    }
+    peer_connection->state = VIRTUAL_CONNECTION_FREE;
+    connection->state = VIRTUAL_CONNECTION_FREE;
+}
+
+// LE
+
+static void hci_transport_virtual_le_own_address(struct btstack_hci_virtual_state * controller, uint8_t own_address_type, bd_addr_type_t * address_type, bd_addr_t address){
+    if (own_address_type & 1){
+        *address_type = BD_ADDR_TYPE_LE_RANDOM;
+        bd_addr_copy(address, controller->random_address);
+    } else {
+        *address_type = BD_ADDR_TYPE_LE_PUBLIC;
+        bd_addr_copy(address, controller->public_address);
+    }
+}
+
+static bool hci_transport_virtual_initiator_accepts(struct btstack_hci_virtual_state * initiator, bd_addr_type_t address_type, const bd_addr_t address){
+    if (initiator->le_initiator_filter_policy == 0){
+        return (initiator->le_initiator_peer_address_type == address_type) && (bd_addr_cmp(initiator->le_initiator_peer_address, address) == 0);
+    }
+    int i;
+    for (i = 0; i < initiator->white_list_num; i++){
+        if (initiator->white_list[i].address_type != address_type) continue;
+        if (bd_addr_cmp(initiator->white_list[i].address, address) != 0) continue;
+        return true;
+    }
+    return false;
+}
+
+static void hci_transport_virtual_emit_advertising_report(struct btstack_hci_virtual_state * scanner, uint8_t event_type, bd_addr_type_t address_type, const bd_addr_t address,
+                                                          const uint8_t * data, uint8_t data_len){
+    if (hci_transport_virtual_link_transmission_failed(scanner->link)){
+        scanner->statistics.num_reports_lost++;
+        return;
+    }
+    uint8_t event[14 + LE_ADVERTISING_DATA_SIZE];
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = 12 + data_len;
+    event[2] = HCI_SUBEVENT_LE_ADVERTISING_REPORT;
+    event[3] = 1;
+    event[4] = event_type;
+    event[5] = (uint8_t) address_type;
+    reverse_bd_addr(address, &event[6]);
+    event[12] = data_len;
+    (void)memcpy(&event[13], data, data_len);
+    event[13 + data_len] = HCI_TRANSPORT_VIRTUAL_RSSI;
+    hci_transport_virtual_emit_event(scanner, event, 14 + data_len, scanner->link->latency_ms);
+}
+
+static bool hci_transport_virtual_le_connect(struct btstack_hci_virtual_state * advertiser, bd_addr_type_t advertiser_address_type, const bd_addr_t advertiser_address,
+                                             struct btstack_hci_virtual_state * initiator){
+    virtual_connection_t * central = hci_transport_virtual_connection_create(initiator);
+    if (central == NULL) return false;
+    virtual_connection_t * peripheral = hci_transport_virtual_connection_create(advertiser);
+    if (peripheral == NULL) return false;
+
+    hci_transport_virtual_connection_setup(central, advertiser, peripheral, VIRTUAL_CONNECTION_OPEN, HCI_ROLE_MASTER);
+    central->le = 1;
+    central->address_type = advertiser_address_type;
+    bd_addr_copy(central->address, advertiser_address);
+
+    hci_transport_virtual_connection_setup(peripheral, initiator, central, VIRTUAL_CONNECTION_OPEN, HCI_ROLE_SLAVE);
+    peripheral->le = 1;
+    hci_transport_virtual_le_own_address(initiator, initiator->le_initiator_own_address_type, &peripheral->address_type, peripheral->address);
+
+    initiator->le_initiating = 0;
+    advertiser->advertising_enabled = 0;
+
+    uint32_t latency_ms = advertiser->link->latency_ms;
+    hci_transport_virtual_emit_le_connection_complete(initiator, ERROR_CODE_SUCCESS, central, initiator->le_initiator_conn_interval,
+                                                      initiator->le_initiator_conn_latency, initiator->le_initiator_supervision_timeout, latency_ms);
+    hci_transport_virtual_emit_le_connection_complete(advertiser, ERROR_CODE_SUCCESS, peripheral, initiator->le_initiator_conn_interval,
+                                                      initiator->le_initiator_conn_latency, initiator->le_initiator_supervision_timeout, latency_ms);
+    return true;
+}
+
+// advertising event: report to scanners, connect to initiator
+static void hci_transport_virtual_advertising_timeout(btstack_state_t * btstack, btstack_timer_source_t * ts){
+    struct btstack_hci_virtual_state * advertiser = btstack->hci_virtual;
+    if (advertiser->advertising_enabled == 0) return;
+
+    bd_addr_type_t address_type;
+    bd_addr_t address;
+    hci_transport_virtual_le_own_address(advertiser, advertiser->advertising_own_address_type, &address_type, address);
+
+    // ADV_IND, ADV_DIRECT_IND high duty cycle, ADV_SCAN_IND, ADV_NONCONN_IND, ADV_DIRECT_IND low duty cycle
+    static const uint8_t report_event_types[] = { 0, 1, 2, 3, 1 };
+    uint8_t advertising_type = btstack_min(advertiser->advertising_type, 4);
+    bool connectable = (advertising_type == 0) || (advertising_type == 1) || (advertising_type == 4);
+    bool scannable   = (advertising_type == 0) || (advertising_type == 2);
+
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &advertiser->link->controllers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        struct btstack_hci_virtual_state * peer = (struct btstack_hci_virtual_state *) btstack_linked_list_iterator_next(&it);
+        if (peer == advertiser) continue;
+        if (connectable && peer->le_initiating && hci_transport_virtual_initiator_accepts(peer, address_type, address)){
+            if (hci_transport_virtual_le_connect(advertiser, address_type, address, peer)) return;
+        }
+        if (peer->le_scan_enabled == 0) continue;
+        hci_transport_virtual_emit_advertising_report(peer, report_event_types[advertising_type], address_type, address,
+                                                      advertiser->advertising_data, advertiser->advertising_data_len);
+        if (scannable && (peer->le_scan_type != 0)){
+            hci_transport_virtual_emit_advertising_report(peer, 4, address_type, address,
+                                                          advertiser->scan_response_data, advertiser->scan_response_data_len);
+        }
+    }
+
+    btstack_run_loop_set_timer(advertiser->btstack, ts, advertiser->advertising_interval_ms);
+    btstack_run_loop_add_timer(advertiser->btstack, ts);
+}
+
+// BR/EDR
+
+static void hci_transport_virtual_emit_inquiry_result(struct btstack_hci_virtual_state * controller, struct btstack_hci_virtual_state * peer){
+    if (hci_transport_virtual_link_transmission_failed(controller->link)){
+        controller->statistics.num_reports_lost++;
+        return;
+    }
+    uint8_t event[2 + 255];
+    memset(event, 0, sizeof(event));
+    uint16_t size;
+    event[2] = 1;
+    reverse_bd_addr(peer->public_address, &event[3]);
+    event[9] = 1;   // page scan repetition mode R1
+    switch (controller->inquiry_mode){
+        case 0:
+            event[0] = HCI_EVENT_INQUIRY_RESULT;
+            little_endian_store_24(event, 12, peer->class_of_device);
+            size = 17;
+            break;
+        case 1:
+            event[0] = HCI_EVENT_INQUIRY_RESULT_WITH_RSSI;
+            little_endian_store_24(event, 11, peer->class_of_device);
+            event[16] = HCI_TRANSPORT_VIRTUAL_RSSI;
+            size = 17;
+            break;
+        default:
+            event[0] = HCI_EVENT_EXTENDED_INQUIRY_RESPONSE;
+            little_endian_store_24(event, 11, peer->class_of_device);
+            event[16] = HCI_TRANSPORT_VIRTUAL_RSSI;
+            (void)memcpy(&event[17], peer->eir_data, EXTENDED_INQUIRY_RESPONSE_DATA_LEN);
+            size = 17 + EXTENDED_INQUIRY_RESPONSE_DATA_LEN;
+            break;
+    }
+    event[1] = (uint8_t) (size - 2);
+    hci_transport_virtual_emit_event(controller, event, size, controller->link->latency_ms);
+}
+
+static void hci_transport_virtual_inquiry(struct btstack_hci_virtual_state * controller, uint8_t inquiry_length, uint8_t num_responses){
+    uint16_t num_results = 0;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &controller->link->controllers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        struct btstack_hci_virtual_state * peer = (struct btstack_hci_virtual_state *) btstack_linked_list_iterator_next(&it);
+        if (peer == controller) continue;
+        if ((peer->scan_enable & 0x01) == 0) continue;
+        if ((num_responses != 0) && (num_results >= num_responses)) break;
+        hci_transport_virtual_emit_inquiry_result(controller, peer);
+        num_results++;
+    }
+    uint8_t event[3] = { HCI_EVENT_INQUIRY_COMPLETE, 1, ERROR_CODE_SUCCESS };
+    hci_transport_virtual_emit_event(controller, event, sizeof(event), inquiry_length * 1280u);
+}
+
+static uint8_t hci_transport_virtual_create_connection(struct btstack_hci_virtual_state * controller, const bd_addr_t address){
+    uint32_t latency_ms = controller->link->latency_ms;
+    struct btstack_hci_virtual_state * peer = hci_transport_virtual_controller_for_public_address(controller, address);
+    if ((peer == NULL) || ((peer->scan_enable & 0x02) == 0)){
+        hci_transport_virtual_emit_connection_complete(controller, ERROR_CODE_PAGE_TIMEOUT, 0, address, 2 * latency_ms);
+        return ERROR_CODE_SUCCESS;
+    }
+    virtual_connection_t * connection = hci_transport_virtual_connection_create(controller);
+    if (connection == NULL) return ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES;
+    virtual_connection_t * peer_connection = hci_transport_virtual_connection_create(peer);
+    if (peer_connection == NULL){
+        hci_transport_virtual_emit_connection_complete(controller, ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES, 0, address, 2 * latency_ms);
+        return ERROR_CODE_SUCCESS;
+    }
+    hci_transport_virtual_connection_setup(connection, peer, peer_connection, VIRTUAL_CONNECTION_W4_ACCEPT, HCI_ROLE_MASTER);
+    connection->address_type = BD_ADDR_TYPE_ACL;
+    bd_addr_copy(connection->address, address);
+    hci_transport_virtual_connection_setup(peer_connection, controller, connection, VIRTUAL_CONNECTION_INCOMING, HCI_ROLE_SLAVE);
+    peer_connection->address_type = BD_ADDR_TYPE_ACL;
+    bd_addr_copy(peer_connection->address, controller->public_address);
+
+    uint8_t event[12];
+    event[0] = HCI_EVENT_CONNECTION_REQUEST;
+    event[1] = 10;
+    reverse_bd_addr(controller->public_address, &event[2]);
+    little_endian_store_24(event, 8, controller->class_of_device);
+    event[11] = 1;  // ACL
+    hci_transport_virtual_emit_event(peer, event, sizeof(event), latency_ms);
+    return ERROR_CODE_SUCCESS;
+}
+
+static uint8_t hci_transport_virtual_accept_connection(struct btstack_hci_virtual_state * controller, const bd_addr_t address, uint8_t reason){
+    virtual_connection_t * connection = hci_transport_virtual_connection_for_address(controller, address, VIRTUAL_CONNECTION_INCOMING);
+    if (connection == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    virtual_connection_t * peer_connection = connection->peer_connection;
+    struct btstack_hci_virtual_state * peer = connection->peer;
+    uint32_t latency_ms = controller->link->latency_ms;
+    if (reason == ERROR_CODE_SUCCESS){
+        connection->state = VIRTUAL_CONNECTION_OPEN;
+        peer_connection->state = VIRTUAL_CONNECTION_OPEN;
+        hci_transport_virtual_emit_connection_complete(controller, ERROR_CODE_SUCCESS, connection->handle, address, latency_ms);
+        hci_transport_virtual_emit_connection_complete(peer, ERROR_CODE_SUCCESS, peer_connection->handle, peer_connection->address, latency_ms);
+    } else {
+        connection->state = VIRTUAL_CONNECTION_FREE;
+        peer_connection->state = VIRTUAL_CONNECTION_FREE;
+        hci_transport_virtual_emit_connection_complete(controller, reason, 0, address, latency_ms);
+        hci_transport_virtual_emit_connection_complete(peer, reason, 0, peer_connection->address, latency_ms);
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+static uint8_t hci_transport_virtual_disconnect(struct btstack_hci_virtual_state * controller, hci_con_handle_t handle, uint8_t reason){
+    virtual_connection_t * connection = hci_transport_virtual_connection_for_handle(controller, handle);
+    if (connection == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    virtual_connection_t * peer_connection = connection->peer_connection;
+    struct btstack_hci_virtual_state * peer = connection->peer;
+    hci_transport_virtual_remove_held_packets(controller, handle);
+    hci_transport_virtual_remove_held_packets(peer, peer_connection->handle);
+    hci_transport_virtual_remove_completed_packets(controller, handle);
+    hci_transport_virtual_remove_completed_packets(peer, peer_connection->handle);
+    hci_transport_virtual_emit_disconnection_complete(controller, handle, ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST, 0);
+    // peer receives ACL packets in flight before disconnect
+    hci_transport_virtual_emit_disconnection_complete(peer, peer_connection->handle, reason, controller->link->latency_ms);
+    connection->state = VIRTUAL_CONNECTION_FREE;
+    peer_connection->state = VIRTUAL_CONNECTION_FREE;
+    return ERROR_CODE_SUCCESS;
+}
+
+static void hci_transport_virtual_remote_name_request(struct btstack_hci_virtual_state * controller, const bd_addr_t address){
+    uint8_t event[2 + 1 + 6 + DEVICE_NAME_LEN];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    reverse_bd_addr(address, &event[3]);
+    struct btstack_hci_virtual_state * peer = hci_transport_virtual_controller_for_public_address(controller, address);
+    if ((peer == NULL) || ((peer->scan_enable & 0x02) == 0)){
+        event[2] = ERROR_CODE_PAGE_TIMEOUT;
+    } else {
+        event[2] = ERROR_CODE_SUCCESS;
+        (void)memcpy(&event[9], peer->local_name, DEVICE_NAME_LEN);
+    }
+    hci_transport_virtual_emit_event(controller, event, sizeof(event), 2 * controller->link->latency_ms);
+}
+
+// reset all state incl. connections, peers are notified
+static void hci_transport_virtual_reset(struct btstack_hci_virtual_state * controller){
+    int i;
+    for (i = 0; i < HCI_TRANSPORT_VIRTUAL_MAX_CONNECTIONS; i++){
+        virtual_connection_t * connection = &controller->connections[i];
+        if (connection->state == VIRTUAL_CONNECTION_FREE) continue;
+        hci_transport_virtual_connection_lost(connection);
+    }
+    // initiator waiting for our advertisements does not care, scanners stop getting reports
+    btstack_run_loop_remove_timer(controller->btstack, &controller->advertising_timer);
+    btstack_run_loop_remove_timer(controller->btstack, &controller->rx_timer);
+
+    // drop queued packets, packet currently delivered by hci_transport_virtual_rx_timeout is not in the queue
+    while (controller->rx_queue != NULL){
+        virtual_packet_t * packet = (virtual_packet_t *) controller->rx_queue;
+        controller->rx_queue = packet->item.next;
+        hci_transport_virtual_free_packet(controller, packet);
+    }
+    while (controller->tx_queue != NULL){
+        btstack_linked_list_add(&controller->tx_free_packets, btstack_linked_list_pop(&controller->tx_queue));
+    }
+
+    controller->tx_busy_until_us = hci_transport_virtual_now(controller) * 1000u;
+    memset(controller->local_name, 0, sizeof(controller->local_name));
+    memset(controller->eir_data, 0, sizeof(controller->eir_data));
+    controller->class_of_device = 0;
+    controller->scan_enable = 0;
+    controller->inquiry_mode = 0;
+    memset(controller->random_address, 0, sizeof(bd_addr_t));
+    controller->advertising_type = 0;
+    controller->advertising_own_address_type = 0;
+    controller->advertising_interval_ms = 1280;
+    controller->advertising_data_len = 0;
+    controller->scan_response_data_len = 0;
+    controller->advertising_enabled = 0;
+    controller->le_scan_enabled = 0;
+    controller->le_scan_type = 0;
+    controller->le_initiating = 0;
+    controller->white_list_num = 0;
+}
+
+// command handler
+
+static void hci_transport_virtual_handle_command(struct btstack_hci_virtual_state * controller, const uint8_t * packet, uint16_t size){
+    if (size < 3) return;
+    controller->statistics.num_commands++;
+
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    const uint8_t * params = &packet[3];
+    uint16_t params_len = btstack_min(packet[2], size - 3);
+
+    // Command Complete return parameters, status first
+    uint8_t return_params[1 + 248];
+    uint8_t return_params_len = 1;
+    memset(return_params, 0, sizeof(return_params));
+    return_params[0] = ERROR_CODE_SUCCESS;
+
+    // avoid reading beyond received parameters
+    uint8_t command_params[255];
+    memset(command_params, 0, sizeof(command_params));
+    (void)memcpy(command_params, params, params_len);
+    params = command_params;
+
+    bd_addr_t address;
+    uint8_t status;
+    virtual_connection_t * connection;
+
+    switch (opcode){
+
+        // asynchronous commands: Command Status + event(s)
+
+        case VIRTUAL_OPCODE_INQUIRY:
+            hci_transport_virtual_remove_events(controller, HCI_EVENT_INQUIRY_COMPLETE);
+            hci_transport_virtual_emit_command_status(controller, opcode, ERROR_CODE_SUCCESS);
+            hci_transport_virtual_inquiry(controller, params[3], params[4]);
+            return;
+        case VIRTUAL_OPCODE_CREATE_CONNECTION:
+            reverse_bd_addr(params, address);
+            hci_transport_virtual_emit_command_status(controller, opcode, ERROR_CODE_SUCCESS);
+            status = hci_transport_virtual_create_connection(controller, address);
+            if (status != ERROR_CODE_SUCCESS){
+                hci_transport_virtual_emit_connection_complete(controller, status, 0, address, 0);
+            }
+            return;
+        case VIRTUAL_OPCODE_DISCONNECT:
+            connection = hci_transport_virtual_connection_for_handle(controller, little_endian_read_16(params, 0));
+            hci_transport_virtual_emit_command_status(controller, opcode, (connection != NULL) ? ERROR_CODE_SUCCESS : ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+            if (connection == NULL) return;
+            (void) hci_transport_virtual_disconnect(controller, connection->handle, params[2]);
+            return;
+        case VIRTUAL_OPCODE_ACCEPT_CONNECTION_REQUEST:
+        case VIRTUAL_OPCODE_REJECT_CONNECTION_REQUEST:
+            reverse_bd_addr(params, address);
+            connection = hci_transport_virtual_connection_for_address(controller, address, VIRTUAL_CONNECTION_INCOMING);
+            hci_transport_virtual_emit_command_status(controller, opcode, (connection != NULL) ? ERROR_CODE_SUCCESS : ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+            if (connection == NULL) return;
+            (void) hci_transport_virtual_accept_connection(controller, address, (opcode == VIRTUAL_OPCODE_ACCEPT_CONNECTION_REQUEST) ? ERROR_CODE_SUCCESS : params[6]);
+            return;
+        case VIRTUAL_OPCODE_REMOTE_NAME_REQUEST:
+            reverse_bd_addr(params, address);
+            hci_transport_virtual_emit_command_status(controller, opcode, ERROR_CODE_SUCCESS);
+            hci_transport_virtual_remote_name_request(controller, address);
+            return;
+        case VIRTUAL_OPCODE_READ_REMOTE_SUPPORTED_FEATURES:
+        case VIRTUAL_OPCODE_READ_REMOTE_EXTENDED_FEATURES:
+        case VIRTUAL_OPCODE_READ_REMOTE_VERSION_INFORMATION:
+        case VIRTUAL_OPCODE_LE_READ_REMOTE_USED_FEATURES:{
+            connection = hci_transport_virtual_connection_for_handle(controller, little_endian_read_16(params, 0));
+            hci_transport_virtual_emit_command_status(controller, opcode, (connection != NULL) ? ERROR_CODE_SUCCESS : ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+            if (connection == NULL) return;
+            uint8_t event[15];
+            uint16_t event_size;
+            memset(event, 0, sizeof(event));
+            switch (opcode){
+                case VIRTUAL_OPCODE_READ_REMOTE_SUPPORTED_FEATURES:
+                    event[0] = HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE;
+                    little_endian_store_16(event, 3, connection->handle);
+                    (void)memcpy(&event[5], hci_transport_virtual_features, 8);
+                    event_size = 13;
+                    break;
+                case VIRTUAL_OPCODE_READ_REMOTE_EXTENDED_FEATURES:
+                    event[0] = HCI_EVENT_READ_REMOTE_EXTENDED_FEATURES_COMPLETE;
+                    little_endian_store_16(event, 3, connection->handle);
+                    event[5] = params[2];
+                    if (params[2] == 0){
+                        (void)memcpy(&event[7], hci_transport_virtual_features, 8);
+                    }
+                    event_size = 15;
+                    break;
+                case VIRTUAL_OPCODE_READ_REMOTE_VERSION_INFORMATION:
+                    event[0] = HCI_EVENT_READ_REMOTE_VERSION_INFORMATION_COMPLETE;
+                    little_endian_store_16(event, 3, connection->handle);
+                    event[5] = 0x09;    // Bluetooth 5.0
+                    little_endian_store_16(event, 6, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+                    event_size = 10;
+                    break;
+                default:
+                    event[0] = HCI_EVENT_LE_META;
+                    event[2] = HCI_SUBEVENT_LE_READ_REMOTE_USED_FEATURES_COMPLETE;
+                    little_endian_store_16(event, 4, connection->handle);
+                    event_size = 14;
+                    break;
+            }
+            event[1] = (uint8_t) (event_size - 2);
+            hci_transport_virtual_emit_event(controller, event, event_size, 2 * controller->link->latency_ms);
+            return;
+        }
+        case VIRTUAL_OPCODE_LE_CREATE_CONNECTION:
+            if (controller->le_initiating){
+                hci_transport_virtual_emit_command_status(controller, opcode, ERROR_CODE_COMMAND_DISALLOWED);
+                return;
+            }
+            controller->le_initiating = 1;
+            controller->le_initiator_filter_policy = params[4];
+            controller->le_initiator_peer_address_type = (bd_addr_type_t) (params[5] & 1);
+            reverse_bd_addr(&params[6], controller->le_initiator_peer_address);
+            controller->le_initiator_own_address_type = params[12];
+            controller->le_initiator_conn_interval = little_endian_read_16(params, 15);
+            controller->le_initiator_conn_latency = little_endian_read_16(params, 17);
+            controller->le_initiator_supervision_timeout = little_endian_read_16(params, 19);
+            // connection is established on next advertising event of the peer
+            hci_transport_virtual_emit_command_status(controller, opcode, ERROR_CODE_SUCCESS);
+            return;
+        case VIRTUAL_OPCODE_LE_CONNECTION_UPDATE:{
+            connection = hci_transport_virtual_connection_for_handle(controller, little_endian_read_16(params, 0));
+            hci_transport_virtual_emit_command_status(controller, opcode, (connection != NULL) ? ERROR_CODE_SUCCESS : ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+            if (connection == NULL) return;
+            uint8_t event[12];
+            event[0] = HCI_EVENT_LE_META;
+            event[1] = 10;
+            event[2] = HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE;
+            event[3] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event,  6, little_endian_read_16(params, 4));   // max interval
+            little_endian_store_16(event,  8, little_endian_read_16(params, 6));   // latency
+            little_endian_store_16(event, 10, little_endian_read_16(params, 8));   // supervision timeout
+            uint32_t latency_ms = controller->link->latency_ms;
+            little_endian_store_16(event, 4, connection->handle);
+            hci_transport_virtual_emit_event(controller, event, sizeof(event), 2 * latency_ms);
+            little_endian_store_16(event, 4, connection->peer_connection->handle);
+            hci_transport_virtual_emit_event(connection->peer, event, sizeof(event), latency_ms);
+            return;
+        }
+        case VIRTUAL_OPCODE_AUTHENTICATION_REQUESTED:
+        case VIRTUAL_OPCODE_SET_CONNECTION_ENCRYPTION:
+        case VIRTUAL_OPCODE_LE_START_ENCRYPTION:
+            // security procedures are not emulated
+            hci_transport_virtual_emit_command_status(controller, opcode, ERROR_CODE_UNKNOWN_HCI_COMMAND);
+            return;
+
+        // synchronous commands: Command Complete
+
+        case VIRTUAL_OPCODE_RESET:
+            hci_transport_virtual_reset(controller);
+            break;
+        case VIRTUAL_OPCODE_INQUIRY_CANCEL:
+            hci_transport_virtual_remove_events(controller, HCI_EVENT_INQUIRY_RESULT);
+            hci_transport_virtual_remove_events(controller, HCI_EVENT_INQUIRY_RESULT_WITH_RSSI);
+            hci_transport_virtual_remove_events(controller, HCI_EVENT_EXTENDED_INQUIRY_RESPONSE);
+            hci_transport_virtual_remove_events(controller, HCI_EVENT_INQUIRY_COMPLETE);
+            break;
+        case VIRTUAL_OPCODE_CREATE_CONNECTION_CANCEL:
+        case VIRTUAL_OPCODE_REMOTE_NAME_REQUEST_CANCEL:
+            // create connection / remote name request complete anyway
+            return_params[0] = ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+            (void)memcpy(&return_params[1], params, 6);
+            return_params_len = 7;
+            break;
+        case VIRTUAL_OPCODE_WRITE_LOCAL_NAME:
+            (void)memcpy(controller->local_name, params, DEVICE_NAME_LEN);
+            break;
+        case VIRTUAL_OPCODE_READ_LOCAL_NAME:
+            (void)memcpy(&return_params[1], controller->local_name, DEVICE_NAME_LEN);
+            return_params_len = 1 + DEVICE_NAME_LEN;
+            break;
+        case VIRTUAL_OPCODE_WRITE_SCAN_ENABLE:
+            controller->scan_enable = params[0];
+            break;
+        case VIRTUAL_OPCODE_WRITE_CLASS_OF_DEVICE:
+            controller->class_of_device = little_endian_read_24(params, 0);
+            break;
+        case VIRTUAL_OPCODE_WRITE_INQUIRY_MODE:
+            controller->inquiry_mode = params[0];
+            break;
+        case VIRTUAL_OPCODE_WRITE_EXTENDED_INQUIRY_RESPONSE:
+            (void)memcpy(controller->eir_data, &params[1], EXTENDED_INQUIRY_RESPONSE_DATA_LEN);
+            break;
+        case VIRTUAL_OPCODE_READ_LOCAL_VERSION_INFORMATION:
+            return_params[1] = 0x09;    // HCI 5.0
+            return_params[4] = 0x09;    // LMP 5.0
+            little_endian_store_16(return_params, 5, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+            return_params_len = 9;
+            break;
+        case VIRTUAL_OPCODE_READ_LOCAL_SUPPORTED_COMMANDS:
+            return_params[1 + 14] = 0x80;   // Read Buffer Size
+            return_params[1 + 24] = 0x40;   // Write LE Host Supported
+            return_params_len = 1 + 64;
+            break;
+        case VIRTUAL_OPCODE_READ_LOCAL_SUPPORTED_FEATURES:
+            (void)memcpy(&return_params[1], hci_transport_virtual_features, 8);
+            return_params_len = 9;
+            break;
+        case VIRTUAL_OPCODE_READ_BUFFER_SIZE:
+            little_endian_store_16(return_params, 1, controller->acl_data_packet_length);
+            little_endian_store_16(return_params, 4, controller->acl_packets_total_num);
+            return_params_len = 8;
+            break;
+        case VIRTUAL_OPCODE_READ_BD_ADDR:
+            reverse_bd_addr(controller->public_address, &return_params[1]);
+            return_params_len = 7;
+            break;
+        case VIRTUAL_OPCODE_READ_RSSI:
+            connection = hci_transport_virtual_connection_for_handle(controller, little_endian_read_16(params, 0));
+            if (connection == NULL){
+                return_params[0] = ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+            }
+            little_endian_store_16(return_params, 1, little_endian_read_16(params, 0));
+            return_params[3] = HCI_TRANSPORT_VIRTUAL_RSSI;
+            return_params_len = 4;
+            break;
+        case VIRTUAL_OPCODE_LE_READ_BUFFER_SIZE:
+            little_endian_store_16(return_params, 1, controller->le_data_packet_length);
+            return_params[3] = controller->le_packets_total_num;
+            return_params_len = 4;
+            break;
+        case VIRTUAL_OPCODE_LE_SET_RANDOM_ADDRESS:
+            reverse_bd_addr(params, controller->random_address);
+            break;
+        case VIRTUAL_OPCODE_LE_SET_ADVERTISING_PARAMETERS:
+            controller->advertising_interval_ms = btstack_max(1, (little_endian_read_16(params, 0) * 5u) / 8u);
+            controller->advertising_type = params[4];
+            controller->advertising_own_address_type = params[5];
+            break;
+        case VIRTUAL_OPCODE_LE_SET_ADVERTISING_DATA:
+            controller->advertising_data_len = btstack_min(params[0], LE_ADVERTISING_DATA_SIZE);
+            (void)memcpy(controller->advertising_data, &params[1], controller->advertising_data_len);
+            break;
+        case VIRTUAL_OPCODE_LE_SET_SCAN_RESPONSE_DATA:
+            controller->scan_response_data_len = btstack_min(params[0], LE_ADVERTISING_DATA_SIZE);
+            (void)memcpy(controller->scan_response_data, &params[1], controller->scan_response_data_len);
+            break;
+        case VIRTUAL_OPCODE_LE_SET_ADVERTISE_ENABLE:
+            controller->advertising_enabled = params[0];
+            btstack_run_loop_remove_timer(controller->btstack, &controller->advertising_timer);
+            if (controller->advertising_enabled){
+                // first advertising event right away
+                btstack_run_loop_set_timer(controller->btstack, &controller->advertising_timer, 0);
+                btstack_run_loop_add_timer(controller->btstack, &controller->advertising_timer);
+            }
+            break;
+        case VIRTUAL_OPCODE_LE_SET_SCAN_PARAMETERS:
+            controller->le_scan_type = params[0];
+            break;
+        case VIRTUAL_OPCODE_LE_SET_SCAN_ENABLE:
+            controller->le_scan_enabled = params[0];
+            break;
+        case VIRTUAL_OPCODE_LE_CREATE_CONNECTION_CANCEL:
+            if (controller->le_initiating == 0){
+                return_params[0] = ERROR_CODE_COMMAND_DISALLOWED;
+                break;
+            }
+            controller->le_initiating = 0;
+            hci_transport_virtual_emit_command_complete(controller, opcode, return_params, return_params_len);
+            hci_transport_virtual_emit_le_connection_complete(controller, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, NULL, 0, 0, 0, 0);
+            return;
+        case VIRTUAL_OPCODE_LE_READ_WHITE_LIST_SIZE:
+            return_params[1] = HCI_TRANSPORT_VIRTUAL_WHITE_LIST_SIZE;
+            return_params_len = 2;
+            break;
+        case VIRTUAL_OPCODE_LE_CLEAR_WHITE_LIST:
+            controller->white_list_num = 0;
+            break;
+        case VIRTUAL_OPCODE_LE_ADD_DEVICE_TO_WHITE_LIST:
+            if (controller->white_list_num >= HCI_TRANSPORT_VIRTUAL_WHITE_LIST_SIZE){
+                return_params[0] = ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+                break;
+            }
+            controller->white_list[controller->white_list_num].address_type = (bd_addr_type_t) (params[0] & 1);
+            reverse_bd_addr(&params[1], controller->white_list[controller->white_list_num].address);
+            controller->white_list_num++;
+            break;
+        case VIRTUAL_OPCODE_LE_REMOVE_DEVICE_FROM_WHITE_LIST:{
+            reverse_bd_addr(&params[1], address);
+            int i;
+            for (i = 0; i < controller->white_list_num; i++){
+                if (controller->white_list[i].address_type != (bd_addr_type_t) (params[0] & 1)) continue;
+                if (bd_addr_cmp(controller->white_list[i].address, address) != 0) continue;
+                controller->white_list_num--;
+                controller->white_list[i] = controller->white_list[controller->white_list_num];
+                break;
+            }
+            break;
+        }
+        case VIRTUAL_OPCODE_LE_READ_MAXIMUM_DATA_LENGTH:
+            little_endian_store_16(return_params, 1, 27);
+            little_endian_store_16(return_params, 3, 328);
+            little_endian_store_16(return_params, 5, 27);
+            little_endian_store_16(return_params, 7, 328);
+            return_params_len = 9;
+            break;
+
+        default:
+            // accept all other commands
+            break;
+    }
+    hci_transport_virtual_emit_command_complete(controller, opcode, return_params, return_params_len);
+}
+
+// ACL data: serialize on air, retransmit on loss, deliver to peer after latency
+// @returns false if queue of peer is full
+static bool hci_transport_virtual_transmit_acl_packet(struct btstack_hci_virtual_state * controller, virtual_connection_t * connection,
+                                                      const uint8_t * packet, uint16_t size, uint32_t * delay_ms){
+    if (connection->peer->free_packets == NULL) return false;
+    hci_transport_virtual_link_t * link = controller->link;
+
+    // air time
+    uint32_t now_us = hci_transport_virtual_now(controller) * 1000u;
+    if ((int32_t)(controller->tx_busy_until_us - now_us) < 0){
+        controller->tx_busy_until_us = now_us;
+    }
+    uint32_t air_time_us = 0;
+    if (link->bandwidth != 0){
+        air_time_us = (uint32_t) (((uint64_t) size * 1000000u) / link->bandwidth);
+    }
+    controller->tx_busy_until_us += air_time_us;
+    int retransmissions = 0;
+    while ((retransmissions < HCI_TRANSPORT_VIRTUAL_MAX_RETRANSMISSIONS) && hci_transport_virtual_link_transmission_failed(link)){
+        controller->tx_busy_until_us += HCI_TRANSPORT_VIRTUAL_RETRANSMISSION_DELAY_US + air_time_us;
+        retransmissions++;
+    }
+    controller->statistics.num_retransmissions += retransmissions;
+    *delay_ms = ((controller->tx_busy_until_us - now_us + 999u) / 1000u) + link->latency_ms;
+
+    // forward to peer with peer handle, packet that exceeds HCI_INCOMING_PACKET_BUFFER_SIZE is dropped but completed
+    uint8_t * buffer = hci_transport_virtual_queue_packet(connection->peer, HCI_ACL_DATA_PACKET, size, *delay_ms);
+    if (buffer == NULL) return true;
+    (void)memcpy(buffer, packet, size);
+    little_endian_store_16(buffer, 0, (little_endian_read_16(packet, 0) & 0xf000) | connection->peer_connection->handle);
+    controller->statistics.num_acl_packets_sent++;
+    controller->statistics.num_acl_bytes_sent += size;
+    return true;
+}
+
+// send held ACL packets in order, stop if queue of peer is full
+static void hci_transport_virtual_send_held_packets(struct btstack_hci_virtual_state * controller){
+    while (controller->tx_queue != NULL){
+        virtual_packet_t * held = (virtual_packet_t *) controller->tx_queue;
+        hci_con_handle_t handle = little_endian_read_16(held->buffer, 0) & 0x0fff;
+        virtual_connection_t * connection = hci_transport_virtual_connection_for_handle(controller, handle);
+        btstack_assert(connection != NULL);
+        uint32_t delay_ms;
+        if (!hci_transport_virtual_transmit_acl_packet(controller, connection, held->buffer, held->size, &delay_ms)) break;
+        controller->tx_queue = held->item.next;
+        btstack_linked_list_add(&controller->tx_free_packets, &held->item);
+        hci_transport_virtual_emit_number_of_completed_packets(controller, handle, delay_ms);
+    }
+}
+
+static void hci_transport_virtual_handle_acl_packet(struct btstack_hci_virtual_state * controller, const uint8_t * packet, uint16_t size){
+    if (size < 4) return;
+    hci_con_handle_t handle = little_endian_read_16(packet, 0) & 0x0fff;
+    virtual_connection_t * connection = hci_transport_virtual_connection_for_handle(controller, handle);
+    if (connection == NULL){
+        log_info("virtual: ACL for unknown handle 0x%04x dropped", handle);
+        return;
+    }
+
+    // keep order behind held packets
+    uint32_t delay_ms;
+    if ((controller->tx_queue == NULL) && hci_transport_virtual_transmit_acl_packet(controller, connection, packet, size, &delay_ms)){
+        hci_transport_virtual_emit_number_of_completed_packets(controller, handle, delay_ms);
+        return;
+    }
+
+    // hold packet until peer has room, the controller buffer stays in use meanwhile
+    if (size > HCI_INCOMING_PACKET_BUFFER_SIZE){
+        log_error("virtual: ACL packet size %u exceeds HCI_INCOMING_PACKET_BUFFER_SIZE", size);
+        controller->statistics.num_packets_dropped++;
+        return;
+    }
+    virtual_packet_t * held = (virtual_packet_t *) btstack_linked_list_pop(&controller->tx_free_packets);
+    if (held == NULL){
+        log_error("virtual: host exceeded ACL buffers, packet dropped");
+        controller->statistics.num_packets_dropped++;
+        return;
+    }
+    held->packet_type = HCI_ACL_DATA_PACKET;
+    held->size = size;
+    (void)memcpy(held->buffer, packet, size);
+    btstack_linked_list_add_tail(&controller->tx_queue, &held->item);
+}
+
+// hci_transport_t
+
+static void hci_transport_virtual_init(btstack_state_t *btstack, const void * transport_config){
+    struct btstack_hci_virtual_state * controller = btstack->hci_virtual;
+    const hci_transport_config_virtual_t * config = (const hci_transport_config_virtual_t *) transport_config;
+    btstack_assert(config != NULL);
+    btstack_assert(config->type == HCI_TRANSPORT_CONFIG_VIRTUAL);
+
+    controller->link = config->link;
+    bd_addr_copy(controller->public_address, config->bd_addr);
+    controller->acl_data_packet_length = (config->acl_data_packet_length != 0) ? config->acl_data_packet_length : HCI_ACL_PAYLOAD_SIZE;
+    controller->acl_packets_total_num  = (config->acl_packets_total_num  != 0) ? config->acl_packets_total_num  : HCI_TRANSPORT_VIRTUAL_DEFAULT_ACL_PACKETS;
+    controller->le_data_packet_length  = config->le_data_packet_length;
+    controller->le_packets_total_num   = config->le_packets_total_num;
+
+    // storage to hold ACL packets for all buffers reported to host
+    uint16_t tx_packets_num = controller->acl_packets_total_num + controller->le_packets_total_num;
+    free(controller->tx_packets);
+    controller->tx_packets = calloc(tx_packets_num, sizeof(virtual_packet_t));
+    btstack_assert(controller->tx_packets != NULL);
+    controller->tx_queue = NULL;
+    controller->tx_free_packets = NULL;
+    uint16_t i;
+    for (i = 0; i < tx_packets_num; i++){
+        btstack_linked_list_add(&controller->tx_free_packets, &controller->tx_packets[i].item);
+    }
+
+    btstack_run_loop_set_timer_handler(&controller->rx_timer, &hci_transport_virtual_rx_timeout);
+    btstack_run_loop_set_timer_handler(&controller->advertising_timer, &hci_transport_virtual_advertising_timeout);
+}
+
+static int hci_transport_virtual_open(btstack_state_t *btstack){
+    struct btstack_hci_virtual_state * controller = btstack->hci_virtual;
+    hci_transport_virtual_reset(controller);
+    // power on: become visible to other controllers on the link
+    btstack_linked_list_remove(&controller->link->controllers, &controller->item);
+    btstack_linked_list_add_tail(&controller->link->controllers, &controller->item);
+    return 0;
+}
+
+static int hci_transport_virtual_close(btstack_state_t *btstack){
+    struct btstack_hci_virtual_state * controller = btstack->hci_virtual;
+    hci_transport_virtual_reset(controller);
+    btstack_linked_list_remove(&controller->link->controllers, &controller->item);
+    return 0;
+}
+
+static void hci_transport_virtual_register_packet_handler(btstack_state_t *btstack, void (*handler)(btstack_state_t *btstack, uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    btstack->hci_virtual->packet_handler = handler;
+}
+
+static int hci_transport_virtual_send_packet(btstack_state_t *btstack, uint8_t packet_type, uint8_t * packet, int size){
+    struct btstack_hci_virtual_state * controller = btstack->hci_virtual;
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            hci_transport_virtual_handle_command(controller, packet, (uint16_t) size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            hci_transport_virtual_handle_acl_packet(controller, packet, (uint16_t) size);
+            break;
+        default:
+            log_info("virtual: packet type %u not supported", packet_type);
+            break;
+    }
+    return 0;
+}
+
+const hci_transport_virtual_statistics_t * hci_transport_virtual_get_statistics(btstack_state_t *btstack){
+    return &btstack->hci_virtual->statistics;
+}
+
+// get virtual transport singleton, packet is copied in send_packet, so can_send_packet_now is not needed
+const hci_transport_t * hci_transport_virtual_instance(btstack_state_t *btstack) {
+
+    static const hci_transport_t hci_transport_virtual = {
+            /* const char * name; */                                        "Virtual",
+            /* void   (*init) (const void *transport_config); */            &hci_transport_virtual_init,
+            /* int    (*open)(void); */                                     &hci_transport_virtual_open,
+            /* int    (*close)(void); */                                    &hci_transport_virtual_close,
+            /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_virtual_register_packet_handler,
+            /* int    (*can_send_packet_now)(uint8_t packet_type); */       NULL,
+            /* int    (*send_packet)(...); */                               &hci_transport_virtual_send_packet,
+            /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+            /* void   (*reset_link)(void); */                               NULL,
+            /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+    };
+
+    struct btstack_hci_virtual_state * controller = calloc(1, sizeof(struct btstack_hci_virtual_state));
+    controller->btstack = btstack;
+    int i;
+    for (i = 0; i < HCI_TRANSPORT_VIRTUAL_QUEUE_SIZE; i++){
+        hci_transport_virtual_free_packet(controller, &controller->packets[i]);
+    }
+    btstack->hci_virtual = controller;
+    return &hci_transport_virtual;
+}
@@ -51,8 +51,10 @@
 #include "bluetooth_sdp.h"
 #include "bluetooth_psm.h"
 #include "btstack_bool.h"
+#include "btstack_crc.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
+#include "btstack_instrumentation.h"
 #include "btstack_memory.h"
 
 #include <stdarg.h>
@@ -143,6 +145,9 @@ static void l2cap_notify_channel_can_send(void);
 static void l2cap_emit_can_send_now(btstack_packet_handler_t packet_handler, uint16_t channel);
 static uint8_t  l2cap_next_sig_id(void);
 static l2cap_fixed_channel_t * l2cap_fixed_channel_for_channel_id(uint16_t local_cid);
+static void l2cap_tx_scheduler_packet_sent(l2cap_fixed_channel_t * channel, uint16_t size);
+static l2cap_fixed_channel_t * l2cap_tx_scheduler_drr_select(void);
+static void l2cap_tx_scheduler_drr_packet_sent(l2cap_fixed_channel_t * channel, uint16_t size);
 #ifdef ENABLE_CLASSIC
 static void l2cap_handle_remote_supported_features_received(l2cap_channel_t * channel);
 static void l2cap_handle_connection_complete(hci_con_handle_t con_handle, l2cap_channel_t * channel);
@@ -171,6 +176,8 @@ static l2cap_channel_t * l2cap_get_channel_for_local_cid(uint16_t local_cid);
 static l2cap_channel_t * l2cap_create_channel_entry(btstack_packet_handler_t packet_handler, l2cap_channel_type_t channel_type, bd_addr_t address, bd_addr_type_t address_type, 
         uint16_t psm, uint16_t local_mtu, gap_security_level_t security_level);
 static void l2cap_free_channel_entry(l2cap_channel_t * channel);
+static void l2cap_iov_requests_abort(l2cap_channel_t * channel);
+static void l2cap_add_channel(l2cap_channel_t * channel);
 #endif
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 static void l2cap_ertm_notify_channel_can_send(l2cap_channel_t * channel);
@@ -198,11 +205,26 @@ static btstack_linked_list_t l2cap_le_services;
 #endif
 
 // single list of channels for Classic Channels, LE Data Channels, Classic Connectionless, ATT, and SM
-static btstack_linked_list_t l2cap_channels;
+static btstack_dlist_t l2cap_channels;
+
+// transmit scheduler policy
+static const l2cap_tx_scheduler_t l2cap_tx_scheduler_drr = {
+    &l2cap_tx_scheduler_drr_select,
+    &l2cap_tx_scheduler_drr_packet_sent,
+};
+static const l2cap_tx_scheduler_t * l2cap_tx_scheduler = &l2cap_tx_scheduler_drr;
 #ifdef L2CAP_USES_CHANNELS
 // next channel id for new connections
 static uint16_t  local_source_cid  = 0x40;
+// lookup tables for dynamic channels by local cid and by (con_handle, remote cid)
+static l2cap_channel_t * l2cap_channel_for_local_cid_index[L2CAP_CHANNEL_INDEX_SIZE];
+static l2cap_channel_t * l2cap_channel_for_remote_cid_index[L2CAP_CHANNEL_INDEX_SIZE];
+#endif
+
+#if (L2CAP_CHANNEL_INDEX_SIZE & (L2CAP_CHANNEL_INDEX_SIZE - 1)) != 0
+#error "L2CAP_CHANNEL_INDEX_SIZE must be a power of two"
 #endif
+
 // next signaling sequence number
 static uint8_t   sig_seq_nr  = 0xff;
 
@@ -222,34 +244,8 @@ static uint16_t l2cap_le_custom_max_mtu;
 // enable for testing
 // #define L2CAP_ERTM_SIMULATE_FCS_ERROR_INTERVAL 16
 
-/*
- * CRC lookup table for generator polynom D^16 + D^15 + D^2 + 1
- */
-static const uint16_t crc16_table[256] = {
-    0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241, 0xc601, 0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1, 0xc481, 0x0440,
-    0xcc01, 0x0cc0, 0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40, 0x0a00, 0xcac1, 0xcb81, 0x0b40, 0xc901, 0x09c0, 0x0880, 0xc841,
-    0xd801, 0x18c0, 0x1980, 0xd941, 0x1b00, 0xdbc1, 0xda81, 0x1a40, 0x1e00, 0xdec1, 0xdf81, 0x1f40, 0xdd01, 0x1dc0, 0x1c80, 0xdc41,
-    0x1400, 0xd4c1, 0xd581, 0x1540, 0xd701, 0x17c0, 0x1680, 0xd641, 0xd201, 0x12c0, 0x1380, 0xd341, 0x1100, 0xd1c1, 0xd081, 0x1040,
-    0xf001, 0x30c0, 0x3180, 0xf141, 0x3300, 0xf3c1, 0xf281, 0x3240, 0x3600, 0xf6c1, 0xf781, 0x3740, 0xf501, 0x35c0, 0x3480, 0xf441,
-    0x3c00, 0xfcc1, 0xfd81, 0x3d40, 0xff01, 0x3fc0, 0x3e80, 0xfe41, 0xfa01, 0x3ac0, 0x3b80, 0xfb41, 0x3900, 0xf9c1, 0xf881, 0x3840,
-    0x2800, 0xe8c1, 0xe981, 0x2940, 0xeb01, 0x2bc0, 0x2a80, 0xea41, 0xee01, 0x2ec0, 0x2f80, 0xef41, 0x2d00, 0xedc1, 0xec81, 0x2c40,
-    0xe401, 0x24c0, 0x2580, 0xe541, 0x2700, 0xe7c1, 0xe681, 0x2640, 0x2200, 0xe2c1, 0xe381, 0x2340, 0xe101, 0x21c0, 0x2080, 0xe041,
-    0xa001, 0x60c0, 0x6180, 0xa141, 0x6300, 0xa3c1, 0xa281, 0x6240, 0x6600, 0xa6c1, 0xa781, 0x6740, 0xa501, 0x65c0, 0x6480, 0xa441,
-    0x6c00, 0xacc1, 0xad81, 0x6d40, 0xaf01, 0x6fc0, 0x6e80, 0xae41, 0xaa01, 0x6ac0, 0x6b80, 0xab41, 0x6900, 0xa9c1, 0xa881, 0x6840,
-    0x7800, 0xb8c1, 0xb981, 0x7940, 0xbb01, 0x7bc0, 0x7a80, 0xba41, 0xbe01, 0x7ec0, 0x7f80, 0xbf41, 0x7d00, 0xbdc1, 0xbc81, 0x7c40,
-    0xb401, 0x74c0, 0x7580, 0xb541, 0x7700, 0xb7c1, 0xb681, 0x7640, 0x7200, 0xb2c1, 0xb381, 0x7340, 0xb101, 0x71c0, 0x7080, 0xb041,
-    0x5000, 0x90c1, 0x9181, 0x5140, 0x9301, 0x53c0, 0x5280, 0x9241, 0x9601, 0x56c0, 0x5780, 0x9741, 0x5500, 0x95c1, 0x9481, 0x5440,
-    0x9c01, 0x5cc0, 0x5d80, 0x9d41, 0x5f00, 0x9fc1, 0x9e81, 0x5e40, 0x5a00, 0x9ac1, 0x9b81, 0x5b40, 0x9901, 0x59c0, 0x5880, 0x9841,
-    0x8801, 0x48c0, 0x4980, 0x8941, 0x4b00, 0x8bc1, 0x8a81, 0x4a40, 0x4e00, 0x8ec1, 0x8f81, 0x4f40, 0x8d01, 0x4dc0, 0x4c80, 0x8c41,
-    0x4400, 0x84c1, 0x8581, 0x4540, 0x8701, 0x47c0, 0x4680, 0x8641, 0x8201, 0x42c0, 0x4380, 0x8341, 0x4100, 0x81c1, 0x8081, 0x4040, 
-};
-
 static uint16_t crc16_calc(uint8_t * data, uint16_t len){
-    uint16_t crc = 0;   // initial value = 0 
-    while (len--){
-        crc = (crc >> 8) ^ crc16_table[ (crc ^ ((uint16_t) *data++)) & 0x00FF ];
-    }
-    return crc;
+    return btstack_crc16_update(0, data, len);  // initial value = 0
 }
 
 static inline uint16_t l2cap_encanced_control_field_for_information_frame(uint8_t tx_seq, int final, uint8_t req_seq, l2cap_segmentation_and_reassembly_t sar){
@@ -618,7 +614,7 @@ uint8_t l2cap_create_ertm_channel(btstack_packet_handler_t packet_handler, bd_ad
     l2cap_ertm_configure_channel(channel, ertm_config, buffer, size);
 
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // store local_cid
     if (out_local_cid){
@@ -848,14 +844,91 @@ static void l2cap_ertm_channel_send_information_frame(l2cap_channel_t * channel)
 #endif
 
 #ifdef L2CAP_USES_CHANNELS
+/**
+ * channel lookup tables
+ *
+ * Dynamic channels are chained into a slot by local cid and, once the remote cid is known, into a slot
+ * by (con_handle, remote cid). Local cids are allocated to free slots where possible, so that a lookup
+ * by local cid usually finds the channel at the head of its chain.
+ */
+static inline unsigned int l2cap_channel_index_for_local_cid(uint16_t local_cid){
+    return (local_cid - 0x40u) & (L2CAP_CHANNEL_INDEX_SIZE - 1);
+}
+
+static inline unsigned int l2cap_channel_index_for_remote_cid(hci_con_handle_t con_handle, uint16_t remote_cid){
+    return (remote_cid ^ (con_handle * 31u)) & (L2CAP_CHANNEL_INDEX_SIZE - 1);
+}
+
+static void l2cap_channel_index_add_remote_cid(l2cap_channel_t * channel){
+    if (channel->remote_cid == 0) return;
+    l2cap_channel_t ** slot = &l2cap_channel_for_remote_cid_index[l2cap_channel_index_for_remote_cid(channel->con_handle, channel->remote_cid)];
+    channel->next_for_remote_cid = *slot;
+    *slot = channel;
+}
+
+static void l2cap_channel_index_remove_remote_cid(l2cap_channel_t * channel){
+    if (channel->remote_cid == 0) return;
+    l2cap_channel_t ** slot = &l2cap_channel_for_remote_cid_index[l2cap_channel_index_for_remote_cid(channel->con_handle, channel->remote_cid)];
+    while (*slot != NULL){
+        if (*slot == channel){
+            *slot = channel->next_for_remote_cid;
+            break;
+        }
+        slot = &(*slot)->next_for_remote_cid;
+    }
+    channel->next_for_remote_cid = NULL;
+}
+
+static void l2cap_add_channel(l2cap_channel_t * channel){
+    btstack_dlist_add_tail(&l2cap_channels, (btstack_dlist_item_t *) channel);
+    l2cap_channel_t ** slot = &l2cap_channel_for_local_cid_index[l2cap_channel_index_for_local_cid(channel->local_cid)];
+    channel->next_for_local_cid = *slot;
+    *slot = channel;
+    l2cap_channel_index_add_remote_cid(channel);
+}
+
+static void l2cap_remove_channel(l2cap_channel_t * channel){
+    btstack_dlist_remove(&l2cap_channels, (btstack_dlist_item_t *) channel);
+    l2cap_channel_t ** slot = &l2cap_channel_for_local_cid_index[l2cap_channel_index_for_local_cid(channel->local_cid)];
+    while (*slot != NULL){
+        if (*slot == channel){
+            *slot = channel->next_for_local_cid;
+            break;
+        }
+        slot = &(*slot)->next_for_local_cid;
+    }
+    channel->next_for_local_cid = NULL;
+    l2cap_channel_index_remove_remote_cid(channel);
+}
+
+// remote cid is part of the lookup key, set it only via this function once the channel has been added
+static void l2cap_channel_set_remote_cid(l2cap_channel_t * channel, uint16_t remote_cid){
+    l2cap_channel_index_remove_remote_cid(channel);
+    channel->remote_cid = remote_cid;
+    l2cap_channel_index_add_remote_cid(channel);
+}
+
+static void l2cap_advance_local_cid(void){
+    if (local_source_cid == 0xffff) {
+        local_source_cid = 0x40;
+    } else {
+        local_source_cid++;
+    }
+}
+
 static uint16_t l2cap_next_local_cid(void){
-    do {
-        if (local_source_cid == 0xffff) {
-            local_source_cid = 0x40;
-        } else {
-            local_source_cid++;
+    // prefer local cid with empty lookup table slot, so that it maps directly to the channel
+    int i;
+    for (i = 0; i < L2CAP_CHANNEL_INDEX_SIZE; i++){
+        l2cap_advance_local_cid();
+        if (l2cap_channel_for_local_cid_index[l2cap_channel_index_for_local_cid(local_source_cid)] == NULL){
+            return local_source_cid;
         }
-    } while (l2cap_get_channel_for_local_cid(local_source_cid) != NULL);
+    }
+    // all slots in use, chain in slot
+    while (l2cap_get_channel_for_local_cid(local_source_cid) != NULL){
+        l2cap_advance_local_cid();
+    }
     return local_source_cid;
 }
 #endif
@@ -872,7 +945,11 @@ static uint8_t l2cap_next_sig_id(void){
 void l2cap_init(void){
     signaling_responses_pending = 0;
     
-    l2cap_channels = NULL;
+    memset(&l2cap_channels, 0, sizeof(btstack_dlist_t));
+#ifdef L2CAP_USES_CHANNELS
+    memset(l2cap_channel_for_local_cid_index,  0, sizeof(l2cap_channel_for_local_cid_index));
+    memset(l2cap_channel_for_remote_cid_index, 0, sizeof(l2cap_channel_for_remote_cid_index));
+#endif
 
 #ifdef ENABLE_CLASSIC
     l2cap_services = NULL;
@@ -881,7 +958,9 @@ void l2cap_init(void){
     // Setup Connectionless Channel
     l2cap_fixed_channel_connectionless.local_cid     = L2CAP_CID_CONNECTIONLESS_CHANNEL;
     l2cap_fixed_channel_connectionless.channel_type  = L2CAP_CHANNEL_TYPE_CONNECTIONLESS;
-    btstack_linked_list_add(&l2cap_channels, (btstack_linked_item_t *) &l2cap_fixed_channel_connectionless);
+    // list item is stale after previous l2cap_init, btstack_dlist_add would consider it as already in the list
+    memset(&l2cap_fixed_channel_connectionless.item, 0, sizeof(btstack_dlist_item_t));
+    btstack_dlist_add(&l2cap_channels, (btstack_dlist_item_t *) &l2cap_fixed_channel_connectionless);
 #endif
 
 #ifdef ENABLE_LE_DATA_CHANNELS
@@ -895,12 +974,14 @@ void l2cap_init(void){
     // Setup fixed ATT Channel
     l2cap_fixed_channel_att.local_cid    = L2CAP_CID_ATTRIBUTE_PROTOCOL;
     l2cap_fixed_channel_att.channel_type = L2CAP_CHANNEL_TYPE_LE_FIXED;
-    btstack_linked_list_add(&l2cap_channels, (btstack_linked_item_t *) &l2cap_fixed_channel_att);
+    memset(&l2cap_fixed_channel_att.item, 0, sizeof(btstack_dlist_item_t));
+    btstack_dlist_add(&l2cap_channels, (btstack_dlist_item_t *) &l2cap_fixed_channel_att);
 
     // Setup fixed SM Channel
     l2cap_fixed_channel_sm.local_cid     = L2CAP_CID_SECURITY_MANAGER_PROTOCOL;
     l2cap_fixed_channel_sm.channel_type  = L2CAP_CHANNEL_TYPE_LE_FIXED;
-    btstack_linked_list_add(&l2cap_channels, (btstack_linked_item_t *) &l2cap_fixed_channel_sm);
+    memset(&l2cap_fixed_channel_sm.item, 0, sizeof(btstack_dlist_item_t));
+    btstack_dlist_add(&l2cap_channels, (btstack_dlist_item_t *) &l2cap_fixed_channel_sm);
 #endif
     
     // 
@@ -930,6 +1011,7 @@ void l2cap_request_can_send_fix_channel_now_event(hci_con_handle_t con_handle, u
     l2cap_fixed_channel_t * channel = l2cap_fixed_channel_for_channel_id(channel_id);
     if (!channel) return;
     channel->waiting_for_can_send_now = 1;
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(BTSTACK_INSTRUMENTATION_LAYER_L2CAP, channel_id);
     l2cap_notify_channel_can_send();
 }
 
@@ -981,6 +1063,7 @@ int l2cap_send_prepared_connectionless(hci_con_handle_t con_handle, uint16_t cid
     
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
     l2cap_setup_header(acl_buffer, con_handle, 0, cid, len);
+    l2cap_tx_scheduler_packet_sent(l2cap_fixed_channel_for_channel_id(cid), len+8);
     // send
     return hci_send_acl_packet_buffer(len+8);
 }
@@ -1008,6 +1091,7 @@ static void l2cap_emit_can_send_now(btstack_packet_handler_t packet_handler, uin
     event[1] = sizeof(event) - 2;
     little_endian_store_16(event, 2, channel);
     hci_dump_packet( HCI_EVENT_PACKET, 0, event, sizeof(event));
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_EMITTED(BTSTACK_INSTRUMENTATION_LAYER_L2CAP, channel);
     packet_handler(HCI_EVENT_PACKET, channel, event, sizeof(event));
 }
 
@@ -1098,35 +1182,80 @@ static void l2cap_handle_channel_closed(l2cap_channel_t * channel){
 }
 #endif
 
+// used for fixed channels in LE (ATT/SM) and Classic (Connectionless Channel). CID < 0x04
+static l2cap_fixed_channel_t * l2cap_fixed_channel_for_channel_id(uint16_t local_cid){
+    switch (local_cid){
+#ifdef ENABLE_CLASSIC
+        case L2CAP_CID_CONNECTIONLESS_CHANNEL:
+            return &l2cap_fixed_channel_connectionless;
+#endif
+#ifdef ENABLE_BLE
+        case L2CAP_CID_ATTRIBUTE_PROTOCOL:
+            return &l2cap_fixed_channel_att;
+        case L2CAP_CID_SECURITY_MANAGER_PROTOCOL:
+            return &l2cap_fixed_channel_sm;
+#endif
+        default:
+            return NULL;
+    }
+}
+
 static l2cap_fixed_channel_t * l2cap_channel_item_by_cid(uint16_t cid){
-    btstack_linked_list_iterator_t it;    
-    btstack_linked_list_iterator_init(&it, &l2cap_channels);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        l2cap_fixed_channel_t * channel = (l2cap_fixed_channel_t*) btstack_linked_list_iterator_next(&it);
-        if (channel->local_cid == cid) {
-            return channel;
-        }
-    } 
+    if (cid < 0x40) return l2cap_fixed_channel_for_channel_id(cid);
+#ifdef L2CAP_USES_CHANNELS
+    return (l2cap_fixed_channel_t *) l2cap_get_channel_for_local_cid(cid);
+#else
     return NULL;
+#endif
 }
 
-// used for fixed channels in LE (ATT/SM) and Classic (Connectionless Channel). CID < 0x04
-static l2cap_fixed_channel_t * l2cap_fixed_channel_for_channel_id(uint16_t local_cid){
-    if (local_cid >= 0x40) return NULL;
-    return (l2cap_fixed_channel_t*) l2cap_channel_item_by_cid(local_cid);
+uint8_t l2cap_set_tx_priority(uint16_t local_cid, uint8_t priority){
+    l2cap_fixed_channel_t * channel = l2cap_channel_item_by_cid(local_cid);
+    if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    channel->tx_scheduler.priority = priority;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_set_tx_weight(uint16_t local_cid, uint8_t weight){
+    l2cap_fixed_channel_t * channel = l2cap_channel_item_by_cid(local_cid);
+    if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    channel->tx_scheduler.weight = weight;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_get_tx_statistics(uint16_t local_cid, l2cap_tx_statistics_t * statistics){
+    l2cap_fixed_channel_t * channel = l2cap_channel_item_by_cid(local_cid);
+    if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    *statistics = channel->tx_scheduler.statistics;
+    return ERROR_CODE_SUCCESS;
 }
 
 // used for Classic Channels + LE Data Channels. local_cid >= 0x40
 #ifdef L2CAP_USES_CHANNELS
 static l2cap_channel_t * l2cap_get_channel_for_local_cid(uint16_t local_cid){
     if (local_cid < 0x40) return NULL;
-    return (l2cap_channel_t*) l2cap_channel_item_by_cid(local_cid);
+    l2cap_channel_t * channel = l2cap_channel_for_local_cid_index[l2cap_channel_index_for_local_cid(local_cid)];
+    while (channel != NULL){
+        if (channel->local_cid == local_cid) return channel;
+        channel = channel->next_for_local_cid;
+    }
+    return NULL;
+}
+
+static l2cap_channel_t * l2cap_get_channel_for_remote_cid(hci_con_handle_t con_handle, uint16_t remote_cid){
+    l2cap_channel_t * channel = l2cap_channel_for_remote_cid_index[l2cap_channel_index_for_remote_cid(con_handle, remote_cid)];
+    while (channel != NULL){
+        if ((channel->remote_cid == remote_cid) && (channel->con_handle == con_handle)) return channel;
+        channel = channel->next_for_remote_cid;
+    }
+    return NULL;
 }
 
 void l2cap_request_can_send_now_event(uint16_t local_cid){
     l2cap_channel_t *channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) return;
     channel->waiting_for_can_send_now = 1;
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(BTSTACK_INSTRUMENTATION_LAYER_L2CAP, local_cid);
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
         l2cap_ertm_notify_channel_can_send(channel);
@@ -1144,6 +1273,8 @@ int  l2cap_can_send_packet_now(uint16_t local_cid){
         return l2cap_ertm_can_store_packet_now(channel);
     }
 #endif    
+    // don't let a basic mode packet overtake SDUs queued with l2cap_send_iov
+    if (channel->send_iov_requests) return 0;
     return hci_can_send_acl_packet_now(channel->con_handle);
 }
 
@@ -1155,6 +1286,7 @@ int  l2cap_can_send_prepared_packet_now(uint16_t local_cid){
         return 0;
     }
 #endif
+    if (channel->send_iov_requests) return 0;
     return hci_can_send_prepared_acl_packet_now(channel->con_handle);
 }
 
@@ -1182,10 +1314,10 @@ static int l2cap_is_dynamic_channel_type(l2cap_channel_type_t channel_type){
 #ifdef ENABLE_CLASSIC
 // RTX Timer only exist for dynamic channels
 static l2cap_channel_t * l2cap_channel_for_rtx_timer(btstack_timer_source_t * ts){
-    btstack_linked_list_iterator_t it;    
-    btstack_linked_list_iterator_init(&it, &l2cap_channels);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;    
+    btstack_dlist_iterator_init(&it, &l2cap_channels);
+    while (btstack_dlist_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
         if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
         if (&channel->rtx == ts) {
             return channel;
@@ -1206,7 +1338,7 @@ static void l2cap_rtx_timeout(btstack_timer_source_t * ts){
     l2cap_handle_channel_open_failed(channel, L2CAP_CONNECTION_RESPONSE_RESULT_RTX_TIMEOUT);
 
     // discard channel
-    btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_remove_channel(channel);
     l2cap_free_channel_entry(channel);
 }
 
@@ -1277,7 +1409,7 @@ int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
         return -1;   // TODO: define error
     }
 
-    if (!hci_can_send_prepared_acl_packet_now(channel->con_handle)){
+    if (channel->send_iov_requests || !hci_can_send_prepared_acl_packet_now(channel->con_handle)){
         log_info("l2cap_send_prepared cid 0x%02x, cannot send", local_cid);
         return BTSTACK_ACL_BUFFERS_FULL;
     }
@@ -1306,6 +1438,8 @@ int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
     }
 #endif
 
+    l2cap_tx_scheduler_packet_sent((l2cap_fixed_channel_t *) channel, len+8+fcs_size);
+
     // send
     return hci_send_acl_packet_buffer(len+8+fcs_size);
 }
@@ -1330,7 +1464,7 @@ int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len){
         return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
     }
 
-    if (!hci_can_send_acl_packet_now(channel->con_handle)){
+    if (channel->send_iov_requests || !hci_can_send_acl_packet_now(channel->con_handle)){
         log_info("l2cap_send cid 0x%02x, cannot send", local_cid);
         return BTSTACK_ACL_BUFFERS_FULL;
     }
@@ -1472,7 +1606,7 @@ static bool l2cap_run_for_classic_channel(l2cap_channel_t * channel){
             channel->state = L2CAP_STATE_INVALID;
             l2cap_send_signaling_packet(channel->con_handle, CONNECTION_RESPONSE, channel->remote_sig_id, channel->local_cid, channel->remote_cid, channel->reason, 0);
             // discard channel - l2cap_finialize_channel_close without sending l2cap close event
-            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+            l2cap_remove_channel(channel);
             l2cap_free_channel_entry(channel);
             channel = NULL;
             break;
@@ -1730,10 +1864,10 @@ static void l2cap_run_signaling_response(void) {
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 static bool l2ap_run_ertm(void){
     // send l2cap information request if neccessary
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
     hci_connections_get_iterator(&it);
-    while(btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    while(btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         if (connection->l2cap_state.information_state == L2CAP_INFORMATION_STATE_W2_SEND_EXTENDED_FEATURE_REQUEST){
             if (!hci_can_send_acl_packet_now(connection->con_handle)) break;
             connection->l2cap_state.information_state = L2CAP_INFORMATION_STATE_W4_EXTENDED_FEATURE_RESPONSE;
@@ -1749,11 +1883,11 @@ static bool l2ap_run_ertm(void){
 
 #ifdef ENABLE_LE_DATA_CHANNELS
 static void l2cap_run_le_data_channels(void){
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &l2cap_channels);
-    while (btstack_linked_list_iterator_has_next(&it)){
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &l2cap_channels);
+    while (btstack_dlist_iterator_has_next(&it)){
         uint16_t mps;
-        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
 
         if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL) continue;
 
@@ -1785,7 +1919,7 @@ static void l2cap_run_le_data_channels(void){
                 channel->state = L2CAP_STATE_INVALID;
                 l2cap_send_le_signaling_packet(channel->con_handle, LE_CREDIT_BASED_CONNECTION_RESPONSE, channel->remote_sig_id, 0, 0, 0, 0, channel->reason);
                 // discard channel - l2cap_finialize_channel_close without sending l2cap close event
-                btstack_linked_list_iterator_remove(&it);
+                l2cap_remove_channel(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             case L2CAP_STATE_OPEN:
@@ -1834,14 +1968,14 @@ static void l2cap_run(void){
 #endif
 
 #if defined(ENABLE_CLASSIC) || defined(ENABLE_BLE)
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
 #endif
 
 #ifdef ENABLE_CLASSIC
-    btstack_linked_list_iterator_init(&it, &l2cap_channels);
-    while (btstack_linked_list_iterator_has_next(&it)){
+    btstack_dlist_iterator_init(&it, &l2cap_channels);
+    while (btstack_dlist_iterator_has_next(&it)){
 
-        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
 
         if (channel->channel_type != L2CAP_CHANNEL_TYPE_CLASSIC) continue;
 
@@ -1863,8 +1997,8 @@ static void l2cap_run(void){
 #ifdef ENABLE_BLE
     // send l2cap con paramter update if necessary
     hci_connections_get_iterator(&it);
-    while(btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+    while(btstack_dlist_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_dlist_iterator_next(&it);
         if ((connection->address_type != BD_ADDR_TYPE_LE_PUBLIC) && (connection->address_type != BD_ADDR_TYPE_LE_RANDOM)) continue;
         if (!hci_can_send_acl_packet_now(connection->con_handle)) continue;
         switch (connection->le_con_parameter_update_state){
@@ -1970,6 +2104,8 @@ static l2cap_channel_t * l2cap_create_channel_entry(btstack_packet_handler_t pac
 
 static void l2cap_free_channel_entry(l2cap_channel_t * channel){
     log_info("free channel %p, local_cid 0x%04x", channel, channel->local_cid);
+    // drop SDUs from caller memory
+    l2cap_iov_requests_abort(channel);
     // assert all timers are stopped
     l2cap_stop_rtx(channel);
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
@@ -2008,7 +2144,7 @@ uint8_t l2cap_create_channel(btstack_packet_handler_t channel_packet_handler, bd
 #endif    
 
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // store local_cid
     if (out_local_cid){
@@ -2044,10 +2180,10 @@ void l2cap_disconnect(uint16_t local_cid, uint8_t reason){
 
 static void l2cap_handle_connection_failed_for_addr(bd_addr_t address, uint8_t status){
     // mark all channels before emitting open events as these could trigger new connetion requests to the same device
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &l2cap_channels);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &l2cap_channels);
+    while (btstack_dlist_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
         if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
         if (bd_addr_cmp( channel->address, address) != 0) continue;
         // channel for this address found
@@ -2064,16 +2200,16 @@ static void l2cap_handle_connection_failed_for_addr(bd_addr_t address, uint8_t s
     int done = 0;
     while (!done) {
         done = 1;
-        btstack_linked_list_iterator_init(&it, &l2cap_channels);
-        while (btstack_linked_list_iterator_has_next(&it)){
-            l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        btstack_dlist_iterator_init(&it, &l2cap_channels);
+        while (btstack_dlist_iterator_has_next(&it)){
+            l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
             if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
             if (channel->state == L2CAP_STATE_EMIT_OPEN_FAILED_AND_DISCARD){
                 done = 0;
                 // failure, forward error code
                 l2cap_handle_channel_open_failed(channel, status);
                 // discard channel
-                btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_remove_channel(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             }
@@ -2083,10 +2219,10 @@ static void l2cap_handle_connection_failed_for_addr(bd_addr_t address, uint8_t s
 }
 
 static void l2cap_handle_connection_success_for_addr(bd_addr_t address, hci_con_handle_t handle){
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &l2cap_channels);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, &l2cap_channels);
+    while (btstack_dlist_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
         if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
         if ( ! bd_addr_cmp( channel->address, address) ){
             l2cap_handle_connection_complete(handle, channel);
@@ -2097,6 +2233,170 @@ static void l2cap_handle_connection_success_for_addr(bd_addr_t address, hci_con_
 }
 #endif
 
+#ifdef L2CAP_USES_CHANNELS
+// SDUs from caller memory: one PDU per channel is owned by HCI at a time
+
+// @returns request with next PDU to send or NULL
+static l2cap_iov_request_t * l2cap_iov_request_ready(l2cap_channel_t * channel){
+    l2cap_iov_request_t * request = (l2cap_iov_request_t *) channel->send_iov_requests;
+    if (request == NULL) return NULL;
+    if (request->pdu_active) return NULL;
+    return request;
+}
+
+static void l2cap_iov_request_pdu_sent(btstack_state_t * btstack, hci_acl_iov_packet_t * pdu, uint8_t status){
+    UNUSED(btstack);
+    l2cap_iov_request_t * request = (l2cap_iov_request_t *) pdu->context;
+    request->pdu_active = false;
+
+    // channel was closed while PDU was owned by HCI
+    if (request->status != ERROR_CODE_SUCCESS){
+        (*request->callback)(request, request->status);
+        return;
+    }
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(request->local_cid);
+    btstack_assert(channel != NULL);
+
+    // next PDU is sent by l2cap_notify_channel_can_send on HCI_EVENT_TRANSPORT_PACKET_SENT
+    if ((status != ERROR_CODE_SUCCESS) || (request->pos >= request->len)){
+        btstack_linked_list_remove(&channel->send_iov_requests, (btstack_linked_item_t *) request);
+        (*request->callback)(request, status);
+    }
+}
+
+static void l2cap_iov_request_send_pdu(l2cap_channel_t * channel){
+    l2cap_iov_request_t * request = l2cap_iov_request_ready(channel);
+    btstack_assert(request != NULL);
+
+    hci_acl_iov_packet_t * pdu = &request->pdu;
+    pdu->con_handle = channel->con_handle;
+    pdu->iov = request->iov;
+    pdu->iov_count = request->iov_count;
+    pdu->payload_offset = request->pos;
+    pdu->callback = &l2cap_iov_request_pdu_sent;
+    pdu->context = request;
+
+    uint16_t pos = 4;
+    uint16_t payload_len = request->len;
+#ifdef ENABLE_LE_DATA_CHANNELS
+    if (channel->channel_type == L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL){
+        // K-Frame, first one starts with SDU len
+        pdu->packet_boundary_flag = 0x00;
+        if (request->num_pdus == 0){
+            little_endian_store_16(pdu->header, pos, request->len);
+            pos += 2;
+        }
+        payload_len = btstack_min(request->len - request->pos, channel->remote_mps - (pos - 4));
+        channel->credits_outgoing--;
+    } else
+#endif
+    {
+        // B-Frame, set non-flushable packet boundary flag if supported on Controller
+        pdu->packet_boundary_flag = hci_non_flushable_packet_boundary_flag_supported() ? 0x00 : 0x02;
+    }
+    little_endian_store_16(pdu->header, 0, pos - 4 + payload_len);
+    little_endian_store_16(pdu->header, 2, channel->remote_cid);
+    pdu->header_len  = (uint8_t) pos;
+    pdu->payload_len = payload_len;
+
+    request->pos += payload_len;
+    request->num_pdus++;
+    request->pdu_active = true;
+
+    l2cap_tx_scheduler_packet_sent((l2cap_fixed_channel_t *) channel, 4 + pos + payload_len);
+
+    uint8_t status = hci_send_acl_iov_packet(pdu);
+    if (status != ERROR_CODE_SUCCESS){
+#ifdef ENABLE_LE_DATA_CHANNELS
+        // K-Frame was not sent, return its credit
+        if (channel->channel_type == L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL){
+            channel->credits_outgoing++;
+        }
+#endif
+        l2cap_iov_request_pdu_sent(NULL, pdu, status);
+    }
+}
+
+// called when channel gets freed
+static void l2cap_iov_requests_abort(l2cap_channel_t * channel){
+    while (channel->send_iov_requests != NULL){
+        l2cap_iov_request_t * request = (l2cap_iov_request_t *) btstack_linked_list_pop(&channel->send_iov_requests);
+        request->status = L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+        // callback is emitted when HCI returns PDU
+        if (request->pdu_active) continue;
+        (*request->callback)(request, request->status);
+    }
+}
+
+uint8_t l2cap_send_iov(uint16_t local_cid, l2cap_iov_request_t * request){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_send_iov no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    if (channel->state != L2CAP_STATE_OPEN) return ERROR_CODE_COMMAND_DISALLOWED;
+
+#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+    // ERTM keeps a copy of I-Frames for retransmission, use l2cap_send
+    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) return ERROR_CODE_COMMAND_DISALLOWED;
+#endif
+
+    uint32_t len = 0;
+    int i;
+    for (i = 0; i < request->iov_count; i++){
+        len += request->iov[i].len;
+    }
+    if (len > channel->remote_mtu){
+        log_error("l2cap_send_iov cid 0x%02x, data length exceeds remote MTU.", local_cid);
+        return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
+    }
+    // B-Frame incl. L2CAP header needs to fit into ACL packet
+    if ((len + 4) > 0xffff) return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
+
+    request->local_cid  = local_cid;
+    request->len        = (uint16_t) len;
+    request->pos        = 0;
+    request->num_pdus   = 0;
+    request->pdu_active = false;
+    request->status     = ERROR_CODE_SUCCESS;
+    btstack_linked_list_add_tail(&channel->send_iov_requests, (btstack_linked_item_t *) request);
+
+    l2cap_notify_channel_can_send();
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
+// channel has data or a pending can send now request, independent of flow control and HCI
+static bool l2cap_channel_has_data_to_send(l2cap_channel_t * channel){
+    switch (channel->channel_type){
+#ifdef ENABLE_CLASSIC
+        case L2CAP_CHANNEL_TYPE_CLASSIC:
+#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+            if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) {
+                return channel->unacked_frames < channel->num_stored_tx_frames;
+            }
+#endif
+            // can send now is emitted after all queued iov SDUs have been sent
+            if (channel->send_iov_requests != NULL) return l2cap_iov_request_ready(channel) != NULL;
+            return channel->waiting_for_can_send_now != 0;
+        case L2CAP_CHANNEL_TYPE_CONNECTIONLESS:
+            return channel->waiting_for_can_send_now != 0;
+#endif
+#ifdef ENABLE_BLE
+        case L2CAP_CHANNEL_TYPE_LE_FIXED:
+            return channel->waiting_for_can_send_now != 0;
+#ifdef ENABLE_LE_DATA_CHANNELS
+        case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
+            return (channel->send_sdu_buffer != NULL) || (l2cap_iov_request_ready(channel) != NULL);
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
 static bool l2cap_channel_ready_to_send(l2cap_channel_t * channel){
     switch (channel->channel_type){
 #ifdef ENABLE_CLASSIC
@@ -2108,6 +2408,10 @@ static bool l2cap_channel_ready_to_send(l2cap_channel_t * channel){
                 return hci_can_send_acl_classic_packet_now() != 0;
             }
 #endif
+            if (channel->send_iov_requests != NULL){
+                if (l2cap_iov_request_ready(channel) == NULL) return false;
+                return (hci_can_send_acl_classic_packet_now() != 0);
+            }
             if (!channel->waiting_for_can_send_now) return false;
             return (hci_can_send_acl_classic_packet_now() != 0);
         case L2CAP_CHANNEL_TYPE_CONNECTIONLESS:
@@ -2120,7 +2424,7 @@ static bool l2cap_channel_ready_to_send(l2cap_channel_t * channel){
             return hci_can_send_acl_le_packet_now() != 0;
 #ifdef ENABLE_LE_DATA_CHANNELS
         case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
-            if (channel->send_sdu_buffer == NULL) return false;
+            if ((channel->send_sdu_buffer == NULL) && (l2cap_iov_request_ready(channel) == NULL)) return false;
             if (channel->credits_outgoing == 0) return false;
             return hci_can_send_acl_le_packet_now() != 0;
 #endif
@@ -2140,6 +2444,10 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
                 return;
             }
 #endif
+            if (l2cap_iov_request_ready(channel) != NULL){
+                l2cap_iov_request_send_pdu(channel);
+                return;
+            }
             channel->waiting_for_can_send_now = 0;
             l2cap_emit_can_send_now(channel->packet_handler, channel->local_cid);
             break;
@@ -2155,7 +2463,11 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
             break;
 #ifdef ENABLE_LE_DATA_CHANNELS
         case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
-            l2cap_le_send_pdu(channel);
+            if (channel->send_sdu_buffer != NULL){
+                l2cap_le_send_pdu(channel);
+            } else {
+                l2cap_iov_request_send_pdu(channel);
+            }
             break;
 #endif
 #endif
@@ -2164,28 +2476,91 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
     }
 }
 
-static void l2cap_notify_channel_can_send(void){
-    bool done = false;
-    while (!done){
-        done = true;
-        btstack_linked_list_iterator_t it;
-        btstack_linked_list_iterator_init(&it, &l2cap_channels);
-        while (btstack_linked_list_iterator_has_next(&it)){
-            l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
-            bool ready = l2cap_channel_ready_to_send(channel);
-            if (!ready) continue;
-
-            // requeue channel for fairness
-            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
-            btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
-
-            // trigger sending
-            l2cap_channel_trigger_send(channel);
-
-            // exit inner loop as we just broke the iterator, but try again
-            done = false;
-            break;
+// channels with data that are ready to send, in round robin order
+l2cap_fixed_channel_t * l2cap_tx_scheduler_next_ready(l2cap_fixed_channel_t * channel){
+    btstack_dlist_item_t * item = (channel == NULL) ? btstack_dlist_get_first_item(&l2cap_channels) : channel->item.next;
+    for (; item != NULL; item = item->next){
+        if (l2cap_channel_ready_to_send((l2cap_channel_t *) item)) return (l2cap_fixed_channel_t *) item;
+    }
+    return NULL;
+}
+
+static void l2cap_tx_scheduler_packet_sent(l2cap_fixed_channel_t * channel, uint16_t size){
+    if (!channel) return;
+    channel->tx_scheduler.statistics.num_packets++;
+    channel->tx_scheduler.statistics.num_bytes += size;
+    if (l2cap_tx_scheduler->packet_sent != NULL){
+        (*l2cap_tx_scheduler->packet_sent)(channel, size);
+    }
+}
+
+// default policy: highest priority first, deficit round robin within same priority
+
+static void l2cap_tx_scheduler_drr_packet_sent(l2cap_fixed_channel_t * channel, uint16_t size){
+    channel->tx_scheduler.deficit -= size;
+}
+
+static l2cap_fixed_channel_t * l2cap_tx_scheduler_drr_select(void){
+    btstack_dlist_iterator_t it;
+    bool ready_found = false;
+    uint8_t priority = 0;
+    btstack_dlist_iterator_init(&it, &l2cap_channels);
+    while (btstack_dlist_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
+        if (!l2cap_channel_has_data_to_send(channel)){
+            // idle channels don't keep credit from earlier rounds
+            channel->tx_scheduler.deficit = btstack_min(0, channel->tx_scheduler.deficit);
+            continue;
         }
+        if (!l2cap_channel_ready_to_send(channel)) continue;
+        if (ready_found && (channel->tx_scheduler.priority <= priority)) continue;
+        ready_found = true;
+        priority = channel->tx_scheduler.priority;
+    }
+    if (!ready_found) return NULL;
+
+    while (true){
+        // first ready channel in list order that has deficit left
+        btstack_dlist_iterator_init(&it, &l2cap_channels);
+        while (btstack_dlist_iterator_has_next(&it)){
+            l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
+            if (channel->tx_scheduler.priority != priority) continue;
+            if (channel->tx_scheduler.deficit <= 0) continue;
+            if (!l2cap_channel_ready_to_send(channel)) continue;
+            return (l2cap_fixed_channel_t *) channel;
+        }
+        // all ready channels used up their deficit -> start next round
+        btstack_dlist_iterator_init(&it, &l2cap_channels);
+        while (btstack_dlist_iterator_has_next(&it)){
+            l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
+            if (channel->tx_scheduler.priority != priority) continue;
+            if (!l2cap_channel_ready_to_send(channel)) continue;
+            uint8_t weight = btstack_max(1, channel->tx_scheduler.weight);
+            channel->tx_scheduler.deficit += weight * L2CAP_TX_SCHEDULER_QUANTUM;
+        }
+    }
+}
+
+const l2cap_tx_scheduler_t * l2cap_tx_scheduler_drr_instance(void){
+    return &l2cap_tx_scheduler_drr;
+}
+
+void l2cap_set_tx_scheduler(const l2cap_tx_scheduler_t * scheduler){
+    l2cap_tx_scheduler = (scheduler != NULL) ? scheduler : &l2cap_tx_scheduler_drr;
+}
+
+static void l2cap_notify_channel_can_send(void){
+    while (true){
+        l2cap_channel_t * channel = (l2cap_channel_t *) (*l2cap_tx_scheduler->select)();
+        if (!channel) break;
+
+        // requeue channel for fairness
+        btstack_dlist_remove(&l2cap_channels, (btstack_dlist_item_t *) channel);
+        btstack_dlist_add_tail(&l2cap_channels, (btstack_dlist_item_t *) channel);
+
+        // trigger sending
+        channel->tx_scheduler.statistics.num_scheduled++;
+        l2cap_channel_trigger_send(channel);
     }
 }
 
@@ -2266,7 +2641,7 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
 #endif
 #ifdef L2CAP_USES_CHANNELS
     hci_con_handle_t handle;
-    btstack_linked_list_iterator_t it;
+    btstack_dlist_iterator_t it;
 #endif
 
     switch(hci_event_packet_get_type(packet)){
@@ -2326,12 +2701,12 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
         case HCI_EVENT_DISCONNECTION_COMPLETE:
             handle = little_endian_read_16(packet, 3);
             // send l2cap open failed or closed events for all channels on this handle and free them
-            btstack_linked_list_iterator_init(&it, &l2cap_channels);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            btstack_dlist_iterator_init(&it, &l2cap_channels);
+            while (btstack_dlist_iterator_has_next(&it)){
+                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
                 if (channel->con_handle != handle) continue;
-                btstack_linked_list_iterator_remove(&it);
+                l2cap_remove_channel(channel);
                 switch(channel->channel_type){
 #ifdef ENABLE_CLASSIC
                     case L2CAP_CHANNEL_TYPE_CLASSIC:
@@ -2358,9 +2733,9 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
             if (gap_get_connection_type(handle) != GAP_CONNECTION_ACL) break;
             if (hci_authentication_active_for_handle(handle)) break;
             hci_con_used = 0;
-            btstack_linked_list_iterator_init(&it, &l2cap_channels);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            btstack_dlist_iterator_init(&it, &l2cap_channels);
+            while (btstack_dlist_iterator_has_next(&it)){
+                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
                 if (channel->con_handle != handle) continue;
                 hci_con_used = 1;
@@ -2373,9 +2748,9 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
 
         case HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE:
             handle = little_endian_read_16(packet, 3);
-            btstack_linked_list_iterator_init(&it, &l2cap_channels);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            btstack_dlist_iterator_init(&it, &l2cap_channels);
+            while (btstack_dlist_iterator_has_next(&it)){
+                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
                 if (channel->con_handle != handle) continue;
                 log_info("remote supported features, channel %p, cid %04x - state %u", channel, channel->local_cid, channel->state);
@@ -2386,9 +2761,9 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
         case GAP_EVENT_SECURITY_LEVEL:
             handle = little_endian_read_16(packet, 2);
             log_info("l2cap - security level update for handle 0x%04x", handle);
-            btstack_linked_list_iterator_init(&it, &l2cap_channels);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            btstack_dlist_iterator_init(&it, &l2cap_channels);
+            while (btstack_dlist_iterator_has_next(&it)){
+                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
                 if (channel->con_handle != handle) continue;
 
@@ -2477,6 +2852,13 @@ static void l2cap_handle_connection_request(hci_con_handle_t handle, uint8_t sig
         return;
     }
 
+    // check if source cid is already used by a channel on this ACL connection
+    if (l2cap_get_channel_for_remote_cid(handle, source_cid) != NULL){
+        // 0x0007 Connection refused - Source CID already allocated
+        l2cap_register_signaling_response(handle, CONNECTION_REQUEST, sig_id, source_cid, 0x0007);
+        return;
+    }
+
     // alloc structure
     // log_info("l2cap_handle_connection_request register channel");
     l2cap_channel_t * channel = l2cap_create_channel_entry(service->packet_handler, L2CAP_CHANNEL_TYPE_CLASSIC, hci_connection->address, BD_ADDR_TYPE_ACL, 
@@ -2501,7 +2883,7 @@ static void l2cap_handle_connection_request(hci_con_handle_t handle, uint8_t sig
     channel->state_var  = (L2CAP_CHANNEL_STATE_VAR) (L2CAP_CHANNEL_STATE_VAR_SEND_CONN_RESP_PEND | L2CAP_CHANNEL_STATE_VAR_INCOMING);
     
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // assert security requirements
     gap_request_security_level(handle, channel->required_security_level);
@@ -2752,7 +3134,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
                     switch (result) {
                         case 0:
                             // successful connection
-                            channel->remote_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET);
+                            l2cap_channel_set_remote_cid(channel, little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET));
                             channel->state = L2CAP_STATE_CONFIG;
                             channelStateVarSetFlag(channel, L2CAP_CHANNEL_STATE_VAR_SEND_CONF_REQ);
                             break;
@@ -2772,7 +3154,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
                             }
                             
                             // discard channel
-                            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                            l2cap_remove_channel(channel);
                             l2cap_free_channel_entry(channel);
                             break;
                     }
@@ -2878,7 +3260,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
 // @pre command len is valid, see check in l2cap_acl_classic_handler
 static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t * command){
     
-    btstack_linked_list_iterator_t it;    
+    btstack_dlist_iterator_t it;    
 
     // get code, signalind identifier and command len
     uint8_t code     = command[L2CAP_SIGNALING_COMMAND_CODE_OFFSET];
@@ -2936,9 +3318,9 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
             log_info("extended features mask 0x%02x", connection->l2cap_state.extended_feature_mask);
 
             // trigger connection request
-            btstack_linked_list_iterator_init(&it, &l2cap_channels);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            btstack_dlist_iterator_init(&it, &l2cap_channels);
+            while (btstack_dlist_iterator_has_next(&it)){
+                l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
                 if (channel->con_handle != handle) continue;
 
@@ -2961,7 +3343,7 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
                             // map l2cap connection response result to BTstack status enumeration
                             l2cap_handle_channel_open_failed(channel, L2CAP_CONNECTION_RESPONSE_RESULT_ERTM_NOT_SUPPORTED);
                             // discard channel
-                            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                            l2cap_remove_channel(channel);
                             l2cap_free_channel_entry(channel);
                             continue;
 
@@ -2985,27 +3367,25 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
             break;
     }
     
-    // Get potential destination CID
-    uint16_t dest_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET);
-    
-    // Find channel for this sig_id and connection handle
-    btstack_linked_list_iterator_init(&it, &l2cap_channels);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+    if ((code & 1) == 0){
+        // match even commands (requests) by local channel id
+        uint16_t dest_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET);
+        l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(dest_cid);
+        if ((channel != NULL) && l2cap_is_dynamic_channel_type(channel->channel_type) && (channel->con_handle == handle)){
+            l2cap_signaling_handler_channel(channel, command);
+        }
+        return;
+    }
+
+    // match odd commands (responses) by previous signaling identifier
+    btstack_dlist_iterator_init(&it, &l2cap_channels);
+    while (btstack_dlist_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
         if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
         if (channel->con_handle != handle) continue;
-        if (code & 1) {
-            // match odd commands (responses) by previous signaling identifier 
-            if (channel->local_sig_id == sig_id) {
-                l2cap_signaling_handler_channel(channel, command);
-                break;
-            }
-        } else {
-            // match even commands (requests) by local channel id
-            if (channel->local_cid == dest_cid) {
-                l2cap_signaling_handler_channel(channel, command);
-                break;
-            }
+        if (channel->local_sig_id == sig_id) {
+            l2cap_signaling_handler_channel(channel, command);
+            break;
         }
     }
 }
@@ -3031,7 +3411,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
     uint8_t  event[12];
 
 #ifdef ENABLE_LE_DATA_CHANNELS
-    btstack_linked_list_iterator_t it;    
+    btstack_dlist_iterator_t it;    
     l2cap_channel_t * channel;
     uint16_t local_cid;
     uint16_t le_psm;
@@ -3099,9 +3479,9 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
         case COMMAND_REJECT:
             // Find channel for this sig_id and connection handle
             channel = NULL;
-            btstack_linked_list_iterator_init(&it, &l2cap_channels);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            btstack_dlist_iterator_init(&it, &l2cap_channels);
+            while (btstack_dlist_iterator_has_next(&it)){
+                l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(a_channel->channel_type)) continue;
                 if (a_channel->con_handle   != handle) continue;
                 if (a_channel->local_sig_id != sig_id) continue;
@@ -3117,7 +3497,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 l2cap_emit_le_channel_opened(channel, 0x0002);
                                 
                 // discard channel
-                btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_remove_channel(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             }
@@ -3143,17 +3523,12 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                     return 1;
                 }
 
-                // go through list of channels for this ACL connection and check if we get a match
-                btstack_linked_list_iterator_init(&it, &l2cap_channels);
-                while (btstack_linked_list_iterator_has_next(&it)){
-                    l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
-                    if (!l2cap_is_dynamic_channel_type(a_channel->channel_type)) continue;
-                    if (a_channel->con_handle != handle) continue;
-                    if (a_channel->remote_cid != source_cid) continue;
+                // check if source cid is already used by a channel on this ACL connection
+                if (l2cap_get_channel_for_remote_cid(handle, source_cid) != NULL){
                     // 0x000a Connection refused - Source CID already allocated
                     l2cap_register_signaling_response(handle, LE_CREDIT_BASED_CONNECTION_REQUEST, sig_id, source_cid, 0x000a);
                     return 1;
-                }                    
+                }
 
                 // security: check encryption
                 if (service->required_security_level >= LEVEL_2){
@@ -3209,7 +3584,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 channel->state_var |= L2CAP_CHANNEL_STATE_VAR_INCOMING;
 
                 // add to connections list
-                btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_add_channel(channel);
 
                 // post connection request event
                 l2cap_emit_le_incoming_connection(channel);
@@ -3226,9 +3601,9 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
 
             // Find channel for this sig_id and connection handle
             channel = NULL;
-            btstack_linked_list_iterator_init(&it, &l2cap_channels);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            btstack_dlist_iterator_init(&it, &l2cap_channels);
+            while (btstack_dlist_iterator_has_next(&it)){
+                l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_dlist_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(a_channel->channel_type)) continue;
                 if (a_channel->con_handle   != handle) continue;
                 if (a_channel->local_sig_id != sig_id) continue;
@@ -3245,13 +3620,13 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 l2cap_emit_le_channel_opened(channel, result);
                                 
                 // discard channel
-                btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_remove_channel(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             }
 
             // success
-            channel->remote_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 0);
+            l2cap_channel_set_remote_cid(channel, little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 0));
             channel->remote_mtu = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 2);
             channel->remote_mps = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 4);
             channel->credits_outgoing = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 6);
@@ -3660,6 +4035,12 @@ static void l2cap_acl_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
     hci_con_handle_t handle = READ_ACL_CONNECTION_HANDLE(packet);
     hci_connection_t *conn = hci_connection_for_handle(handle);
     if (!conn) return;
+#ifdef ENABLE_BTSTACK_INSTRUMENTATION
+    // read before dispatch, packet might get modified by handlers
+    uint16_t instrumentation_cid  = READ_L2CAP_CHANNEL_ID(packet);
+    uint16_t instrumentation_size = size - COMPLETE_L2CAP_HEADER;
+#endif
+    BTSTACK_INSTRUMENTATION_START(handler_start_us);
     if (conn->address_type == BD_ADDR_TYPE_ACL){
         l2cap_acl_classic_handler(handle, packet, size);
     } else {
@@ -3667,6 +4048,7 @@ static void l2cap_acl_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
     }
 
     l2cap_run();
+    BTSTACK_INSTRUMENTATION_HANDLED(BTSTACK_INSTRUMENTATION_LAYER_L2CAP, instrumentation_cid, instrumentation_size, handler_start_us);
 }
 
 // Bluetooth 4.0 - allows to register handler for Attribute Protocol and Security Manager Protocol
@@ -3682,7 +4064,7 @@ void l2cap_finialize_channel_close(l2cap_channel_t * channel){
     channel->state = L2CAP_STATE_CLOSED;
     l2cap_handle_channel_closed(channel);
     // discard channel
-    btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_remove_channel(channel);
     l2cap_free_channel_entry(channel);
 }
 #endif
@@ -3761,7 +4143,7 @@ uint8_t l2cap_unregister_service(uint16_t psm){
 
 static void l2cap_le_notify_channel_can_send(l2cap_channel_t *channel){
     if (!channel->waiting_for_can_send_now) return;
-    if (channel->send_sdu_buffer) return;
+    if (channel->send_sdu_buffer || channel->send_iov_requests) return;
     channel->waiting_for_can_send_now = 0;
     log_debug("L2CAP_EVENT_CHANNEL_LE_CAN_SEND_NOW local_cid 0x%x", channel->local_cid);
     l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_LE_CAN_SEND_NOW);
@@ -3843,6 +4225,7 @@ static void l2cap_le_send_pdu(l2cap_channel_t *channel){
 
     channel->credits_outgoing--;
 
+    l2cap_tx_scheduler_packet_sent((l2cap_fixed_channel_t *) channel, 8 + pos);
     hci_send_acl_packet_buffer(8 + pos);
 
     if (channel->send_sdu_pos >= (channel->send_sdu_len + 2)){
@@ -3859,7 +4242,7 @@ void l2cap_le_finialize_channel_close(l2cap_channel_t * channel){
     channel->state = L2CAP_STATE_CLOSED;
     l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_CHANNEL_CLOSED);
     // discard channel
-    btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_remove_channel(channel);
     l2cap_free_channel_entry(channel);
 }
 
@@ -3986,7 +4369,7 @@ uint8_t l2cap_le_create_channel(btstack_packet_handler_t packet_handler, hci_con
     channel->automatic_credits    = initial_credits == L2CAP_LE_AUTOMATIC_CREDITS;
 
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // go
     l2cap_run();
@@ -4043,7 +4426,7 @@ int l2cap_le_can_send_now(uint16_t local_cid){
     if (channel->state != L2CAP_STATE_OPEN) return 0;
 
     // check queue
-    if (channel->send_sdu_buffer) return 0;    
+    if (channel->send_sdu_buffer || channel->send_iov_requests) return 0;
 
     // fine, go ahead
     return 1;
@@ -4062,6 +4445,7 @@ uint8_t l2cap_le_request_can_send_now_event(uint16_t local_cid){
         return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
     }
     channel->waiting_for_can_send_now = 1;
+    BTSTACK_INSTRUMENTATION_CAN_SEND_NOW_REQUESTED(BTSTACK_INSTRUMENTATION_LAYER_L2CAP, local_cid);
     l2cap_le_notify_channel_can_send(channel);
     return ERROR_CODE_SUCCESS;
 }
@@ -4086,7 +4470,7 @@ uint8_t l2cap_le_send_data(uint16_t local_cid, uint8_t * data, uint16_t len){
         return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
     }
 
-    if (channel->send_sdu_buffer){
+    if (channel->send_sdu_buffer || channel->send_iov_requests){
         log_info("l2cap_send cid 0x%02x, cannot send", local_cid);
         return BTSTACK_ACL_BUFFERS_FULL;
     }
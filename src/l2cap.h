@@ -69,6 +69,38 @@ extern "C" {
 
 #define L2CAP_LE_AUTOMATIC_CREDITS 0xffff
 
+// bytes added to the deficit of a ready channel with weight 1 per transmit scheduler round
+#ifndef L2CAP_TX_SCHEDULER_QUANTUM
+#define L2CAP_TX_SCHEDULER_QUANTUM HCI_ACL_PAYLOAD_SIZE
+#endif
+
+// number of slots in the channel lookup tables by local cid and by (con_handle, remote cid), must be a power of two
+#ifndef L2CAP_CHANNEL_INDEX_SIZE
+#define L2CAP_CHANNEL_INDEX_SIZE 16
+#endif
+
+/*
+ * @brief Transmit statistics per channel
+ */
+typedef struct {
+    // times the channel was allowed to send
+    uint32_t num_scheduled;
+    // sent L2CAP packets and bytes incl. L2CAP header
+    uint32_t num_packets;
+    uint32_t num_bytes;
+} l2cap_tx_statistics_t;
+
+// transmit scheduler: strict priority between channels, deficit round robin between channels of same priority
+typedef struct {
+    // higher priority is served first, default 0
+    uint8_t  priority;
+    // share of ACL bandwidth within same priority, 0 is treated as 1
+    uint8_t  weight;
+    // bytes the channel may send in the current round
+    int32_t  deficit;
+    l2cap_tx_statistics_t statistics;
+} l2cap_tx_scheduler_state_t;
+
 // private structs
 typedef enum {
     L2CAP_STATE_CLOSED = 1,           // no baseband
@@ -180,8 +212,8 @@ typedef struct {
 // note: l2cap_fixed_channel and l2cap_channel_t share commmon fields
 
 typedef struct l2cap_fixed_channel {
-    // linked list - assert: first field
-    btstack_linked_item_t    item;
+    // doubly linked list - assert: first field
+    btstack_dlist_item_t     item;
     
     // channel type
     l2cap_channel_type_t channel_type;
@@ -195,13 +227,59 @@ typedef struct l2cap_fixed_channel {
     // send request
     uint8_t waiting_for_can_send_now;
 
+    // transmit scheduler
+    l2cap_tx_scheduler_state_t tx_scheduler;
+
     // -- end of shared prefix
 
 } l2cap_fixed_channel_t;
 
+/**
+ * Transmit scheduler policy, see l2cap_set_tx_scheduler
+ */
 typedef struct {
+    // select channel that sends next from channels returned by l2cap_tx_scheduler_next_ready, NULL if none
+    l2cap_fixed_channel_t * (*select)(void);
+    // channel sent packet of given size incl. L2CAP header
+    void (*packet_sent)(l2cap_fixed_channel_t * channel, uint16_t size);
+} l2cap_tx_scheduler_t;
+
+struct l2cap_iov_request;
+
+/**
+ * @brief Called when an SDU sent with l2cap_send_iov has been accepted by the HCI Transport or was dropped
+ * @param request
+ * @param status ERROR_CODE_SUCCESS, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER if connection was closed or L2CAP_LOCAL_CID_DOES_NOT_EXIST if channel was closed
+ */
+typedef void (*l2cap_iov_request_callback_t)(struct l2cap_iov_request * request, uint8_t status);
+
+/**
+ * SDU sent with l2cap_send_iov from caller memory
+ */
+typedef struct l2cap_iov_request {
     // linked list - assert: first field
-    btstack_linked_item_t    item;
+    btstack_linked_item_t item;
+
+    // SDU data, needs to stay valid until callback
+    const hci_iov_t * iov;
+    uint8_t iov_count;
+
+    l2cap_iov_request_callback_t callback;
+    void * context;
+
+    // internal
+    uint16_t local_cid;
+    uint16_t len;           // SDU len
+    uint16_t pos;           // SDU bytes passed to HCI
+    uint16_t num_pdus;      // PDUs passed to HCI
+    bool     pdu_active;    // PDU owned by HCI
+    uint8_t  status;        // != ERROR_CODE_SUCCESS if channel was closed while PDU was owned by HCI
+    hci_acl_iov_packet_t pdu;
+} l2cap_iov_request_t;
+
+typedef struct l2cap_channel {
+    // doubly linked list - assert: first field
+    btstack_dlist_item_t     item;
     
     // channel type
     l2cap_channel_type_t channel_type;
@@ -215,8 +293,15 @@ typedef struct {
     // send request
     uint8_t   waiting_for_can_send_now;
 
+    // transmit scheduler
+    l2cap_tx_scheduler_state_t tx_scheduler;
+
     // -- end of shared prefix
 
+    // chaining in channel lookup tables
+    struct l2cap_channel * next_for_local_cid;
+    struct l2cap_channel * next_for_remote_cid;
+
     // timer
     btstack_timer_source_t rtx; // also used for ertx
 
@@ -257,6 +342,9 @@ typedef struct {
     uint16_t   send_sdu_len;
     uint16_t   send_sdu_pos;
 
+    // SDUs sent from caller memory, Classic Basic Mode and LE Data Channels
+    btstack_linked_list_t send_iov_requests;
+
     // max PDU size
     uint16_t  remote_mps;
 
@@ -508,6 +596,18 @@ uint16_t l2cap_get_remote_mtu_for_local_cid(uint16_t local_cid);
  */
 int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len);
 
+/**
+ * @brief Send SDU gathered from parts in caller memory on Classic channel in Basic Mode or on LE Data Channel.
+ *        L2CAP and HCI assemble each ACL fragment directly from the iov, so the SDU is not limited by HCI_ACL_PAYLOAD_SIZE
+ *        and doesn't need to be copied into a single buffer first. SDUs are queued per channel and sent in order.
+ *        While SDUs are queued, l2cap_send returns BTSTACK_ACL_BUFFERS_FULL and L2CAP_EVENT_CAN_SEND_NOW is deferred.
+ * @note iov and data need to stay valid until request callback, which is called once the HCI Transport has accepted the SDU
+ * @param local_cid
+ * @param request with iov, iov_count and callback set
+ * @return status
+ */
+uint8_t l2cap_send_iov(uint16_t local_cid, l2cap_iov_request_t * request);
+
 /** 
  * @brief Registers L2CAP service with given PSM and MTU, and assigns a packet handler.
  */
@@ -551,6 +651,51 @@ int  l2cap_can_send_packet_now(uint16_t local_cid);
  */
 void l2cap_request_can_send_now_event(uint16_t local_cid);
 
+/**
+ * @brief Set transmit priority of a channel. Ready channels with higher priority are allowed to send first.
+ * @param local_cid of dynamic or fixed channel
+ * @param priority default: 0
+ * @return status
+ */
+uint8_t l2cap_set_tx_priority(uint16_t local_cid, uint8_t priority);
+
+/**
+ * @brief Set transmit weight of a channel. Ready channels with the same priority share the
+ *        ACL bandwidth in proportion to their weight, equal weights result in round robin.
+ * @param local_cid of dynamic or fixed channel
+ * @param weight default: 1
+ * @return status
+ */
+uint8_t l2cap_set_tx_weight(uint16_t local_cid, uint8_t weight);
+
+/**
+ * @brief Get transmit statistics of a channel
+ * @param local_cid of dynamic or fixed channel
+ * @param statistics
+ * @return status
+ */
+uint8_t l2cap_get_tx_statistics(uint16_t local_cid, l2cap_tx_statistics_t * statistics);
+
+/**
+ * @brief Set transmit scheduler policy
+ * @param scheduler or NULL for default policy: strict priority, deficit round robin by weight within same priority
+ */
+void l2cap_set_tx_scheduler(const l2cap_tx_scheduler_t * scheduler);
+
+/**
+ * @brief Get default transmit scheduler policy, e.g. to wrap it in a custom one
+ * @return scheduler
+ */
+const l2cap_tx_scheduler_t * l2cap_tx_scheduler_drr_instance(void);
+
+/**
+ * @brief Iterate over channels that are ready to send, for use by transmit scheduler policies.
+ *        Channels are returned in round robin order, starting with the one that waited longest
+ * @param channel previous channel or NULL to get first one
+ * @return next channel ready to send or NULL
+ */
+l2cap_fixed_channel_t * l2cap_tx_scheduler_next_ready(l2cap_fixed_channel_t * channel);
+
 /** 
  * @brief Reserve outgoing buffer
  * @note Only for L2CAP Basic Mode Channels
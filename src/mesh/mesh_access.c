@@ -65,7 +65,7 @@ static const mesh_operation_t * mesh_model_lookup_operation_by_opcode(mesh_model
 static uint16_t mesh_access_received_pdu_refcount;
 
 // acknowledged messages
-static btstack_linked_list_t  mesh_access_acknowledged_messages;
+static btstack_dlist_t  mesh_access_acknowledged_messages;
 static btstack_timer_source_t mesh_access_acknowledged_timer;
 static int                    mesh_access_acknowledged_timer_active;
 
@@ -140,13 +140,13 @@ static void mesh_access_acknowledged_run(btstack_timer_source_t * ts){
     uint32_t now = btstack_run_loop_get_time_ms();
 
     // handle timeouts
-    btstack_linked_list_iterator_t ack_it;
-    btstack_linked_list_iterator_init(&ack_it, &mesh_access_acknowledged_messages);
-    while (btstack_linked_list_iterator_has_next(&ack_it)){
-        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_linked_list_iterator_next(&ack_it);
+    btstack_dlist_iterator_t ack_it;
+    btstack_dlist_iterator_init(&ack_it, &mesh_access_acknowledged_messages);
+    while (btstack_dlist_iterator_has_next(&ack_it)){
+        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_dlist_iterator_next(&ack_it);
         if (btstack_time_delta(now, pdu->retransmit_timeout_ms) >= 0) {
             // remove from list
-            btstack_linked_list_remove(&mesh_access_acknowledged_messages, (btstack_linked_item_t*) pdu);
+            btstack_dlist_remove(&mesh_access_acknowledged_messages, (btstack_dlist_item_t *) pdu);
             // retransmit or report failure
             if (pdu->retransmit_count){
                 pdu->retransmit_count--;
@@ -187,10 +187,10 @@ static void mesh_access_acknowledged_run(btstack_timer_source_t * ts){
     if (mesh_access_acknowledged_timer_active) return;
     
     // find earliest timeout and set timer
-    btstack_linked_list_iterator_init(&ack_it, &mesh_access_acknowledged_messages);
+    btstack_dlist_iterator_init(&ack_it, &mesh_access_acknowledged_messages);
     int32_t next_timeout_ms = 0;
-    while (btstack_linked_list_iterator_has_next(&ack_it)){
-        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_linked_list_iterator_next(&ack_it);
+    while (btstack_dlist_iterator_has_next(&ack_it)){
+        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_dlist_iterator_next(&ack_it);
         int32_t timeout_delta_ms = btstack_time_delta(pdu->retransmit_timeout_ms, now);
         if (next_timeout_ms == 0 || timeout_delta_ms < next_timeout_ms){
             next_timeout_ms = timeout_delta_ms;
@@ -210,10 +210,10 @@ static void mesh_access_acknowledged_received(uint16_t rx_src, uint32_t opcode){
     // check if received src matches our dest
     // free acknowledged messages if we were waiting for this message
 
-    btstack_linked_list_iterator_t ack_it;
-    btstack_linked_list_iterator_init(&ack_it, &mesh_access_acknowledged_messages);
-    while (btstack_linked_list_iterator_has_next(&ack_it)){
-        mesh_pdu_t * tx_pdu = (mesh_pdu_t *) btstack_linked_list_iterator_next(&ack_it);
+    btstack_dlist_iterator_t ack_it;
+    btstack_dlist_iterator_init(&ack_it, &mesh_access_acknowledged_messages);
+    while (btstack_dlist_iterator_has_next(&ack_it)){
+        mesh_pdu_t * tx_pdu = (mesh_pdu_t *) btstack_dlist_iterator_next(&ack_it);
         uint16_t tx_dest = mesh_pdu_dst(tx_pdu);
         if (tx_dest != rx_src) continue;
         if (tx_pdu->ack_opcode != opcode) continue;
@@ -235,7 +235,7 @@ static void mesh_access_upper_transport_handler(mesh_transport_callback_type_t c
             // setup timeout
             pdu->retransmit_timeout_ms = btstack_run_loop_get_time_ms() + mesh_access_acknowledged_message_timeout_ms();
             // add to mesh_access_acknowledged_messages
-            btstack_linked_list_add(&mesh_access_acknowledged_messages, (btstack_linked_item_t *) pdu);
+            btstack_dlist_add(&mesh_access_acknowledged_messages, (btstack_dlist_item_t *) pdu);
             // update timer
             mesh_access_acknowledged_run(NULL);
             break;
@@ -118,10 +118,10 @@ static void mesh_lower_transport_segment_transmission_timeout(btstack_timer_sour
 static int                    lower_transport_retry_count;
 
 // lower transport incoming
-static btstack_linked_list_t  lower_transport_incoming;
+static btstack_dlist_t  lower_transport_incoming;
 
 // lower transport ougoing
-static btstack_linked_list_t lower_transport_outgoing;
+static btstack_dlist_t lower_transport_outgoing;
 
 static mesh_transport_pdu_t * lower_transport_outgoing_pdu;
 static mesh_network_pdu_t   * lower_transport_outgoing_segment;
@@ -544,7 +544,7 @@ void mesh_lower_transport_received_message(mesh_network_callback_type_t callback
                 // track seq
                 peer->seq = seq;
                 // add to list and go
-                btstack_linked_list_add_tail(&lower_transport_incoming, (btstack_linked_item_t *) network_pdu);
+                btstack_dlist_add_tail(&lower_transport_incoming, (btstack_dlist_item_t *) network_pdu);
                 mesh_lower_transport_run();
             } else {
                 // drop packet
@@ -745,7 +745,7 @@ void mesh_lower_transport_send_pdu(mesh_pdu_t *pdu){
             while (true);
         }
     }
-    btstack_linked_list_add_tail(&lower_transport_outgoing, (btstack_linked_item_t*) pdu);
+    btstack_dlist_add_tail(&lower_transport_outgoing, (btstack_dlist_item_t *) pdu);
     mesh_lower_transport_run();
 }
 
@@ -764,9 +764,9 @@ static void mesh_lower_transport_segment_transmission_timeout(btstack_timer_sour
 }
 
 static void mesh_lower_transport_run(void){
-    while(!btstack_linked_list_empty(&lower_transport_incoming)){
+    while(!btstack_dlist_empty(&lower_transport_incoming)){
         // get next message
-        mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&lower_transport_incoming);
+        mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_dlist_pop(&lower_transport_incoming);
         // segmented?
         if (mesh_network_segmented(network_pdu)){
             mesh_transport_pdu_t * transport_pdu = mesh_lower_transport_pdu_for_segmented_message(network_pdu);
@@ -797,11 +797,11 @@ static void mesh_lower_transport_run(void){
     // check if outgoing segmented pdu is active
     if (lower_transport_outgoing_pdu) return;
 
-    while(!btstack_linked_list_empty(&lower_transport_outgoing)) {
+    while(!btstack_dlist_empty(&lower_transport_outgoing)) {
         // get next message
         mesh_transport_pdu_t * transport_pdu;
         mesh_network_pdu_t   * network_pdu;
-        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_linked_list_pop(&lower_transport_outgoing);
+        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_dlist_pop(&lower_transport_outgoing);
         switch (pdu->pdu_type) {
             case MESH_PDU_TYPE_NETWORK:
                 network_pdu = (mesh_network_pdu_t *) pdu;
@@ -826,25 +826,25 @@ static void mesh_lower_transport_run(void){
     }
 }
 
-static void mesh_lower_transport_dump_network_pdus(const char *name, btstack_linked_list_t *list){
+static void mesh_lower_transport_dump_network_pdus(const char *name, btstack_dlist_t * list){
     printf("List: %s:\n", name);
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, list);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t*) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, list);
+    while (btstack_dlist_iterator_has_next(&it)){
+        mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t*) btstack_dlist_iterator_next(&it);
         printf("- %p: ", network_pdu); printf_hexdump(network_pdu->data, network_pdu->len);
     }
 }
-static void mesh_lower_transport_reset_network_pdus(btstack_linked_list_t *list){
-    while (!btstack_linked_list_empty(list)){
-        mesh_network_pdu_t * pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(list);
+static void mesh_lower_transport_reset_network_pdus(btstack_dlist_t * list){
+    while (!btstack_dlist_empty(list)){
+        mesh_network_pdu_t * pdu = (mesh_network_pdu_t *) btstack_dlist_pop(list);
         btstack_memory_mesh_network_pdu_free(pdu);
     }
 }
 
 bool mesh_lower_transport_can_send_to_dest(uint16_t dest){
     UNUSED(dest);
-    return (lower_transport_outgoing_pdu == NULL) && btstack_linked_list_empty(&lower_transport_outgoing);
+    return (lower_transport_outgoing_pdu == NULL) && btstack_dlist_empty(&lower_transport_outgoing);
 }
 
 void mesh_lower_transport_reserve_slot(void){
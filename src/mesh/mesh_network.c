@@ -68,7 +68,7 @@
 // debug config
 // #define LOG_NETWORK
 
-static void mesh_network_dump_network_pdus(const char * name, btstack_linked_list_t * list);
+static void mesh_network_dump_network_pdus(const char * name, btstack_dlist_t * list);
 
 // structs
 
@@ -105,7 +105,7 @@ static uint8_t network_nonce[13];
 // INCOMING //
 
 // unprocessed network pdu - added by mesh_network_pdus_received_message
-static btstack_linked_list_t        network_pdus_received;
+static btstack_dlist_t        network_pdus_received;
 
 // in validation
 static mesh_network_pdu_t *         incoming_pdu_raw;
@@ -115,20 +115,20 @@ static mesh_network_key_iterator_t  validation_network_key_it;
 // OUTGOING //
 
 // Network PDUs queued by mesh_network_send
-static btstack_linked_list_t network_pdus_queued;
+static btstack_dlist_t network_pdus_queued;
 
 // Network PDU about to get send via all bearers when encrypted
 static mesh_network_pdu_t * outgoing_pdu;
 
 // Network PDUs ready to send via GATT Bearer
-static btstack_linked_list_t network_pdus_outgoing_gatt;
+static btstack_dlist_t network_pdus_outgoing_gatt;
 
 #ifdef ENABLE_MESH_GATT_BEARER
 static mesh_network_pdu_t * gatt_bearer_network_pdu;
 #endif
 
 // Network PDUs ready to send via ADV Bearer
-static btstack_linked_list_t network_pdus_outgoing_adv;
+static btstack_dlist_t network_pdus_outgoing_adv;
 
 #ifdef ENABLE_MESH_ADV_BEARER
 static mesh_network_pdu_t * adv_bearer_network_pdu;
@@ -280,7 +280,7 @@ static void mesh_network_send_d(mesh_network_pdu_t * network_pdu){
 #endif
 
     // add to queue
-    btstack_linked_list_add_tail(&network_pdus_outgoing_gatt, (btstack_linked_item_t *) network_pdu);
+    btstack_dlist_add_tail(&network_pdus_outgoing_gatt, (btstack_dlist_item_t *) network_pdu);
 
     // go
     mesh_network_run();
@@ -411,7 +411,7 @@ static void mesh_network_relay_message(mesh_network_pdu_t * network_pdu){
 
     // queue up
     network_pdu->callback = &mesh_network_send_d;
-    btstack_linked_list_add_tail(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    btstack_dlist_add_tail(&network_pdus_queued, (btstack_dlist_item_t *) network_pdu);
 }
 #endif
 
@@ -686,7 +686,7 @@ static void process_network_pdu(void){
 
 // returns true if done
 static bool mesh_network_run_gatt(void){
-    if (btstack_linked_list_empty(&network_pdus_outgoing_gatt)){
+    if (btstack_dlist_empty(&network_pdus_outgoing_gatt)){
         return true;
     }
 
@@ -696,7 +696,7 @@ static bool mesh_network_run_gatt(void){
     }
 
     // move to 'gatt bearer queue'
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_gatt);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_dlist_pop(&network_pdus_outgoing_gatt);
 
 #ifdef LOG_NETWORK
     printf("network run 1: pop %p from network_pdus_outgoing_gatt\n", network_pdu);
@@ -720,7 +720,7 @@ static bool mesh_network_run_gatt(void){
 #ifdef LOG_NETWORK
         printf("network run 3: push %p to network_pdus_outgoing_adv\n", network_pdu);
 #endif
-        btstack_linked_list_add_tail(&network_pdus_outgoing_adv, (btstack_linked_item_t *) network_pdu);
+        btstack_dlist_add_tail(&network_pdus_outgoing_adv, (btstack_dlist_item_t *) network_pdu);
 
 #ifdef LOG_NETWORK
         mesh_network_dump_network_pdus("network_pdus_outgoing_adv (1)", &network_pdus_outgoing_adv);
@@ -728,8 +728,8 @@ static bool mesh_network_run_gatt(void){
     }
 #else
     // directly move to 'outgoing adv bearer queue'
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_gatt);
-    btstack_linked_list_add_tail(&network_pdus_outgoing_adv, (btstack_linked_item_t *) network_pdu);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_dlist_pop(&network_pdus_outgoing_gatt);
+    btstack_dlist_add_tail(&network_pdus_outgoing_adv, (btstack_dlist_item_t *) network_pdu);
 #endif
     return false;
 }
@@ -737,7 +737,7 @@ static bool mesh_network_run_gatt(void){
 // returns true if done
 static bool mesh_network_run_adv(void){
 
-    if (btstack_linked_list_empty(&network_pdus_outgoing_adv)){
+    if (btstack_dlist_empty(&network_pdus_outgoing_adv)){
         return true;
     }
     
@@ -747,7 +747,7 @@ static bool mesh_network_run_adv(void){
     }
 
     // move to 'adv bearer queue'
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_adv);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_dlist_pop(&network_pdus_outgoing_adv);
 
 #ifdef LOG_NETWORK
     printf("network run 4: pop %p from network_pdus_outgoing_adv\n", network_pdu);
@@ -778,7 +778,7 @@ static bool mesh_network_run_adv(void){
     }
 #else
     // done
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_adv);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_dlist_pop(&network_pdus_outgoing_adv);
     // directly notify upper layer
     mesh_network_send_complete(network_pdu);
 #endif
@@ -791,7 +791,7 @@ static bool mesh_network_run_received(void){
         return true;
     }
 
-    if (btstack_linked_list_empty(&network_pdus_received)) {
+    if (btstack_dlist_empty(&network_pdus_received)) {
         return true;
     }
 
@@ -800,7 +800,7 @@ static bool mesh_network_run_received(void){
 
     // get encoded network pdu and start processing
     mesh_crypto_active = 1;
-    incoming_pdu_raw = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_received);
+    incoming_pdu_raw = (mesh_network_pdu_t *) btstack_dlist_pop(&network_pdus_received);
     process_network_pdu();
     return true;
 }
@@ -811,12 +811,12 @@ static bool mesh_network_run_queued(void){
         return true;
     }
 
-    if (btstack_linked_list_empty(&network_pdus_queued)){
+    if (btstack_dlist_empty(&network_pdus_queued)){
         return true;
     }
     
     // get queued network pdu and start processing
-    outgoing_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_queued);
+    outgoing_pdu = (mesh_network_pdu_t *) btstack_dlist_pop(&network_pdus_queued);
 
 #ifdef LOG_NETWORK
     printf("network run 5: pop %p from network_pdus_queued\n", outgoing_pdu);
@@ -906,7 +906,7 @@ static void mesh_network_gatt_bearer_outgoing_complete(void){
     if (gatt_bearer_network_pdu == NULL) return;
 
     // forward to adv bearer
-    btstack_linked_list_add_tail(&network_pdus_outgoing_adv, (btstack_linked_item_t*) gatt_bearer_network_pdu);
+    btstack_dlist_add_tail(&network_pdus_outgoing_adv, (btstack_dlist_item_t *) gatt_bearer_network_pdu);
     gatt_bearer_network_pdu = NULL;
 
     mesh_network_run();
@@ -1023,7 +1023,7 @@ void mesh_network_received_message(const uint8_t * pdu_data, uint8_t pdu_len, ui
     network_pdu->flags = flags;
 
     // add to list and go
-    btstack_linked_list_add_tail(&network_pdus_received, (btstack_linked_item_t *) network_pdu);
+    btstack_dlist_add_tail(&network_pdus_received, (btstack_dlist_item_t *) network_pdu);
     mesh_network_run();
 
 }
@@ -1042,7 +1042,7 @@ void mesh_network_process_proxy_configuration_message(const uint8_t * pdu_data,
     network_pdu->flags = MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION; // Network PDU
 
     // add to list and go
-    btstack_linked_list_add_tail(&network_pdus_received, (btstack_linked_item_t *) network_pdu);
+    btstack_dlist_add_tail(&network_pdus_received, (btstack_dlist_item_t *) network_pdu);
     mesh_network_run();
 }
 
@@ -1061,7 +1061,7 @@ void mesh_network_send_pdu(mesh_network_pdu_t * network_pdu){
     network_pdu->flags    = 0;
 
     // queue up
-    btstack_linked_list_add_tail(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    btstack_dlist_add_tail(&network_pdus_queued, (btstack_dlist_item_t *) network_pdu);
 #ifdef LOG_NETWORK
     mesh_network_dump_network_pdus("network_pdus_queued", &network_pdus_queued);
 #endif
@@ -1079,7 +1079,7 @@ void mesh_network_encrypt_proxy_configuration_message(mesh_network_pdu_t * netwo
     network_pdu->flags    = MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION;
 
     // queue up
-    btstack_linked_list_add_tail(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    btstack_dlist_add_tail(&network_pdus_queued, (btstack_dlist_item_t *) network_pdu);
 
     // go
     mesh_network_run();
@@ -1173,18 +1173,18 @@ static void mesh_network_dump_network_pdu(mesh_network_pdu_t * network_pdu){
         printf("- %p: ", network_pdu); printf_hexdump(network_pdu->data, network_pdu->len);
     }
 }
-static void mesh_network_dump_network_pdus(const char * name, btstack_linked_list_t * list){
+static void mesh_network_dump_network_pdus(const char * name, btstack_dlist_t * list){
     printf("List: %s:\n", name);
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, list);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t*) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, list);
+    while (btstack_dlist_iterator_has_next(&it)){
+        mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t*) btstack_dlist_iterator_next(&it);
         mesh_network_dump_network_pdu(network_pdu);
     }
 }
-static void mesh_network_reset_network_pdus(btstack_linked_list_t * list){
-    while (!btstack_linked_list_empty(list)){
-        mesh_network_pdu_t * pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(list);
+static void mesh_network_reset_network_pdus(btstack_dlist_t * list){
+    while (!btstack_dlist_empty(list)){
+        mesh_network_pdu_t * pdu = (mesh_network_pdu_t *) btstack_dlist_pop(list);
         btstack_memory_mesh_network_pdu_free(pdu);
     }
 }
@@ -38,6 +38,7 @@
 #ifndef __MESH_NETWORK
 #define __MESH_NETWORK
 
+#include "btstack_dlist.h"
 #include "btstack_linked_list.h"
 #include "btstack_run_loop.h"
 
@@ -71,8 +72,8 @@ typedef enum {
 } mesh_pdu_type_t;
 
 typedef struct mesh_pdu {
-    // allow for linked lists
-    btstack_linked_item_t item;
+    // allow for doubly linked lists
+    btstack_dlist_item_t item;
     // type
     mesh_pdu_type_t pdu_type;
 
@@ -150,25 +150,25 @@ static void (*mesh_access_message_handler)(mesh_pdu_t * pdu);
 static void (*mesh_control_message_handler)(mesh_pdu_t * pdu);
 
 // incoming unsegmented (network) and segmented (transport) control and access messages
-static btstack_linked_list_t upper_transport_incoming;
+static btstack_dlist_t upper_transport_incoming;
 
 // outgoing unsegmented (network) and segmented (uppert_transport_outgoing) control and access messages
-static btstack_linked_list_t upper_transport_outgoing;
+static btstack_dlist_t upper_transport_outgoing;
 
-static void mesh_upper_transport_dump_pdus(const char *name, btstack_linked_list_t *list){
+static void mesh_upper_transport_dump_pdus(const char *name, btstack_dlist_t * list){
     printf("List: %s:\n", name);
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, list);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        mesh_pdu_t * pdu = (mesh_pdu_t*) btstack_linked_list_iterator_next(&it);
+    btstack_dlist_iterator_t it;
+    btstack_dlist_iterator_init(&it, list);
+    while (btstack_dlist_iterator_has_next(&it)){
+        mesh_pdu_t * pdu = (mesh_pdu_t*) btstack_dlist_iterator_next(&it);
         printf("- %p\n", pdu);
         // printf_hexdump( mesh_pdu_data(pdu), mesh_pdu_len(pdu));
     }
 }
 
-static void mesh_upper_transport_reset_pdus(btstack_linked_list_t *list){
-    while (!btstack_linked_list_empty(list)){
-        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_linked_list_pop(list);
+static void mesh_upper_transport_reset_pdus(btstack_dlist_t * list){
+    while (!btstack_dlist_empty(list)){
+        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_dlist_pop(list);
         switch (pdu->pdu_type){
             case MESH_PDU_TYPE_NETWORK:
                 btstack_memory_mesh_network_pdu_free((mesh_network_pdu_t *) pdu);
@@ -547,7 +547,7 @@ static void mesh_upper_transport_process_message(void){
 }
 
 static void mesh_upper_transport_message_received(mesh_pdu_t * pdu){
-    btstack_linked_list_add_tail(&upper_transport_incoming, (btstack_linked_item_t*) pdu);
+    btstack_dlist_add_tail(&upper_transport_incoming, (btstack_dlist_item_t *) pdu);
     mesh_upper_transport_run();
 }
 
@@ -971,12 +971,12 @@ static void mesh_upper_transport_send_segmented_control_pdu(mesh_transport_pdu_t
 
 static void mesh_upper_transport_run(void){
 
-    while(!btstack_linked_list_empty(&upper_transport_incoming)){
+    while(!btstack_dlist_empty(&upper_transport_incoming)){
 
         if (crypto_active) return;
 
         // peek at next message
-        mesh_pdu_t * pdu =  (mesh_pdu_t *) btstack_linked_list_get_first_item(&upper_transport_incoming);
+        mesh_pdu_t * pdu =  (mesh_pdu_t *) btstack_dlist_get_first_item(&upper_transport_incoming);
         mesh_transport_pdu_t * transport_pdu;
         mesh_network_pdu_t   * network_pdu;
         switch (pdu->pdu_type){
@@ -984,14 +984,14 @@ static void mesh_upper_transport_run(void){
                 network_pdu = (mesh_network_pdu_t *) pdu;
                 // control?
                 if (mesh_network_control(network_pdu)) {
-                    (void) btstack_linked_list_pop(&upper_transport_incoming);
+                    (void) btstack_dlist_pop(&upper_transport_incoming);
                     mesh_upper_unsegmented_control_message_received(network_pdu);
                 } else {
                     incoming_network_pdu_decoded = mesh_network_pdu_get();
                     if (!incoming_network_pdu_decoded) return;
                     // get encoded network pdu and start processing
                     incoming_network_pdu_raw = network_pdu;
-                    (void) btstack_linked_list_pop(&upper_transport_incoming);
+                    (void) btstack_dlist_pop(&upper_transport_incoming);
                     mesh_upper_transport_process_unsegmented_access_message();
                 }
                 break;
@@ -1000,14 +1000,14 @@ static void mesh_upper_transport_run(void){
                 uint8_t ctl = mesh_transport_ctl(transport_pdu);
                 if (ctl){
                     printf("Ignoring Segmented Control Message\n");
-                    (void) btstack_linked_list_pop(&upper_transport_incoming);
+                    (void) btstack_dlist_pop(&upper_transport_incoming);
                     mesh_lower_transport_message_processed_by_higher_layer((mesh_pdu_t *) transport_pdu);
                 } else {
                     incoming_transport_pdu_decoded = mesh_transport_pdu_get();
                     if (!incoming_transport_pdu_decoded) return;
                     // get encoded transport pdu and start processing
                     incoming_transport_pdu_raw = transport_pdu;
-                    (void) btstack_linked_list_pop(&upper_transport_incoming);
+                    (void) btstack_dlist_pop(&upper_transport_incoming);
                     mesh_upper_transport_process_message();
                 }
                 break;
@@ -1016,14 +1016,14 @@ static void mesh_upper_transport_run(void){
         }
     }
 
-    while (!btstack_linked_list_empty(&upper_transport_outgoing)){
+    while (!btstack_dlist_empty(&upper_transport_outgoing)){
 
         if (crypto_active) break;
 
-        mesh_pdu_t * pdu =  (mesh_pdu_t *) btstack_linked_list_get_first_item(&upper_transport_outgoing);
+        mesh_pdu_t * pdu =  (mesh_pdu_t *) btstack_dlist_get_first_item(&upper_transport_outgoing);
         if (mesh_lower_transport_can_send_to_dest(mesh_pdu_dst(pdu)) == 0) break;
 
-        (void) btstack_linked_list_pop(&upper_transport_outgoing);
+        (void) btstack_dlist_pop(&upper_transport_outgoing);
 
         if (mesh_pdu_ctl(pdu)){
             switch (pdu->pdu_type){
@@ -1077,7 +1077,7 @@ void mesh_upper_transport_send_access_pdu(mesh_pdu_t *pdu){
         btstack_assert( ((mesh_network_pdu_t *) pdu)->len >= 9);
     }
 
-    btstack_linked_list_add_tail(&upper_transport_outgoing, (btstack_linked_item_t*) pdu);
+    btstack_dlist_add_tail(&upper_transport_outgoing, (btstack_dlist_item_t *) pdu);
     mesh_upper_transport_run();
 }
 
@@ -1086,6 +1086,6 @@ void mesh_upper_transport_send_control_pdu(mesh_pdu_t * pdu){
         btstack_assert( ((mesh_network_pdu_t *) pdu)->len >= 9);
     }
 
-    btstack_linked_list_add_tail(&upper_transport_outgoing, (btstack_linked_item_t*) pdu);
+    btstack_dlist_add_tail(&upper_transport_outgoing, (btstack_dlist_item_t *) pdu);
     mesh_upper_transport_run();
 }
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "slip_benchmark.c"
+
+/*
+ *  slip_benchmark.c
+ *
+ *  Compares the throughput of the bulk SLIP encoder/decoder functions with the byte-wise API
+ *  for 1 kB frames processed in 64 byte chunks, as done by the H5 transport, and checks that
+ *  both produce the same result.
+ */
+
+#include "btstack_config.h"
+#include "btstack_slip.h"
+#include "btstack_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_SIZE 1024
+#define CHUNK_SIZE 64
+#define NUM_ROUNDS 20000
+
+#define SLIP_SOF 0xc0
+#define SLIP_ESC 0xdb
+
+static uint8_t frame[FRAME_SIZE];
+static uint8_t encoded_bytewise[2 * FRAME_SIZE + 2];
+static uint8_t encoded_bulk[2 * FRAME_SIZE + 2];
+static uint8_t decoded[2 * FRAME_SIZE];
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static double mb_per_s(double duration){
+    return ((double) FRAME_SIZE * NUM_ROUNDS) / 1e6 / duration;
+}
+
+// special_every: 0 = no bytes to escape, 1 = only bytes to escape, n = every n-th byte, -1 = random data
+static void frame_init(int special_every){
+    int i;
+    srand(5);
+    for (i = 0; i < FRAME_SIZE; i++){
+        uint8_t value = (uint8_t) rand();
+        if (special_every == 0){
+            if ((value == SLIP_SOF) || (value == SLIP_ESC) || (value == 0x11) || (value == 0x13)){
+                value ^= 1;
+            }
+        } else if ((special_every > 0) && ((i % special_every) == 0)){
+            value = ((i / special_every) & 1) ? SLIP_SOF : SLIP_ESC;
+        }
+        frame[i] = value;
+    }
+}
+
+static uint16_t encode_bytewise(btstack_slip_encoder_t * encoder){
+    uint16_t len = 0;
+    btstack_slip_encoder_start(encoder, frame, FRAME_SIZE);
+    while (btstack_slip_encoder_has_data(encoder)){
+        uint16_t pos = 0;
+        while (btstack_slip_encoder_has_data(encoder) && (pos < CHUNK_SIZE)){
+            encoded_bytewise[1 + len + pos] = btstack_slip_encoder_get_byte(encoder);
+            pos++;
+        }
+        len += pos;
+    }
+    return len;
+}
+
+static uint16_t encode_bulk(btstack_slip_encoder_t * encoder){
+    uint16_t len = 0;
+    btstack_slip_encoder_start(encoder, frame, FRAME_SIZE);
+    while (btstack_slip_encoder_has_data(encoder)){
+        len += btstack_slip_encoder_encode(encoder, &encoded_bulk[1 + len], CHUNK_SIZE);
+    }
+    return len;
+}
+
+static uint16_t decode_bytewise(btstack_slip_decoder_t * decoder, const uint8_t * data, uint16_t size){
+    uint16_t i;
+    btstack_slip_decoder_init(decoder, decoded, sizeof(decoded));
+    for (i = 0; i < size; i++){
+        btstack_slip_decoder_process(decoder, data[i]);
+    }
+    return btstack_slip_decoder_frame_size(decoder);
+}
+
+static uint16_t decode_bulk(btstack_slip_decoder_t * decoder, const uint8_t * data, uint16_t size){
+    uint16_t pos = 0;
+    btstack_slip_decoder_init(decoder, decoded, sizeof(decoded));
+    while ((pos < size) && (btstack_slip_decoder_frame_size(decoder) == 0)){
+        pos += btstack_slip_decoder_process_data(decoder, &data[pos], btstack_min(size - pos, CHUNK_SIZE));
+    }
+    return btstack_slip_decoder_frame_size(decoder);
+}
+
+static int decoded_ok(uint16_t frame_size){
+    return (frame_size == FRAME_SIZE) && (memcmp(decoded, frame, FRAME_SIZE) == 0);
+}
+
+static int benchmark(const char * name, int special_every, int escape_xon_xoff){
+    btstack_slip_encoder_t encoder;
+    btstack_slip_decoder_t decoder;
+    uint16_t len_bytewise = 0;
+    uint16_t len_bulk = 0;
+    uint16_t frame_size = 0;
+    int round;
+    int ok = 1;
+    double t_start;
+
+    frame_init(special_every);
+    memset(&encoder, 0, sizeof(encoder));
+    btstack_slip_encoder_set_escape_xon_xoff(&encoder, escape_xon_xoff);
+
+    t_start = now_s();
+    for (round = 0; round < NUM_ROUNDS; round++) len_bytewise = encode_bytewise(&encoder);
+    double encode_bytewise_s = now_s() - t_start;
+
+    t_start = now_s();
+    for (round = 0; round < NUM_ROUNDS; round++) len_bulk = encode_bulk(&encoder);
+    double encode_bulk_s = now_s() - t_start;
+
+    if ((len_bytewise != len_bulk) || (memcmp(&encoded_bytewise[1], &encoded_bulk[1], len_bulk) != 0)){
+        printf("error: %s: bulk encoder output differs\n", name);
+        ok = 0;
+    }
+
+    // frame encoded data with SOF
+    uint16_t size = len_bulk + 2;
+    encoded_bulk[0] = SLIP_SOF;
+    encoded_bulk[size - 1] = SLIP_SOF;
+
+    t_start = now_s();
+    for (round = 0; round < NUM_ROUNDS; round++) frame_size = decode_bytewise(&decoder, encoded_bulk, size);
+    double decode_bytewise_s = now_s() - t_start;
+
+    if (!decoded_ok(frame_size)){
+        printf("error: %s: byte-wise decoder output differs\n", name);
+        ok = 0;
+    }
+    memset(decoded, 0, sizeof(decoded));
+
+    t_start = now_s();
+    for (round = 0; round < NUM_ROUNDS; round++) frame_size = decode_bulk(&decoder, encoded_bulk, size);
+    double decode_bulk_s = now_s() - t_start;
+
+    if (!decoded_ok(frame_size)){
+        printf("error: %s: bulk decoder output differs\n", name);
+        ok = 0;
+    }
+
+    printf("%-24s encode: byte-wise %7.1f MB/s, bulk %7.1f MB/s (%4.1fx) | decode: byte-wise %7.1f MB/s, bulk %7.1f MB/s (%4.1fx)\n",
+           name, mb_per_s(encode_bytewise_s), mb_per_s(encode_bulk_s), encode_bytewise_s / encode_bulk_s,
+           mb_per_s(decode_bytewise_s), mb_per_s(decode_bulk_s), decode_bytewise_s / decode_bulk_s);
+    return ok;
+}
+
+int main(void){
+    int ok = 1;
+    ok &= benchmark("no bytes to escape",       0, 0);
+    ok &= benchmark("random data",             -1, 0);
+    ok &= benchmark("random data, XON/XOFF",   -1, 1);
+    ok &= benchmark("every 8th byte escaped",   8, 0);
+    ok &= benchmark("all bytes escaped",        1, 0);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "timer_heap_benchmark.c"
+
+/*
+ *  timer_heap_benchmark.c
+ *
+ *  Compares the timer heap of btstack_run_loop_base with the previously used sorted linked list
+ *  for 10000 timers with random timeouts that are removed in scattered order.
+ */
+
+#include "btstack_config.h"
+#include "btstack_linked_list.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_TIMERS 10000
+
+static btstack_timer_source_t timers[NUM_TIMERS];
+static struct btstack_run_loop_state run_loop_state;
+static btstack_state_t btstack;
+static btstack_linked_list_t timer_list;
+static int num_fired;
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+// sorted insert as done by the run loops before the timer heap
+static void timer_list_add(btstack_timer_source_t * ts){
+    btstack_linked_item_t * it;
+    for (it = (btstack_linked_item_t *) &timer_list; it->next ; it = it->next){
+        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
+        if (next == ts) return;
+        if (btstack_time_delta(ts->timeout, next->timeout) < 0) break;
+    }
+    ts->item.next = it->next;
+    it->next = (btstack_linked_item_t *) ts;
+}
+
+static void timer_handler(btstack_state_t * state, btstack_timer_source_t * ts){
+    UNUSED(state);
+    UNUSED(ts);
+    num_fired++;
+}
+
+// scattered removal order, 7919 is prime
+static btstack_timer_source_t * timer_for_removal(int i){
+    return &timers[(i * 7919) % NUM_TIMERS];
+}
+
+int main(void){
+    int i;
+    double t_start, t_added, t_removed;
+
+    btstack.run_loop = &run_loop_state;
+    btstack_run_loop_base_init(&btstack);
+
+    srand(1);
+    for (i = 0; i < NUM_TIMERS; i++){
+        timers[i].timeout = rand() % 1000000;
+        timers[i].process = &timer_handler;
+    }
+
+    t_start = now_s();
+    for (i = 0; i < NUM_TIMERS; i++) timer_list_add(&timers[i]);
+    t_added = now_s();
+    for (i = 0; i < NUM_TIMERS; i++) btstack_linked_list_remove(&timer_list, (btstack_linked_item_t *) timer_for_removal(i));
+    t_removed = now_s();
+    printf("sorted list: insert %8.1f ns/op, remove %8.1f ns/op\n", (t_added - t_start) * 1e9 / NUM_TIMERS, (t_removed - t_added) * 1e9 / NUM_TIMERS);
+
+    t_start = now_s();
+    for (i = 0; i < NUM_TIMERS; i++) btstack_run_loop_base_add_timer(&btstack, &timers[i]);
+    t_added = now_s();
+    for (i = 0; i < NUM_TIMERS; i++) btstack_run_loop_base_remove_timer(&btstack, timer_for_removal(i));
+    t_removed = now_s();
+#ifdef MAX_NR_BTSTACK_TIMERS
+    const char * variant = "fixed heap: ";
+#else
+    const char * variant = "heap:       ";
+#endif
+    printf("%s insert %8.1f ns/op, remove %8.1f ns/op\n", variant, (t_added - t_start) * 1e9 / NUM_TIMERS, (t_removed - t_added) * 1e9 / NUM_TIMERS);
+    if (run_loop_state.num_timers != 0){
+        printf("error: %u timers left after remove\n", (unsigned int) run_loop_state.num_timers);
+        return 1;
+    }
+
+    // timers have to fire in timeout order
+    for (i = 0; i < NUM_TIMERS; i++) btstack_run_loop_base_add_timer(&btstack, &timers[i]);
+    uint32_t last_timeout = 0;
+    while (run_loop_state.num_timers > 0){
+        btstack_timer_source_t * ts = btstack_run_loop_base_get_next_timer(&btstack);
+        if (ts->timeout < last_timeout){
+            printf("error: timer %u fired after %u\n", (unsigned int) ts->timeout, (unsigned int) last_timeout);
+            return 1;
+        }
+        last_timeout = ts->timeout;
+        btstack_run_loop_base_process_timers(&btstack, ts->timeout);
+    }
+    printf("%u timers fired in timeout order\n", (unsigned int) num_fired);
+    return (num_fired == NUM_TIMERS) ? 0 : 1;
+}
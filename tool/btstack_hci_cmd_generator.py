@@ -0,0 +1,254 @@
+#!/usr/bin/env python
+# BlueKitchen GmbH (c) 2020
+
+import re
+import sys
+import os
+
+import btstack_parser as parser
+
+program_info = '''
+BTstack HCI Command Encoder Generator for BTstack
+Copyright 2020, BlueKitchen GmbH
+'''
+
+copyright = """/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+"""
+
+hfile_header_begin = """
+/*
+ *  hci_cmd_encoder.h
+ *
+ *  @brief HCI Command encoders with fixed layout, alternative to hci_cmd_create_from_template
+ *  @note  Don't edit - generated by tool/btstack_hci_cmd_generator.py from src/hci_cmd.c
+ *
+ */
+
+#ifndef HCI_CMD_ENCODER_H
+#define HCI_CMD_ENCODER_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include "bluetooth.h"
+#include "btstack_util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* API_START */
+
+"""
+
+hfile_header_end = """
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HCI_CMD_ENCODER_H
+"""
+
+encoder_template = '''/**
+ * @brief Create {command_name} command packet
+ * @param buffer for command packet, at least {size} bytes
+{param_docs} * @return size of command packet
+ * @note: opcode 0x{opcode:04x}, format string "{format}"
+ */
+static inline uint16_t {fn_name}({args}){{
+{code}    return {size};
+}}
+'''
+
+param_types = {
+    '1' : 'uint8_t',
+    '2' : 'uint16_t',
+    '3' : 'uint32_t',
+    '4' : 'uint32_t',
+    'H' : 'hci_con_handle_t',
+    'B' : 'const bd_addr_t',
+    'D' : 'const uint8_t *',
+    'E' : 'const uint8_t *',
+    'N' : 'const char *',
+    'P' : 'const uint8_t *',
+    'A' : 'const uint8_t *',
+    'Q' : 'const uint8_t *',
+}
+
+param_sizes = { '1' : 1, '2' : 2, '3' : 3, '4' : 4, 'H' : 2, 'B' : 6, 'D' : 8, 'E' : 240, 'N' : 248, 'P' : 16, 'A' : 31, 'Q' : 32 }
+
+def store_code(field_type, name, offset):
+    code = ''
+    if field_type in '1234H':
+        for i in range(param_sizes[field_type]):
+            if i == 0:
+                code += '    buffer[{0}] = (uint8_t) {1};\n'.format(offset + i, name)
+            else:
+                code += '    buffer[{0}] = (uint8_t) ({1} >> {2});\n'.format(offset + i, name, 8 * i)
+    elif field_type == 'B':
+        for i in range(6):
+            code += '    buffer[{0}] = {1}[{2}];\n'.format(offset + i, name, 5 - i)
+    elif field_type in 'DEPA':
+        code += '    (void)memcpy(&buffer[{0}], {1}, {2});\n'.format(offset, name, param_sizes[field_type])
+    elif field_type == 'Q':
+        code += '    reverse_bytes({1}, &buffer[{0}], 32);\n'.format(offset, name)
+    elif field_type == 'N':
+        code += '    uint16_t {1}_len = (uint16_t) strlen({1});\n'.format(offset, name)
+        code += '    if ({0}_len > 248) {{\n        {0}_len = 248;\n    }}\n'.format(name)
+        code += '    (void)memcpy(&buffer[{0}], {1}, {1}_len);\n'.format(offset, name)
+        code += '    memset(&buffer[{0} + {1}_len], 0, 248 - {1}_len);\n'.format(offset, name)
+    return code
+
+def valid_param_names(params, format):
+    if len(params) != len(format):
+        return False
+    if len(set(params)) != len(params):
+        return False
+    for param in params:
+        if not re.match('^[A-Za-z_]\w*$', param):
+            return False
+    return True
+
+def parse_commands(path):
+    # returns list of (command_name, ogf, ocf, format, params, conditions)
+    commands = []
+    conditions = []
+    params = []
+    command_name = None
+    with open (path, 'rt') as fin:
+        for line in fin:
+            directive = re.match('\s*#\s*(ifdef|ifndef|if|else|endif)\s*(.*)', line)
+            if directive:
+                (keyword, argument) = directive.groups()
+                argument = argument.split('//')[0].strip()
+                if keyword == 'ifdef':
+                    conditions.append('defined(%s)' % argument)
+                elif keyword == 'ifndef':
+                    conditions.append('!defined(%s)' % argument)
+                elif keyword == 'if':
+                    conditions.append(argument)
+                elif keyword == 'else':
+                    conditions[-1] = '!(%s)' % conditions[-1]
+                elif keyword == 'endif':
+                    conditions.pop()
+                continue
+
+            parts = re.match('.*@param\s*(\w*)\s*', line)
+            if parts:
+                params.append(parts.groups()[0].lower())
+                continue
+
+            declaration = re.match('const\s+hci_cmd_t\s+(\w+)[\s=]+', line)
+            if declaration:
+                command_name = declaration.groups()[0]
+                continue
+
+            definition = re.match('\s*OPCODE\\(\s*(\w+)\s*,\s*(\w+)\s*\\)\s*,\s*\\"(\w*)\\".*', line)
+            if not definition:
+                # vendor commands with plain opcode
+                definition = re.match('\s*()(0x[0-9a-fA-F]+)\s*,\s*\\"(\w*)\\".*', line)
+            if definition and command_name:
+                (ogf, ocf, format) = definition.groups()
+                if '0' not in conditions:
+                    if not valid_param_names(params, format):
+                        print('%s: params %s do not match format "%s", using arg1..argN' % (command_name, params, format))
+                        params = ['arg%u' % (i + 1) for i in range(len(format))]
+                    commands.append((command_name, ogf, ocf, format, params, list(conditions)))
+                params = []
+                command_name = None
+                continue
+
+            # doc comment of next command starts
+            if line.strip().startswith('/**'):
+                params = []
+    return commands
+
+def create_encoder(command_name, opcode, format, params):
+    fn_name = 'hci_cmd_encode_' + command_name[len('hci_'):] if command_name.startswith('hci_') else 'hci_cmd_encode_' + command_name
+    args = ['uint8_t * buffer']
+    param_docs = ''
+    params_len = sum([param_sizes[f] for f in format])
+    code  = '    buffer[0] = 0x{0:02x};\n    buffer[1] = 0x{1:02x};\n'.format(opcode & 0xff, opcode >> 8)
+    code += '    buffer[2] = {0};\n'.format(params_len)
+    offset = 3
+    for field_type, name in zip(format, params):
+        args.append('%s %s' % (param_types[field_type], name))
+        param_docs += ' * @param %s\n' % name
+        code += store_code(field_type, name, offset)
+        offset += param_sizes[field_type]
+    return encoder_template.format(command_name=command_name.upper(), size=offset, param_docs=param_docs, opcode=opcode,
+                                   format=format, fn_name=fn_name, args=', '.join(args), code=code)
+
+def create_encoders(commands, defines):
+    global gen_path
+    with open(gen_path, 'wt') as fout:
+        fout.write(copyright)
+        fout.write(hfile_header_begin)
+        for (command_name, ogf, ocf, format, params, conditions) in commands:
+            unsupported = [f for f in format if f not in param_types]
+            if unsupported:
+                print('%s: format "%s" not supported, skipped' % (command_name, format))
+                continue
+            opcode = int(ocf, 0)
+            if ogf:
+                opcode |= int(defines.get(ogf, ogf), 0) << 10
+            if conditions:
+                fout.write('#if %s\n' % ' && '.join(conditions))
+            fout.write(create_encoder(command_name, opcode, format, params))
+            if conditions:
+                fout.write('#endif\n')
+            fout.write('\n')
+        fout.write(hfile_header_end)
+
+btstack_root = os.path.abspath(os.path.dirname(sys.argv[0]) + '/..')
+gen_path = btstack_root + '/src/hci_cmd_encoder.h'
+
+print(program_info)
+
+# parse OGF values and commands
+parser.set_btstack_root(btstack_root)
+defines = parser.parse_defines()
+commands = parse_commands(btstack_root + '/' + parser.hci_cmds_c_path)
+
+# create encoders
+create_encoders(commands, defines)
+
+# done
+print('Done!')
@@ -37,7 +37,7 @@ copyright = """/*
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  *
- * Please inquire about commercial licensing options at 
+ * Please inquire about commercial licensing options at
  * contact@bluekitchen-gmbh.com
  *
  */
@@ -60,7 +60,9 @@ extern "C" {
 #endif
 
 #include "btstack_config.h"
-    
+
+#include "btstack_memory_pool.h"
+
 // Core
 #include "hci.h"
 #include "l2cap.h"
@@ -89,12 +91,39 @@ extern "C" {
 #endif
 
 /* API_START */
+"""
 
+hfile_api = """
 /**
  * @brief Initializes BTstack memory pools.
  */
 void btstack_memory_init(void);
 
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+/**
+ * @brief Get size of arena needed for given number of elements per type
+ * @param config
+ * @return size in bytes for an arena aligned to BTSTACK_MEMORY_POOL_ALIGNMENT
+ */
+uint32_t btstack_memory_arena_get_size(const btstack_memory_arena_config_t * config);
+
+/**
+ * @brief Initializes BTstack memory pools from single arena instead of btstack_memory_init with ENABLE_BTSTACK_MEMORY_ARENA
+ * @note  pools are placed contiguously in the order of btstack_memory_arena_config_t, MAX_NR_* defines are ignored
+ * @param arena
+ * @param arena_size
+ * @param config with number of elements per type, fields for types of disabled features are ignored
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if arena is too small
+ */
+uint8_t btstack_memory_init_arena(void * arena, uint32_t arena_size, const btstack_memory_arena_config_t * config);
+#endif
+
+/**
+ * @brief Report usage of all memory pools, or of allocations via malloc with HAVE_MALLOC, for capacity planning
+ * @param callback called with type name, e.g. "l2cap_channel", and statistics for each pool
+ */
+void btstack_memory_get_statistics(void (*callback)(const char * name, const btstack_memory_pool_statistics_t * statistics));
+
 /* API_END */
 """
 
@@ -106,7 +135,9 @@ hfile_header_end = """
 #endif // BTSTACK_MEMORY_H
 """
 
-cfile_header_begin = """
+cfile_header_begin = """#define BTSTACK_FILE__ "btstack_memory.c"
+
+
 /*
  *  btstack_memory.h
  *
@@ -119,11 +150,15 @@ cfile_header_begin = """
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 
 """
 
+config_template = """    uint16_t POOL_FIELD;"""
+
 header_template = """STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void);
 void   btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME);"""
 
@@ -137,9 +172,11 @@ code_template = """
     #endif
 #endif
 
-#ifdef POOL_COUNT
-#if POOL_COUNT > 0
+#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(POOL_COUNT) && (POOL_COUNT > 0))
+#ifndef ENABLE_BTSTACK_MEMORY_ARENA
 static STRUCT_TYPE STRUCT_NAME_storage[POOL_COUNT];
+static uint32_t STRUCT_NAME_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(POOL_COUNT)];
+#endif
 static btstack_memory_pool_t STRUCT_NAME_pool;
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     void * buffer = btstack_memory_pool_get(&STRUCT_NAME_pool);
@@ -151,7 +188,7 @@ STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
     btstack_memory_pool_free(&STRUCT_NAME_pool, STRUCT_NAME);
 }
-#else
+#elif defined(POOL_COUNT)
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     return NULL;
 }
@@ -159,23 +196,35 @@ void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
     // silence compiler warning about unused parameter in a portable way
     (void) STRUCT_NAME;
 };
-#endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_statistics_t STRUCT_NAME_statistics;
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     void * buffer = malloc(sizeof(STRUCT_TYPE));
     if (buffer){
         memset(buffer, 0, sizeof(STRUCT_TYPE));
     }
+    btstack_memory_pool_statistics_allocated(&STRUCT_NAME_statistics, buffer);
     return (STRUCT_NAME_t *) buffer;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
+    btstack_memory_pool_statistics_freed(&STRUCT_NAME_statistics, STRUCT_NAME);
     free(STRUCT_NAME);
 }
 #endif
 """
 
 init_template = """#if POOL_COUNT > 0
-    btstack_memory_pool_create(&STRUCT_NAME_pool, STRUCT_NAME_storage, POOL_COUNT, sizeof(STRUCT_TYPE));
+    btstack_memory_pool_create(&STRUCT_NAME_pool, STRUCT_NAME_storage, POOL_COUNT, sizeof(STRUCT_TYPE), STRUCT_NAME_allocated);
+#endif"""
+
+arena_size_template = """    size += btstack_memory_pool_get_buffer_size(config->POOL_FIELD, sizeof(STRUCT_TYPE));"""
+
+arena_init_template = """    buffer += btstack_memory_pool_create_in_buffer(&STRUCT_NAME_pool, buffer, config->POOL_FIELD, sizeof(STRUCT_TYPE));"""
+
+statistics_template = """#if defined(ENABLE_BTSTACK_MEMORY_ARENA) || (defined(POOL_COUNT) && (POOL_COUNT > 0))
+    (*callback)("STRUCT_NAME", btstack_memory_pool_get_statistics(&STRUCT_NAME_pool));
+#elif defined(HAVE_MALLOC)
+    (*callback)("STRUCT_NAME", &STRUCT_NAME_statistics);
 #endif"""
 
 def writeln(f, data):
@@ -188,7 +237,8 @@ def replacePlaceholder(template, struct_name):
     else:
         pool_count = "MAX_NR_" + struct_name.upper() + "S"
     pool_count_old_no = pool_count.replace("MAX_NR_", "MAX_NO_")
-    snippet = template.replace("STRUCT_TYPE", struct_type).replace("STRUCT_NAME", struct_name).replace("POOL_COUNT_OLD_NO", pool_count_old_no).replace("POOL_COUNT", pool_count)
+    pool_field = pool_count.lower()
+    snippet = template.replace("STRUCT_TYPE", struct_type).replace("STRUCT_NAME", struct_name).replace("POOL_COUNT_OLD_NO", pool_count_old_no).replace("POOL_COUNT", pool_count).replace("POOL_FIELD", pool_field)
     return snippet
     
 list_of_structs = [
@@ -213,6 +263,26 @@ list_of_mesh_structs = [
     ['mesh_network_pdu', 'mesh_transport_pdu', 'mesh_network_key', 'mesh_transport_key', 'mesh_virtual_address', 'mesh_subnet']
 ]
 
+def writeForAllStructs(f, template):
+    for struct_names in list_of_structs:
+        for struct_name in struct_names:
+            writeln(f, replacePlaceholder(template, struct_name))
+    writeln(f, "#ifdef ENABLE_CLASSIC")
+    for struct_names in list_of_classic_structs:
+        for struct_name in struct_names:
+            writeln(f, replacePlaceholder(template, struct_name))
+    writeln(f, "#endif")
+    writeln(f, "#ifdef ENABLE_BLE")
+    for struct_names in list_of_le_structs:
+        for struct_name in struct_names:
+            writeln(f, replacePlaceholder(template, struct_name))
+    writeln(f, "#endif")
+    writeln(f, "#ifdef ENABLE_MESH")
+    for struct_names in list_of_mesh_structs:
+        for struct_name in struct_names:
+            writeln(f, replacePlaceholder(template, struct_name))
+    writeln(f, "#endif")
+
 btstack_root = os.path.abspath(os.path.dirname(sys.argv[0]) + '/..')
 file_name = btstack_root + "/src/btstack_memory"
 print ('Generating %s.[h|c]' % file_name)
@@ -220,6 +290,13 @@ print ('Generating %s.[h|c]' % file_name)
 f = open(file_name+".h", "w")
 writeln(f, copyright)
 writeln(f, hfile_header_begin)
+writeln(f, "// number of elements per type for btstack_memory_init_arena, fields named after MAX_NR_* defines")
+writeln(f, "typedef struct {")
+for struct_names in list_of_structs + list_of_classic_structs + list_of_le_structs + list_of_mesh_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(config_template, struct_name))
+writeln(f, "} btstack_memory_arena_config_t;")
+writeln(f, hfile_api)
 for struct_names in list_of_structs:
     writeln(f, "// "+ ", ".join(struct_names))
     for struct_name in struct_names:
@@ -277,6 +354,7 @@ writeln(f, "#endif")
 
 writeln(f, "// init")
 writeln(f, "void btstack_memory_init(void){")
+writeln(f, "#ifndef ENABLE_BTSTACK_MEMORY_ARENA")
 for struct_names in list_of_structs:
     for struct_name in struct_names:
         writeln(f, replacePlaceholder(init_template, struct_name))
@@ -295,6 +373,56 @@ for struct_names in list_of_mesh_structs:
     for struct_name in struct_names:
         writeln(f, replacePlaceholder(init_template, struct_name))
 writeln(f, "#endif")
+writeln(f, "#endif")
+writeln(f, "}")
+
+writeln(f, "")
+writeln(f, "// arena")
+writeln(f, "#ifdef ENABLE_BTSTACK_MEMORY_ARENA")
+writeln(f, "uint32_t btstack_memory_arena_get_size(const btstack_memory_arena_config_t * config){")
+writeln(f, "    uint32_t size = 0;")
+writeForAllStructs(f, arena_size_template)
+writeln(f, "    return size;")
+writeln(f, "}")
+writeln(f, "")
+writeln(f, "uint8_t btstack_memory_init_arena(void * arena, uint32_t arena_size, const btstack_memory_arena_config_t * config){")
+writeln(f, "    // align start of arena")
+writeln(f, "    uint32_t misalignment = (uint32_t) (((uintptr_t) arena) & (BTSTACK_MEMORY_POOL_ALIGNMENT - 1));")
+writeln(f, "    uint32_t offset = (misalignment == 0) ? 0 : (BTSTACK_MEMORY_POOL_ALIGNMENT - misalignment);")
+writeln(f, "    if ((offset + btstack_memory_arena_get_size(config)) > arena_size){")
+writeln(f, "        log_error(\"btstack_memory_init_arena: arena with %u bytes too small\", (unsigned int) arena_size);")
+writeln(f, "        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;")
+writeln(f, "    }")
+writeln(f, "    // carve pools from arena one after the other")
+writeln(f, "    uint8_t * buffer = ((uint8_t *) arena) + offset;")
+writeForAllStructs(f, arena_init_template)
+writeln(f, "    return ERROR_CODE_SUCCESS;")
+writeln(f, "}")
+writeln(f, "#endif")
+
+writeln(f, "")
+writeln(f, "// statistics")
+writeln(f, "void btstack_memory_get_statistics(void (*callback)(const char * name, const btstack_memory_pool_statistics_t * statistics)){")
+writeln(f, "    // silence compiler warning about unused parameter if no pools are configured")
+writeln(f, "    (void) callback;")
+for struct_names in list_of_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#ifdef ENABLE_CLASSIC")
+for struct_names in list_of_classic_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_BLE")
+for struct_names in list_of_le_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_MESH")
+for struct_names in list_of_mesh_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#endif")
 writeln(f, "}")
 f.close();
     